@@ -74,6 +74,7 @@ list (APPEND MAIN_SOURCE_FILES
   opm/core/simulator/BlackoilState.cpp
   opm/core/simulator/TwophaseState.cpp
   opm/core/transport/TransportSolverTwophaseInterface.cpp
+  opm/core/transport/reorder/IncrementalReorderSequence.cpp
   opm/core/transport/reorder/ReorderSolverInterface.cpp
   opm/core/transport/reorder/TransportSolverCompressibleTwophaseReorder.cpp
   opm/core/transport/reorder/TransportSolverTwophaseReorder.cpp
@@ -118,6 +119,21 @@ list (APPEND TEST_SOURCE_FILES
   tests/test_satfunc.cpp
   tests/test_anisotropiceikonal.cpp
   tests/test_blackoilstate.cpp
+  tests/test_autodiffblockexpression.cpp
+  tests/test_autodiffmatrixpool.cpp
+  tests/test_preconditionerreusepolicy.cpp
+  tests/test_threadhandle.cpp
+  tests/test_sparseproductcache.cpp
+  tests/test_incrementalreordersequence.cpp
+  tests/test_pvtevaluationcache.cpp
+  tests/test_solvereordercomponent.cpp
+  tests/test_cfs_tpfa_residual.cpp
+  tests/test_reorderlevels.cpp
+  tests/test_transportsolvertwophasereorder.cpp
+  tests/test_reorderingtransportmodel.cpp
+  tests/test_newtoniterationinterleaved.cpp
+  tests/test_tofreorder.cpp
+  tests/test_updatablepreconditioner.cpp
 )
 
 if(MPI_FOUND)
@@ -175,6 +191,8 @@ list (APPEND PROGRAM_SOURCE_FILES
 # originally generated with the command:
 # find opm -name '*.h*' -a ! -name '*-pch.hpp' -printf '\t%p\n' | sort
 list (APPEND PUBLIC_HEADER_FILES
+  opm/autodiff/AutoDiffBlockExpression.hpp
+  opm/autodiff/AutoDiffMatrixPool.hpp
   opm/autodiff/BlackoilLegacyDetails.hpp
   opm/autodiff/BlackoilModel.hpp
   opm/autodiff/BlackoilModelBase.hpp
@@ -208,6 +226,8 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/NonlinearSolver_impl.hpp
   opm/autodiff/LinearisedBlackoilResidual.hpp
   opm/autodiff/ParallelDebugOutput.hpp
+  opm/autodiff/PreconditionerReusePolicy.hpp
+  opm/autodiff/PvtEvaluationCache.hpp
   opm/autodiff/RateConverterLegacy.hpp
   opm/autodiff/RedistributeDataHandles.hpp
   opm/autodiff/SimulatorBase.hpp
@@ -215,7 +235,10 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/autodiff/SimulatorFullyImplicitBlackoil.hpp
   opm/autodiff/SimulatorIncompTwophaseAd.hpp
   opm/autodiff/SimulatorSequentialBlackoil.hpp
+  opm/autodiff/solveReorderComponent.hpp
+  opm/autodiff/SparseProductCache.hpp
   opm/autodiff/TransportSolverTwophaseAd.hpp
+  opm/autodiff/UpdatablePreconditioner.hpp
   opm/autodiff/WellDensitySegmented.hpp
   opm/autodiff/SimulatorFullyImplicitBlackoilOutput.hpp
   opm/autodiff/ThreadHandle.hpp
@@ -278,6 +301,7 @@ list (APPEND PUBLIC_HEADER_FILES
   opm/core/simulator/initStateEquil_impl.hpp
   opm/core/simulator/initState_impl.hpp
   opm/core/transport/TransportSolverTwophaseInterface.hpp
+  opm/core/transport/reorder/IncrementalReorderSequence.hpp
   opm/core/transport/reorder/ReorderSolverInterface.hpp
   opm/core/transport/reorder/TransportSolverCompressibleTwophaseReorder.hpp
   opm/core/transport/reorder/TransportSolverTwophaseReorder.hpp
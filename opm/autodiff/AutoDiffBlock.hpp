@@ -225,7 +225,7 @@ namespace Opm
 
                 const int num_blocks = numBlocks();
 #if HAVE_OPENMP
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!SparseKernelParallelism::rowParallel())
 #endif // HAVE_OPENMP
                 for (int block = 0; block < num_blocks; ++block) {
                     assert(jac_[block].rows() == rhs.jac_[block].rows());
@@ -246,7 +246,7 @@ namespace Opm
                 const int num_blocks = rhs.numBlocks();
                 jac_.resize(num_blocks);
 #if HAVE_OPENMP
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!SparseKernelParallelism::rowParallel())
 #endif // HAVE_OPENMP
                 for (int block = 0; block < num_blocks; ++block) {
                     jac_[block] = rhs.jac_[block] * (-1.0);
@@ -257,7 +257,7 @@ namespace Opm
 
                 const int num_blocks = numBlocks();
 #if HAVE_OPENMP
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!SparseKernelParallelism::rowParallel())
 #endif // HAVE_OPENMP
                 for (int block = 0; block < num_blocks; ++block) {
                     assert(jac_[block].rows() == rhs.jac_[block].rows());
@@ -287,7 +287,7 @@ namespace Opm
             assert(numBlocks() == rhs.numBlocks());
             int num_blocks = numBlocks();
 #if HAVE_OPENMP
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!SparseKernelParallelism::rowParallel())
 #endif // HAVE_OPENMP
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac[block].rows() == rhs.jac_[block].rows());
@@ -313,7 +313,7 @@ namespace Opm
             assert(numBlocks() == rhs.numBlocks());
             int num_blocks = numBlocks();
 #if HAVE_OPENMP
-#pragma omp parallel for schedule(static)
+#pragma omp parallel for schedule(static) if(!SparseKernelParallelism::rowParallel())
 #endif // HAVE_OPENMP
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac[block].rows() == rhs.jac_[block].rows());
@@ -341,7 +341,7 @@ namespace Opm
             M D1(val_.matrix().asDiagonal());
             M D2(rhs.val_.matrix().asDiagonal());
 #if HAVE_OPENMP
-#pragma omp parallel for schedule(dynamic)
+#pragma omp parallel for schedule(dynamic) if(!SparseKernelParallelism::rowParallel())
 #endif // HAVE_OPENMP
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac_[block].rows() == rhs.jac_[block].rows());
@@ -381,7 +381,7 @@ namespace Opm
             M D2(rhs.val_.matrix().asDiagonal());
             M D3((1.0/(rhs.val_*rhs.val_)).matrix().asDiagonal());
 #if HAVE_OPENMP
-#pragma omp parallel for schedule(dynamic)
+#pragma omp parallel for schedule(dynamic) if(!SparseKernelParallelism::rowParallel())
 #endif // HAVE_OPENMP
             for (int block = 0; block < num_blocks; ++block) {
                 assert(jac_[block].rows() == rhs.jac_[block].rows());
@@ -508,7 +508,7 @@ namespace Opm
         std::vector<typename AutoDiffBlock<Scalar>::M> jac(num_blocks);
         assert(lhs.cols() == rhs.value().rows());
 #if HAVE_OPENMP
-#pragma omp parallel for schedule(dynamic)
+#pragma omp parallel for schedule(dynamic) if(!SparseKernelParallelism::rowParallel())
 #endif // HAVE_OPENMP
         for (int block = 0; block < num_blocks; ++block) {
             fastSparseProduct(lhs, rhs.derivative()[block], jac[block]);
@@ -534,6 +534,29 @@ namespace Opm
     }
 
 
+    /// Multiply with an Eigen sparse matrix with fixed sparsity pattern
+    /// from the left, taking the sparsity patterns of the jacobian
+    /// products from cache when possible.
+    template <typename Scalar>
+    AutoDiffBlock<Scalar> cachedProduct(const Eigen::SparseMatrix<Scalar>& lhs,
+                                        SparseProductCache& cache,
+                                        const AutoDiffBlock<Scalar>& rhs)
+    {
+        typedef typename AutoDiffBlock<Scalar>::M M;
+        int num_blocks = rhs.numBlocks();
+        std::vector<M> jac(num_blocks);
+        assert(lhs.cols() == rhs.value().rows());
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(!SparseKernelParallelism::rowParallel())
+#endif // HAVE_OPENMP
+        for (int block = 0; block < num_blocks; ++block) {
+            jac[block] = M::cachedProduct(lhs, rhs.derivative()[block], cache);
+        }
+        typename AutoDiffBlock<Scalar>::V val = lhs*rhs.value().matrix();
+        return AutoDiffBlock<Scalar>::function(std::move(val), std::move(jac));
+    }
+
+
     /// Elementwise multiplication with constant on the left.
     template <typename Scalar>
     AutoDiffBlock<Scalar> operator*(const typename AutoDiffBlock<Scalar>::V& lhs,
@@ -0,0 +1,567 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_AUTODIFFBLOCKEXPRESSION_HEADER_INCLUDED
+#define OPM_AUTODIFFBLOCKEXPRESSION_HEADER_INCLUDED
+
+#include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/AutoDiffMatrix.hpp>
+
+#include <cassert>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /// Lazy (expression template) evaluation of elementwise AutoDiffBlock
+    /// arithmetic.
+    ///
+    /// Every arithmetic operator on AutoDiffBlock computes its result
+    /// immediately, including all its jacobian blocks. A chain of
+    /// operations such as a*b + c*d therefore creates several temporary
+    /// jacobians that are only used once. The classes in this file
+    /// instead build an expression tree, which is evaluated by
+    /// fusedEval(). Since all the operations are elementwise, the
+    /// jacobian of the expression with respect to each variable block is
+    ///
+    ///     sum_k diag(s_k) * J_k,
+    ///
+    /// where the J_k are the jacobian blocks of the AutoDiffBlock leaves
+    /// of the expression, and the s_k are vectors computed from the
+    /// values only. fusedEval() computes the s_k, then writes each
+    /// jacobian block of the result exactly once using
+    /// AutoDiffMatrix::diagonalScaledSum().
+    ///
+    /// An expression is started by wrapping an AutoDiffBlock with
+    /// lazy(), after which AutoDiffBlocks, value arrays and scalars may
+    /// be mixed freely with the elementwise operators +, -, * and /.
+    /// For example
+    ///
+    ///     ADB r = fusedEval(pvdt * (lazy(accum1) - accum0) + flux);
+    ///
+    /// Like for Eigen expressions, the expression objects only refer to
+    /// their operands, so they must be evaluated while the operands are
+    /// still alive, typically in the same statement.
+    struct AdbExpressionTag
+    {
+    };
+
+
+    namespace AdbExprDetail
+    {
+        /// The jacobian contributions collected from the leaves of an
+        /// expression, one row scaling per distinct AutoDiffBlock.
+        template <typename Scalar>
+        class Terms
+        {
+        public:
+            typedef AutoDiffBlock<Scalar> ADB;
+            typedef typename ADB::V V;
+
+            /// Add diag(factor * scale) * J(leaf) to the sum. A null
+            /// scale is interpreted as a vector of ones.
+            void add(const ADB& leaf, const V* scale, const Scalar factor)
+            {
+                for (auto& term : terms_) {
+                    if (term.first == &leaf) {
+                        if (scale) {
+                            term.second += factor * (*scale);
+                        } else {
+                            term.second += factor;
+                        }
+                        return;
+                    }
+                }
+                if (scale) {
+                    terms_.emplace_back(&leaf, factor * (*scale));
+                } else {
+                    terms_.emplace_back(&leaf, V::Constant(leaf.size(), factor));
+                }
+            }
+
+            const std::vector<std::pair<const ADB*, V>>& terms() const
+            {
+                return terms_;
+            }
+
+        private:
+            std::vector<std::pair<const ADB*, V>> terms_;
+        };
+    } // namespace AdbExprDetail
+
+
+
+    /// Expression leaf referring to an AutoDiffBlock.
+    template <typename ScalarT>
+    class AdbLeafExpr : public AdbExpressionTag
+    {
+    public:
+        typedef ScalarT Scalar;
+        typedef AutoDiffBlock<Scalar> ADB;
+        typedef typename ADB::V V;
+
+        explicit AdbLeafExpr(const ADB& adb)
+            : adb_(&adb)
+        {
+        }
+
+        int size() const { return adb_->size(); }
+        bool isConstant() const { return adb_->numBlocks() == 0; }
+        const V& value() const { return adb_->value(); }
+
+        void accumulate(const V* scale, const Scalar factor,
+                        AdbExprDetail::Terms<Scalar>& terms) const
+        {
+            if (!isConstant()) {
+                terms.add(*adb_, scale, factor);
+            }
+        }
+
+    private:
+        const ADB* adb_;
+    };
+
+
+
+    /// Expression leaf referring to a constant value array.
+    template <typename ScalarT>
+    class AdbConstantExpr : public AdbExpressionTag
+    {
+    public:
+        typedef ScalarT Scalar;
+        typedef typename AutoDiffBlock<Scalar>::V V;
+
+        explicit AdbConstantExpr(const V& val)
+            : val_(&val)
+        {
+        }
+
+        int size() const { return val_->size(); }
+        bool isConstant() const { return true; }
+        const V& value() const { return *val_; }
+
+        void accumulate(const V*, const Scalar,
+                        AdbExprDetail::Terms<Scalar>&) const
+        {
+        }
+
+    private:
+        const V* val_;
+    };
+
+
+
+    /// Common base for the binary elementwise expressions. Holds the
+    /// operand expressions by value, and caches the value of the node
+    /// once computed, so that each node value is computed only once
+    /// during fusedEval().
+    template <class Derived, class L, class R>
+    class AdbBinaryExpr : public AdbExpressionTag
+    {
+    public:
+        typedef typename L::Scalar Scalar;
+        typedef typename AutoDiffBlock<Scalar>::V V;
+
+        AdbBinaryExpr(const L& lhs, const R& rhs)
+            : lhs_(lhs), rhs_(rhs), evaluated_(false)
+        {
+            assert(lhs_.size() == rhs_.size());
+        }
+
+        int size() const { return lhs_.size(); }
+        bool isConstant() const { return lhs_.isConstant() && rhs_.isConstant(); }
+
+        const V& value() const
+        {
+            if (!evaluated_) {
+                val_ = static_cast<const Derived&>(*this).computeValue();
+                evaluated_ = true;
+            }
+            return val_;
+        }
+
+    protected:
+        L lhs_;
+        R rhs_;
+
+        /// Returns scale*x, with a null scale meaning ones.
+        static V scaled(const V* scale, const V& x)
+        {
+            return scale ? V((*scale) * x) : x;
+        }
+
+    private:
+        mutable V val_;
+        mutable bool evaluated_;
+    };
+
+
+
+    /// Elementwise sum of two expressions.
+    template <class L, class R>
+    class AdbSumExpr : public AdbBinaryExpr<AdbSumExpr<L, R>, L, R>
+    {
+        typedef AdbBinaryExpr<AdbSumExpr<L, R>, L, R> Base;
+    public:
+        using typename Base::Scalar;
+        using typename Base::V;
+
+        AdbSumExpr(const L& lhs, const R& rhs) : Base(lhs, rhs) {}
+
+        V computeValue() const { return this->lhs_.value() + this->rhs_.value(); }
+
+        void accumulate(const V* scale, const Scalar factor,
+                        AdbExprDetail::Terms<Scalar>& terms) const
+        {
+            this->lhs_.accumulate(scale, factor, terms);
+            this->rhs_.accumulate(scale, factor, terms);
+        }
+    };
+
+
+
+    /// Elementwise difference of two expressions.
+    template <class L, class R>
+    class AdbDifferenceExpr : public AdbBinaryExpr<AdbDifferenceExpr<L, R>, L, R>
+    {
+        typedef AdbBinaryExpr<AdbDifferenceExpr<L, R>, L, R> Base;
+    public:
+        using typename Base::Scalar;
+        using typename Base::V;
+
+        AdbDifferenceExpr(const L& lhs, const R& rhs) : Base(lhs, rhs) {}
+
+        V computeValue() const { return this->lhs_.value() - this->rhs_.value(); }
+
+        void accumulate(const V* scale, const Scalar factor,
+                        AdbExprDetail::Terms<Scalar>& terms) const
+        {
+            this->lhs_.accumulate(scale, factor, terms);
+            this->rhs_.accumulate(scale, -factor, terms);
+        }
+    };
+
+
+
+    /// Elementwise product of two expressions.
+    template <class L, class R>
+    class AdbProductExpr : public AdbBinaryExpr<AdbProductExpr<L, R>, L, R>
+    {
+        typedef AdbBinaryExpr<AdbProductExpr<L, R>, L, R> Base;
+    public:
+        using typename Base::Scalar;
+        using typename Base::V;
+
+        AdbProductExpr(const L& lhs, const R& rhs) : Base(lhs, rhs) {}
+
+        V computeValue() const { return this->lhs_.value() * this->rhs_.value(); }
+
+        void accumulate(const V* scale, const Scalar factor,
+                        AdbExprDetail::Terms<Scalar>& terms) const
+        {
+            // (lr)' = r l' + l r'
+            if (!this->lhs_.isConstant()) {
+                const V s = Base::scaled(scale, this->rhs_.value());
+                this->lhs_.accumulate(&s, factor, terms);
+            }
+            if (!this->rhs_.isConstant()) {
+                const V s = Base::scaled(scale, this->lhs_.value());
+                this->rhs_.accumulate(&s, factor, terms);
+            }
+        }
+    };
+
+
+
+    /// Elementwise quotient of two expressions.
+    template <class L, class R>
+    class AdbQuotientExpr : public AdbBinaryExpr<AdbQuotientExpr<L, R>, L, R>
+    {
+        typedef AdbBinaryExpr<AdbQuotientExpr<L, R>, L, R> Base;
+    public:
+        using typename Base::Scalar;
+        using typename Base::V;
+
+        AdbQuotientExpr(const L& lhs, const R& rhs) : Base(lhs, rhs) {}
+
+        V computeValue() const { return this->lhs_.value() / this->rhs_.value(); }
+
+        void accumulate(const V* scale, const Scalar factor,
+                        AdbExprDetail::Terms<Scalar>& terms) const
+        {
+            // (l/r)' = l'/r - (l/r) r'/r
+            if (!this->lhs_.isConstant()) {
+                const V s = Base::scaled(scale, V(1.0 / this->rhs_.value()));
+                this->lhs_.accumulate(&s, factor, terms);
+            }
+            if (!this->rhs_.isConstant()) {
+                const V s = Base::scaled(scale, V(this->value() / this->rhs_.value()));
+                this->rhs_.accumulate(&s, -factor, terms);
+            }
+        }
+    };
+
+
+
+    /// Expression multiplied by a scalar.
+    template <class E>
+    class AdbScaledExpr : public AdbExpressionTag
+    {
+    public:
+        typedef typename E::Scalar Scalar;
+        typedef typename AutoDiffBlock<Scalar>::V V;
+
+        AdbScaledExpr(const E& expr, const Scalar factor)
+            : expr_(expr), factor_(factor), evaluated_(false)
+        {
+        }
+
+        int size() const { return expr_.size(); }
+        bool isConstant() const { return expr_.isConstant(); }
+
+        const V& value() const
+        {
+            if (!evaluated_) {
+                val_ = factor_ * expr_.value();
+                evaluated_ = true;
+            }
+            return val_;
+        }
+
+        void accumulate(const V* scale, const Scalar factor,
+                        AdbExprDetail::Terms<Scalar>& terms) const
+        {
+            expr_.accumulate(scale, factor * factor_, terms);
+        }
+
+    private:
+        E expr_;
+        Scalar factor_;
+        mutable V val_;
+        mutable bool evaluated_;
+    };
+
+
+
+    namespace AdbExprDetail
+    {
+        /// Maps the types that may appear as operands in an expression to
+        /// the corresponding expression node types.
+        template <class T, class Enable = void>
+        struct Operand
+        {
+            static const bool valid = false;
+            static const bool expression = false;
+        };
+
+        template <class E>
+        struct Operand<E, typename std::enable_if<std::is_base_of<AdbExpressionTag, E>::value>::type>
+        {
+            static const bool valid = true;
+            static const bool expression = true;
+            typedef E Node;
+            static const Node& make(const E& e) { return e; }
+        };
+
+        template <typename Scalar>
+        struct Operand<AutoDiffBlock<Scalar>, void>
+        {
+            static const bool valid = true;
+            static const bool expression = false;
+            typedef AdbLeafExpr<Scalar> Node;
+            static Node make(const AutoDiffBlock<Scalar>& adb) { return Node(adb); }
+        };
+
+        template <typename Scalar>
+        struct Operand<Eigen::Array<Scalar, Eigen::Dynamic, 1>, void>
+        {
+            static const bool valid = true;
+            static const bool expression = false;
+            typedef AdbConstantExpr<Scalar> Node;
+            static Node make(const Eigen::Array<Scalar, Eigen::Dynamic, 1>& v) { return Node(v); }
+        };
+
+        /// Result type of a binary operator, only defined if both
+        /// arguments are valid operands and at least one of them is
+        /// already an expression. The last condition makes sure the
+        /// operators of AutoDiffBlock itself are not hijacked.
+        template <template <class, class> class Expr, class L, class R,
+                  bool enabled = Operand<L>::valid && Operand<R>::valid
+                                 && (Operand<L>::expression || Operand<R>::expression)>
+        struct BinaryResult
+        {
+        };
+
+        template <template <class, class> class Expr, class L, class R>
+        struct BinaryResult<Expr, L, R, true>
+        {
+            typedef Expr<typename Operand<L>::Node, typename Operand<R>::Node> type;
+        };
+
+        template <class E, class T>
+        struct ScaledResult
+            : std::enable_if<std::is_base_of<AdbExpressionTag, E>::value
+                             && std::is_arithmetic<T>::value,
+                             AdbScaledExpr<E> >
+        {
+        };
+    } // namespace AdbExprDetail
+
+
+
+    // ---------  Free functions and operators for expressions  ---------
+
+    /// Start a lazy expression from an AutoDiffBlock.
+    template <typename Scalar>
+    AdbLeafExpr<Scalar> lazy(const AutoDiffBlock<Scalar>& adb)
+    {
+        return AdbLeafExpr<Scalar>(adb);
+    }
+
+
+    /// Elementwise operator +
+    template <class L, class R>
+    typename AdbExprDetail::BinaryResult<AdbSumExpr, L, R>::type
+    operator+(const L& lhs, const R& rhs)
+    {
+        typedef AdbExprDetail::Operand<L> OL;
+        typedef AdbExprDetail::Operand<R> OR;
+        return AdbSumExpr<typename OL::Node, typename OR::Node>(OL::make(lhs), OR::make(rhs));
+    }
+
+
+    /// Elementwise operator -
+    template <class L, class R>
+    typename AdbExprDetail::BinaryResult<AdbDifferenceExpr, L, R>::type
+    operator-(const L& lhs, const R& rhs)
+    {
+        typedef AdbExprDetail::Operand<L> OL;
+        typedef AdbExprDetail::Operand<R> OR;
+        return AdbDifferenceExpr<typename OL::Node, typename OR::Node>(OL::make(lhs), OR::make(rhs));
+    }
+
+
+    /// Elementwise operator *
+    template <class L, class R>
+    typename AdbExprDetail::BinaryResult<AdbProductExpr, L, R>::type
+    operator*(const L& lhs, const R& rhs)
+    {
+        typedef AdbExprDetail::Operand<L> OL;
+        typedef AdbExprDetail::Operand<R> OR;
+        return AdbProductExpr<typename OL::Node, typename OR::Node>(OL::make(lhs), OR::make(rhs));
+    }
+
+
+    /// Elementwise operator /
+    template <class L, class R>
+    typename AdbExprDetail::BinaryResult<AdbQuotientExpr, L, R>::type
+    operator/(const L& lhs, const R& rhs)
+    {
+        typedef AdbExprDetail::Operand<L> OL;
+        typedef AdbExprDetail::Operand<R> OR;
+        return AdbQuotientExpr<typename OL::Node, typename OR::Node>(OL::make(lhs), OR::make(rhs));
+    }
+
+
+    /// Multiplication with a scalar on the right.
+    template <class E, class T>
+    typename AdbExprDetail::ScaledResult<E, T>::type
+    operator*(const E& expr, const T factor)
+    {
+        return AdbScaledExpr<E>(expr, factor);
+    }
+
+
+    /// Multiplication with a scalar on the left.
+    template <class T, class E>
+    typename AdbExprDetail::ScaledResult<E, T>::type
+    operator*(const T factor, const E& expr)
+    {
+        return AdbScaledExpr<E>(expr, factor);
+    }
+
+
+    /// Division by a scalar.
+    template <class E, class T>
+    typename AdbExprDetail::ScaledResult<E, T>::type
+    operator/(const E& expr, const T divisor)
+    {
+        return AdbScaledExpr<E>(expr, 1.0 / divisor);
+    }
+
+
+    /// Unary minus.
+    template <class E>
+    typename AdbExprDetail::ScaledResult<E, double>::type
+    operator-(const E& expr)
+    {
+        return AdbScaledExpr<E>(expr, -1.0);
+    }
+
+
+    /// Evaluate an expression into an AutoDiffBlock, computing the
+    /// value and writing each jacobian block exactly once.
+    template <class E>
+    typename std::enable_if<std::is_base_of<AdbExpressionTag, E>::value,
+                            AutoDiffBlock<typename E::Scalar> >::type
+    fusedEval(const E& expr)
+    {
+        typedef typename E::Scalar Scalar;
+        typedef AutoDiffBlock<Scalar> ADB;
+        typedef typename ADB::V V;
+        typedef typename ADB::M M;
+
+        V val = expr.value();
+        if (expr.isConstant()) {
+            return ADB::constant(std::move(val));
+        }
+
+        AdbExprDetail::Terms<Scalar> collected;
+        expr.accumulate(nullptr, 1.0, collected);
+        const auto& terms = collected.terms();
+        assert(!terms.empty());
+
+        const int num_terms = terms.size();
+        const int num_blocks = terms[0].first->numBlocks();
+        std::vector<const double*> scales(num_terms);
+        for (int t = 0; t < num_terms; ++t) {
+            assert(terms[t].first->numBlocks() == num_blocks);
+            assert(terms[t].second.size() == val.size());
+            scales[t] = terms[t].second.data();
+        }
+
+        std::vector<M> jac(num_blocks);
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic) if(!SparseKernelParallelism::rowParallel())
+#endif // HAVE_OPENMP
+        for (int block = 0; block < num_blocks; ++block) {
+            std::vector<const M*> mats(num_terms);
+            for (int t = 0; t < num_terms; ++t) {
+                mats[t] = &terms[t].first->derivative()[block];
+            }
+            jac[block] = M::diagonalScaledSum(mats, scales);
+        }
+        return ADB::function(std::move(val), std::move(jac));
+    }
+
+} // namespace Opm
+
+#endif // OPM_AUTODIFFBLOCKEXPRESSION_HEADER_INCLUDED
@@ -74,6 +74,20 @@ struct HelperOps
     /// The set of all connections' cells (face or nnc).
     TwoColInt connection_cells;
 
+    /// Returns op * x, where op is one of the operators above. The
+    /// sparsity patterns of the products with the jacobian blocks of x
+    /// are cached, so that repeated products with jacobians of the same
+    /// structure (e.g. div * flux in every Newton iteration) only
+    /// compute the values.
+    AutoDiffBlock<double> product(const M& op, const AutoDiffBlock<double>& x) const
+    {
+        SparseProductCache* cache = productCache(op);
+        if (cache == nullptr) {
+            return op * x;
+        }
+        return cachedProduct(op, *cache, x);
+    }
+
     /// Constructs all helper vectors and matrices.
     template<class Grid>
     HelperOps(const Grid& grid, const NNC& nnc = NNC())
@@ -171,6 +185,22 @@ struct HelperOps
             connection_cells = nbi;
         }
     }
+
+private:
+    // One cache per operator, in the order ngrad, grad, caver, div,
+    // fullngrad, fulldiv.
+    mutable SparseProductCache product_cache_[6];
+
+    SparseProductCache* productCache(const M& op) const
+    {
+        const M* ops[] = { &ngrad, &grad, &caver, &div, &fullngrad, &fulldiv };
+        for (int i = 0; i < 6; ++i) {
+            if (&op == ops[i]) {
+                return &product_cache_[i];
+            }
+        }
+        return nullptr;
+    }
 };
 // -------------------- upwinding helper class --------------------
 
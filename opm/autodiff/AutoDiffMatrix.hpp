@@ -28,7 +28,10 @@
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
 #include <opm/common/ErrorMacros.hpp>
+#include <opm/autodiff/AutoDiffMatrixPool.hpp>
+#include <opm/autodiff/SparseProductCache.hpp>
 #include <opm/autodiff/fastSparseOperations.hpp>
+#include <algorithm>
 #include <vector>
 
 
@@ -39,6 +42,9 @@ namespace Opm
      * AutoDiffMatrix is a wrapper class that optimizes matrix operations.
      * Internally, an AutoDiffMatrix can be either Zero, Identity, Diagonal,
      * or Sparse, and we utilize this to perform faster matrix operations.
+     * When AutoDiffMatrixPool is enabled, the storage of the diagonal and
+     * sparse representations is recycled through the pool of the current
+     * thread.
      */
     class AutoDiffMatrix
     {
@@ -114,11 +120,38 @@ namespace Opm
 
 
 
-        AutoDiffMatrix(const AutoDiffMatrix& other) = default;
+        AutoDiffMatrix(const AutoDiffMatrix& other)
+            : type_(other.type_),
+              rows_(other.rows_),
+              cols_(other.cols_),
+              diag_(),
+              sparse_()
+        {
+            if (type_ == Diagonal) {
+                acquireStorage(rows_, diag_);
+            } else if (type_ == Sparse) {
+                acquireStorage(rows_, cols_, sparse_, other.sparse_.nonZeros());
+            }
+            diag_ = other.diag_;
+            sparse_ = other.sparse_;
+        }
+
         AutoDiffMatrix& operator=(const AutoDiffMatrix& other) = default;
 
 
 
+        ~AutoDiffMatrix()
+        {
+            if (AutoDiffMatrixPool::enabled()) {
+                if (AutoDiffMatrixPool* pool = AutoDiffMatrixPool::local()) {
+                    pool->recycle(diag_);
+                    pool->recycle(sparse_);
+                }
+            }
+        }
+
+
+
         AutoDiffMatrix(AutoDiffMatrix&& other)
             : type_(Zero),
               rows_(0),
@@ -310,6 +343,7 @@ namespace Opm
                 {
                     AutoDiffMatrix retval(*this);
                     retval.type_ = Diagonal;
+                    acquireStorage(rows_, retval.diag_);
                     retval.diag_.assign(rows_, rhs);
                     return retval;
                 }
@@ -351,6 +385,7 @@ namespace Opm
                 {
                     AutoDiffMatrix retval(*this);
                     retval.type_ = Diagonal;
+                    acquireStorage(rows_, retval.diag_);
                     retval.diag_.assign(rows_, 1.0/rhs);
                     return retval;
                 }
@@ -416,6 +451,7 @@ namespace Opm
             retval.type_ = Diagonal;
             retval.rows_ = lhs.rows_;
             retval.cols_ = rhs.cols_;
+            acquireStorage(lhs.rows_, retval.diag_);
             retval.diag_.assign(lhs.rows_, 2.0);
             return retval;
         }
@@ -472,7 +508,7 @@ namespace Opm
             assert(lhs.type_ == Sparse);
             assert(rhs.type_ == Sparse);
             AutoDiffMatrix retval = lhs;
-            retval.sparse_ += rhs.sparse_;
+            fastSparseAdd(retval.sparse_, rhs.sparse_);
             return retval;
         }
 
@@ -500,6 +536,7 @@ namespace Opm
             retval.type_ = Sparse;
             retval.rows_ = lhs.rows_;
             retval.cols_ = rhs.cols_;
+            acquireStorage(retval.rows_, retval.cols_, retval.sparse_);
             fastDiagSparseProduct(lhs.diag_, rhs.sparse_, retval.sparse_);
             return retval;
         }
@@ -513,6 +550,7 @@ namespace Opm
             retval.type_ = Sparse;
             retval.rows_ = lhs.rows_;
             retval.cols_ = rhs.cols_;
+            acquireStorage(retval.rows_, retval.cols_, retval.sparse_);
             fastSparseDiagProduct(lhs.sparse_, rhs.diag_, retval.sparse_);
             return retval;
         }
@@ -526,6 +564,7 @@ namespace Opm
             retval.type_ = Sparse;
             retval.rows_ = lhs.rows_;
             retval.cols_ = rhs.cols_;
+            acquireStorage(retval.rows_, retval.cols_, retval.sparse_);
             fastSparseProduct(lhs.sparse_, rhs.sparse_, retval.sparse_);
             return retval;
         }
@@ -533,6 +572,178 @@ namespace Opm
 
 
 
+        /**
+         * Multiplies a sparse matrix with fixed sparsity pattern, such as
+         * one of the operators of HelperOps, with an AutoDiffMatrix. For a
+         * Sparse rhs, the sparsity pattern of the result is taken from
+         * the cache when rhs has a pattern seen before.
+         */
+        static AutoDiffMatrix cachedProduct(const SparseRep& lhs, const AutoDiffMatrix& rhs,
+                                            SparseProductCache& cache)
+        {
+            assert(lhs.cols() == rhs.rows_);
+            if (rhs.type_ != Sparse || !lhs.isCompressed() || !rhs.sparse_.isCompressed()) {
+                return AutoDiffMatrix(lhs) * rhs;
+            }
+            AutoDiffMatrix retval;
+            retval.type_ = Sparse;
+            retval.rows_ = lhs.rows();
+            retval.cols_ = rhs.cols_;
+            acquireStorage(retval.rows_, retval.cols_, retval.sparse_);
+            cache.multiply(lhs, rhs.sparse_, retval.sparse_);
+            return retval;
+        }
+
+
+
+
+        /**
+         * Computes the sum of row-scaled matrices, i.e.
+         *
+         *     sum_k diag(scales[k]) * mats[k],
+         *
+         * in a single pass, writing the result exactly once. All matrices
+         * must have the same dimensions, and each scales[k] must point to
+         * rows() values. The result is Zero if all terms are Zero, Diagonal
+         * if no term is Sparse, and Sparse otherwise.
+         */
+        static AutoDiffMatrix diagonalScaledSum(const std::vector<const AutoDiffMatrix*>& mats,
+                                                const std::vector<const double*>& scales)
+        {
+            assert(!mats.empty());
+            assert(mats.size() == scales.size());
+            const int num_terms = mats.size();
+            const int rows = mats[0]->rows_;
+            const int cols = mats[0]->cols_;
+
+            // Find the structure of the result.
+            AudoDiffMatrixType res_type = Zero;
+            int num_nonzero = 0;
+            int last_nonzero = -1;
+            int estimated_nnz = 0;
+            for (int k = 0; k < num_terms; ++k) {
+                assert(mats[k]->rows_ == rows);
+                assert(mats[k]->cols_ == cols);
+                switch (mats[k]->type_) {
+                case Zero:
+                    break;
+                case Identity:
+                case Diagonal:
+                    if (res_type == Zero) {
+                        res_type = Diagonal;
+                    }
+                    ++num_nonzero;
+                    last_nonzero = k;
+                    estimated_nnz += rows;
+                    break;
+                case Sparse:
+                    res_type = Sparse;
+                    ++num_nonzero;
+                    last_nonzero = k;
+                    estimated_nnz += mats[k]->sparse_.nonZeros();
+                    break;
+                default:
+                    OPM_THROW(std::logic_error, "Invalid AutoDiffMatrix type encountered: " << mats[k]->type_);
+                }
+            }
+
+            AutoDiffMatrix retval(rows, cols);
+            if (res_type == Zero) {
+                return retval;
+            }
+
+            if (res_type == Diagonal) {
+                retval.type_ = Diagonal;
+                acquireStorage(rows, retval.diag_);
+                retval.diag_.assign(rows, 0.0);
+                for (int k = 0; k < num_terms; ++k) {
+                    const double* s = scales[k];
+                    if (mats[k]->type_ == Identity) {
+                        for (int r = 0; r < rows; ++r) {
+                            retval.diag_[r] += s[r];
+                        }
+                    } else if (mats[k]->type_ == Diagonal) {
+                        const double* d = mats[k]->diag_.data();
+                        for (int r = 0; r < rows; ++r) {
+                            retval.diag_[r] += s[r] * d[r];
+                        }
+                    }
+                }
+                return retval;
+            }
+
+            retval.type_ = Sparse;
+            acquireStorage(rows, cols, retval.sparse_);
+            if (num_nonzero == 1) {
+                // A single sparse term: the result has the same sparsity
+                // pattern, so we only need to scale its rows.
+                const double* s = scales[last_nonzero];
+                retval.sparse_ = mats[last_nonzero]->sparse_;
+                double* v = retval.sparse_.valuePtr();
+                const auto r = retval.sparse_.innerIndexPtr();
+                const int nnz = retval.sparse_.nonZeros();
+                for (int i = 0; i < nnz; ++i) {
+                    v[i] *= s[r[i]];
+                }
+                return retval;
+            }
+
+            // General case: merge the columns of all terms, using a dense
+            // work column with a mask, as in fastSparseProduct().
+            SparseRep& res = retval.sparse_;
+            res.resize(rows, cols);
+            res.reserve(estimated_nnz);
+            std::vector<bool> mask(rows, false);
+            std::vector<double> values(rows);
+            std::vector<SparseRep::Index> indices(rows);
+            for (int col = 0; col < cols; ++col) {
+                int nnz = 0;
+                for (int k = 0; k < num_terms; ++k) {
+                    const AutoDiffMatrix& m = *mats[k];
+                    const double* s = scales[k];
+                    if (m.type_ == Zero) {
+                        continue;
+                    }
+                    if (m.type_ == Sparse) {
+                        for (SparseRep::InnerIterator it(m.sparse_, col); it; ++it) {
+                            const SparseRep::Index row = it.index();
+                            const double val = s[row] * it.value();
+                            if (!mask[row]) {
+                                mask[row] = true;
+                                values[row] = val;
+                                indices[nnz++] = row;
+                            } else {
+                                values[row] += val;
+                            }
+                        }
+                    } else if (col < rows) {
+                        const double val = (m.type_ == Identity) ? s[col] : s[col] * m.diag_[col];
+                        if (!mask[col]) {
+                            mask[col] = true;
+                            values[col] = val;
+                            indices[nnz++] = col;
+                        } else {
+                            values[col] += val;
+                        }
+                    }
+                }
+                if (nnz > 1) {
+                    std::sort(indices.begin(), indices.begin() + nnz);
+                }
+                res.startVec(col);
+                for (int i = 0; i < nnz; ++i) {
+                    const SparseRep::Index row = indices[i];
+                    res.insertBackByOuterInnerUnordered(col, row) = values[row];
+                    mask[row] = false;
+                }
+            }
+            res.finalize();
+            return retval;
+        }
+
+
+
+
         /**
          * Converts the AutoDiffMatrix to an Eigen SparseMatrix.This might be
          * an expensive operation to perform for e.g., an identity matrix or a
@@ -676,6 +887,39 @@ namespace Opm
 
 
 
+        /**
+         * Gets storage for a diagonal representation from the pool,
+         * if pooling is enabled.
+         */
+        static void acquireStorage(const int n, DiagRep& d)
+        {
+            if (AutoDiffMatrixPool::enabled() && d.capacity() == 0) {
+                if (AutoDiffMatrixPool* pool = AutoDiffMatrixPool::local()) {
+                    pool->acquire(n, d);
+                }
+            }
+        }
+
+
+
+        /**
+         * Gets storage for a sparse representation from the pool,
+         * if pooling is enabled. If nnz is known, the storage is
+         * chosen to fit that number of nonzeros.
+         */
+        static void acquireStorage(const int rows, const int cols, SparseRep& s, const int nnz = 0)
+        {
+            if (AutoDiffMatrixPool::enabled() && s.outerSize() == 0) {
+                if (AutoDiffMatrixPool* pool = AutoDiffMatrixPool::local()) {
+                    pool->acquire(rows, cols, s, nnz);
+                }
+            }
+        }
+
+
+
+
+
         /**
          * Creates a sparse diagonal matrix from d.
          * Typical use is to convert a standard vector to an
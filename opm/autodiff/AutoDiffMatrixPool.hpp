@@ -0,0 +1,328 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_AUTODIFFMATRIXPOOL_HEADER_INCLUDED
+#define OPM_AUTODIFFMATRIXPOOL_HEADER_INCLUDED
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+
+#include <Eigen/Sparse>
+
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /**
+     * A pool of storage for the diagonal and sparse representations of
+     * AutoDiffMatrix.
+     *
+     * The assembly of the fully implicit equations creates and destroys
+     * a large number of temporary jacobians, and the same shapes and
+     * sparsity patterns are created again in every Newton iteration.
+     * When the pool is enabled, the storage of a destroyed AutoDiffMatrix
+     * is kept in the pool instead of being freed, and handed out again
+     * to the next matrix of the same shape. Since Eigen reuses the
+     * allocated storage of a sparse matrix when assigning into it, a
+     * product or copy with an unchanged pattern then needs no allocation
+     * at all.
+     *
+     * There is one pool per thread, so that the OpenMP-parallel parts of
+     * the assembly do not contend for a shared allocator. Calling
+     * newAssembly() (done at the start of each assembly by the models)
+     * makes every pool release the storage that was not reused during
+     * the previous assembly, which bounds the memory held by the pools
+     * to what one assembly actually needs. A pool does this when it is
+     * next used, so releaseIdle() must be called now and then (the
+     * models do it at the start of each timestep) to also trim the
+     * pools of threads that are no longer used.
+     *
+     * Pooling is disabled by default.
+     */
+    class AutoDiffMatrixPool
+    {
+    public:
+        typedef std::vector<double> DiagRep;
+        typedef Eigen::SparseMatrix<double> SparseRep;
+
+        /// Whether pooling is enabled (globally, for all threads).
+        static bool enabled()
+        {
+            return enabledFlag().load(std::memory_order_relaxed);
+        }
+
+        /// Enable or disable pooling.
+        static void setEnabled(const bool enable)
+        {
+            enabledFlag().store(enable);
+        }
+
+        /// Mark the start of a new assembly. Storage which has not been
+        /// reused since the previous call is released lazily by each
+        /// thread's pool.
+        static void newAssembly()
+        {
+            ++globalGeneration();
+        }
+
+        /// Release the storage that was not reused during the previous
+        /// assembly from the pools of all threads. Must not be called
+        /// while other threads use their pools, i.e. not from within a
+        /// parallel region.
+        static void releaseIdle()
+        {
+            std::lock_guard<std::mutex> lock(registryMutex());
+            for (AutoDiffMatrixPool* pool : registry()) {
+                pool->trim();
+            }
+        }
+
+        /// The pool of the calling thread. Returns null during thread
+        /// shutdown, after the pool has been destroyed.
+        static AutoDiffMatrixPool* local()
+        {
+            static thread_local AutoDiffMatrixPool* pool = nullptr;
+            static thread_local bool destroyed = false;
+            if (!pool && !destroyed) {
+                struct Cleanup
+                {
+                    ~Cleanup()
+                    {
+                        {
+                            std::lock_guard<std::mutex> lock(registryMutex());
+                            auto& pools = registry();
+                            pools.erase(std::remove(pools.begin(), pools.end(), pool), pools.end());
+                        }
+                        delete pool;
+                        pool = nullptr;
+                        destroyed = true;
+                    }
+                };
+                static thread_local Cleanup cleanup;
+                static_cast<void>(cleanup);
+                pool = new AutoDiffMatrixPool();
+                std::lock_guard<std::mutex> lock(registryMutex());
+                registry().push_back(pool);
+            }
+            return pool;
+        }
+
+        /// Give d storage for (at least) n elements, if the pool has
+        /// such storage. The contents of d are unspecified afterwards.
+        void acquire(const int n, DiagRep& d)
+        {
+            trim();
+            auto it = diag_.find(n);
+            if (it != diag_.end() && !it->second.empty()) {
+                d.swap(it->second.back().rep);
+                it->second.pop_back();
+                ++hits_;
+            } else {
+                ++misses_;
+            }
+        }
+
+        /// Give s storage for a rows x cols matrix, if the pool has such
+        /// storage. If nnz is positive, the smallest storage with room
+        /// for nnz nonzeros is preferred, otherwise the most recently
+        /// recycled. The contents of s are unspecified afterwards.
+        void acquire(const int rows, const int cols, SparseRep& s, const int nnz = 0)
+        {
+            trim();
+            auto it = sparse_.find(std::make_pair(rows, cols));
+            if (it != sparse_.end() && !it->second.empty()) {
+                auto& entries = it->second;
+                std::size_t best = entries.size() - 1;
+                if (nnz > 0) {
+                    for (std::size_t i = 0; i < entries.size(); ++i) {
+                        const auto size = entries[i].rep.data().allocatedSize();
+                        const auto best_size = entries[best].rep.data().allocatedSize();
+                        if (size >= nnz && (best_size < nnz || size < best_size)) {
+                            best = i;
+                        }
+                    }
+                }
+                s.swap(entries[best].rep);
+                if (best + 1 != entries.size()) {
+                    entries[best].rep.swap(entries.back().rep);
+                    entries[best].generation = entries.back().generation;
+                }
+                entries.pop_back();
+                ++hits_;
+            } else {
+                ++misses_;
+            }
+        }
+
+        /// Take over the storage of d, leaving it empty.
+        void recycle(DiagRep& d)
+        {
+            if (d.capacity() == 0) {
+                return;
+            }
+            const int n = d.size();
+            auto& entries = diag_[n];
+            entries.emplace_back();
+            entries.back().rep.swap(d);
+            entries.back().generation = generation_;
+        }
+
+        /// Take over the storage of s, leaving it empty.
+        void recycle(SparseRep& s)
+        {
+            if (s.outerSize() == 0 || s.data().allocatedSize() == 0) {
+                return;
+            }
+            auto& entries = sparse_[std::make_pair(int(s.rows()), int(s.cols()))];
+            entries.emplace_back();
+            entries.back().rep.swap(s);
+            entries.back().generation = generation_;
+        }
+
+        /// Number of requests satisfied from the pool.
+        std::size_t hits() const
+        {
+            return hits_;
+        }
+
+        /// Number of requests the pool could not satisfy.
+        std::size_t misses() const
+        {
+            return misses_;
+        }
+
+        /// Number of storage buffers held by the pool.
+        std::size_t size() const
+        {
+            std::size_t num = 0;
+            for (const auto& entries : diag_) {
+                num += entries.second.size();
+            }
+            for (const auto& entries : sparse_) {
+                num += entries.second.size();
+            }
+            return num;
+        }
+
+        /// Release all storage held by the pool.
+        void clear()
+        {
+            diag_.clear();
+            sparse_.clear();
+        }
+
+    private:
+        template <class Rep>
+        struct Entry
+        {
+            Rep rep;
+            unsigned long generation;
+        };
+
+        // A deque, since growing it must not copy the stored matrices.
+        template <class Key, class Rep>
+        using FreeList = std::map<Key, std::deque<Entry<Rep>>>;
+
+        AutoDiffMatrixPool()
+            : generation_(globalGeneration().load()),
+              hits_(0),
+              misses_(0)
+        {
+        }
+
+        static std::atomic<bool>& enabledFlag()
+        {
+            static std::atomic<bool> flag(false);
+            return flag;
+        }
+
+        static std::atomic<unsigned long>& globalGeneration()
+        {
+            static std::atomic<unsigned long> generation(0);
+            return generation;
+        }
+
+        // The pools of all threads, for releaseIdle().
+        static std::vector<AutoDiffMatrixPool*>& registry()
+        {
+            static std::vector<AutoDiffMatrixPool*> pools;
+            return pools;
+        }
+
+        static std::mutex& registryMutex()
+        {
+            static std::mutex mutex;
+            return mutex;
+        }
+
+        // Release the entries that were idle during a complete assembly.
+        void trim()
+        {
+            const unsigned long current = globalGeneration().load(std::memory_order_relaxed);
+            if (current == generation_) {
+                return;
+            }
+            trimList(diag_, current);
+            trimList(sparse_, current);
+            generation_ = current;
+        }
+
+        template <class Key, class Rep>
+        static void trimList(FreeList<Key, Rep>& list, const unsigned long current)
+        {
+            for (auto it = list.begin(); it != list.end(); ) {
+                auto& entries = it->second;
+                std::size_t keep = 0;
+                for (std::size_t i = 0; i < entries.size(); ++i) {
+                    if (entries[i].generation + 1 >= current) {
+                        if (keep != i) {
+                            entries[keep].rep.swap(entries[i].rep);
+                            entries[keep].generation = entries[i].generation;
+                        }
+                        ++keep;
+                    }
+                }
+                entries.resize(keep);
+                if (entries.empty()) {
+                    it = list.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+
+        FreeList<int, DiagRep> diag_;
+        FreeList<std::pair<int, int>, SparseRep> sparse_;
+        unsigned long generation_;
+        std::size_t hits_;
+        std::size_t misses_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_AUTODIFFMATRIXPOOL_HEADER_INCLUDED
@@ -26,6 +26,14 @@
 
 #include <opm/core/linalg/ParallelIstlInformation.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if HAVE_MPI
+#include <mpi.h>
+#endif
+
 namespace Opm {
 namespace detail {
         /// \brief Compute the L-infinity norm of a vector
@@ -81,6 +89,57 @@ namespace detail {
 #endif
             return result;
         }
+
+#if HAVE_MPI
+        /// \brief Reduction operator for sumAndMaxAllReduce(). Each element
+        ///        of the datatype is a buffer whose first entry holds the
+        ///        number of summed entries, which follow it, and the
+        ///        remaining entries are maximized. A NaN in any process
+        ///        gives a NaN maximum.
+        inline void sumAndMaxReductionOp(void* invec, void* inoutvec, int* len, MPI_Datatype* datatype)
+        {
+            int bytes = 0;
+            MPI_Type_size(*datatype, &bytes);
+            const int size = bytes / sizeof(double);
+            for (int k = 0; k < *len; ++k) {
+                const double* in = static_cast<const double*>(invec) + k*size;
+                double* inout = static_cast<double*>(inoutvec) + k*size;
+                const int num_sum = static_cast<int>(in[0]);
+                for (int i = 1; i <= num_sum; ++i) {
+                    inout[i] += in[i];
+                }
+                for (int i = num_sum + 1; i < size; ++i) {
+                    if (std::isnan(in[i]) || in[i] > inout[i]) {
+                        inout[i] = in[i];
+                    }
+                }
+            }
+        }
+
+        /// \brief Sum the first num_sum entries of values over all processes, and
+        ///        take the maximum of the others, with a single collective call.
+        /// \param info   The information about the data distribution.
+        /// \param values The local values. The first entry is reserved and
+        ///               overwritten.
+        inline void sumAndMaxAllReduce(const ParallelISTLInformation& info,
+                                       std::vector<double>& values,
+                                       const int num_sum)
+        {
+            // The buffer is reduced as a single element of a contiguous
+            // type, such that MPI cannot split it into pieces for which
+            // the number of summed entries would not be known.
+            MPI_Datatype buffer_type;
+            MPI_Type_contiguous(values.size(), MPI_DOUBLE, &buffer_type);
+            MPI_Type_commit(&buffer_type);
+            MPI_Op op;
+            MPI_Op_create(&sumAndMaxReductionOp, 1, &op);
+            values[0] = num_sum;
+            MPI_Comm comm = info.communicator();
+            MPI_Allreduce(MPI_IN_PLACE, values.data(), 1, buffer_type, op, comm);
+            MPI_Op_free(&op);
+            MPI_Type_free(&buffer_type);
+        }
+#endif
     } // namespace detail
 } // namespace Opm
 
@@ -553,7 +553,10 @@ namespace Opm {
         ///                   of B for the phase i.
         /// \param[out] maxNormWell The maximum of the well flux equations for each phase.
         /// \param[in]  nc    The number of cells of the local grid.
+        /// \param[out] maxNormWellControl If not null, the maximum of the well
+        ///                   control equations.
         /// \return The total pore volume over all cells.
+        /// In parallel runs all quantities are reduced with a single collective.
         double
         convergenceReduction(const Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>& B,
                              const Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic>& tempV,
@@ -562,7 +565,8 @@ namespace Opm {
                              std::vector<double>& maxCoeff,
                              std::vector<double>& B_avg,
                              std::vector<double>& maxNormWell,
-                             int nc) const;
+                             int nc,
+                             double* maxNormWellControl = nullptr) const;
 
         /// Set up the group control related at the beginning of each time step
         void
@@ -29,7 +29,10 @@
 #include <opm/autodiff/BlackoilLegacyDetails.hpp>
 
 #include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/AutoDiffBlockExpression.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
+#include <opm/autodiff/AutoDiffMatrixPool.hpp>
+#include <opm/autodiff/fastSparseOperations.hpp>
 #include <opm/autodiff/GridHelpers.hpp>
 #include <opm/autodiff/WellHelpers.hpp>
 #include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
@@ -157,6 +160,11 @@ typedef Eigen::Array<double,
             material_name_.push_back("Gas");
         }
 
+        if (param_.use_adb_storage_pool_) {
+            AutoDiffMatrixPool::setEnabled(true);
+        }
+        SparseKernelParallelism::setRowParallel(param_.adb_row_parallel_);
+
         assert(numMaterials() == std::accumulate(active_.begin(), active_.end(), 0)); // Due to the material_name_ init above.
 
         const double gravity = detail::getGravity(geo_.gravity(), UgGridHelpers::dimensions(grid_));
@@ -225,6 +233,12 @@ typedef Eigen::Array<double,
     {
         const double dt = timer.currentStepLength();
 
+        // Trim the jacobian storage pools of all threads, including
+        // those not used since the previous step.
+        if (param_.use_adb_storage_pool_) {
+            AutoDiffMatrixPool::releaseIdle();
+        }
+
         pvdt_ = geo_.poreVolume() / dt;
         if (active_[Gas]) {
             updatePrimalVariableFromState(reservoir_state);
@@ -561,9 +575,9 @@ typedef Eigen::Array<double,
         const V p = Eigen::Map<const V>(& x.pressure()[0], nc, 1);
         vars0.push_back(p);
 
-        // Initial saturation.
+        // Initial saturation, read in place from the interleaved state.
         assert (not x.saturation().empty());
-        const DataBlock s = Eigen::Map<const DataBlock>(& x.saturation()[0], nc, np);
+        const Eigen::Map<const DataBlock> s(& x.saturation()[0], nc, np);
         const Opm::PhaseUsage pu = fluid_.phaseUsage();
         // We do not handle a Water/Gas situation correctly, guard against it.
         assert (active_[ Oil]);
@@ -575,10 +589,9 @@ typedef Eigen::Array<double,
         if (active_[ Gas ]) {
             // define new primary variable xvar depending on solution condition
             V xvar(nc);
-            const V sg = s.col(pu.phase_pos[ Gas ]);
-            const V rs = Eigen::Map<const V>(& x.gasoilratio()[0], x.gasoilratio().size());
-            const V rv = Eigen::Map<const V>(& x.rv()[0], x.rv().size());
-            xvar = isRs_*rs + isRv_*rv + isSg_*sg;
+            const Eigen::Map<const V> rs(& x.gasoilratio()[0], x.gasoilratio().size());
+            const Eigen::Map<const V> rv(& x.rv()[0], x.rv().size());
+            xvar = isRs_*rs + isRv_*rv + isSg_*s.col(pu.phase_pos[ Gas ]);
             vars0.push_back(xvar);
         }
     }
@@ -729,7 +742,7 @@ typedef Eigen::Array<double,
             if (active_[ phase ]) {
                 const int pos = pu.phase_pos[ phase ];
                 sd_.rq[pos].b = asImpl().fluidReciprocFVF(phase, state.canonical_phase_pressures[phase], temp, rs, rv, cond);
-                sd_.rq[pos].accum[aix] = pv_mult * sd_.rq[pos].b * sat[pos];
+                sd_.rq[pos].accum[aix] = fusedEval(lazy(pv_mult) * sd_.rq[pos].b * sat[pos]);
                 // OPM_AD_DUMP(sd_.rq[pos].b);
                 // OPM_AD_DUMP(sd_.rq[pos].accum[aix]);
             }
@@ -765,6 +778,12 @@ typedef Eigen::Array<double,
 
         SimulatorReport report;
 
+        // Let the jacobian storage pools release what was not
+        // reused during the previous assembly.
+        if (param_.use_adb_storage_pool_) {
+            AutoDiffMatrixPool::newAssembly();
+        }
+
         // If we have VFP tables, we need the well connection
         // pressures for the "simple" hydrostatic correction
         // between well depth and vfp table depth.
@@ -876,9 +895,11 @@ typedef Eigen::Array<double,
             sd_.rq[phaseIdx].rho = asImpl().fluidDensity(canph_[phaseIdx], sd_.rq[phaseIdx].b, state.rs, state.rv);
             asImpl().computeMassFlux(phaseIdx, trans_all, sd_.rq[phaseIdx].kr, sd_.rq[phaseIdx].mu, sd_.rq[phaseIdx].rho, state.canonical_phase_pressures[canph_[phaseIdx]], state);
 
+            // Evaluated as one fused expression, so that each jacobian
+            // block of the residual is written only once.
             residual_.material_balance_eq[ phaseIdx ] =
-                pvdt_ * (sd_.rq[phaseIdx].accum[1] - sd_.rq[phaseIdx].accum[0])
-                + ops_.div*sd_.rq[phaseIdx].mflux;
+                fusedEval(pvdt_ * (lazy(sd_.rq[phaseIdx].accum[1]) - sd_.rq[phaseIdx].accum[0])
+                          + ops_.product(ops_.div, sd_.rq[phaseIdx].mflux));
         }
 
         // -------- Extra (optional) rs and rv contributions to the mass balance equations --------
@@ -898,8 +919,8 @@ typedef Eigen::Array<double,
                                                 sd_.rq[pg].dh.value());
             const ADB rv_face = upwindGas.select(state.rv);
 
-            residual_.material_balance_eq[ pg ] += ops_.div * (rs_face * sd_.rq[po].mflux);
-            residual_.material_balance_eq[ po ] += ops_.div * (rv_face * sd_.rq[pg].mflux);
+            residual_.material_balance_eq[ pg ] += ops_.product(ops_.div, rs_face * sd_.rq[po].mflux);
+            residual_.material_balance_eq[ po ] += ops_.product(ops_.div, rv_face * sd_.rq[pg].mflux);
 
             // OPM_AD_DUMP(residual_.material_balance_eq[ Gas ]);
 
@@ -1184,7 +1205,7 @@ typedef Eigen::Array<double,
 
         // Saturation updates.
         const Opm::PhaseUsage& pu = fluid_.phaseUsage();
-        const DataBlock s_old = Eigen::Map<const DataBlock>(& reservoir_state.saturation()[0], nc, np);
+        const Eigen::Map<const DataBlock> s_old(& reservoir_state.saturation()[0], nc, np);
         const double dsmax = dsMax();
 
         V so;
@@ -1212,21 +1233,15 @@ typedef Eigen::Array<double,
             step = step.min(1.);
 
             if (active_[Water]) {
-                const int pos = pu.phase_pos[ Water ];
-                const V sw_old = s_old.col(pos);
-                sw = sw_old - step * dsw;
+                sw = s_old.col(pu.phase_pos[ Water ]) - step * dsw;
             }
 
             if (active_[Gas]) {
-                const int pos = pu.phase_pos[ Gas ];
-                const V sg_old = s_old.col(pos);
-                sg = sg_old - step * dsg;
+                sg = s_old.col(pu.phase_pos[ Gas ]) - step * dsg;
             }
 
             assert(active_[Oil]);
-            const int pos = pu.phase_pos[ Oil ];
-            const V so_old = s_old.col(pos);
-            so = so_old - step * dso;
+            so = s_old.col(pu.phase_pos[ Oil ]) - step * dso;
         }
 
         if (active_[Gas]) {
@@ -1355,23 +1370,18 @@ typedef Eigen::Array<double,
             //rv = rv.min(rvSat);
         }
 
-        // Update the reservoir_state
+        // Update the reservoir_state. Note that this overwrites s_old.
+        Eigen::Map<DataBlock> s_new(& reservoir_state.saturation()[0], nc, np);
         if (active_[Water]) {
-            for (int c = 0; c < nc; ++c) {
-                reservoir_state.saturation()[c*np + pu.phase_pos[ Water ]] = sw[c];
-            }
+            s_new.col(pu.phase_pos[ Water ]) = sw;
         }
 
         if (active_[Gas]) {
-            for (int c = 0; c < nc; ++c) {
-                reservoir_state.saturation()[c*np + pu.phase_pos[ Gas ]] = sg[c];
-            }
+            s_new.col(pu.phase_pos[ Gas ]) = sg;
         }
 
         if (active_[ Oil ]) {
-            for (int c = 0; c < nc; ++c) {
-                reservoir_state.saturation()[c*np + pu.phase_pos[ Oil ]] = so[c];
-            }
+            s_new.col(pu.phase_pos[ Oil ]) = so;
         }
 
         if (has_disgas_) {
@@ -1497,7 +1507,7 @@ typedef Eigen::Array<double,
         sd_.rq[ actph ].mob = tr_mult * kr / mu;
 
         // Compute head differentials. Gravity potential is done using the face average as in eclipse and MRST.
-        const ADB rhoavg = ops_.caver * rho;
+        const ADB rhoavg = ops_.product(ops_.caver, rho);
         sd_.rq[ actph ].dh = ops_.ngrad * phasePressure - geo_.gravity()[2] * (rhoavg * (ops_.ngrad * geo_.z().matrix()));
         if (use_threshold_pressure_) {
             applyThresholdPressures(sd_.rq[ actph ].dh);
@@ -1640,7 +1650,8 @@ typedef Eigen::Array<double,
                          std::vector<double>& maxCoeff,
                          std::vector<double>& B_avg,
                          std::vector<double>& maxNormWell,
-                         int nc) const
+                         int nc,
+                         double* maxNormWellControl) const
     {
         const int np = asImpl().numPhases();
         const int nm = asImpl().numMaterials();
@@ -1654,38 +1665,61 @@ typedef Eigen::Array<double,
             const ParallelISTLInformation& info =
                 boost::any_cast<const ParallelISTLInformation&>(linsolver_.parallelInformation());
 
-            // Compute the global number of cells and porevolume
-            std::vector<int> v(nc, 1);
-            auto nc_and_pv = std::tuple<int, double>(0, 0.0);
-            auto nc_and_pv_operators = std::make_tuple(Opm::Reduction::makeGlobalSumFunctor<int>(),
-                                                        Opm::Reduction::makeGlobalSumFunctor<double>());
-            auto nc_and_pv_containers  = std::make_tuple(v, geo_.poreVolume());
-            info.computeReduction(nc_and_pv_containers, nc_and_pv_operators, nc_and_pv);
+            // All quantities are reduced with a single collective: the
+            // buffer holds the reserved entry, the sums (number of cells,
+            // pore volume, B and R for each material), and the maxima
+            // (tempV for each material, well flux norm for each phase and
+            // the well control norm).
+            const int num_sum = 2 + 2*nm;
+            std::vector<double> buffer(1 + num_sum + nm + np + 1, 0.0);
+            double* const sums = buffer.data() + 1;
+            double* const maxima = sums + num_sum;
+            std::fill(maxima, buffer.data() + buffer.size(), -std::numeric_limits<double>::max());
+
+            info.updateOwnerMask(geo_.poreVolume());
+            const std::vector<double>& mask = info.getOwnerMask();
+            const V& pv = geo_.poreVolume();
+            for (int cell = 0; cell < nc; ++cell) {
+                if (mask[cell] == 0.0) {
+                    continue;
+                }
+                sums[0] += 1.0;
+                sums[1] += pv[cell];
+                for (int idx = 0; idx < nm; ++idx) {
+                    sums[2 + idx] += B(cell, idx);
+                    sums[2 + nm + idx] += R(cell, idx);
+                    maxima[idx] = std::max(maxima[idx], tempV(cell, idx));
+                }
+            }
+            assert(nm >= np);
+            for (int idx = 0; idx < np; ++idx) {
+                maxima[nm + idx] = 0.0;
+                for ( int w = 0; w < nw; ++w ) {
+                    maxima[nm + idx] = std::max(maxima[nm + idx], std::abs(residual_.well_flux_eq.value()[nw*idx + w]));
+                }
+            }
+            if (residual_.well_eq.value().size() > 0) {
+                maxima[nm + np] = residual_.well_eq.value().matrix().template lpNorm<Eigen::Infinity>();
+            } else {
+                maxima[nm + np] = 0.0;
+            }
+
+            detail::sumAndMaxAllReduce(info, buffer, num_sum);
 
             for ( int idx = 0; idx < nm; ++idx )
             {
-                auto values     = std::tuple<double,double,double>(0.0 ,0.0 ,0.0);
-                auto containers = std::make_tuple(B.col(idx),
-                                                  tempV.col(idx),
-                                                  R.col(idx));
-                auto operators  = std::make_tuple(Opm::Reduction::makeGlobalSumFunctor<double>(),
-                                                  Opm::Reduction::makeGlobalMaxFunctor<double>(),
-                                                  Opm::Reduction::makeGlobalSumFunctor<double>());
-                info.computeReduction(containers, operators, values);
-                B_avg[idx]       = std::get<0>(values)/std::get<0>(nc_and_pv);
-                maxCoeff[idx]    = std::get<1>(values);
-                R_sum[idx]       = std::get<2>(values);
-                assert(nm >= np);
+                B_avg[idx]       = sums[2 + idx]/sums[0];
+                maxCoeff[idx]    = maxima[idx];
+                R_sum[idx]       = sums[2 + nm + idx];
                 if (idx < np) {
-                    maxNormWell[idx] = 0.0;
-                    for ( int w = 0; w < nw; ++w ) {
-                        maxNormWell[idx]  = std::max(maxNormWell[idx], std::abs(residual_.well_flux_eq.value()[nw*idx + w]));
-                    }
+                    maxNormWell[idx] = maxima[nm + idx];
                 }
             }
-            info.communicator().max(maxNormWell.data(), np);
+            if (maxNormWellControl) {
+                *maxNormWellControl = maxima[nm + np];
+            }
             // Compute pore volume
-            return std::get<1>(nc_and_pv);
+            return sums[1];
         }
         else
 #endif
@@ -1708,6 +1742,9 @@ typedef Eigen::Array<double,
                     }
                 }
             }
+            if (maxNormWellControl) {
+                *maxNormWellControl = detail::infinityNormWell(residual_.well_eq, boost::any());
+            }
             // Compute total pore volume
             return geo_.poreVolume().sum();
         }
@@ -1751,9 +1788,10 @@ typedef Eigen::Array<double,
             tempV.col(idx)   = R.col(idx).abs()/pv;
         }
 
+        double residualWell = 0.0;
         const double pvSum = convergenceReduction(B, tempV, R,
                                                   R_sum, maxCoeff, B_avg, maxNormWell,
-                                                  nc);
+                                                  nc, &residualWell);
 
         std::vector<double> CNV(nm);
         std::vector<double> mass_balance_residual(nm);
@@ -1778,8 +1816,6 @@ typedef Eigen::Array<double,
             }
         }
 
-        const double residualWell     = detail::infinityNormWell(residual_.well_eq,
-                                                                 linsolver_.parallelInformation());
         converged_Well = converged_Well && (residualWell < tol_well_control);
 
         const bool converged = converged_MB && converged_CNV && converged_Well;
@@ -1888,7 +1924,8 @@ typedef Eigen::Array<double,
             tempV.col(idx)   = R.col(idx).abs()/pv;
         }
 
-        convergenceReduction(B, tempV, R, R_sum, maxCoeff, B_avg, maxNormWell, nc);
+        double residualWell = 0.0;
+        convergenceReduction(B, tempV, R, R_sum, maxCoeff, B_avg, maxNormWell, nc, &residualWell);
 
         std::vector<double> well_flux_residual(np);
         bool converged_Well = true;
@@ -1899,8 +1936,6 @@ typedef Eigen::Array<double,
             converged_Well = converged_Well && (well_flux_residual[idx] < tol_wells);
         }
 
-        const double residualWell     = detail::infinityNormWell(residual_.well_eq,
-                                                                 linsolver_.parallelInformation());
         converged_Well = converged_Well && (residualWell < tol_well_control);
 
         const bool converged = converged_Well;
@@ -2158,11 +2193,11 @@ typedef Eigen::Array<double,
         const int np = state.numPhases();
 
         const PhaseUsage& pu = fluid_.phaseUsage();
-        const DataBlock s = Eigen::Map<const DataBlock>(& state.saturation()[0], nc, np);
+        const Eigen::Map<const DataBlock> s(& state.saturation()[0], nc, np);
         if (active_[ Gas ]) {
             // Oil/Gas or Water/Oil/Gas system
-            const V so = s.col(pu.phase_pos[ Oil ]);
-            const V sg = s.col(pu.phase_pos[ Gas ]);
+            const auto so = s.col(pu.phase_pos[ Oil ]);
+            const auto sg = s.col(pu.phase_pos[ Gas ]);
 
             for (V::Index c = 0, e = sg.size(); c != e; ++c) {
                 if (so[c] > 0)        { phaseCondition_[c].setFreeOil  (); }
@@ -2174,7 +2209,7 @@ typedef Eigen::Array<double,
             // Water/Oil system
             assert (active_[ Water ]);
 
-            const V so = s.col(pu.phase_pos[ Oil ]);
+            const auto so = s.col(pu.phase_pos[ Oil ]);
 
 
             for (V::Index c = 0, e = so.size(); c != e; ++c) {
@@ -2266,7 +2301,7 @@ typedef Eigen::Array<double,
         using namespace Opm::AutoDiffGrid;
         const int nc = numCells(grid_);
         std::vector<ADB> saturation(3, ADB::null());
-        const DataBlock s = Eigen::Map<const DataBlock>(& x.saturation()[0], nc, x.numPhases());
+        const Eigen::Map<const DataBlock> s(& x.saturation()[0], nc, x.numPhases());
         const ADB pressure    = ADB::constant(Eigen::Map<const V>(& x.pressure()[0], nc, 1));
         const ADB temperature = ADB::constant(Eigen::Map<const V>(& x.temperature()[0], nc, 1));
         saturation[Water] = active_[Water] ? ADB::constant(s.col(Water)) : ADB::null();
@@ -68,6 +68,8 @@ namespace Opm
         deck_file_name_ = param.template get<std::string>("deck_filename");
         matrix_add_well_contributions_ = param.getDefault("matrix_add_well_contributions", matrix_add_well_contributions_);
         preconditioner_add_well_contributions_ = param.getDefault("preconditioner_add_well_contributions", preconditioner_add_well_contributions_);
+        use_adb_storage_pool_ = param.getDefault("use_adb_storage_pool", use_adb_storage_pool_);
+        adb_row_parallel_ = param.getDefault("adb_row_parallel", adb_row_parallel_);
     }
 
 
@@ -99,6 +101,8 @@ namespace Opm
         use_multisegment_well_ = false;
         matrix_add_well_contributions_ = false;
         preconditioner_add_well_contributions_ = false;
+        use_adb_storage_pool_ = false;
+        adb_row_parallel_ = false;
     }
 
 
@@ -99,6 +99,15 @@ namespace Opm
         // Whether to add influences of wells between cells to the preconditioner matrix only
         bool preconditioner_add_well_contributions_;
 
+        /// Whether to recycle the storage of AutoDiffMatrix temporaries
+        /// between Newton iterations (see AutoDiffMatrixPool). Off by default.
+        bool use_adb_storage_pool_;
+
+        /// Whether the OpenMP threads of the AutoDiffBlock operations
+        /// partition the rows of each jacobian block instead of the
+        /// blocks (see SparseKernelParallelism).
+        bool adb_row_parallel_;
+
         /// Construct from user parameters or defaults.
         explicit BlackoilModelParameters( const ParameterGroup& param );
 
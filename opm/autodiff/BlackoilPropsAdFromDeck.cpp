@@ -45,6 +45,37 @@ namespace Opm
     typedef BlackoilPropsAdFromDeck::V V;
     typedef Eigen::Array<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> Block;
 
+    namespace {
+        // Quantity q of a PVT evaluation as an ADB, with the jacobians
+        // from the chain rule through the pressure and, if given, the
+        // dissolution factor.
+        ADB pvtQuantity(const PvtEvaluationCache::Result& result,
+                        const int q,
+                        const ADB& p,
+                        const ADB* r)
+        {
+            const int n = result.size();
+            V value = Eigen::Map<const V>(result.value(q), n);
+            const V dp = Eigen::Map<const V>(result.dp(q), n);
+            ADB::M dp_diag(dp.matrix().asDiagonal());
+            const int num_blocks = p.numBlocks();
+            std::vector<ADB::M> jacs(num_blocks);
+            for (int block = 0; block < num_blocks; ++block) {
+                fastSparseProduct(dp_diag, p.derivative()[block], jacs[block]);
+            }
+            if (r) {
+                const V dr = Eigen::Map<const V>(result.dr(q), n);
+                ADB::M dr_diag(dr.matrix().asDiagonal());
+                for (int block = 0; block < num_blocks; ++block) {
+                    ADB::M temp;
+                    fastSparseProduct(dr_diag, r->derivative()[block], temp);
+                    jacs[block] += temp;
+                }
+            }
+            return ADB::function(std::move(value), std::move(jacs));
+        }
+    } // anonymous namespace
+
     /// Constructor wrapping an opm-core black oil interface.
     BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const Opm::Deck& deck,
                                                      const Opm::EclipseState& eclState,
@@ -268,41 +299,12 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Water]) {
             OPM_THROW(std::runtime_error, "Cannot call muWat(): water phase not active.");
         }
-        const int n = cells.size();
-        assert(pw.size() == n);
-
-        V mu(n);
-        V dmudp(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-
-        pEval.setDerivative(0, 1.0);
-
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pw.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            const Eval& muEval = FluidSystem::waterPvt().viscosity(pvtRegionIdx, TEval, pEval);
-
-            mu[i] = muEval.value();
-            dmudp[i] = muEval.derivative(0);
-        }
-
+        const PvtEvaluationCache::Result& result = waterPvt(pw, T, cells);
         if (pw.derivative().empty()) {
+            V mu = Eigen::Map<const V>(result.value(Viscosity), result.size());
             return ADB::constant(std::move(mu));
-        } else {
-            ADB::M dmudp_diag(dmudp.matrix().asDiagonal());
-            const int num_blocks = pw.numBlocks();
-            std::vector<ADB::M> jacs(num_blocks);
-            for (int block = 0; block < num_blocks; ++block) {
-                fastSparseProduct(dmudp_diag, pw.derivative()[block], jacs[block]);
-            }
-            return ADB::function(std::move(mu), std::move(jacs));
         }
+        return pvtQuantity(result, Viscosity, pw, nullptr);
     }
 
     /// Oil viscosity.
@@ -321,55 +323,8 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Oil]) {
             OPM_THROW(std::runtime_error, "Cannot call muOil(): oil phase not active.");
         }
-        const int n = cells.size();
-        assert(po.size() == n);
-        V mu(n);
-        V dmudp(n);
-        V dmudr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-        Eval RsEval = 0.0;
-
-        pEval.setDerivative(0, 1.0);
-        RsEval.setDerivative(1, 1.0);
-
-        Eval muEval;
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(po.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            if (cond[i].hasFreeGas()) {
-                muEval = FluidSystem::oilPvt().saturatedViscosity(pvtRegionIdx, TEval, pEval);
-            }
-            else {
-                if (phase_usage_.phase_used[Gas]) {
-                    RsEval.setValue(rs.value()[i]);
-                }
-                muEval = FluidSystem::oilPvt().viscosity(pvtRegionIdx, TEval, pEval, RsEval);
-            }
-
-            mu[i] = muEval.value();
-            dmudp[i] = muEval.derivative(0);
-            dmudr[i] = muEval.derivative(1);
-        }
-
-        ADB::M dmudp_diag(dmudp.matrix().asDiagonal());
-        ADB::M dmudr_diag(dmudr.matrix().asDiagonal());
-        const int num_blocks = po.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dmudp_diag, po.derivative()[block], jacs[block]);
-            if (phase_usage_.phase_used[Gas]) {
-                ADB::M temp;
-                fastSparseProduct(dmudr_diag, rs.derivative()[block], temp);
-                jacs[block] += temp;
-            }
-        }
-        return ADB::function(std::move(mu), std::move(jacs));
+        const PvtEvaluationCache::Result& result = oilPvt(po, T, rs, cond, cells);
+        return pvtQuantity(result, Viscosity, po, phase_usage_.phase_used[Gas] ? &rs : nullptr);
     }
 
     /// Gas viscosity.
@@ -388,51 +343,8 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Gas]) {
             OPM_THROW(std::runtime_error, "Cannot call muGas(): gas phase not active.");
         }
-        const int n = cells.size();
-        assert(pg.value().size() == n);
-        V mu(n);
-        V dmudp(n);
-        V dmudr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-        Eval RvEval = 0.0;
-        Eval muEval;
-
-        pEval.setDerivative(0, 1.0);
-        RvEval.setDerivative(1, 1.0);
-
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pg.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            if (cond[i].hasFreeOil()) {
-                muEval = FluidSystem::gasPvt().saturatedViscosity(pvtRegionIdx, TEval, pEval);
-            }
-            else {
-                RvEval.setValue(rv.value()[i]);
-                muEval = FluidSystem::gasPvt().viscosity(pvtRegionIdx, TEval, pEval, RvEval);
-            }
-
-            mu[i] = muEval.value();
-            dmudp[i] = muEval.derivative(0);
-            dmudr[i] = muEval.derivative(1);
-        }
-
-        ADB::M dmudp_diag(dmudp.matrix().asDiagonal());
-        ADB::M dmudr_diag(dmudr.matrix().asDiagonal());
-        const int num_blocks = pg.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dmudp_diag, pg.derivative()[block], jacs[block]);
-            ADB::M temp;
-            fastSparseProduct(dmudr_diag, rv.derivative()[block], temp);
-            jacs[block] += temp;
-        }
-        return ADB::function(std::move(mu), std::move(jacs));
+        const PvtEvaluationCache::Result& result = gasPvt(pg, T, rv, cond, cells);
+        return pvtQuantity(result, Viscosity, pg, &rv);
     }
 
 
@@ -451,37 +363,8 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Water]) {
             OPM_THROW(std::runtime_error, "Cannot call bWat(): water phase not active.");
         }
-        const int n = cells.size();
-        assert(pw.size() == n);
-
-        V b(n);
-        V dbdp(n);
-        V dbdr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-
-        pEval.setDerivative(0, 1.0);
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pw.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            const Eval& bEval = FluidSystem::waterPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
-
-            b[i] = bEval.value();
-            dbdp[i] = bEval.derivative(0);
-        }
-
-        ADB::M dbdp_diag(dbdp.matrix().asDiagonal());
-        const int num_blocks = pw.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dbdp_diag, pw.derivative()[block], jacs[block]);
-        }
-        return ADB::function(std::move(b), std::move(jacs));
+        const PvtEvaluationCache::Result& result = waterPvt(pw, T, cells);
+        return pvtQuantity(result, InverseFvf, pw, nullptr);
     }
 
     /// Oil formation volume factor.
@@ -500,61 +383,8 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Oil]) {
             OPM_THROW(std::runtime_error, "Cannot call bOil(): oil phase not active.");
         }
-        const int n = cells.size();
-        assert(po.size() == n);
-
-        V b(n);
-        V dbdp(n);
-        V dbdr(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
-
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-        Eval RsEval = 0.0;
-        Eval bEval;
-
-        pEval.setDerivative(0, 1.0);
-        RsEval.setDerivative(1, 1.0);
-
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(po.value()[i]);
-            TEval.setValue(T.value()[i]);
-
-            //RS/RV only makes sense when gas phase is active
-            if (cond[i].hasFreeGas()) {
-                bEval = FluidSystem::oilPvt().saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
-            }
-            else {
-                if (rs.size() == 0) {
-                    RsEval.setValue(0.0);
-                }
-                else {
-                    RsEval.setValue(rs.value()[i]);
-                }
-                bEval = FluidSystem::oilPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RsEval);
-            }
-
-            b[i] = bEval.value();
-            dbdp[i] = bEval.derivative(0);
-            dbdr[i] = bEval.derivative(1);
-        }
-
-        ADB::M dbdp_diag(dbdp.matrix().asDiagonal());
-        ADB::M dbdr_diag(dbdr.matrix().asDiagonal());
-        const int num_blocks = po.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dbdp_diag, po.derivative()[block], jacs[block]);
-            if (phase_usage_.phase_used[Gas]) {
-                ADB::M temp;
-                fastSparseProduct(dbdr_diag, rs.derivative()[block], temp);
-                jacs[block] += temp;
-            }
-        }
-        return ADB::function(std::move(b), std::move(jacs));
+        const PvtEvaluationCache::Result& result = oilPvt(po, T, rs, cond, cells);
+        return pvtQuantity(result, InverseFvf, po, phase_usage_.phase_used[Gas] ? &rs : nullptr);
     }
 
     /// Gas formation volume factor.
@@ -573,52 +403,164 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         if (!phase_usage_.phase_used[Gas]) {
             OPM_THROW(std::runtime_error, "Cannot call bGas(): gas phase not active.");
         }
-        const int n = cells.size();
-        assert(pg.size() == n);
+        const PvtEvaluationCache::Result& result = gasPvt(pg, T, rv, cond, cells);
+        return pvtQuantity(result, InverseFvf, pg, &rv);
+    }
 
-        V b(n);
-        V dbdp(n);
-        V dbdr(n);
 
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
 
-        Eval pEval = 0.0;
-        Eval TEval = 0.0;
-        Eval RvEval = 0.0;
-        Eval bEval;
+    // ------ Evaluation of the PVT functions ------
 
-        pEval.setDerivative(0, 1.0);
-        RvEval.setDerivative(1, 1.0);
 
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pg.value()[i]);
-            TEval.setValue(T.value()[i]);
+    const PvtEvaluationCache::Result&
+    BlackoilPropsAdFromDeck::waterPvt(const ADB& pw,
+                                      const ADB& T,
+                                      const Cells& cells) const
+    {
+        assert(pw.size() == int(cells.size()));
+        const auto evaluate = [&](PvtEvaluationCache::Result& result)
+        {
+            typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
 
-            if (cond[i].hasFreeOil()) {
-                bEval = FluidSystem::gasPvt().saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
-            }
-            else {
-                RvEval.setValue(rv.value()[i]);
-                bEval = FluidSystem::gasPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RvEval);
+            Eval pEval = 0.0;
+            Eval TEval = 0.0;
+
+            pEval.setDerivative(0, 1.0);
+
+            const int n = cells.size();
+            for (int i = 0; i < n; ++i) {
+                unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
+                pEval.setValue(pw.value()[i]);
+                TEval.setValue(T.value()[i]);
+
+                const Eval& bEval = FluidSystem::waterPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                const Eval& muEval = FluidSystem::waterPvt().viscosity(pvtRegionIdx, TEval, pEval);
+
+                result.value(InverseFvf)[i] = bEval.value();
+                result.dp(InverseFvf)[i] = bEval.derivative(0);
+                result.value(Viscosity)[i] = muEval.value();
+                result.dp(Viscosity)[i] = muEval.derivative(0);
             }
+        };
+        return waterPvtCache_.evaluate(cells, pw.value().data(), T.value().data(),
+                                       nullptr, std::vector<char>(), evaluate);
+    }
+
 
-            b[i] = bEval.value();
-            dbdp[i] = bEval.derivative(0);
-            dbdr[i] = bEval.derivative(1);
+
+    const PvtEvaluationCache::Result&
+    BlackoilPropsAdFromDeck::oilPvt(const ADB& po,
+                                    const ADB& T,
+                                    const ADB& rs,
+                                    const std::vector<PhasePresence>& cond,
+                                    const Cells& cells) const
+    {
+        const int n = cells.size();
+        assert(po.size() == n);
+
+        // RS only makes sense when the gas phase is active.
+        const double* rsValue = (phase_usage_.phase_used[Gas] && rs.size() != 0) ? rs.value().data() : nullptr;
+        std::vector<char> saturated(n);
+        for (int i = 0; i < n; ++i) {
+            saturated[i] = cond[i].hasFreeGas();
         }
 
-        ADB::M dbdp_diag(dbdp.matrix().asDiagonal());
-        ADB::M dbdr_diag(dbdr.matrix().asDiagonal());
-        const int num_blocks = pg.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(dbdp_diag, pg.derivative()[block], jacs[block]);
-            ADB::M temp;
-            fastSparseProduct(dbdr_diag, rv.derivative()[block], temp);
-            jacs[block] += temp;
+        const auto evaluate = [&](PvtEvaluationCache::Result& result)
+        {
+            typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
+
+            Eval pEval = 0.0;
+            Eval TEval = 0.0;
+            Eval RsEval = 0.0;
+            Eval bEval;
+            Eval muEval;
+
+            pEval.setDerivative(0, 1.0);
+            RsEval.setDerivative(1, 1.0);
+
+            for (int i = 0; i < n; ++i) {
+                unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
+                pEval.setValue(po.value()[i]);
+                TEval.setValue(T.value()[i]);
+
+                if (saturated[i]) {
+                    bEval = FluidSystem::oilPvt().saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                    muEval = FluidSystem::oilPvt().saturatedViscosity(pvtRegionIdx, TEval, pEval);
+                }
+                else {
+                    RsEval.setValue(rsValue ? rsValue[i] : 0.0);
+                    bEval = FluidSystem::oilPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RsEval);
+                    muEval = FluidSystem::oilPvt().viscosity(pvtRegionIdx, TEval, pEval, RsEval);
+                }
+
+                result.value(InverseFvf)[i] = bEval.value();
+                result.dp(InverseFvf)[i] = bEval.derivative(0);
+                result.dr(InverseFvf)[i] = bEval.derivative(1);
+                result.value(Viscosity)[i] = muEval.value();
+                result.dp(Viscosity)[i] = muEval.derivative(0);
+                result.dr(Viscosity)[i] = muEval.derivative(1);
+            }
+        };
+        return oilPvtCache_.evaluate(cells, po.value().data(), T.value().data(),
+                                     rsValue, saturated, evaluate);
+    }
+
+
+
+    const PvtEvaluationCache::Result&
+    BlackoilPropsAdFromDeck::gasPvt(const ADB& pg,
+                                    const ADB& T,
+                                    const ADB& rv,
+                                    const std::vector<PhasePresence>& cond,
+                                    const Cells& cells) const
+    {
+        const int n = cells.size();
+        assert(pg.size() == n);
+
+        const double* rvValue = (rv.size() != 0) ? rv.value().data() : nullptr;
+        std::vector<char> saturated(n);
+        for (int i = 0; i < n; ++i) {
+            saturated[i] = cond[i].hasFreeOil();
         }
-        return ADB::function(std::move(b), std::move(jacs));
+
+        const auto evaluate = [&](PvtEvaluationCache::Result& result)
+        {
+            typedef Opm::DenseAd::Evaluation<double, /*size=*/2> Eval;
+
+            Eval pEval = 0.0;
+            Eval TEval = 0.0;
+            Eval RvEval = 0.0;
+            Eval bEval;
+            Eval muEval;
+
+            pEval.setDerivative(0, 1.0);
+            RvEval.setDerivative(1, 1.0);
+
+            for (int i = 0; i < n; ++i) {
+                unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
+                pEval.setValue(pg.value()[i]);
+                TEval.setValue(T.value()[i]);
+
+                if (saturated[i]) {
+                    bEval = FluidSystem::gasPvt().saturatedInverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval);
+                    muEval = FluidSystem::gasPvt().saturatedViscosity(pvtRegionIdx, TEval, pEval);
+                }
+                else {
+                    RvEval.setValue(rvValue ? rvValue[i] : 0.0);
+                    bEval = FluidSystem::gasPvt().inverseFormationVolumeFactor(pvtRegionIdx, TEval, pEval, RvEval);
+                    muEval = FluidSystem::gasPvt().viscosity(pvtRegionIdx, TEval, pEval, RvEval);
+                }
+
+                result.value(InverseFvf)[i] = bEval.value();
+                result.dp(InverseFvf)[i] = bEval.derivative(0);
+                result.dr(InverseFvf)[i] = bEval.derivative(1);
+                result.value(Viscosity)[i] = muEval.value();
+                result.dp(Viscosity)[i] = muEval.derivative(0);
+                result.dr(Viscosity)[i] = muEval.derivative(1);
+            }
+        };
+        return gasPvtCache_.evaluate(cells, pg.value().data(), T.value().data(),
+                                     rvValue, saturated, evaluate);
     }
 
 
@@ -637,33 +579,29 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         }
         const int n = cells.size();
         assert(po.size() == n);
-        V rbub(n);
-        V drbubdp(n);
-
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
 
-        Eval pEval = 0.0;
-        Eval TEval = 293.15; // temperature is not supported by this API!
+        const auto evaluate = [&](PvtEvaluationCache::Result& result)
+        {
+            typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
 
-        pEval.setDerivative(0, 1.0);
+            Eval pEval = 0.0;
+            Eval TEval = 293.15; // temperature is not supported by this API!
 
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(po.value()[i]);
+            pEval.setDerivative(0, 1.0);
 
-            const Eval& RsEval = FluidSystem::oilPvt().saturatedGasDissolutionFactor(pvtRegionIdx, TEval, pEval);
+            for (int i = 0; i < n; ++i) {
+                unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
+                pEval.setValue(po.value()[i]);
 
-            rbub[i] = RsEval.value();
-            drbubdp[i] = RsEval.derivative(0);
-        }
+                const Eval& RsEval = FluidSystem::oilPvt().saturatedGasDissolutionFactor(pvtRegionIdx, TEval, pEval);
 
-        ADB::M drbubdp_diag(drbubdp.matrix().asDiagonal());
-        const int num_blocks = po.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(drbubdp_diag, po.derivative()[block], jacs[block]);
-        }
-        return ADB::function(std::move(rbub), std::move(jacs));
+                result.value(0)[i] = RsEval.value();
+                result.dp(0)[i] = RsEval.derivative(0);
+            }
+        };
+        const PvtEvaluationCache::Result& result =
+            rsSatCache_.evaluate(cells, po.value().data(), nullptr, nullptr, std::vector<char>(), evaluate);
+        return pvtQuantity(result, 0, po, nullptr);
     }
 
     /// Bubble point curve for Rs as function of oil pressure.
@@ -694,33 +632,29 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
         }
         const int n = cells.size();
         assert(pg.size() == n);
-        V rv(n);
-        V drvdp(n);
 
-        typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
+        const auto evaluate = [&](PvtEvaluationCache::Result& result)
+        {
+            typedef Opm::DenseAd::Evaluation<double, /*size=*/1> Eval;
 
-        Eval pEval = 0.0;
-        Eval TEval = 293.15; // temperature is not supported by this API!
+            Eval pEval = 0.0;
+            Eval TEval = 293.15; // temperature is not supported by this API!
 
-        pEval.setDerivative(0, 1.0);
+            pEval.setDerivative(0, 1.0);
 
-        for (int i = 0; i < n; ++i) {
-            unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
-            pEval.setValue(pg.value()[i]);
+            for (int i = 0; i < n; ++i) {
+                unsigned pvtRegionIdx = cellPvtRegionIdx_[cells[i]];
+                pEval.setValue(pg.value()[i]);
 
-            const Eval& RvEval = FluidSystem::gasPvt().saturatedOilVaporizationFactor(pvtRegionIdx, TEval, pEval);
+                const Eval& RvEval = FluidSystem::gasPvt().saturatedOilVaporizationFactor(pvtRegionIdx, TEval, pEval);
 
-            rv[i] = RvEval.value();
-            drvdp[i] = RvEval.derivative(0);
-        }
-
-        ADB::M drvdp_diag(drvdp.matrix().asDiagonal());
-        const int num_blocks = pg.numBlocks();
-        std::vector<ADB::M> jacs(num_blocks);
-        for (int block = 0; block < num_blocks; ++block) {
-            fastSparseProduct(drvdp_diag, pg.derivative()[block], jacs[block]);
-        }
-        return ADB::function(std::move(rv), std::move(jacs));
+                result.value(0)[i] = RvEval.value();
+                result.dp(0)[i] = RvEval.derivative(0);
+            }
+        };
+        const PvtEvaluationCache::Result& result =
+            rvSatCache_.evaluate(cells, pg.value().data(), nullptr, nullptr, std::vector<char>(), evaluate);
+        return pvtQuantity(result, 0, pg, nullptr);
     }
 
     /// Condensation curve for Rv as function of oil pressure.
@@ -768,9 +702,10 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
             assert(sg.value().size() == n);
             s_all.col(phase_usage_.phase_pos[Gas]) = sg.value();
         }
-        Block kr(n, np);
-        Block dkr(n, np*np);
-        satprops_->relperm(n, s_all.data(), cells.data(), kr.data(), dkr.data());
+        // Column-major, so that each relperm and derivative is contiguous.
+        Eigen::ArrayXXd kr(n, np);
+        Eigen::ArrayXXd dkr(n, np*np);
+        satprops_->relpermByPhase(n, s_all.data(), cells.data(), kr.data(), dkr.data());
         const int num_blocks = so.numBlocks();
         std::vector<ADB> relperms;
         relperms.reserve(3);
@@ -832,9 +767,10 @@ BlackoilPropsAdFromDeck::BlackoilPropsAdFromDeck(const BlackoilPropsAdFromDeck&
             activeSat.col(phase_usage_.phase_pos[Gas]) = sg.value();
         }
 
-        Block pc(nCells, nActivePhases);
-        Block dpc(nCells, nActivePhases*nActivePhases);
-        satprops_->capPress(nCells, activeSat.data(), cells.data(), pc.data(), dpc.data());
+        // Column-major, so that each capillary pressure and derivative is contiguous.
+        Eigen::ArrayXXd pc(nCells, nActivePhases);
+        Eigen::ArrayXXd dpc(nCells, nActivePhases*nActivePhases);
+        satprops_->capPressByPhase(nCells, activeSat.data(), cells.data(), pc.data(), dpc.data());
 
         std::vector<ADB> adbCapPressures;
         adbCapPressures.reserve(3);
@@ -24,6 +24,7 @@
 
 #include <opm/autodiff/AutoDiffBlock.hpp>
 #include <opm/autodiff/BlackoilModelEnums.hpp>
+#include <opm/autodiff/PvtEvaluationCache.hpp>
 
 #include <opm/core/props/satfunc/SaturationPropsFromDeck.hpp>
 #include <opm/core/props/rock/RockFromDeck.hpp>
@@ -58,6 +59,13 @@ namespace Opm
     /// taking an AD type and returning the same. Derivatives are not
     /// returned separately by any method, only implicitly with the AD
     /// version of the methods.
+    ///
+    /// The viscosities, formation volume factors and saturated Rs and Rv
+    /// are kept in caches that are modified by the const methods
+    /// computing them. These methods must therefore not be called from
+    /// several threads at the same time. Threaded code should use the
+    /// fluid system objects of waterProps(), oilProps() and gasProps()
+    /// directly, as BlackoilReorderingTransportModel does.
     class BlackoilPropsAdFromDeck
     {
         friend class BlackoilPropsDataHandle;
@@ -479,6 +487,31 @@ namespace Opm
                       const std::vector<int>& cells,
                       const double vap) const;
 
+        /// Quantities stored in the PVT evaluation caches of the phases.
+        enum PvtQuantity { InverseFvf = 0, Viscosity = 1 };
+
+        /// Inverse formation volume factor and viscosity of water,
+        /// evaluated together or taken from the cache.
+        const PvtEvaluationCache::Result& waterPvt(const ADB& pw,
+                                                   const ADB& T,
+                                                   const Cells& cells) const;
+
+        /// Inverse formation volume factor and viscosity of oil,
+        /// evaluated together or taken from the cache.
+        const PvtEvaluationCache::Result& oilPvt(const ADB& po,
+                                                 const ADB& T,
+                                                 const ADB& rs,
+                                                 const std::vector<PhasePresence>& cond,
+                                                 const Cells& cells) const;
+
+        /// Inverse formation volume factor and viscosity of gas,
+        /// evaluated together or taken from the cache.
+        const PvtEvaluationCache::Result& gasPvt(const ADB& pg,
+                                                 const ADB& T,
+                                                 const ADB& rv,
+                                                 const std::vector<PhasePresence>& cond,
+                                                 const Cells& cells) const;
+
         RockFromDeck rock_;
 
         // This has to be a shared pointer as we must
@@ -498,6 +531,18 @@ namespace Opm
         double vap2_;
         std::vector<double> satOilMax_;
         double vap_satmax_guard_;  //Threshold value to promote stability
+
+        // The PVT properties are requested several times per iteration
+        // with the same inputs, e.g. in the accumulation terms, the mass
+        // balance equations and the well model. The inverse formation
+        // volume factor and the viscosity of a phase are evaluated
+        // together and kept. The caches are only used serially, see
+        // the class documentation.
+        mutable PvtEvaluationCache waterPvtCache_{2};
+        mutable PvtEvaluationCache oilPvtCache_{2};
+        mutable PvtEvaluationCache gasPvtCache_{2};
+        mutable PvtEvaluationCache rsSatCache_{1};
+        mutable PvtEvaluationCache rvSatCache_{1};
     };
 } // namespace Opm
 
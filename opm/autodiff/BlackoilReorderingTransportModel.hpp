@@ -25,18 +25,31 @@
 #include <opm/autodiff/BlackoilModelParameters.hpp>
 #include <opm/autodiff/DebugTimeReport.hpp>
 #include <opm/autodiff/multiPhaseUpwind.hpp>
-#include <opm/grid/UnstructuredGrid.h>
-#include <opm/core/transport/reorder/reordersequence.h>
+#include <opm/autodiff/solveReorderComponent.hpp>
+#include <opm/core/transport/reorder/IncrementalReorderSequence.hpp>
 #include <opm/core/simulator/BlackoilState.hpp>
 
 #include <opm/autodiff/BlackoilTransportModel.hpp>
 
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <Eigen/SparseLU>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <exception>
+
 namespace Opm {
 
 
     namespace detail
     {
 
+        // Smallest number of components of a wavefront for which the
+        // components are solved in parallel. Chain-like orderings give
+        // many tiny wavefronts, which are cheaper to solve serially.
+        const int minimumParallelComponents = 32;
+
+
+
         template <typename Scalar>
         struct CreateVariable
         {
@@ -113,6 +126,11 @@ namespace Opm {
 
             Connections cellConnections(const int cell) const;
 
+            int numConnections() const
+            {
+                return div_.cols();
+            }
+
             std::array<int, 2> connectionCells(const int connection) const
             {
                 const int pos = div_ia_[connection];
@@ -258,6 +276,7 @@ namespace Opm {
             rhos_.col(Water) = props_.surfaceDensity(Water, Base::cells_);
             rhos_.col(Oil) = props_.surfaceDensity(Oil, Base::cells_);
             rhos_.col(Gas) = props_.surfaceDensity(Gas, Base::cells_);
+            computeConnectionArrays();
         }
 
 
@@ -311,6 +330,8 @@ namespace Opm {
             }
 
             // Solve in every component (cell or block of cells), in order.
+            // Independent components are solved concurrently, see
+            // computeWavefronts().
             {
                 DebugTimeReport tr("Solving all components");
                 for (int ii = 0; ii < 5; ++ii) {
@@ -420,6 +441,60 @@ namespace Opm {
 
 
 
+        // Largest changes of the two primary variables in a sweep, and
+        // the cells where they occurred.
+        struct MaxChange
+        {
+            std::array<double, 2> dx = {{ 0.0, 0.0 }};
+            std::array<int, 2> cell = {{ -1, -1 }};
+
+            void update(const int c, const Vec2& change)
+            {
+                for (int i = 0; i < 2; ++i) {
+                    if (std::fabs(change[i]) > dx[i]) {
+                        dx[i] = std::fabs(change[i]);
+                        cell[i] = c;
+                    }
+                }
+            }
+
+            void merge(const MaxChange& other)
+            {
+                for (int i = 0; i < 2; ++i) {
+                    if (other.dx[i] > dx[i]) {
+                        dx[i] = other.dx[i];
+                        cell[i] = other.cell[i];
+                    }
+                }
+            }
+        };
+
+
+
+        // Derivatives of the oil and gas component outflow from a cell
+        // through one connection, with respect to the variables of the
+        // cell. The inflow to the other cell is the negative of this.
+        struct ConnectionDerivative
+        {
+            int other;
+            Mat22 jac;
+        };
+
+
+
+        // The values of a cell changed by updateState(), and its cell
+        // state, saved before a coupled solve.
+        struct SavedCell
+        {
+            double s[3];
+            double rs;
+            double rv;
+            HydroCarbonState hcstate;
+            CellState<double> cstate;
+        };
+
+
+
         // ============  Data members  ============
 
         using Base::grid_;
@@ -442,14 +517,27 @@ namespace Opm {
         V total_wellflux_cell_;
         V oil_wellflux_cell_;
         V gas_wellflux_cell_;
+        // Connectivity graph in compressed form: the two cells of each
+        // connection, and the connections of each cell.
+        std::vector<int> connection_cells_;
+        std::vector<int> cell_connection_pos_;
+        std::vector<int> cell_connections_;
+        IncrementalReorderSequence reorder_sequence_;
         std::vector<int> sequence_;
         std::vector<int> components_;
+        // Components grouped by wavefront: wavefront_components_ holds
+        // the components of wavefront w in positions
+        // [wavefronts_[w], wavefronts_[w + 1]).
+        std::vector<int> wavefronts_;
+        std::vector<int> wavefront_components_;
+        // Index of each cell within the component being solved by
+        // solveCoupled(), -1 for other cells.
+        std::vector<int> local_index_;
         V trans_all_;
         V gdz_;
         DataBlock rhos_;
 
-        std::array<double, 2> max_abs_dx_;
-        std::array<int, 2> max_abs_dx_cell_;
+        MaxChange max_change_;
 
         // TODO: remove this, for debug only.
         BlackoilTransportModel<Grid, WellModel> tr_model_;
@@ -579,25 +667,72 @@ namespace Opm {
 
 
 
+        /// Store the connectivity graph (interior faces and nncs) in the
+        /// compressed form used by IncrementalReorderSequence.
+        void computeConnectionArrays()
+        {
+            const int num_cells = Opm::AutoDiffGrid::numCells(grid_);
+            const int num_connections = graph_.numConnections();
+            connection_cells_.resize(2*num_connections);
+            for (int conn = 0; conn < num_connections; ++conn) {
+                const auto conn_cells = graph_.connectionCells(conn);
+                connection_cells_[2*conn] = conn_cells[0];
+                connection_cells_[2*conn + 1] = conn_cells[1];
+            }
+            cell_connection_pos_.resize(num_cells + 1);
+            cell_connections_.clear();
+            cell_connection_pos_[0] = 0;
+            for (int cell = 0; cell < num_cells; ++cell) {
+                for (auto conn : graph_.cellConnections(cell)) {
+                    cell_connections_.push_back(conn.index);
+                }
+                cell_connection_pos_[cell + 1] = cell_connections_.size();
+            }
+        }
+
+
+
+
+
         void computeOrdering()
         {
-            assert(!geo_.nnc().hasNNC()); // TODO: support compute_sequence() with grid + nnc.
-            static_assert(std::is_same<Grid, UnstructuredGrid>::value,
-                          "compute_sequence() is written in C and therefore requires an UnstructuredGrid, "
-                          "it must be rewritten to use other grid classes such as CpGrid");
-            using namespace Opm::AutoDiffGrid;
-            const int num_cells = numCells(grid_);
-            sequence_.resize(num_cells);
-            components_.resize(num_cells + 1); // max possible size
-            int num_components = -1;
-
-
-            using namespace Opm::AutoDiffGrid;
-            const int num_faces = numFaces(grid_);
-            V flux_on_all_faces = superset(total_flux_, ops_.internal_faces, num_faces);
-            compute_sequence(&grid_, flux_on_all_faces.data(), sequence_.data(), components_.data(), &num_components);
-            OpmLog::debug(std::string("Number of components: ") + std::to_string(num_components));
-            components_.resize(num_components + 1); // resize to fit actually used part
+            // The connections and total_flux_ include nncs.
+            const int num_cells = cell_connection_pos_.size() - 1;
+            assert(total_flux_.size() == graph_.numConnections());
+            reorder_sequence_.compute(num_cells, graph_.numConnections(),
+                                      connection_cells_.data(),
+                                      cell_connection_pos_.data(),
+                                      cell_connections_.data(),
+                                      total_flux_.data());
+            sequence_ = reorder_sequence_.sequence();
+            components_ = reorder_sequence_.components();
+            const int num_components = reorder_sequence_.numComponents();
+            OpmLog::debug(std::string("Number of components: ") + std::to_string(num_components)
+                          + ", cells sorted: " + std::to_string(reorder_sequence_.numSortedCells()));
+            local_index_.assign(num_cells, -1);
+            computeWavefronts();
+        }
+
+
+
+
+
+        /// Group the components in wavefronts that can be solved
+        /// concurrently. A component is placed in the wavefront after the
+        /// last wavefront containing a neighbouring component that comes
+        /// before it in the sequence. Unlike the upwind levels of
+        /// ReorderSolverInterface, any connection counts, since the phase
+        /// upwinding may differ from the total flux direction and a cell
+        /// also reads its downstream neighbours. Neighbouring components
+        /// are therefore never solved at the same time, and every component
+        /// sees the same neighbour values as in a serial sweep: updated
+        /// for components earlier in the sequence, and from the previous
+        /// sweep for later ones.
+        void computeWavefronts()
+        {
+            reorder_sequence_.computeLevels(IncrementalReorderSequence::AllNeighbours,
+                                            wavefronts_, wavefront_components_);
+            OpmLog::debug(std::string("Number of wavefronts: ") + std::to_string(wavefronts_.size() - 1));
         }
 
 
@@ -606,27 +741,62 @@ namespace Opm {
         void solveComponents()
         {
             // Zero the max changed.
-            max_abs_dx_[0] = 0.0;
-            max_abs_dx_[1] = 0.0;
-            max_abs_dx_cell_[0] = -1;
-            max_abs_dx_cell_[1] = -1;
-
-            // Solve the equations.
-            const int num_components = components_.size() - 1;
-            for (int comp = 0; comp < num_components; ++comp) {
-                const int comp_size = components_[comp + 1] - components_[comp];
-                if (comp_size == 1) {
-                    solveSingleCell(sequence_[components_[comp]]);
-                } else {
-                    solveMultiCell(comp_size, &sequence_[components_[comp]]);
+            max_change_ = MaxChange();
+
+            // Solve the equations, one wavefront after the other. The
+            // components of a wavefront are solved concurrently, and each
+            // writes local_index_, cstate_ and state_ for its own cells
+            // only. They also read cstate_ and state_ of neighbouring
+            // cells, which is only safe because neighbouring components
+            // are never in the same wavefront, see computeWavefronts().
+            const int num_wavefronts = wavefronts_.size() - 1;
+            std::exception_ptr error;
+            for (int w = 0; w < num_wavefronts && !error; ++w) {
+                const int begin = wavefronts_[w];
+                const int end = wavefronts_[w + 1];
+#if HAVE_OPENMP
+#pragma omp parallel if(end - begin >= detail::minimumParallelComponents)
+#endif // HAVE_OPENMP
+                {
+                    MaxChange change;
+#if HAVE_OPENMP
+#pragma omp for schedule(dynamic, 16)
+#endif // HAVE_OPENMP
+                    for (int ii = begin; ii < end; ++ii) {
+                        try {
+                            const int comp = wavefront_components_[ii];
+                            const int comp_size = components_[comp + 1] - components_[comp];
+                            if (comp_size == 1) {
+                                solveSingleCell(sequence_[components_[comp]], change);
+                            } else {
+                                solveMultiCell(comp_size, &sequence_[components_[comp]], change);
+                            }
+                        } catch (...) {
+#if HAVE_OPENMP
+#pragma omp critical(ReorderingTransportError)
+#endif // HAVE_OPENMP
+                            {
+                                if (!error) {
+                                    error = std::current_exception();
+                                }
+                            }
+                        }
+                    }
+#if HAVE_OPENMP
+#pragma omp critical(ReorderingTransportMaxChange)
+#endif // HAVE_OPENMP
+                    max_change_.merge(change);
                 }
             }
+            if (error) {
+                std::rethrow_exception(error);
+            }
 
             // Log the max change.
             {
                 std::ostringstream os;
-                os << "===  Max abs dx[0]: " << max_abs_dx_[0] << " (cell " << max_abs_dx_cell_[0]
-                   <<")  dx[1]: " << max_abs_dx_[1] << " (cell " << max_abs_dx_cell_[1] << ")";
+                os << "===  Max abs dx[0]: " << max_change_.dx[0] << " (cell " << max_change_.cell[0]
+                   <<")  dx[1]: " << max_change_.dx[1] << " (cell " << max_change_.cell[1] << ")";
                 OpmLog::debug(os.str());
             }
         }
@@ -635,7 +805,7 @@ namespace Opm {
 
 
 
-        void solveSingleCell(const int cell)
+        void solveSingleCell(const int cell, MaxChange& change)
         {
 
             Vec2 res;
@@ -651,7 +821,7 @@ namespace Opm {
                 jac.solve(dx, res);
                 dx *= relaxation;
                 // const auto hcstate_old = state_.reservoir_state.hydroCarbonState()[cell];
-                updateState(cell, -dx);
+                updateState(cell, -dx, change);
                 // const auto hcstate = state_.reservoir_state.hydroCarbonState()[cell];
                 assembleSingleCell(cell, res, jac);
                 ++iter;
@@ -681,6 +851,9 @@ namespace Opm {
                 os << "Failed to converge in cell " << cell << ", residual = " << res
                    << ", cell values { s = ( " << cstate_[cell].s[Water] << ", " << cstate_[cell].s[Oil] << ", " << cstate_[cell].s[Gas]
                    << " ), rs = " << cstate_[cell].rs << ", rv = " << cstate_[cell].rv << " }";
+#if HAVE_OPENMP
+#pragma omp critical
+#endif // HAVE_OPENMP
                 OpmLog::debug(os.str());
             }
         }
@@ -689,12 +862,130 @@ namespace Opm {
 
 
 
-        void solveMultiCell(const int comp_size, const int* cell_array)
+        void solveMultiCell(const int comp_size, const int* cell_array, MaxChange& change)
         {
-            // OpmLog::warning("solveMultiCell", "solveMultiCell() called with component size " + std::to_string(comp_size));
+            // Small components are solved by nonlinear Gauss-Seidel, which
+            // is also the fallback if the coupled solve fails. The fallback
+            // starts from the state before the coupled solve.
+            const int min_coupled_size = 3;
+            solveReorderComponent(comp_size, cell_array, min_coupled_size,
+                                  [this](const int cell) { return saveCell(cell); },
+                                  [this](const int cell, const SavedCell& saved) { restoreCell(cell, saved); },
+                                  [this, &change](const int n, const int* cells) { return solveCoupled(n, cells, change); },
+                                  [this, &change](const int cell) { solveSingleCell(cell, change); });
+        }
+
+
+
+
+
+        SavedCell saveCell(const int cell) const
+        {
+            SavedCell saved;
+            const double* s = state_.reservoir_state.saturation().data() + 3*cell;
+            std::copy(s, s + 3, saved.s);
+            saved.rs = state_.reservoir_state.gasoilratio()[cell];
+            saved.rv = state_.reservoir_state.rv()[cell];
+            saved.hcstate = state_.reservoir_state.hydroCarbonState()[cell];
+            saved.cstate = cstate_[cell];
+            return saved;
+        }
+
+
+
+
+
+        void restoreCell(const int cell, const SavedCell& saved)
+        {
+            std::copy(saved.s, saved.s + 3, state_.reservoir_state.saturation().data() + 3*cell);
+            state_.reservoir_state.gasoilratio()[cell] = saved.rs;
+            state_.reservoir_state.rv()[cell] = saved.rv;
+            state_.reservoir_state.hydroCarbonState()[cell] = saved.hcstate;
+            cstate_[cell] = saved.cstate;
+        }
+
+
+
+
+
+        /// Newton's method for all cells of a component at once, with the
+        /// 2N x 2N jacobian of the component solved by sparse LU. Returns
+        /// true if the component converged.
+        bool solveCoupled(const int comp_size, const int* cell_array, MaxChange& change)
+        {
+            typedef Eigen::SparseMatrix<double> Sp;
+            const int n = 2*comp_size;
+            for (int ii = 0; ii < comp_size; ++ii) {
+                local_index_[cell_array[ii]] = ii;
+            }
+
+            std::vector<Vec2> res(comp_size);
+            std::vector<Mat22> jac(comp_size);
+            std::vector<std::vector<ConnectionDerivative>> conn_jac(comp_size);
+            std::vector<Eigen::Triplet<double>> triplets;
+            Eigen::VectorXd rhs(n);
+            Eigen::SparseLU<Sp> solver;
+
+            const int max_iter = 50;
+            bool converged = false;
+            for (int iter = 0; ; ++iter) {
+                // The neighbours of each cell must see the current values.
+                for (int ii = 0; ii < comp_size; ++ii) {
+                    computeCellState(cell_array[ii], state_, cstate_[cell_array[ii]]);
+                }
+                converged = true;
+                for (int ii = 0; ii < comp_size; ++ii) {
+                    conn_jac[ii].clear();
+                    assembleSingleCell(cell_array[ii], res[ii], jac[ii], &conn_jac[ii]);
+                    converged = converged && getConvergence(cell_array[ii], res[ii]);
+                }
+                if (converged || iter == max_iter) {
+                    break;
+                }
+
+                // Assemble and solve the linear system of the component.
+                triplets.clear();
+                for (int ii = 0; ii < comp_size; ++ii) {
+                    for (int r = 0; r < 2; ++r) {
+                        rhs[2*ii + r] = res[ii][r];
+                        for (int c = 0; c < 2; ++c) {
+                            triplets.emplace_back(2*ii + r, 2*ii + c, jac[ii][r][c]);
+                        }
+                    }
+                    for (const auto& cd : conn_jac[ii]) {
+                        const int jj = local_index_[cd.other];
+                        if (jj < 0) {
+                            continue; // Not in this component.
+                        }
+                        for (int r = 0; r < 2; ++r) {
+                            for (int c = 0; c < 2; ++c) {
+                                triplets.emplace_back(2*jj + r, 2*ii + c, -cd.jac[r][c]);
+                            }
+                        }
+                    }
+                }
+                Sp A(n, n);
+                A.setFromTriplets(triplets.begin(), triplets.end());
+                solver.compute(A);
+                if (solver.info() != Eigen::Success) {
+                    break;
+                }
+                const Eigen::VectorXd dx = solver.solve(rhs);
+                if (solver.info() != Eigen::Success || !dx.allFinite()) {
+                    break;
+                }
+                for (int ii = 0; ii < comp_size; ++ii) {
+                    Vec2 celldx;
+                    celldx[0] = -dx[2*ii];
+                    celldx[1] = -dx[2*ii + 1];
+                    updateState(cell_array[ii], celldx, change);
+                }
+            }
+
             for (int ii = 0; ii < comp_size; ++ii) {
-                solveSingleCell(cell_array[ii]);
+                local_index_[cell_array[ii]] = -1;
             }
+            return converged;
         }
 
 
@@ -731,7 +1022,12 @@ namespace Opm {
 
 
 
-        void assembleSingleCell(const int cell, Vec2& res, Mat22& jac)
+        /// Assemble the residual of a cell and its derivatives with respect
+        /// to the variables of the cell. If conn_jac is given, the
+        /// derivatives of the flux through each interior connection are
+        /// stored there too.
+        void assembleSingleCell(const int cell, Vec2& res, Mat22& jac,
+                                std::vector<ConnectionDerivative>* conn_jac = nullptr)
         {
             assert(numPhases() == 3); // I apologize for this to my future self, that will have to fix it.
 
@@ -810,8 +1106,19 @@ namespace Opm {
                     }
                     flux[phase] = b[phase] * (mob[phase] / tot_mob) * (vt + tran*gflux);
                 }
-                div_oilflux += flux[Oil] + rv*flux[Gas];
-                div_gasflux += flux[Gas] + rs*flux[Oil];
+                const Eval conn_oilflux = flux[Oil] + rv*flux[Gas];
+                const Eval conn_gasflux = flux[Gas] + rs*flux[Oil];
+                div_oilflux += conn_oilflux;
+                div_gasflux += conn_gasflux;
+                if (conn_jac) {
+                    ConnectionDerivative cd;
+                    cd.other = other;
+                    cd.jac[0][0] = conn_oilflux.derivative(0);
+                    cd.jac[0][1] = conn_oilflux.derivative(1);
+                    cd.jac[1][0] = conn_gasflux.derivative(0);
+                    cd.jac[1][1] = conn_gasflux.derivative(1);
+                    conn_jac->push_back(cd);
+                }
             }
 
             // Well fluxes.
@@ -858,16 +1165,10 @@ namespace Opm {
 
 
         void updateState(const int cell,
-                         const Vec2& dx)
+                         const Vec2& dx,
+                         MaxChange& change)
         {
-            if (std::fabs(dx[0]) > max_abs_dx_[0]) {
-                max_abs_dx_cell_[0] = cell;
-            }
-            if (std::fabs(dx[1]) > max_abs_dx_[1]) {
-                max_abs_dx_cell_[1] = cell;
-            }
-            max_abs_dx_[0] = std::max(max_abs_dx_[0], std::fabs(dx[0]));
-            max_abs_dx_[1] = std::max(max_abs_dx_[1], std::fabs(dx[1]));
+            change.update(cell, dx);
 
             // Get saturation updates.
             const double dsw = dx[0];
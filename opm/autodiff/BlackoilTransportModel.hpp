@@ -22,6 +22,7 @@
 #define OPM_BLACKOILTRANSPORTMODEL_HEADER_INCLUDED
 
 #include <opm/autodiff/BlackoilModelBase.hpp>
+#include <opm/autodiff/AutoDiffBlockExpression.hpp>
 #include <opm/core/simulator/BlackoilState.hpp>
 #include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
 #include <opm/autodiff/BlackoilModelParameters.hpp>
@@ -354,8 +355,8 @@ namespace Opm {
 
                 // Material balance equation for this phase.
                 residual_.material_balance_eq[ phase_idx ] =
-                    pvdt_ * (sd_.rq[phase_idx].accum[1] - sd_.rq[phase_idx].accum[0])
-                    + ops_.div*sd_.rq[phase_idx].mflux;
+                    fusedEval(pvdt_ * (lazy(sd_.rq[phase_idx].accum[1]) - sd_.rq[phase_idx].accum[0])
+                              + ops_.product(ops_.div, sd_.rq[phase_idx].mflux));
             }
 
             // -------- Extra (optional) rs and rv contributions to the mass balance equations --------
@@ -366,8 +367,8 @@ namespace Opm {
             if (active_[ Oil ] && active_[ Gas ]) {
                 const int po = fluid_.phaseUsage().phase_pos[ Oil ];
                 const int pg = fluid_.phaseUsage().phase_pos[ Gas ];
-                residual_.material_balance_eq[ pg ] += ops_.div * (rs * sd_.rq[po].mflux);
-                residual_.material_balance_eq[ po ] += ops_.div * (rv * sd_.rq[pg].mflux);
+                residual_.material_balance_eq[ pg ] += ops_.product(ops_.div, rs * sd_.rq[po].mflux);
+                residual_.material_balance_eq[ po ] += ops_.product(ops_.div, rv * sd_.rq[pg].mflux);
             }
 
             if (param_.update_equations_scaling_) {
@@ -72,9 +72,7 @@ namespace Opm
         // Setup linear solver.
         // Writes to:
         //   fis_solver_
-        //   param_ (conditionally)
         // The CPR solver cannot be used with the sequential model.
-        // Also, the interleaved solver requires the full sparsity pattern option.
         void setupLinearSolver()
         {
             const std::string cprSolver = "cpr";
@@ -93,9 +91,6 @@ namespace Opm
             if (solver_approach == cprSolver) {
                 OPM_THROW( std::runtime_error , "CPR solver is not ready for use with sequential simulator.");
             } else if (solver_approach == interleavedSolver) {
-                if (!param_.has("require_full_sparsity_pattern")) {
-                    param_.insertParameter("require_full_sparsity_pattern", "true");
-                }
                 fis_solver_.reset(new NewtonIterationBlackoilInterleaved(param_, parallel_information_));
             } else if (solver_approach == directSolver) {
                 fis_solver_.reset(new NewtonIterationBlackoilSimple(param_, parallel_information_));
@@ -29,6 +29,8 @@
 #include <opm/autodiff/AutoDiffHelpers.hpp>
 #include <opm/autodiff/MatrixBlock.hpp>
 #include <opm/autodiff/MPIUtilities.hpp>
+#include <opm/autodiff/PreconditionerReusePolicy.hpp>
+#include <opm/autodiff/UpdatablePreconditioner.hpp>
 
 #include <opm/common/Exceptions.hpp>
 #include <opm/core/linalg/ParallelIstlInformation.hpp>
@@ -43,6 +45,9 @@
 
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
+#include <memory>
+#include <type_traits>
+
 namespace Opm
 {
     /// This class solves the fully implicit black-oil system by
@@ -54,6 +59,15 @@ namespace Opm
     /// \tparam pressureIndex The index of the pressure component in the vector
     ///                       vector block. It is used to guide the AMG coarsening.
     ///                       Default is zero.
+    ///
+    /// In sequential runs the preconditioner may be kept between solves
+    /// with the same matrix and sparsity pattern, and is then updated for
+    /// the new matrix values. An AMG preconditioner keeps its aggregates
+    /// and sets up its coarse level matrices, smoothers and coarse solver
+    /// again; an ILU(0) preconditioner is refactorized on the kept
+    /// pattern. ILU with fill-in, MILU and red-black ordering cannot be
+    /// updated this way and are always built anew. When a new
+    /// preconditioner is built is decided by a PreconditionerReusePolicy.
     template < class MatrixBlockType, class VectorBlockType, int pressureIndex=0 >
     class ISTLSolver : public NewtonIterationBlackoilInterface
     {
@@ -70,12 +84,16 @@ namespace Opm
         /// \param[in] param   parameters controlling the behaviour of the linear solvers
         /// \param[in] parallelInformation In the case of a parallel run
         ///                                with dune-istl the information about the parallelization.
+        /// \param[in] reuseParam  parameters controlling the reuse of preconditioners
         ISTLSolver(const NewtonIterationBlackoilInterleavedParameters& param,
-                   const boost::any& parallelInformation_arg=boost::any())
+                   const boost::any& parallelInformation_arg=boost::any(),
+                   const PreconditionerReuseParameters& reuseParam=PreconditionerReuseParameters())
         : iterations_( 0 ),
+          converged_( false ),
           parallelInformation_(parallelInformation_arg),
           isIORank_(isIORank(parallelInformation_arg)),
-          parameters_( param )
+          parameters_( param ),
+          reusePolicy_( reuseParam )
         {
         }
 
@@ -86,9 +104,11 @@ namespace Opm
         ISTLSolver(const ParameterGroup& param,
                    const boost::any& parallelInformation_arg=boost::any())
         : iterations_( 0 ),
+          converged_( false ),
           parallelInformation_(parallelInformation_arg),
           isIORank_(isIORank(parallelInformation_arg)),
-          parameters_( param )
+          parameters_( param ),
+          reusePolicy_( PreconditionerReuseParameters( param ) )
         {
         }
 
@@ -108,6 +128,9 @@ namespace Opm
         /// \copydoc NewtonIterationBlackoilInterface::iterations
         int iterations () const { return iterations_; }
 
+        /// Whether the last linear solve converged.
+        bool converged () const { return converged_; }
+
         /// \copydoc NewtonIterationBlackoilInterface::parallelInformation
         const boost::any& parallelInformation() const { return parallelInformation_; }
 
@@ -138,6 +161,16 @@ namespace Opm
             // Communicate if parallel.
             parallelInformation_arg.copyOwnerToAll(istlb, istlb);
 
+            // Preconditioners are only kept in sequential runs, as the
+            // parallel ones refer to the communication object of the solve,
+            // and only if they can be updated for new matrix values.
+            const bool sequential = std::is_same< POrComm, Dune::Amg::SequentialInformation >::value;
+            if ( sequential && reusePolicy_.enabled() && updatablePreconditioner() )
+            {
+                solveWithUpdatablePrecond( linearOperator, x, istlb, *sp, parallelInformation_arg, result );
+                return;
+            }
+
 #if FLOW_SUPPORT_AMG // activate AMG if either flow_ebos is used or UMFPack is not available
             if( parameters_.linear_solver_use_amg_ || parameters_.use_cpr_)
             {
@@ -188,6 +221,138 @@ namespace Opm
             }
         }
 
+        /// \brief Solve with a preconditioner that is kept between solves.
+        ///
+        /// Only sequential preconditioners are kept.
+        template <class LinearOperator, class ScalarProd, class POrComm>
+        void solveWithUpdatablePrecond(LinearOperator&, Vector&, Vector&, ScalarProd&,
+                                       const POrComm&, Dune::InverseOperatorResult&) const
+        {
+            OPM_THROW(std::logic_error, "Preconditioners are only kept in sequential runs.");
+        }
+
+        /// \brief Solve with a preconditioner that is kept between solves.
+        ///
+        /// The preconditioner of the previous solve is updated for the
+        /// current values of the matrix if the reuse policy allows it, and
+        /// a new one is built otherwise. If the solve with an updated
+        /// preconditioner does not converge, it is repeated with a new one.
+        template <class LinearOperator, class ScalarProd>
+        void solveWithUpdatablePrecond(LinearOperator& linearOperator, Vector& x, Vector& istlb, ScalarProd& sp,
+                                       const Dune::Amg::SequentialInformation& parallelInformation_arg,
+                                       Dune::InverseOperatorResult& result) const
+        {
+            const Matrix& A = linearOperator.getmat();
+            const std::size_t pattern = sparsityPatternKey( A );
+            bool reuse = reusePolicy_.reuse( &A, pattern );
+
+            // A solve with an updated preconditioner may fail where a new
+            // one would succeed. Keep the input, so that the solve can be
+            // repeated.
+            std::unique_ptr< Vector > x0, b0;
+            if ( reuse )
+            {
+                x0.reset( new Vector( x ) );
+                b0.reset( new Vector( istlb ) );
+            }
+            int failedIterations = 0;
+            auto discardIfFailed = [&]() {
+                if ( ! result.converged )
+                {
+                    failedIterations = result.iterations;
+                    x = *x0;
+                    istlb = *b0;
+                    invalidatePreconditioner();
+                    reuse = false;
+                }
+            };
+
+#if FLOW_SUPPORT_AMG // activate AMG if either flow_ebos is used or UMFPack is not available
+            if( parameters_.linear_solver_use_amg_ || parameters_.use_cpr_)
+            {
+                typedef ISTLUtility::CPRSelector< Matrix, Vector, Vector, Dune::Amg::SequentialInformation > CPRSelectorType;
+                typedef typename CPRSelectorType::Operator MatrixOperator;
+                typedef UpdatableAMG< MatrixOperator, Vector, typename CPRSelectorType::AMG::Smoother > AMG;
+
+                if (  parameters_.use_cpr_ )
+                {
+                    // See constructPreconditionerAndSolve().
+                    OPM_THROW(std::logic_error,
+                              "This code path should bever be exectuded for parameters_.use_cpr_="
+                              <<parameters_.use_cpr_<<" in flow_legacy.");
+                }
+                if ( reuse )
+                {
+                    // Keep the aggregates, and set up the coarse level
+                    // matrices, the smoothers and the coarse solver again.
+                    AMG& amg = static_cast< AMG& >( *preconditioner_ );
+                    amg.update();
+
+                    // Solve.
+                    solve(linearOperator, x, istlb, sp, amg, result);
+                    discardIfFailed();
+                }
+                if ( ! reuse )
+                {
+                    // The hierarchy refers to the operator, which must
+                    // therefore live as long as the preconditioner.
+                    std::shared_ptr< MatrixOperator > op( CPRSelectorType::makeOperator( A, parallelInformation_arg ) );
+                    std::unique_ptr< AMG > amg;
+                    constructUpdatableAMGPrecond( *op, amg, parameters_.ilu_relaxation_ );
+
+                    // Solve.
+                    solve(linearOperator, x, istlb, sp, *amg, result);
+                    keepPreconditioner( A, pattern, std::move( op ), std::move( amg ) );
+                }
+            }
+            else
+#endif
+            {
+                if ( reuse )
+                {
+                    // Factorize the new values on the kept pattern.
+                    UpdatablePreconditioner& ilu = static_cast< UpdatablePreconditioner& >( *preconditioner_ );
+                    ilu.update();
+
+                    // Solve.
+                    solve(linearOperator, x, istlb, sp, ilu, result);
+                    discardIfFailed();
+                }
+                if ( ! reuse )
+                {
+                    // Construct preconditioner.
+                    std::unique_ptr< UpdatablePreconditioner > ilu( new UpdatablePreconditioner( A, parameters_.ilu_relaxation_ ) );
+
+                    // Solve.
+                    solve(linearOperator, x, istlb, sp, *ilu, result);
+                    keepPreconditioner( A, pattern, std::shared_ptr< void >(), std::move( ilu ) );
+                }
+            }
+
+            reusePolicy_.solved( result.iterations );
+            result.iterations += failedIterations;
+        }
+
+        /// \brief Forget the preconditioner of an earlier solve.
+        void invalidatePreconditioner() const
+        {
+            preconditioner_.reset();
+            preconditionerOperator_.reset();
+            reusePolicy_.invalidate();
+        }
+
+        /// \brief Keep a preconditioner, and the operator it refers to,
+        ///        for later solves with the matrix A.
+        template <class Op, class Precond>
+        void keepPreconditioner(const Matrix& A, const std::size_t pattern,
+                                Op&& op, std::unique_ptr< Precond >&& precond) const
+        {
+            preconditioner_.reset();
+            preconditionerOperator_ = std::forward< Op >( op );
+            preconditioner_ = std::move( precond );
+            reusePolicy_.rebuilt( &A, pattern );
+        }
+
 
 	// 3x3 matrix block inversion was unstable at least 2.3 until and including
 	// 2.5.0. There may still be some issue with the 4x4 matrix block inversion
@@ -210,6 +375,25 @@ namespace Opm
             return precond;
         }
 
+        typedef UpdatableSeqILU0<Matrix, Vector, Vector> UpdatablePreconditioner;
+
+        /// \brief Whether the preconditioner chosen by the parameters
+        ///        can be updated for new values of the matrix.
+        bool updatablePreconditioner() const
+        {
+            if ( parameters_.ilu_milu_ != MILU_VARIANT::ILU )
+            {
+                return false;
+            }
+#if FLOW_SUPPORT_AMG
+            if ( parameters_.linear_solver_use_amg_ || parameters_.use_cpr_ )
+            {
+                return true;
+            }
+#endif
+            return parameters_.ilu_fillin_level_ == 0 && ! parameters_.ilu_redblack_;
+        }
+
 #if HAVE_MPI
         typedef Dune::OwnerOverlapCopyCommunication<int, int> Comm;
 #if DUNE_VERSION_NEWER_REV(DUNE_ISTL, 2 , 5, 1)
@@ -245,6 +429,31 @@ namespace Opm
                                                                                  milu, comm, amg );
         }
 
+        /// \brief Construct an AMG preconditioner that can be updated for
+        ///        new matrix values, with the same coarsening and smoother
+        ///        parameters as ISTLUtility::createAMGPreconditionerPointer().
+        template <class MatrixOperator, class AMG>
+        void
+        constructUpdatableAMGPrecond(const MatrixOperator& opA, std::unique_ptr< AMG >& amg, const double relax) const
+        {
+            typedef Dune::Amg::Diagonal<pressureIndex> CouplingMetric;
+            typedef Dune::Amg::SymmetricCriterion<Matrix, CouplingMetric> CritBase;
+            typedef Dune::Amg::CoarsenCriterion<CritBase> Criterion;
+
+            const int coarsenTarget = 1200;
+            Criterion criterion(15, coarsenTarget);
+            criterion.setDebugLevel(0);
+            criterion.setDefaultValuesIsotropic(2);
+            criterion.setNoPostSmoothSteps(1);
+            criterion.setNoPreSmoothSteps(1);
+
+            typename AMG::SmootherArgs smootherArgs;
+            smootherArgs.iterations = 1;
+            smootherArgs.relaxationFactor = relax;
+
+            amg.reset( new AMG( opA, criterion, smootherArgs ) );
+        }
+
         /// \brief Solve the system using the given preconditioner and scalar product.
         template <class Operator, class ScalarProd, class Precond>
         void solve(Operator& opA, Vector& x, Vector& istlb, ScalarProd& sp, Precond& precond, Dune::InverseOperatorResult& result) const
@@ -359,6 +568,7 @@ namespace Opm
         {
             // store number of iterations
             iterations_ = result.iterations;
+            converged_ = result.converged;
 
             // Check for failure of linear solver.
             if (!parameters_.ignoreConvergenceFailure_ && !result.converged) {
@@ -368,10 +578,18 @@ namespace Opm
         }
     protected:
         mutable int iterations_;
+        mutable bool converged_;
         boost::any parallelInformation_;
         bool isIORank_;
 
         NewtonIterationBlackoilInterleavedParameters parameters_;
+
+        // Preconditioner of an earlier solve, and the operator it refers
+        // to (if any). The preconditioner is declared last, so that it is
+        // destroyed first.
+        mutable PreconditionerReusePolicy reusePolicy_;
+        mutable std::shared_ptr< void > preconditionerOperator_;
+        mutable std::shared_ptr< Dune::Preconditioner< Vector, Vector > > preconditioner_;
     }; // end ISTLSolver
 
 } // namespace Opm
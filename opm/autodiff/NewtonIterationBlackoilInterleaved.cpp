@@ -47,19 +47,159 @@
 #endif
 #include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <typeinfo>
+
 namespace Opm
 {
 
     namespace detail {
-        /**
-         * Simple binary operator that always returns 0.1
-         * It is used to get the sparsity pattern for our
-         * interleaved system, and is marginally faster than using
-         * operator+=.
-         */
-        template<typename Scalar> struct PointOneOp {
-            EIGEN_EMPTY_STRUCT_CTOR(PointOneOp)
-            Scalar operator()(const Scalar&, const Scalar&) const { return 0.1; }
+
+        /// Form a sparse matrix from a rectangular array of
+        /// AutoDiffMatrix blocks. All blocks in a block row must have
+        /// the same number of rows, and all blocks in a block column the
+        /// same number of columns.
+        inline Eigen::SparseMatrix<double>
+        blockMatrix(const std::vector< std::vector<const AutoDiffMatrix*> >& blocks)
+        {
+            typedef Eigen::SparseMatrix<double> Sp;
+            const int nbr = blocks.size();
+            const int nbc = blocks[0].size();
+            std::vector<int> row_offset(nbr + 1, 0);
+            std::vector<int> col_offset(nbc + 1, 0);
+            int nnz = 0;
+            for (int br = 0; br < nbr; ++br) {
+                row_offset[br + 1] = row_offset[br] + blocks[br][0]->rows();
+                for (int bc = 0; bc < nbc; ++bc) {
+                    nnz += blocks[br][bc]->nonZeros();
+                }
+            }
+            for (int bc = 0; bc < nbc; ++bc) {
+                col_offset[bc + 1] = col_offset[bc] + blocks[0][bc]->cols();
+            }
+            std::vector< Eigen::Triplet<double> > t;
+            t.reserve(nnz);
+            for (int br = 0; br < nbr; ++br) {
+                for (int bc = 0; bc < nbc; ++bc) {
+                    const AutoDiffMatrix& m = *blocks[br][bc];
+                    assert(m.rows() == row_offset[br + 1] - row_offset[br]);
+                    assert(m.cols() == col_offset[bc + 1] - col_offset[bc]);
+                    if (m.nonZeros() == 0) {
+                        continue;
+                    }
+                    const Sp& s = m.getSparse();
+                    for (int col = 0; col < s.outerSize(); ++col) {
+                        for (Sp::InnerIterator it(s, col); it; ++it) {
+                            t.emplace_back(row_offset[br] + it.row(), col_offset[bc] + col, it.value());
+                        }
+                    }
+                }
+            }
+            Sp res(row_offset[nbr], col_offset[nbc]);
+            res.setFromTriplets(t.begin(), t.end());
+            return res;
+        }
+
+
+
+        /// The Schur complement of the cell equations with respect to
+        /// the well unknowns. The well rates and bottom hole pressures
+        /// are eliminated together, which is equivalent to eliminating
+        /// them one after the other as eliminateVariable() does, but
+        /// without forming new sets of equations. Writing the cell
+        /// equations as A x + B w = b and the well equations as
+        /// C x + D w = d, the reduced system is
+        ///
+        ///     (A - B inv(D) C) x = b - B inv(D) d,
+        ///
+        /// and the well unknowns are recovered from w = inv(D) (d - C x).
+        class WellSchurComplement
+        {
+        public:
+            typedef LinearisedBlackoilResidual::ADB ADB;
+            typedef Eigen::SparseMatrix<double> Sp;
+
+            explicit WellSchurComplement(const LinearisedBlackoilResidual& residual)
+            {
+                const std::vector<ADB>& mb = residual.material_balance_eq;
+                const ADB& wf = residual.well_flux_eq;
+                const ADB& we = residual.well_eq;
+                const int np = mb.size();
+                const int qs = np;
+                const int bhp = np + 1;
+                assert(wf.numBlocks() == np + 2);
+                assert(we.numBlocks() == np + 2);
+
+                // inv(D), using sparse LU to solve for the identity
+                // as in eliminateVariable().
+                Sp D = blockMatrix({ { &wf.derivative()[qs], &wf.derivative()[bhp] },
+                                     { &we.derivative()[qs], &we.derivative()[bhp] } });
+                D.makeCompressed();
+#if HAVE_UMFPACK
+                const Eigen::UmfPackLU<Sp> solver(D);
+#else
+                Eigen::SparseLU<Sp> solver;
+                solver.analyzePattern(D);
+                solver.factorize(D);
+#endif
+                Sp id(D.rows(), D.cols());
+                id.setIdentity();
+                Di_ = solver.solve(id);
+
+                // inv(D) d
+                Eigen::VectorXd d(D.rows());
+                d << wf.value().matrix(), we.value().matrix();
+                Did_ = Di_ * d;
+
+                B_.resize(np);
+                DiC_.resize(np);
+                for (int phase = 0; phase < np; ++phase) {
+                    B_[phase] = blockMatrix({ { &mb[phase].derivative()[qs], &mb[phase].derivative()[bhp] } });
+                    const Sp C = blockMatrix({ { &wf.derivative()[phase] }, { &we.derivative()[phase] } });
+                    fastSparseProduct(Di_, C, DiC_[phase]);
+                }
+            }
+
+            /// The correction B_p1 inv(D) C_p2 of the (p1, p2) block.
+            void correction(const int p1, const int p2, Sp& res) const
+            {
+                fastSparseProduct(B_[p1], DiC_[p2], res);
+            }
+
+            /// The correction B_p inv(D) d of the right hand side of
+            /// equation p.
+            Eigen::VectorXd rhsCorrection(const int p) const
+            {
+                return B_[p] * Did_;
+            }
+
+            /// The well unknowns w = inv(D) (d - C x), given the cell
+            /// unknowns x of each phase.
+            Eigen::VectorXd recover(const std::vector<Eigen::VectorXd>& x) const
+            {
+                Eigen::VectorXd w = Did_;
+                const int np = DiC_.size();
+                for (int phase = 0; phase < np; ++phase) {
+                    w -= DiC_[phase] * x[phase];
+                }
+                return w;
+            }
+
+            /// Number of well unknowns.
+            int size() const
+            {
+                return Di_.rows();
+            }
+
+        private:
+            Sp Di_;
+            Eigen::VectorXd Did_;
+            std::vector<Sp> B_;
+            std::vector<Sp> DiC_;
         };
     }
 
@@ -68,18 +208,48 @@ namespace Opm
     /// solving the reduced system (after eliminating well variables)
     /// as a block-structured matrix (one block for all cell variables) for a fixed
     /// number of cell variables np .
+    ///
+    /// The interleaved matrix and right hand side are kept between
+    /// calls. The jacobians are written directly into the existing
+    /// block structure, with the well Schur complement applied in
+    /// place, and the structure is only rebuilt when an entry is found
+    /// that it does not contain.
+    ///
+    /// The system is always assembled in double precision. ScalarT is
+    /// the precision of the linear solver. For single precision, the
+    /// matrix is copied to a float matrix, from which the preconditioner
+    /// is built and on which the Krylov iterations run. The solution is
+    /// then improved by iterative refinement: the residual b - A x is
+    /// computed with the double precision matrix, and the correction is
+    /// again found with the single precision solver, until the residual
+    /// is reduced by linear_solver_reduction.
     template <int np, class ScalarT = double >
     class NewtonIterationBlackoilInterleavedImpl : public NewtonIterationBlackoilInterface
     {
         typedef ScalarT                                 Scalar;
-        typedef Dune::FieldVector<Scalar, np    >       VectorBlockType;
+        typedef Dune::FieldVector<double, np    >       VectorBlockType;
 
-        typedef Dune::MatrixBlock<Scalar, np, np >      MatrixBlockType;
+        typedef Dune::MatrixBlock<double, np, np >      MatrixBlockType;
 
         typedef Dune::BCRSMatrix <MatrixBlockType>      Mat;
         typedef Dune::BlockVector<VectorBlockType>      Vector;
 
-        typedef Opm::ISTLSolver< MatrixBlockType, VectorBlockType > ISTLSolverType;
+        typedef Dune::FieldVector<Scalar, np    >       SolverVectorBlockType;
+        typedef Dune::MatrixBlock<Scalar, np, np >      SolverMatrixBlockType;
+        typedef Dune::BCRSMatrix <SolverMatrixBlockType> SolverMat;
+        typedef Dune::BlockVector<SolverVectorBlockType> SolverVector;
+
+        typedef Opm::ISTLSolver< SolverMatrixBlockType, SolverVectorBlockType > ISTLSolverType;
+
+        typedef std::integral_constant<bool, std::is_same<Scalar, double>::value> DoublePrecision;
+
+        // Single precision solves are not asked to reduce the residual
+        // by more than this, which is close to what float can resolve.
+        // The requested reduction is reached by iterative refinement.
+        static constexpr double minimumSinglePrecisionReduction = 1e-5;
+
+        typedef LinearisedBlackoilResidual::ADB         ADB;
+        typedef Eigen::SparseMatrix<double>             Sp;
 
     public:
         typedef NewtonIterationBlackoilInterface :: SolutionVector  SolutionVector;
@@ -87,10 +257,16 @@ namespace Opm
         /// \param[in] param   parameters controlling the behaviour of the linear solvers
         /// \param[in] parallelInformation In the case of a parallel run
          ///                               with dune-istl the information about the parallelization.
+        /// \param[in] reuseParam  parameters controlling the reuse of preconditioners
+        /// \param[in] mixedParam  parameters of the single precision solves
         NewtonIterationBlackoilInterleavedImpl(const NewtonIterationBlackoilInterleavedParameters& param,
-                                               const boost::any& parallelInformation_arg=boost::any())
-        : istlSolver_( param, parallelInformation_arg ),
-          parameters_( param )
+                                               const boost::any& parallelInformation_arg=boost::any(),
+                                               const PreconditionerReuseParameters& reuseParam=PreconditionerReuseParameters(),
+                                               const MixedPrecisionParameters& mixedParam=MixedPrecisionParameters())
+        : istlSolver_( solverParameters( param ), parallelInformation_arg, reuseParam ),
+          parameters_( param ),
+          mixedParameters_( mixedParam ),
+          iterations_( 0 )
         {
         }
 
@@ -101,99 +277,192 @@ namespace Opm
         /// \return               the solution x
 
         /// \copydoc NewtonIterationBlackoilInterface::iterations
-        int iterations () const { return istlSolver_.iterations(); }
+        int iterations () const { return iterations_; }
 
         /// \copydoc NewtonIterationBlackoilInterface::parallelInformation
         const boost::any& parallelInformation() const { return istlSolver_.parallelInformation(); }
 
-    public:
-        void formInterleavedSystem(const std::vector<LinearisedBlackoilResidual::ADB>& eqs,
-                                   Mat& istlA) const
+    private:
+        /// The parameters of the linear solver of precision Scalar.
+        static NewtonIterationBlackoilInterleavedParameters
+        solverParameters(NewtonIterationBlackoilInterleavedParameters param)
         {
-            assert( np == int(eqs.size()) );
-            // Find sparsity structure as union of basic block sparsity structures,
-            // corresponding to the jacobians with respect to pressure.
-            // Use our custom PointOneOp to get to the union structure.
-            // As default we only iterate over the pressure derivatives.
-            Eigen::SparseMatrix<double, Eigen::ColMajor> col_major = eqs[0].derivative()[0].getSparse();
-            detail::PointOneOp<double> point_one;
-            for (int phase = 1; phase < np; ++phase) {
-                const AutoDiffMatrix::SparseRep& mat = eqs[phase].derivative()[0].getSparse();
-                col_major = col_major.binaryExpr(mat, point_one);
+            if (!DoublePrecision::value) {
+                param.linear_solver_reduction_ = std::max(param.linear_solver_reduction_,
+                                                          double(minimumSinglePrecisionReduction));
             }
-            // For some cases (for instance involving Solvent flow) the reasoning for only adding
-            // the pressure derivatives fails. As getting the sparsity pattern is non-trivial, in terms
-            // of work, the full sparsity pattern is only added when required.
-            if (parameters_.require_full_sparsity_pattern_) {
-                for (int p1 = 0; p1 < np; ++p1) {
-                    for (int p2 = 1; p2 < np; ++p2) { // pressure is already added
-                        const AutoDiffMatrix::SparseRep& mat = eqs[p1].derivative()[p2].getSparse();
-                        col_major = col_major.binaryExpr(mat, point_one);
+            return param;
+        }
+
+        /// Solve istlA_ x_ = istlb_ in double precision.
+        void solveSystem(std::true_type) const
+        {
+            istlSolver_.solve( *istlA_, x_, istlb_ );
+            iterations_ = istlSolver_.iterations();
+        }
+
+        /// Solve istlA_ x_ = istlb_ with single precision solves and
+        /// double precision iterative refinement.
+        void solveSystem(std::false_type) const
+        {
+            const int size = istlA_->N();
+
+            // Copy the matrix to solver precision, with the same structure.
+            if (!istlAs_) {
+                istlAs_.reset(new SolverMat(size, size, istlA_->nonzeroes(), SolverMat::row_wise));
+                const typename SolverMat::CreateIterator endrow = istlAs_->createend();
+                for (typename SolverMat::CreateIterator row = istlAs_->createbegin(); row != endrow; ++row) {
+                    const auto& source = (*istlA_)[row.index()];
+                    for (auto col = source.begin(); col != source.end(); ++col) {
+                        row.insert(col.index());
+                    }
+                }
+            }
+            auto target = istlAs_->begin();
+            for (auto row = istlA_->begin(); row != istlA_->end(); ++row, ++target) {
+                auto targetBlock = target->begin();
+                for (auto block = row->begin(); block != row->end(); ++block, ++targetBlock) {
+                    for (int p1 = 0; p1 < np; ++p1) {
+                        for (int p2 = 0; p2 < np; ++p2) {
+                            (*targetBlock)[p1][p2] = (*block)[p1][p2];
+                        }
                     }
                 }
             }
 
-            // Automatically convert the column major structure to a row-major structure
-            Eigen::SparseMatrix<double, Eigen::RowMajor> row_major = col_major;
+            // The residual norm is only available for sequential runs,
+            // in parallel a single solve is done as before.
+            const bool refine = istlSolver_.parallelInformation().type() != typeid(ParallelISTLInformation);
+            const double target_norm = parameters_.linear_solver_reduction_ * istlb_.two_norm();
+
+            Vector r(istlb_);
+            SolverVector rs(size);
+            SolverVector dx(size);
+            iterations_ = 0;
+            bool converged = false;
+            for (int step = 0; step < std::max(mixedParameters_.max_refinement_steps_, 1); ++step) {
+                for (int i = 0; i < size; ++i) {
+                    for (int p = 0; p < np; ++p) {
+                        rs[i][p] = r[i][p];
+                    }
+                }
+                dx = 0.0;
+                istlSolver_.solve( *istlAs_, dx, rs );
+                iterations_ += istlSolver_.iterations();
+                for (int i = 0; i < size; ++i) {
+                    for (int p = 0; p < np; ++p) {
+                        x_[i][p] += dx[i][p];
+                    }
+                }
+                if (!refine || !istlSolver_.converged()) {
+                    converged = istlSolver_.converged();
+                    break;
+                }
 
-            const int size = row_major.rows();
-            assert(size == row_major.cols());
+                // r = b - A x
+                r = istlb_;
+                istlA_->mmv(x_, r);
+                const double norm = r.two_norm();
+                if (norm <= target_norm) {
+                    converged = true;
+                    break;
+                }
+                if (!std::isfinite(norm)) {
+                    break;
+                }
+            }
 
-            {
-                // Create ISTL matrix with interleaved rows and columns (block structured).
-                istlA.setSize(row_major.rows(), row_major.cols(), row_major.nonZeros());
-                istlA.setBuildMode(Mat::row_wise);
-                const int* ia = row_major.outerIndexPtr();
-                const int* ja = row_major.innerIndexPtr();
-                const typename Mat::CreateIterator endrow = istlA.createend();
-                for (typename Mat::CreateIterator row = istlA.createbegin(); row != endrow; ++row) {
-                    const int ri = row.index();
-                    for (int i = ia[ri]; i < ia[ri + 1]; ++i) {
-                        row.insert(ja[i]);
+            if (!converged && !parameters_.ignoreConvergenceFailure_) {
+                const std::string msg("Convergence failure for mixed precision linear solver.");
+                OPM_THROW_NOLOG(LinearSolverProblem, msg);
+            }
+        }
+
+        /// Build the block structure of istlA_ as the union of the
+        /// structures of all cell jacobians and well corrections.
+        void buildStructure(const std::vector<ADB>& eqs,
+                            const std::vector<Sp>& corrections) const
+        {
+            const int size = eqs[0].size();
+            std::vector< std::vector<int> > columns(size);
+            auto addStructure = [&columns](const Sp& s) {
+                for (int col = 0; col < s.outerSize(); ++col) {
+                    for (Sp::InnerIterator it(s, col); it; ++it) {
+                        columns[it.row()].push_back(col);
+                    }
+                }
+            };
+            for (int p1 = 0; p1 < np; ++p1) {
+                for (int p2 = 0; p2 < np; ++p2) {
+                    if (eqs[p1].derivative()[p2].nonZeros() > 0) {
+                        addStructure(eqs[p1].derivative()[p2].getSparse());
                     }
                 }
             }
+            for (const Sp& s : corrections) {
+                addStructure(s);
+            }
+
+            // The diagonal blocks are always present, as needed by ILU.
+            int nnz = 0;
+            for (int row = 0; row < size; ++row) {
+                std::vector<int>& c = columns[row];
+                c.push_back(row);
+                std::sort(c.begin(), c.end());
+                c.erase(std::unique(c.begin(), c.end()), c.end());
+                nnz += c.size();
+            }
 
-            /*
-            // not neeeded since MatrixBlock initially zeros all elements during construction
-            // Set all blocks to zero.
-            for (auto row = istlA.begin(), rowend = istlA.end(); row != rowend; ++row ) {
-                for (auto col = row->begin(), colend = row->end(); col != colend; ++col ) {
-                    *col = 0.0;
+            istlA_.reset(new Mat(size, size, nnz, Mat::row_wise));
+            istlAs_.reset();
+            const typename Mat::CreateIterator endrow = istlA_->createend();
+            for (typename Mat::CreateIterator row = istlA_->createbegin(); row != endrow; ++row) {
+                for (const int col : columns[row.index()]) {
+                    row.insert(col);
                 }
             }
-            */
-
-            /**
-             * Go through all jacobians, and insert in correct spot
-             *
-             * The straight forward way to do this would be to run through each
-             * element in the output matrix, and set all block entries by gathering
-             * from all "input matrices" (derivatives).
-             *
-             * A faster alternative is to instead run through each "input matrix" and
-             * insert its elements in the correct spot in the output matrix.
-             *
-             */
+        }
+
+        /// Add scale * s to component (p1, p2) of the blocks of istlA_.
+        /// Returns false if s has an entry outside the block structure.
+        bool addToSystem(const Sp& s, const int p1, const int p2, const double scale) const
+        {
+            Mat& A = *istlA_;
+            for (int col = 0; col < s.outerSize(); ++col) {
+                for (Sp::InnerIterator it(s, col); it; ++it) {
+                    auto& row = A[it.row()];
+                    const auto block = row.find(col);
+                    if (block == row.end()) {
+                        return false;
+                    }
+                    (*block)[p1][p2] += scale * it.value();
+                }
+            }
+            return true;
+        }
+
+        /// Write the scaled and well-eliminated jacobian into istlA_.
+        /// Returns false if the block structure of istlA_ is too small.
+        bool assembleSystem(const std::vector<ADB>& eqs,
+                            const std::vector<double>& scale,
+                            const std::vector<Sp>& corrections) const
+        {
+            *istlA_ = 0.0;
             for (int p1 = 0; p1 < np; ++p1) {
                 for (int p2 = 0; p2 < np; ++p2) {
-                    // Note that that since these are CSC and not CSR matrices,
-                    // ja contains row numbers instead of column numbers.
-                    const AutoDiffMatrix::SparseRep& s = eqs[p1].derivative()[p2].getSparse();
-                    const int* ia = s.outerIndexPtr();
-                    const int* ja = s.innerIndexPtr();
-                    const double* sa = s.valuePtr();
-                    for (int col = 0; col < size; ++col) {
-                        for (int elem_ix = ia[col]; elem_ix < ia[col + 1]; ++elem_ix) {
-                            const int row = ja[elem_ix];
-                            istlA[row][col][p1][p2] = sa[elem_ix];
-                        }
+                    const AutoDiffMatrix& J = eqs[p1].derivative()[p2];
+                    if (J.nonZeros() > 0 && !addToSystem(J.getSparse(), p1, p2, scale[p1])) {
+                        return false;
+                    }
+                    if (!corrections.empty() && !addToSystem(corrections[p1*np + p2], p1, p2, -scale[p1])) {
+                        return false;
                     }
                 }
             }
+            return true;
         }
 
-
+    public:
         /// Solve the linear system Ax = b, with A being the
         /// combined derivative matrix of the residual and b
         /// being the residual itself.
@@ -201,92 +470,75 @@ namespace Opm
         /// \return               the solution x
         SolutionVector computeNewtonIncrement(const LinearisedBlackoilResidual& residual) const
         {
-            typedef LinearisedBlackoilResidual::ADB  ADB;
-            typedef ADB::V   V;
-
-            // Build the vector of equations.
-            //const int np = residual.material_balance_eq.size();
-            assert( np == int(residual.material_balance_eq.size()) );
-            std::vector<ADB> eqs;
-            eqs.reserve(np + 2);
-            for (int phase = 0; phase < np; ++phase) {
-                eqs.push_back(residual.material_balance_eq[phase]);
-            }
+            const std::vector<ADB>& eqs = residual.material_balance_eq;
+            assert( np == int(eqs.size()) );
+            const int size = eqs[0].size();
 
             // check if wells are present
             const bool hasWells = residual.well_flux_eq.size() > 0 ;
-            std::vector<ADB> elim_eqs;
+            std::unique_ptr<detail::WellSchurComplement> wells;
+            std::vector<Sp> corrections;
             if( hasWells )
             {
-                eqs.push_back(residual.well_flux_eq);
-                eqs.push_back(residual.well_eq);
-
                 // Eliminate the well-related unknowns, and corresponding equations.
-                elim_eqs.reserve(2);
-                elim_eqs.push_back(eqs[np]);
-                eqs = eliminateVariable(eqs, np); // Eliminate well flux unknowns.
-                elim_eqs.push_back(eqs[np]);
-                eqs = eliminateVariable(eqs, np); // Eliminate well bhp unknowns.
-                assert(int(eqs.size()) == np);
-            }
-
-            // Scale material balance equations.
-            for (int phase = 0; phase < np; ++phase) {
-                eqs[phase] = eqs[phase] * residual.matbalscale[phase];
-            }
-
-            // calculating the size for b
-            int size_b = 0;
-            for (int elem = 0; elem < np; ++elem) {
-                const int loc_size = eqs[elem].size();
-                size_b += loc_size;
+                wells.reset(new detail::WellSchurComplement(residual));
+                corrections.resize(np*np);
+                for (int p1 = 0; p1 < np; ++p1) {
+                    for (int p2 = 0; p2 < np; ++p2) {
+                        wells->correction(p1, p2, corrections[p1*np + p2]);
+                    }
+                }
             }
 
-            V b(size_b);
-
-            int pos = 0;
-            for (int elem = 0; elem < np; ++elem) {
-                const int loc_size = eqs[elem].size();
-                b.segment(pos, loc_size) = eqs[elem].value();
-                pos += loc_size;
+            // Write the scaled system into the existing block structure,
+            // rebuilding the structure only if it does not fit.
+            if (!istlA_ || int(istlA_->N()) != size
+                || !assembleSystem(eqs, residual.matbalscale, corrections)) {
+                buildStructure(eqs, corrections);
+                const bool fits = assembleSystem(eqs, residual.matbalscale, corrections);
+                static_cast<void>(fits);
+                assert(fits);
             }
-            assert(pos == size_b);
-
-            // Create ISTL matrix with interleaved rows and columns (block structured).
-            Mat istlA;
-            formInterleavedSystem(eqs, istlA);
-
-            // Solve reduced system.
-            SolutionVector dx(SolutionVector::Zero(b.size()));
 
             // Right hand side.
-            const int size = istlA.N();
-            Vector istlb(size);
-            for (int i = 0; i < size; ++i) {
-                for( int p = 0, idx = i; p<np; ++p, idx += size ) {
-                    istlb[i][p] = b(idx);
+            istlb_.resize(size);
+            for (int p = 0; p < np; ++p) {
+                const double scale = residual.matbalscale[p];
+                const ADB::V& val = eqs[p].value();
+                if (hasWells) {
+                    const Eigen::VectorXd corr = wells->rhsCorrection(p);
+                    for (int i = 0; i < size; ++i) {
+                        istlb_[i][p] = scale * (val[i] - corr[i]);
+                    }
+                } else {
+                    for (int i = 0; i < size; ++i) {
+                        istlb_[i][p] = scale * val[i];
+                    }
                 }
             }
 
             // System solution
-            Vector x(istlA.M());
-            x = 0.0;
+            x_.resize(size);
+            x_ = 0.0;
 
             // solve linear system using ISTL methods
-            istlSolver_.solve( istlA, x, istlb );
+            solveSystem( DoublePrecision() );
 
-            // Copy solver output to dx.
+            // Copy solver output to dx, and compute the well unknowns
+            // from the eliminated equations.
+            const int nw = hasWells ? wells->size() : 0;
+            SolutionVector dx(np*size + nw);
             for (int i = 0; i < size; ++i) {
                 for( int p=0, idx = i; p<np; ++p, idx += size ) {
-                    dx(idx) = x[i][p];
+                    dx(idx) = x_[i][p];
                 }
             }
-
             if ( hasWells ) {
-                // Compute full solution using the eliminated equations.
-                // Recovery in inverse order of elimination.
-                dx = recoverVariable(elim_eqs[1], dx, np);
-                dx = recoverVariable(elim_eqs[0], dx, np);
+                std::vector<Eigen::VectorXd> xp(np);
+                for (int p = 0; p < np; ++p) {
+                    xp[p] = dx.segment(p*size, size).matrix();
+                }
+                dx.tail(nw) = wells->recover(xp).array();
             }
             return dx;
         }
@@ -294,6 +546,14 @@ namespace Opm
     protected:
         ISTLSolverType istlSolver_;
         NewtonIterationBlackoilInterleavedParameters parameters_;
+        MixedPrecisionParameters mixedParameters_;
+        mutable int iterations_;
+        // The interleaved system, kept between calls.
+        mutable std::unique_ptr<Mat> istlA_;
+        mutable Vector istlb_;
+        mutable Vector x_;
+        // Copy of istlA_ in solver precision, if different.
+        mutable std::unique_ptr<SolverMat> istlAs_;
     }; // end NewtonIterationBlackoilInterleavedImpl
 
 
@@ -304,6 +564,8 @@ namespace Opm
       : newtonIncrementDoublePrecision_(),
         newtonIncrementSinglePrecision_(),
         parameters_( param ),
+        reuseParameters_( param ),
+        mixedPrecisionParameters_( param ),
         parallelInformation_(parallelInformation_arg),
         iterations_( 0 )
     {
@@ -318,6 +580,8 @@ namespace Opm
             static const NewtonIterationBlackoilInterface&
             get( NewtonIncVector& newtonIncrements,
                  const NewtonIterationBlackoilInterleavedParameters& param,
+                 const PreconditionerReuseParameters& reuseParam,
+                 const MixedPrecisionParameters& mixedParam,
                  const boost::any& parallelInformation,
                  const int np )
             {
@@ -326,12 +590,12 @@ namespace Opm
                     assert( np < int(newtonIncrements.size()) );
                     // create NewtonIncrement with fixed np
                     if( ! newtonIncrements[ NP ] )
-                        newtonIncrements[ NP ].reset( new NewtonIterationBlackoilInterleavedImpl< NP, Scalar >( param, parallelInformation ) );
+                        newtonIncrements[ NP ].reset( new NewtonIterationBlackoilInterleavedImpl< NP, Scalar >( param, parallelInformation, reuseParam, mixedParam ) );
                     return *(newtonIncrements[ NP ]);
                 }
                 else
                 {
-                    return NewtonIncrement< NP-1, Scalar >::get(newtonIncrements, param, parallelInformation, np );
+                    return NewtonIncrement< NP-1, Scalar >::get(newtonIncrements, param, reuseParam, mixedParam, parallelInformation, np );
                 }
             }
         };
@@ -343,6 +607,8 @@ namespace Opm
             static const NewtonIterationBlackoilInterface&
             get( NewtonIncVector&,
                  const NewtonIterationBlackoilInterleavedParameters&,
+                 const PreconditionerReuseParameters&,
+                 const MixedPrecisionParameters&,
                  const boost::any&,
                  const int np )
             {
@@ -475,9 +741,10 @@ namespace Opm
             return result.first;
         }
 
-        const NewtonIterationBlackoilInterface& newtonIncrement = residual.singlePrecision ?
-            detail::NewtonIncrement< maxNumberEquations_, float  > :: get( newtonIncrementSinglePrecision_, parameters_, parallelInformation_, np ) :
-            detail::NewtonIncrement< maxNumberEquations_, double > :: get( newtonIncrementDoublePrecision_, parameters_, parallelInformation_, np );
+        const bool singlePrecision = residual.singlePrecision || mixedPrecisionParameters_.use_mixed_precision_;
+        const NewtonIterationBlackoilInterface& newtonIncrement = singlePrecision ?
+            detail::NewtonIncrement< maxNumberEquations_, float  > :: get( newtonIncrementSinglePrecision_, parameters_, reuseParameters_, mixedPrecisionParameters_, parallelInformation_, np ) :
+            detail::NewtonIncrement< maxNumberEquations_, double > :: get( newtonIncrementDoublePrecision_, parameters_, reuseParameters_, mixedPrecisionParameters_, parallelInformation_, np );
 
         // compute newton increment
         SolutionVector dx = newtonIncrement.computeNewtonIncrement( residual );
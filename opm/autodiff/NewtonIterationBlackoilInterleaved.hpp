@@ -30,6 +30,7 @@
 #include <opm/common/utility/parameters/ParameterGroup.hpp>
 #include <opm/autodiff/ParallelOverlappingILU0.hpp>
 #include <opm/autodiff/FlowLinearSolverParameters.hpp>
+#include <opm/autodiff/PreconditionerReusePolicy.hpp>
 
 #include <ewoms/common/parametersystem.hh>
 
@@ -41,6 +42,39 @@ namespace Opm
 
     using NewtonIterationBlackoilInterleavedParameters = FlowLinearSolverParameters;
 
+    /// Parameters of the mixed precision linear solve, in which the
+    /// matrix, preconditioner and Krylov iterations use single precision,
+    /// and the solution is refined with double precision residuals.
+    struct MixedPrecisionParameters
+    {
+        /// Whether to always use the mixed precision solve. Otherwise it
+        /// is only used for time steps below max_single_precision_days.
+        bool use_mixed_precision_;
+        /// Maximum number of single precision solves per linear system.
+        int max_refinement_steps_;
+
+        /// Construct with default values.
+        MixedPrecisionParameters()
+        {
+            reset();
+        }
+
+        /// Construct from user parameters or defaults.
+        explicit MixedPrecisionParameters(const ParameterGroup& param)
+        {
+            reset();
+            use_mixed_precision_ = param.getDefault("linear_solver_mixed_precision", use_mixed_precision_);
+            max_refinement_steps_ = param.getDefault("linear_solver_max_refinement_steps", max_refinement_steps_);
+        }
+
+        /// Set default values.
+        void reset()
+        {
+            use_mixed_precision_ = false;
+            max_refinement_steps_ = 5;
+        }
+    };
+
     /// This class solves the fully implicit black-oil system by
     /// solving the reduced system (after eliminating well variables)
     /// as a block-structured matrix (one block for all cell variables).
@@ -52,6 +86,10 @@ namespace Opm
         /// \param[in] param   parameters controlling the behaviour of the linear solvers
         /// \param[in] parallelInformation In the case of a parallel run
         ///                                with dune-istl the information about the parallelization.
+        ///
+        /// Systems marked as singlePrecision, or all systems if
+        /// linear_solver_mixed_precision is set, are solved in mixed
+        /// precision (see MixedPrecisionParameters).
         NewtonIterationBlackoilInterleaved(const ParameterGroup& param,
                                            const boost::any& parallelInformation=boost::any());
 
@@ -75,6 +113,8 @@ namespace Opm
         mutable std::array< std::unique_ptr< NewtonIterationBlackoilInterface >, maxNumberEquations_+1 > newtonIncrementDoublePrecision_;
         mutable std::array< std::unique_ptr< NewtonIterationBlackoilInterface >, maxNumberEquations_+1 > newtonIncrementSinglePrecision_;
         NewtonIterationBlackoilInterleavedParameters parameters_;
+        PreconditionerReuseParameters reuseParameters_;
+        MixedPrecisionParameters mixedPrecisionParameters_;
         boost::any parallelInformation_;
         mutable int iterations_;
     };
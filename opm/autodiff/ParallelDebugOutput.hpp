@@ -19,6 +19,9 @@
 #ifndef OPM_PARALLELDEBUGOUTPUT_HEADER_INCLUDED
 #define OPM_PARALLELDEBUGOUTPUT_HEADER_INCLUDED
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <unordered_set>
 
 #include <opm/common/data/SimulationDataContainer.hpp>
@@ -84,7 +87,8 @@ namespace Opm
                               const EclipseState& /* eclipseState */,
                               const Schedule&,
                               const int,
-                              const Opm::PhaseUsage& )
+                              const Opm::PhaseUsage&,
+                              const int /* gatherGroupSize */ = 0 )
             : grid_( grid ) {}
 
         // gather solution to rank 0 for EclipseWriter
@@ -248,16 +252,29 @@ namespace Opm
         /// \param eclipseState The eclipse file parser output
         /// \param numPhases The number of active phases.
         /// \param permeability The permeabilities  for the global(!) view.
+        /// \param gatherGroupSize The number of ranks sending their data to
+        ///                        one aggregator rank, which forwards it to
+        ///                        the I/O rank. 0 selects a direct gather for
+        ///                        less than 64 ranks, and groups of about
+        ///                        sqrt(#ranks) ranks otherwise.
         ParallelDebugOutput( const Dune::CpGrid& otherGrid,
                              const EclipseState& eclipseState,
                              const Schedule& schedule,
                              const int numPhases,
-                             const Opm::PhaseUsage& phaseUsage)
+                             const Opm::PhaseUsage& phaseUsage,
+                             const int gatherGroupSize = 0 )
             : grid_(),
               eclipseState_( eclipseState ),
               schedule_(schedule),
+              groupSize_(1),
+              aggregatorRank_(ioRank),
+              packedSize_(0),
+              gatherSizesCached_(false),
               globalCellData_(new data::Solution),
+              globalWellStateStep_(-1),
               isIORank_(true),
+              isAggregator_(true),
+              useAggregators_(false),
               phaseUsage_(phaseUsage)
 
         {
@@ -339,6 +356,9 @@ namespace Opm
                 // distribute global id's to io rank for later association of dof's
                 DistributeIndexMapping distIndexMapping( globalIndex_, distributed_grid.globalCell(), localIndexMap_, indexMaps_ );
                 toIORankComm_.exchange( distIndexMapping );
+
+                // set up the communication used for collecting the data
+                setupGather( distributed_grid.comm(), gatherGroupSize );
             }
             else // serial run
             {
@@ -375,10 +395,21 @@ namespace Opm
 
                 if( isIORank )
                 {
-                    // add missing data to global cell data
+                    // add missing data to global cell data. Fields of an
+                    // earlier gather are reused, as they are overwritten
+                    // completely.
                     for (const auto& pair : localCellData_) {
                         const std::string& key = pair.first;
                         std::size_t container_size = numGlobalCells;
+                        auto old = globalCellData_.find(key);
+                        if (old != globalCellData_.end()) {
+                            if (old->second.dim == pair.second.dim &&
+                                old->second.target == pair.second.target &&
+                                old->second.data.size() == container_size) {
+                                continue;
+                            }
+                            globalCellData_.erase(old);
+                        }
                         auto ret = globalCellData_.insert(key, pair.second.dim,
                                                 std::vector<double>(container_size),
                                                 pair.second.target);
@@ -594,6 +625,157 @@ namespace Opm
             }
         };
 
+        /// \brief The index map of the data sent by a rank.
+        ///
+        /// The index maps are ordered as the links of the exchange in the
+        /// constructor, i.e. by rank, with the map of the I/O rank last.
+        static const IndexMapType& indexMapOfRank( const IndexMapStorageType& indexMaps, const int rank )
+        {
+            static_assert( ioRank == 0, "index maps assume that the I/O rank is rank 0" );
+            return ( rank == ioRank ) ? indexMaps.back() : indexMaps[ rank - 1 ];
+        }
+
+        /// \brief Copy bytes from one message buffer to another.
+        static void copyBytes( MessageBufferType& from, MessageBufferType& to, std::size_t bytes )
+        {
+            for( ; bytes >= sizeof( std::uint64_t ); bytes -= sizeof( std::uint64_t ) )
+            {
+                std::uint64_t chunk;
+                from.read( chunk );
+                to.write( chunk );
+            }
+            for( ; bytes > 0; --bytes )
+            {
+                char c;
+                from.read( c );
+                to.write( c );
+            }
+        }
+
+        /// \brief Write the packed data of this rank, preceded by its size.
+        static void writePacked( MessageBufferType& packed, MessageBufferType& buffer )
+        {
+            const std::size_t bytes = packed.size();
+            buffer.write( bytes );
+            packed.resetReadPosition();
+            copyBytes( packed, buffer, bytes );
+        }
+
+        /// \brief First level of the gather: each rank sends its data to the
+        ///        aggregator of its group. The I/O rank unpacks the data it
+        ///        receives, the other aggregators keep it for forwarding.
+        class GatherToAggregator : public P2PCommunicatorType::DataHandleInterface
+        {
+            PackUnPackSimulationDataContainer& packUnpack_;
+            MessageBufferType& packed_;
+            const std::vector< int >& memberRanks_;
+            const IndexMapStorageType& indexMaps_;
+            std::vector< MessageBufferType >& forwarded_;
+            const bool forward_;
+
+        public:
+            GatherToAggregator( PackUnPackSimulationDataContainer& packUnpack,
+                                MessageBufferType& packed,
+                                const std::vector< int >& memberRanks,
+                                const IndexMapStorageType& indexMaps,
+                                std::vector< MessageBufferType >& forwarded,
+                                const bool forward )
+            : packUnpack_( packUnpack ),
+              packed_( packed ),
+              memberRanks_( memberRanks ),
+              indexMaps_( indexMaps ),
+              forwarded_( forwarded ),
+              forward_( forward )
+            {
+            }
+
+            void pack( const int link, MessageBufferType& buffer )
+            {
+                // we should only get one link
+                if( link != 0 ) {
+                    OPM_THROW(std::logic_error,"link in method pack is not 0 as execpted");
+                }
+                writePacked( packed_, buffer );
+            }
+
+            void unpack( const int link, MessageBufferType& buffer )
+            {
+                std::size_t bytes = 0;
+                buffer.read( bytes );
+                if( forward_ ) {
+                    copyBytes( buffer, forwarded_[ link ], bytes );
+                }
+                else {
+                    packUnpack_.doUnpack( indexMapOfRank( indexMaps_, memberRanks_[ link ] ), buffer );
+                }
+            }
+        };
+
+        /// \brief Second level of the gather: the aggregators send their own
+        ///        data and that of their group to the I/O rank.
+        class GatherToIORank : public P2PCommunicatorType::DataHandleInterface
+        {
+            PackUnPackSimulationDataContainer& packUnpack_;
+            MessageBufferType& packed_;
+            const int rank_;
+            const std::vector< int >& memberRanks_;
+            const IndexMapStorageType& indexMaps_;
+            std::vector< MessageBufferType >& forwarded_;
+
+        public:
+            GatherToIORank( PackUnPackSimulationDataContainer& packUnpack,
+                            MessageBufferType& packed,
+                            const int rank,
+                            const std::vector< int >& memberRanks,
+                            const IndexMapStorageType& indexMaps,
+                            std::vector< MessageBufferType >& forwarded )
+            : packUnpack_( packUnpack ),
+              packed_( packed ),
+              rank_( rank ),
+              memberRanks_( memberRanks ),
+              indexMaps_( indexMaps ),
+              forwarded_( forwarded )
+            {
+            }
+
+            void pack( const int link, MessageBufferType& buffer )
+            {
+                // we should only get one link
+                if( link != 0 ) {
+                    OPM_THROW(std::logic_error,"link in method pack is not 0 as execpted");
+                }
+                const int count = 1 + memberRanks_.size();
+                buffer.write( count );
+
+                buffer.write( rank_ );
+                writePacked( packed_, buffer );
+
+                for( std::size_t member = 0; member < memberRanks_.size(); ++member )
+                {
+                    MessageBufferType& data = forwarded_[ member ];
+                    const std::size_t bytes = data.size();
+                    buffer.write( memberRanks_[ member ] );
+                    buffer.write( bytes );
+                    data.resetReadPosition();
+                    copyBytes( data, buffer, bytes );
+                }
+            }
+
+            void unpack( const int /* link */, MessageBufferType& buffer )
+            {
+                int count = 0;
+                buffer.read( count );
+                for( int i = 0; i < count; ++i )
+                {
+                    int rank = -1;
+                    std::size_t bytes = 0;
+                    buffer.read( rank );
+                    buffer.read( bytes );
+                    packUnpack_.doUnpack( indexMapOfRank( indexMaps_, rank ), buffer );
+                }
+            }
+        };
+
         // gather solution to rank 0 for EclipseWriter
         template <class WellState>
         bool collectToIORank( const SimulationDataContainer& /*localReservoirState*/,
@@ -601,10 +783,10 @@ namespace Opm
                               const data::Solution& localCellData,
                               const int wellStateStepNumber )
         {
-            if( isIORank() )
+            if( isIORank() && wellStateStepNumber != globalWellStateStep_ )
             {
                 Dune::CpGrid& globalGrid = *grid_;
-                // Create wells and well state.
+                // Create wells and well state, only once per step.
                 WellsManager wells_manager(eclipseState_,
                                            schedule_,
                                            wellStateStepNumber,
@@ -623,7 +805,22 @@ namespace Opm
 
                 const Wells* wells = wells_manager.c_wells();
                 globalWellState_.initLegacy(wells, *globalReservoirState_, globalWellState_, phaseUsage_ );
-                globalCellData_->clear();
+                globalWellStateStep_ = wellStateStepNumber;
+            }
+
+            if( isIORank() )
+            {
+                // remove the cell data not written in this step, the other
+                // fields are reused
+                for( auto it = globalCellData_->begin(); it != globalCellData_->end(); )
+                {
+                    if( localCellData.find( it->first ) == localCellData.end() ) {
+                        it = globalCellData_->erase( it );
+                    }
+                    else {
+                        ++it;
+                    }
+                }
             }
 
             PackUnPackSimulationDataContainer packUnpack( numCells(),
@@ -632,8 +829,37 @@ namespace Opm
                                                           localIndexMap_, indexMaps_,
                                                           isIORank() );
 
-            //toIORankComm_.exchangeCached( packUnpack );
-            toIORankComm_.exchange( packUnpack );
+            // pack the data of this rank once, into a buffer kept between
+            // the gathers
+            packBuffer_.clear();
+            if( ! isIORank() ) {
+                packUnpack.pack( 0, packBuffer_ );
+            }
+
+            // The message sizes of the previous gather are cached by the
+            // communicators. They are only valid if no rank's data changed
+            // size, otherwise the communicators are created anew.
+            const int sizeChanged = ( packBuffer_.size() != packedSize_ ) ? 1 : 0;
+            packedSize_ = packBuffer_.size();
+            if( toIORankComm_.max( sizeChanged ) > 0 && gatherSizesCached_ ) {
+                createGatherCommunication();
+            }
+            gatherSizesCached_ = true;
+
+            forwardBuffers_.resize( memberRanks_.size() );
+            for( auto& buffer : forwardBuffers_ ) {
+                buffer.clear();
+            }
+
+            // gather to the aggregators, which forward to the I/O rank
+            const bool forward = isAggregator_ && ! isIORank();
+            GatherToAggregator toAggregator( packUnpack, packBuffer_, memberRanks_, indexMaps_, forwardBuffers_, forward );
+            toAggregatorComm_.exchangeCached( toAggregator );
+            if( useAggregators_ )
+            {
+                GatherToIORank toIORank( packUnpack, packBuffer_, toIORankComm_.rank(), memberRanks_, indexMaps_, forwardBuffers_ );
+                aggregatorToIORankComm_.exchangeCached( toIORank );
+            }
 #ifndef NDEBUG
             // make sure every process is on the same page
             toIORankComm_.barrier();
@@ -674,10 +900,97 @@ namespace Opm
         }
 
     protected:
+        // Set up the two level gather of collectToIORank(): the ranks are
+        // split into groups of consecutive ranks, and the first rank of
+        // each group is its aggregator. With a single group this is a
+        // direct gather to the I/O rank.
+        void setupGather( const CollectiveCommunication& comm, int groupSize )
+        {
+            const int rank = comm.rank();
+            const int size = comm.size();
+            if( groupSize <= 0 ) {
+                groupSize = ( size < 64 ) ? size : int( std::ceil( std::sqrt( double( size ) ) ) );
+            }
+            groupSize = std::min( groupSize, size );
+            useAggregators_ = groupSize < size;
+
+            groupSize_ = groupSize;
+            aggregatorRank_ = ( rank / groupSize ) * groupSize;
+            isAggregator_ = ( rank == aggregatorRank_ );
+
+            memberRanks_.clear();
+            if( isAggregator_ )
+            {
+                for( int member = rank + 1; member < std::min( rank + groupSize, size ); ++member )
+                {
+                    memberRanks_.push_back( member );
+                }
+            }
+
+            gatherComm_.reset( new CollectiveCommunication( comm ) );
+            createGatherCommunication();
+        }
+
+        // Create the communicators of the gather, which drops the cached
+        // message sizes.
+        void createGatherCommunication()
+        {
+            const CollectiveCommunication& comm = *gatherComm_;
+            const int rank = comm.rank();
+            const int size = comm.size();
+
+            // first level: group members to aggregator
+            std::set< int > send, recv;
+            if( isAggregator_ ) {
+                recv.insert( memberRanks_.begin(), memberRanks_.end() );
+            }
+            else {
+                send.insert( aggregatorRank_ );
+            }
+            toAggregatorComm_ = comm;
+            toAggregatorComm_.insertRequest( send, recv );
+
+            // second level: aggregators to I/O rank
+            send.clear();
+            recv.clear();
+            if( useAggregators_ )
+            {
+                if( rank == ioRank )
+                {
+                    for( int other = groupSize_; other < size; other += groupSize_ )
+                    {
+                        recv.insert( other );
+                    }
+                }
+                else if( isAggregator_ )
+                {
+                    send.insert( ioRank );
+                }
+            }
+            aggregatorToIORankComm_ = comm;
+            aggregatorToIORankComm_.insertRequest( send, recv );
+            gatherSizesCached_ = false;
+        }
+
         std::unique_ptr< Dune::CpGrid >           grid_;
         const EclipseState&                       eclipseState_;
       const Schedule&                             schedule_;
         P2PCommunicatorType                       toIORankComm_;
+        // communication of the two level gather in collectToIORank
+        P2PCommunicatorType                       toAggregatorComm_;
+        P2PCommunicatorType                       aggregatorToIORankComm_;
+        std::unique_ptr< CollectiveCommunication > gatherComm_;
+        // ranks sending to this rank in the first level of the gather
+        std::vector< int >                        memberRanks_;
+        int                                       groupSize_;
+        int                                       aggregatorRank_;
+        // buffers of the gather, kept to avoid reallocation
+        MessageBufferType                         packBuffer_;
+        std::vector< MessageBufferType >          forwardBuffers_;
+        // size of the data packed by this rank in the last gather
+        std::size_t                               packedSize_;
+        // true if the communicators hold the message sizes of a gather
+        bool                                      gatherSizesCached_;
         IndexMapType                              globalIndex_;
         IndexMapType                              localIndexMap_;
         IndexMapStorageType                       indexMaps_;
@@ -685,8 +998,14 @@ namespace Opm
         std::unique_ptr<data::Solution>           globalCellData_;
         // this needs to be revised
         WellStateFullyImplicitBlackoil            globalWellState_;
+        // step number of the wells of globalWellState_
+        int                                       globalWellStateStep_;
         // true if we are on I/O rank
         bool                                      isIORank_;
+        // true if this rank collects the data of a group of ranks
+        bool                                      isAggregator_;
+        // true if the gather goes through aggregators
+        bool                                      useAggregators_;
         // Phase usage needed to convert solution to simulation data container
         Opm::PhaseUsage phaseUsage_;
     };
@@ -0,0 +1,182 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PRECONDITIONERREUSEPOLICY_HEADER_INCLUDED
+#define OPM_PRECONDITIONERREUSEPOLICY_HEADER_INCLUDED
+
+#include <opm/common/utility/parameters/ParameterGroup.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+namespace Opm
+{
+
+    /// Parameters controlling when a linear solver may use the
+    /// preconditioner of an earlier solve again.
+    struct PreconditionerReuseParameters
+    {
+        /// Whether preconditioners may be reused at all. Off by default.
+        bool reuse_preconditioner_;
+        /// Maximum number of linear solves with the same preconditioner.
+        int max_preconditioner_age_;
+        /// A new preconditioner is built when the number of linear
+        /// iterations exceeds this factor times the number of iterations
+        /// of the first solve with the current preconditioner.
+        double max_iteration_growth_;
+
+        /// Construct with default values.
+        PreconditionerReuseParameters()
+        {
+            reset();
+        }
+
+        /// Construct from user parameters or defaults.
+        explicit PreconditionerReuseParameters(const ParameterGroup& param)
+        {
+            reset();
+            reuse_preconditioner_ = param.getDefault("linear_solver_reuse_preconditioner", reuse_preconditioner_);
+            max_preconditioner_age_ = param.getDefault("linear_solver_max_preconditioner_age", max_preconditioner_age_);
+            max_iteration_growth_ = param.getDefault("linear_solver_max_iteration_growth", max_iteration_growth_);
+        }
+
+        /// Set default values.
+        void reset()
+        {
+            reuse_preconditioner_ = false;
+            max_preconditioner_age_ = 10;
+            max_iteration_growth_ = 1.5;
+        }
+    };
+
+
+
+    /// Keeps track of the preconditioner built for an earlier linear
+    /// solve, and decides whether it may be used for the next one.
+    ///
+    /// A preconditioner is only reused for the same matrix object with
+    /// an unchanged sparsity pattern. A new one is built after a given
+    /// number of solves, or when the number of linear iterations has
+    /// grown too much compared to the first solve with the current
+    /// preconditioner.
+    class PreconditionerReusePolicy
+    {
+    public:
+        explicit PreconditionerReusePolicy(const PreconditionerReuseParameters& param = PreconditionerReuseParameters())
+            : param_(param),
+              valid_(false),
+              matrix_(nullptr),
+              pattern_(0),
+              age_(0),
+              first_iterations_(-1),
+              last_iterations_(-1)
+        {
+        }
+
+        /// Whether preconditioners may be reused at all.
+        bool enabled() const
+        {
+            return param_.reuse_preconditioner_;
+        }
+
+        /// Whether the current preconditioner may be used for the matrix
+        /// at the given address with the given sparsity pattern key.
+        bool reuse(const void* matrix, const std::size_t pattern) const
+        {
+            if (!param_.reuse_preconditioner_ || !valid_) {
+                return false;
+            }
+            if (matrix != matrix_ || pattern != pattern_) {
+                return false;
+            }
+            if (age_ >= param_.max_preconditioner_age_) {
+                return false;
+            }
+            return last_iterations_ <= param_.max_iteration_growth_ * std::max(first_iterations_, 1);
+        }
+
+        /// Record that a new preconditioner was built.
+        void rebuilt(const void* matrix, const std::size_t pattern)
+        {
+            valid_ = true;
+            matrix_ = matrix;
+            pattern_ = pattern;
+            age_ = 0;
+            first_iterations_ = -1;
+            last_iterations_ = -1;
+        }
+
+        /// Record the number of iterations of a solve with the current
+        /// preconditioner.
+        void solved(const int iterations)
+        {
+            if (first_iterations_ < 0) {
+                first_iterations_ = iterations;
+            }
+            last_iterations_ = iterations;
+            ++age_;
+        }
+
+        /// Forget the current preconditioner.
+        void invalidate()
+        {
+            valid_ = false;
+            matrix_ = nullptr;
+        }
+
+        /// Number of solves with the current preconditioner.
+        int age() const
+        {
+            return age_;
+        }
+
+    private:
+        PreconditionerReuseParameters param_;
+        bool valid_;
+        const void* matrix_;
+        std::size_t pattern_;
+        int age_;
+        int first_iterations_;
+        int last_iterations_;
+    };
+
+
+
+    /// A hash of the sparsity pattern of a (Dune) sparse matrix.
+    template <class Matrix>
+    std::size_t sparsityPatternKey(const Matrix& A)
+    {
+        std::size_t key = std::hash<std::size_t>()(A.N());
+        auto combine = [&key](const std::size_t value) {
+            key ^= std::hash<std::size_t>()(value) + 0x9e3779b9 + (key << 6) + (key >> 2);
+        };
+        combine(A.M());
+        for (auto row = A.begin(); row != A.end(); ++row) {
+            combine(row->size());
+            for (auto col = row->begin(); col != row->end(); ++col) {
+                combine(col.index());
+            }
+        }
+        return key;
+    }
+
+} // namespace Opm
+
+#endif // OPM_PRECONDITIONERREUSEPOLICY_HEADER_INCLUDED
@@ -0,0 +1,226 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_PVTEVALUATIONCACHE_HEADER_INCLUDED
+#define OPM_PVTEVALUATIONCACHE_HEADER_INCLUDED
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif // HAVE_OPENMP
+
+namespace Opm
+{
+
+    /**
+     * Cache of cell-wise PVT evaluations.
+     *
+     * A PVT quantity of a cell is a function of the pressure p, the
+     * temperature T, a dissolution factor r and whether the phase is
+     * saturated. The cache stores the values and the derivatives with
+     * respect to p and r of a fixed number of such quantities, for
+     * example the inverse formation volume factor and the viscosity of
+     * a phase, which are evaluated at the same points.
+     *
+     * The inputs of an evaluation are compared exactly with those of
+     * the stored evaluations. The same properties are requested several
+     * times with identical inputs during a Newton iteration, and all
+     * but the first of these requests only copy the stored results.
+     * A few evaluations are kept, so that requests for the well cells
+     * do not evict the evaluation for all cells.
+     *
+     * The cache is not thread-safe: an evaluation may evict the entry
+     * whose result another caller still holds. It must only be used
+     * from serial code, which is checked in debug builds.
+     */
+    class PvtEvaluationCache
+    {
+    public:
+        /// Maximum number of evaluations kept.
+        static const std::size_t maxEntries = 2;
+
+        /// Values and derivatives of the quantities for a set of cells.
+        class Result
+        {
+        public:
+            /// Number of cells.
+            int size() const { return size_; }
+
+            double* value(const int q) { return data(q, 0); }
+            double* dp(const int q) { return data(q, 1); }
+            double* dr(const int q) { return data(q, 2); }
+
+            const double* value(const int q) const { return data(q, 0); }
+            const double* dp(const int q) const { return data(q, 1); }
+            const double* dr(const int q) const { return data(q, 2); }
+
+        private:
+            friend class PvtEvaluationCache;
+
+            double* data(const int q, const int k)
+            {
+                return data_.data() + (3*q + k)*size_;
+            }
+
+            const double* data(const int q, const int k) const
+            {
+                return data_.data() + (3*q + k)*size_;
+            }
+
+            void resize(const int num_quantities, const int n)
+            {
+                size_ = n;
+                data_.assign(3*num_quantities*n, 0.0);
+            }
+
+            int size_ = 0;
+            std::vector<double> data_;
+        };
+
+        /// Construct a cache for the given number of quantities.
+        explicit PvtEvaluationCache(const int num_quantities)
+            : num_quantities_(num_quantities), clock_(0), hits_(0), misses_(0)
+        {
+        }
+
+        /// Return the quantities for the given inputs. If they are not
+        /// stored, evaluate(result) is called to compute them.
+        /// \param[in] cells      Array of n cell indices.
+        /// \param[in] p          Array of n pressure values.
+        /// \param[in] T          Array of n temperature values, or null.
+        /// \param[in] r          Array of n dissolution factors, or null.
+        /// \param[in] saturated  Array of n saturation flags, or empty.
+        /// \param[in] evaluate   Callable filling a Result for n cells.
+        template <class Evaluate>
+        const Result& evaluate(const std::vector<int>& cells,
+                               const double* p,
+                               const double* T,
+                               const double* r,
+                               const std::vector<char>& saturated,
+                               Evaluate&& evaluate)
+        {
+            const int n = cells.size();
+            assert(saturated.empty() || int(saturated.size()) == n);
+#if HAVE_OPENMP
+            assert(!omp_in_parallel());
+#endif // HAVE_OPENMP
+            ++clock_;
+            for (Entry& entry : entries_) {
+                if (entry.matches(cells, p, T, r, saturated)) {
+                    entry.last_used = clock_;
+                    ++hits_;
+                    return entry.result;
+                }
+            }
+
+            ++misses_;
+            Entry* entry = nullptr;
+            if (entries_.size() < maxEntries) {
+                entries_.emplace_back();
+                entry = &entries_.back();
+            } else {
+                entry = &*std::min_element(entries_.begin(), entries_.end(),
+                                           [](const Entry& a, const Entry& b)
+                                           { return a.last_used < b.last_used; });
+            }
+            entry->last_used = clock_;
+            entry->cells = cells;
+            entry->p.assign(p, p + n);
+            assignOptional(entry->T, T, n);
+            assignOptional(entry->r, r, n);
+            entry->saturated = saturated;
+            entry->result.resize(num_quantities_, n);
+            evaluate(entry->result);
+            return entry->result;
+        }
+
+        /// Number of evaluations that reused stored results.
+        std::size_t hits() const
+        {
+            return hits_;
+        }
+
+        /// Number of evaluations that computed new results.
+        std::size_t misses() const
+        {
+            return misses_;
+        }
+
+        /// Forget all stored evaluations.
+        void clear()
+        {
+            entries_.clear();
+        }
+
+    private:
+        struct Entry
+        {
+            std::size_t last_used = 0;
+            std::vector<int> cells;
+            std::vector<double> p;
+            std::vector<double> T;
+            std::vector<double> r;
+            std::vector<char> saturated;
+            Result result;
+
+            bool matches(const std::vector<int>& c,
+                         const double* pp,
+                         const double* TT,
+                         const double* rr,
+                         const std::vector<char>& sat) const
+            {
+                const int n = c.size();
+                return c == cells && sat == saturated
+                    && std::equal(p.begin(), p.end(), pp)
+                    && equalOptional(T, TT, n)
+                    && equalOptional(r, rr, n);
+            }
+        };
+
+        static void assignOptional(std::vector<double>& stored, const double* values, const int n)
+        {
+            if (values) {
+                stored.assign(values, values + n);
+            } else {
+                stored.clear();
+            }
+        }
+
+        static bool equalOptional(const std::vector<double>& stored, const double* values, const int n)
+        {
+            if (!values) {
+                return stored.empty();
+            }
+            return int(stored.size()) == n && std::equal(stored.begin(), stored.end(), values);
+        }
+
+        int num_quantities_;
+        std::vector<Entry> entries_;
+        std::size_t clock_;
+        std::size_t hits_;
+        std::size_t misses_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_PVTEVALUATIONCACHE_HEADER_INCLUDED
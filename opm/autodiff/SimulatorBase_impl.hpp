@@ -316,6 +316,14 @@ namespace Opm
             prev_well_state = well_state;
         }
 
+        // Wait for the output threads to write the last report steps.
+        {
+            Dune::Timer perfTimer;
+            perfTimer.start();
+            output_writer_.flushOutput();
+            report.output_write_time += perfTimer.stop();
+        }
+
         // Stop timer and create timing report
         total_timer.stop();
         report.total_time = total_timer.secsSinceStart();
@@ -687,7 +695,7 @@ namespace Opm
         const int nc = Opm::AutoDiffGrid::numCells(grid_);
         const int np = state.numPhases();
         const PhaseUsage& pu = props_.phaseUsage();
-        const DataBlock s = Eigen::Map<const DataBlock>(& state.saturation()[0], nc, np);
+        const Eigen::Map<const DataBlock> s(& state.saturation()[0], nc, np);
         std::vector<double> so(nc);
         std::vector<double> sg(nc);
         std::vector<double> hydrocarbon(nc);
@@ -40,11 +40,14 @@
 #include <sstream>
 #include <iomanip>
 #include <fstream>
+#include <exception>
+#include <stdexcept>
 
 #include <boost/filesystem.hpp>
 
 //For OutputWriterHelper
 #include <map>
+#include <memory>
 #include <opm/parser/eclipse/Units/UnitSystem.hpp>
 
 
@@ -57,6 +60,37 @@
 namespace Opm
 {
 
+    namespace
+    {
+        /// Tell all processes whether writing failed on the I/O rank,
+        /// and throw on all of them if so.
+        void broadcastOutputError(int err, const std::string& emsg, const bool isIORank)
+        {
+#if HAVE_MPI
+            MPI_Bcast(&err, 1, MPI_INT, 0, MPI_COMM_WORLD);
+#endif
+            if (err) {
+                if (isIORank) {
+                    throw std::runtime_error(emsg);
+                } else {
+                    throw std::runtime_error("I/O process encountered problems.");
+                }
+            }
+        }
+
+        /// The message of the exception currently handled.
+        std::string currentExceptionMessage()
+        {
+            try {
+                throw;
+            } catch (const std::exception& e) {
+                return e.what();
+            } catch (...) {
+                return "Unknown exception during output.";
+            }
+        }
+    } // anonymous namespace
+
 
 
     void outputStateVtk(const UnstructuredGrid& grid,
@@ -175,9 +209,10 @@ namespace Opm
 
     namespace detail {
 
-        struct WriterCall : public ThreadHandle :: ObjectInterface
+        // Copy of the data of one time step, shared by the write calls of
+        // the different writers.
+        struct WriterData
         {
-            BlackoilOutputWriter& writer_;
             std::unique_ptr< SimulatorTimerInterface > timer_;
             const SimulationDataContainer state_;
             const WellStateFullyImplicitBlackoil wellState_;
@@ -186,16 +221,14 @@ namespace Opm
             RestartValue::ExtraVector extraRestartData_;
             const bool substep_;
 
-            explicit WriterCall( BlackoilOutputWriter& writer,
-                                 const SimulatorTimerInterface& timer,
-                                 const SimulationDataContainer& state,
-                                 const WellStateFullyImplicitBlackoil& wellState,
-                                 const data::Solution& simProps,
-                                 const std::map<std::string, double>& miscSummaryData,
-                                 const RestartValue::ExtraVector& extraRestartData,
-                                 bool substep)
-                : writer_( writer ),
-                  timer_( timer.clone() ),
+            WriterData( const SimulatorTimerInterface& timer,
+                        const SimulationDataContainer& state,
+                        const WellStateFullyImplicitBlackoil& wellState,
+                        const data::Solution& simProps,
+                        const std::map<std::string, double>& miscSummaryData,
+                        const RestartValue::ExtraVector& extraRestartData,
+                        bool substep)
+                : timer_( timer.clone() ),
                   state_( state ),
                   wellState_( wellState ),
                   simProps_( simProps ),
@@ -204,12 +237,37 @@ namespace Opm
                   substep_( substep )
             {
             }
+        };
+
+        struct WriterCall
+        {
+            typedef void (BlackoilOutputWriter::*WriteMethod)(const SimulatorTimerInterface&,
+                                                              const SimulationDataContainer&,
+                                                              const WellStateFullyImplicitBlackoil&,
+                                                              const data::Solution&,
+                                                              const std::map<std::string, double>&,
+                                                              const RestartValue::ExtraVector&,
+                                                              bool);
+
+            BlackoilOutputWriter& writer_;
+            WriteMethod method_;
+            std::shared_ptr< const WriterData > data_;
+
+            WriterCall( BlackoilOutputWriter& writer,
+                        WriteMethod method,
+                        const std::shared_ptr< const WriterData >& data )
+                : writer_( writer ),
+                  method_( method ),
+                  data_( data )
+            {
+            }
 
-            // callback to writer's serial writeTimeStep method
+            // callback to one of the writer's serial write methods
             void run ()
             {
                 // write data
-                writer_.writeTimeStepSerial( *timer_, state_, wellState_, simProps_, miscSummaryData_, extraRestartData_, substep_ );
+                const WriterData& d = *data_;
+                (writer_.*method_)( *d.timer_, d.state_, d.wellState_, d.simProps_, d.miscSummaryData_, d.extraRestartData_, d.substep_ );
             }
         };
     }
@@ -283,31 +341,48 @@ namespace Opm
         if( isIORank )
         {
             if( asyncOutput_ ) {
-                // dispatch the write call to the extra thread
-                asyncOutput_->dispatch( detail::WriterCall( *this, timer, state, wellState, cellData, miscSummaryData, extraRestartData, substep ) );
+                // At report steps, wait for the earlier steps to be
+                // written, such that write errors are reported on all
+                // processes below.
+                if( ! substep ) {
+                    try {
+                        asyncOutput_->flush();
+                    } catch (...) {
+                        err = 1;
+                        emsg = currentExceptionMessage();
+                    }
+                }
+
+                // dispatch the write calls to the output threads, Matlab
+                // and ECL output in separate channels
+                if( ! err ) {
+                    try {
+                        auto data = std::make_shared< const detail::WriterData >( timer, state, wellState, cellData, miscSummaryData, extraRestartData, substep );
+                        if( matlabWriter_ ) {
+                            asyncOutput_->dispatch( detail::WriterCall( *this, &BlackoilOutputWriter::writeMatlabTimeStep, data ), 0 );
+                        }
+                        if( eclIO_ ) {
+                            asyncOutput_->dispatch( detail::WriterCall( *this, &BlackoilOutputWriter::writeEclTimeStep, data ), 1 );
+                        }
+                    } catch (...) {
+                        err = 1;
+                        emsg = currentExceptionMessage();
+                    }
+                }
             }
             else {
                 // just write the data to disk
                 try {
                     writeTimeStepSerial( timer, state, wellState, cellData, miscSummaryData, extraRestartData, substep );
-                } catch (std::runtime_error& msg) {
+                } catch (...) {
                     err = 1;
-                    emsg = msg.what();
+                    emsg = currentExceptionMessage();
                 }
             }
         }
 
-        if (!asyncOutput_) {
-#if HAVE_MPI
-            MPI_Bcast(&err, 1, MPI_INT, 0, MPI_COMM_WORLD);
-#endif
-            if (err) {
-                if (isIORank) {
-                    throw std::runtime_error(emsg);
-                } else {
-                    throw std::runtime_error("I/O process encountered problems.");
-                }
-            }
+        if (!asyncOutput_ || !substep) {
+            broadcastOutputError(err, emsg, isIORank);
         }
     }
 
@@ -323,12 +398,39 @@ namespace Opm
                         const RestartValue::ExtraVector& extraRestartData,
                         bool substep)
     {
-        // Matlab output
+        writeMatlabTimeStep( timer, state, wellState, simProps, miscSummaryData, extraRestartData, substep );
+        writeEclTimeStep( timer, state, wellState, simProps, miscSummaryData, extraRestartData, substep );
+    }
+
+
+
+    void
+    BlackoilOutputWriter::
+    writeMatlabTimeStep(const SimulatorTimerInterface& timer,
+                        const SimulationDataContainer& state,
+                        const WellStateFullyImplicitBlackoil& wellState,
+                        const data::Solution& /* simProps */,
+                        const std::map<std::string, double>& /* miscSummaryData */,
+                        const RestartValue::ExtraVector& /* extraRestartData */,
+                        bool substep)
+    {
         if( matlabWriter_ ) {
             matlabWriter_->writeTimeStep( timer, state, wellState, substep );
         }
+    }
+
 
-        // ECL output
+
+    void
+    BlackoilOutputWriter::
+    writeEclTimeStep(const SimulatorTimerInterface& timer,
+                     const SimulationDataContainer& /* state */,
+                     const WellStateFullyImplicitBlackoil& wellState,
+                     const data::Solution& simProps,
+                     const std::map<std::string, double>& miscSummaryData,
+                     const RestartValue::ExtraVector& extraRestartData,
+                     bool substep)
+    {
         if ( eclIO_ )
         {
             const auto& initConfig = eclipseState_.getInitConfig();
@@ -358,6 +460,23 @@ namespace Opm
     }
 
 
+    void BlackoilOutputWriter::flushOutput()
+    {
+        if( asyncOutput_ ) {
+            const bool isIORank = parallelOutput_ ? parallelOutput_->isIORank() : true;
+            int err = 0;
+            std::string emsg;
+            try {
+                asyncOutput_->flush();
+            } catch (...) {
+                err = 1;
+                emsg = currentExceptionMessage();
+            }
+            broadcastOutputError(err, emsg, isIORank);
+        }
+    }
+
+
     bool BlackoilOutputWriter::isRestart() const {
         const auto& initconfig = eclipseState_.getInitConfig();
         return initconfig.restartRequested();
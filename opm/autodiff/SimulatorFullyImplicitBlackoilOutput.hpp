@@ -47,6 +47,7 @@
 #include <opm/parser/eclipse/EclipseState/InitConfig/InitConfig.hpp>
 #include <opm/simulators/ensureDirectoryExists.hpp>
 
+#include <algorithm>
 #include <string>
 #include <sstream>
 #include <iomanip>
@@ -276,6 +277,13 @@ namespace Opm
                                  const RestartValue::ExtraVector& extraRestartData,
                                  bool substep );
 
+        /*!
+         * \brief Wait until all time steps dispatched to the output
+         *        threads have been written. Throws on all processes
+         *        if writing failed on the I/O rank.
+         */
+        void flushOutput();
+
         /** \brief return output directory */
         const std::string& outputDirectory() const { return outputDir_; }
 
@@ -300,6 +308,25 @@ namespace Opm
         bool requireFIPNUM() const;
 
     protected:
+        // The Matlab part of writeTimeStepSerial().
+        void writeMatlabTimeStep(const SimulatorTimerInterface& timer,
+                                 const SimulationDataContainer& reservoirState,
+                                 const Opm::WellStateFullyImplicitBlackoil& wellState,
+                                 const data::Solution& simProps,
+                                 const std::map<std::string, double>& miscSummaryData,
+                                 const RestartValue::ExtraVector& extraRestartData,
+                                 bool substep );
+
+        // The ECL part of writeTimeStepSerial().
+        void writeEclTimeStep(const SimulatorTimerInterface& timer,
+                              const SimulationDataContainer& reservoirState,
+                              const Opm::WellStateFullyImplicitBlackoil& wellState,
+                              const data::Solution& simProps,
+                              const std::map<std::string, double>& miscSummaryData,
+                              const RestartValue::ExtraVector& extraRestartData,
+                              bool substep );
+
+
         const bool output_;
         std::unique_ptr< ParallelDebugOutputInterface > parallelOutput_;
 
@@ -341,7 +368,8 @@ namespace Opm
                 return ( outputString == "all" ||  outputString == "true" );
             }()
             ),
-        parallelOutput_( output_ ? new ParallelDebugOutput< Grid >( grid, eclipseState, schedule, phaseUsage.num_phases, phaseUsage ) : 0 ),
+        parallelOutput_( output_ ? new ParallelDebugOutput< Grid >( grid, eclipseState, schedule, phaseUsage.num_phases, phaseUsage,
+                                                                      param.getDefault("output_gather_group_size", 0) ) : 0 ),
         outputDir_( eclipseState.getIOConfig().getOutputDir() ),
         restart_double_si_( output_ ? param.getDefault("restart_double_si", false) : false ),
         phaseUsage_( phaseUsage ),
@@ -382,8 +410,11 @@ namespace Opm
                 ensureDirectoryExists(outputDir_);
             }
 
-            // create output thread if enabled and rank is I/O rank
-            // async output is enabled by default if pthread are enabled
+            // create output threads if enabled and rank is I/O rank
+            // async output is enabled by default if pthread are enabled.
+            // Matlab and ECL output are written by separate threads if
+            // output_threads > 1, and at most output_queue_size time steps
+            // are waiting to be written before the simulator is held back.
 #if HAVE_PTHREAD
             const bool asyncOutputDefault = true;
 #else
@@ -393,7 +424,9 @@ namespace Opm
             {
                 const bool isIORank = parallelOutput_ ? parallelOutput_->isIORank() : true;
 #if HAVE_PTHREAD
-                asyncOutput_.reset( new ThreadHandle( isIORank ) );
+                const int numThreads = param.getDefault("output_threads", 1);
+                const int maxQueueSize = param.getDefault("output_queue_size", 2);
+                asyncOutput_.reset( new ThreadHandle( isIORank, numThreads, std::max( maxQueueSize, 0 ) ) );
 #else
                 OPM_THROW(std::runtime_error,"Pthreads were not found, cannot enable async_output");
 #endif
@@ -55,6 +55,8 @@ namespace Opm
         ///     nl_pressure_maxiter (10)       max nonlinear iterations in pressure
         ///     nl_maxiter (30)                max nonlinear iterations in transport
         ///     nl_tolerance (1e-9)            transport solver absolute residual tolerance
+        ///     nl_batch_levels (false)        solve independent cells of the reorder transport
+        ///                                    solver together, see TransportSolverTwophaseReorder
         ///     num_transport_substeps (1)     number of transport steps per pressure step
         ///     use_segregation_split (false)  solve for gravity segregation (if false,
         ///                                    segregation is ignored).
@@ -0,0 +1,261 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_SPARSEPRODUCTCACHE_HEADER_INCLUDED
+#define OPM_SPARSEPRODUCTCACHE_HEADER_INCLUDED
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+
+#include <Eigen/Sparse>
+
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Opm
+{
+
+    /**
+     * Cache of the symbolic phase of sparse products lhs * rhs, for a
+     * lhs with fixed sparsity pattern such as the discrete gradient and
+     * divergence operators of HelperOps.
+     *
+     * The first product with given sparsity patterns of lhs and rhs computes
+     * the pattern of the result, and for every elementary product
+     * lhs(i,k) * rhs(k,j) the position in the result it contributes
+     * to. Later products with the same rhs pattern only accumulate the
+     * values into the stored result pattern, without the masking and
+     * sorting done by fastSparseProduct(). Both patterns are compared
+     * in full, so a lhs with a different pattern only gives a miss.
+     *
+     * Since the jacobian blocks of a quantity typically have different
+     * patterns, a few patterns are kept per cache. The cache may be
+     * used from several threads at the same time.
+     */
+    class SparseProductCache
+    {
+    public:
+        typedef Eigen::SparseMatrix<double> SparseRep;
+        typedef std::remove_pointer<decltype(std::declval<SparseRep&>().innerIndexPtr())>::type StorageIndex;
+
+        /// Maximum number of rhs patterns kept.
+        static const std::size_t maxPatterns = 16;
+
+        SparseProductCache()
+            : next_(0), hits_(0), misses_(0)
+        {
+        }
+
+        // A copy starts with an empty cache.
+        SparseProductCache(const SparseProductCache&)
+            : SparseProductCache()
+        {
+        }
+
+        SparseProductCache& operator=(const SparseProductCache&)
+        {
+            clear();
+            return *this;
+        }
+
+        /// Compute res = lhs * rhs. Both lhs and rhs must be compressed.
+        void multiply(const SparseRep& lhs, const SparseRep& rhs, SparseRep& res)
+        {
+            assert(lhs.isCompressed() && rhs.isCompressed());
+            assert(lhs.cols() == rhs.rows());
+            const std::shared_ptr<const Pattern> pattern = lookup(lhs, rhs);
+
+            res.resize(lhs.rows(), rhs.cols());
+            res.resizeNonZeros(pattern->res_inner.size());
+            std::copy(pattern->res_outer.begin(), pattern->res_outer.end(), res.outerIndexPtr());
+            std::copy(pattern->res_inner.begin(), pattern->res_inner.end(), res.innerIndexPtr());
+
+            double* values = res.valuePtr();
+            std::fill(values, values + res.nonZeros(), 0.0);
+            const StorageIndex* lhs_outer = lhs.outerIndexPtr();
+            const double* lhs_values = lhs.valuePtr();
+            const StorageIndex* rhs_outer = rhs.outerIndexPtr();
+            const StorageIndex* rhs_inner = rhs.innerIndexPtr();
+            const double* rhs_values = rhs.valuePtr();
+            const StorageIndex* target = pattern->target.data();
+            const int cols = rhs.cols();
+            for (int j = 0; j < cols; ++j) {
+                for (StorageIndex r = rhs_outer[j]; r < rhs_outer[j + 1]; ++r) {
+                    const double y = rhs_values[r];
+                    const StorageIndex k = rhs_inner[r];
+                    for (StorageIndex l = lhs_outer[k]; l < lhs_outer[k + 1]; ++l) {
+                        values[*target++] += lhs_values[l] * y;
+                    }
+                }
+            }
+        }
+
+        /// Number of products that reused a stored pattern.
+        std::size_t hits() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return hits_;
+        }
+
+        /// Number of products that computed a new pattern.
+        std::size_t misses() const
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return misses_;
+        }
+
+        /// Forget all stored patterns.
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            patterns_.clear();
+            next_ = 0;
+        }
+
+    private:
+        struct Pattern
+        {
+            int lhs_rows;
+            int lhs_cols;
+            int rhs_cols;
+            std::vector<StorageIndex> lhs_outer;
+            std::vector<StorageIndex> lhs_inner;
+            std::vector<StorageIndex> rhs_outer;
+            std::vector<StorageIndex> rhs_inner;
+            std::vector<StorageIndex> res_outer;
+            std::vector<StorageIndex> res_inner;
+            // Result position of each elementary product, in the order
+            // the products are visited by multiply().
+            std::vector<StorageIndex> target;
+
+            bool matches(const SparseRep& lhs, const SparseRep& rhs) const
+            {
+                return lhs.rows() == lhs_rows && lhs.cols() == lhs_cols && rhs.cols() == rhs_cols
+                    && std::size_t(rhs.nonZeros()) == rhs_inner.size()
+                    && std::size_t(lhs.nonZeros()) == lhs_inner.size()
+                    && std::equal(rhs_outer.begin(), rhs_outer.end(), rhs.outerIndexPtr())
+                    && std::equal(rhs_inner.begin(), rhs_inner.end(), rhs.innerIndexPtr())
+                    && std::equal(lhs_outer.begin(), lhs_outer.end(), lhs.outerIndexPtr())
+                    && std::equal(lhs_inner.begin(), lhs_inner.end(), lhs.innerIndexPtr());
+            }
+        };
+
+        std::shared_ptr<const Pattern> lookup(const SparseRep& lhs, const SparseRep& rhs)
+        {
+            // Compare the patterns outside the lock, other threads may
+            // use the cache for other blocks at the same time.
+            std::vector<std::shared_ptr<const Pattern>> candidates;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                candidates = patterns_;
+            }
+            for (const auto& pattern : candidates) {
+                if (pattern->matches(lhs, rhs)) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    ++hits_;
+                    return pattern;
+                }
+            }
+
+            std::shared_ptr<const Pattern> pattern = symbolic(lhs, rhs);
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++misses_;
+            if (patterns_.size() < maxPatterns) {
+                patterns_.push_back(pattern);
+            } else {
+                patterns_[next_] = pattern;
+                next_ = (next_ + 1) % maxPatterns;
+            }
+            return pattern;
+        }
+
+        static std::shared_ptr<const Pattern> symbolic(const SparseRep& lhs, const SparseRep& rhs)
+        {
+            auto pattern = std::make_shared<Pattern>();
+            const int rows = lhs.rows();
+            const int cols = rhs.cols();
+            pattern->lhs_rows = rows;
+            pattern->lhs_cols = lhs.cols();
+            pattern->rhs_cols = cols;
+            pattern->lhs_outer.assign(lhs.outerIndexPtr(), lhs.outerIndexPtr() + lhs.cols() + 1);
+            pattern->lhs_inner.assign(lhs.innerIndexPtr(), lhs.innerIndexPtr() + lhs.nonZeros());
+            pattern->rhs_outer.assign(rhs.outerIndexPtr(), rhs.outerIndexPtr() + cols + 1);
+            pattern->rhs_inner.assign(rhs.innerIndexPtr(), rhs.innerIndexPtr() + rhs.nonZeros());
+            pattern->res_outer.resize(cols + 1);
+            pattern->res_outer[0] = 0;
+
+            const StorageIndex* lhs_outer = lhs.outerIndexPtr();
+            const StorageIndex* lhs_inner = lhs.innerIndexPtr();
+            const StorageIndex* rhs_outer = rhs.outerIndexPtr();
+            const StorageIndex* rhs_inner = rhs.innerIndexPtr();
+
+            // position[i] is the index of row i within the current column
+            // of the result, or -1.
+            std::vector<StorageIndex> position(rows, -1);
+            std::vector<StorageIndex> column;
+            std::vector<StorageIndex> slots;
+            for (int j = 0; j < cols; ++j) {
+                column.clear();
+                slots.clear();
+                for (StorageIndex r = rhs_outer[j]; r < rhs_outer[j + 1]; ++r) {
+                    const StorageIndex k = rhs_inner[r];
+                    for (StorageIndex l = lhs_outer[k]; l < lhs_outer[k + 1]; ++l) {
+                        const StorageIndex i = lhs_inner[l];
+                        if (position[i] < 0) {
+                            position[i] = column.size();
+                            column.push_back(i);
+                        }
+                        slots.push_back(i);
+                    }
+                }
+                std::sort(column.begin(), column.end());
+                const StorageIndex offset = pattern->res_inner.size();
+                for (std::size_t p = 0; p < column.size(); ++p) {
+                    position[column[p]] = offset + p;
+                }
+                for (const StorageIndex i : slots) {
+                    pattern->target.push_back(position[i]);
+                }
+                for (const StorageIndex i : column) {
+                    position[i] = -1;
+                }
+                pattern->res_inner.insert(pattern->res_inner.end(), column.begin(), column.end());
+                pattern->res_outer[j + 1] = pattern->res_inner.size();
+            }
+            return pattern;
+        }
+
+        mutable std::mutex mutex_;
+        std::vector<std::shared_ptr<const Pattern>> patterns_;
+        std::size_t next_;
+        std::size_t hits_;
+        std::size_t misses_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_SPARSEPRODUCTCACHE_HEADER_INCLUDED
@@ -27,13 +27,29 @@
 #include <cassert>
 #include <dune/common/exceptions.hh>
 
-#include <thread>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <thread>
+#include <vector>
 
 namespace Opm
 {
 
+  /// \brief Runs objects dispatched to it in a set of worker threads.
+  ///
+  /// Objects are run in the order they are dispatched within each channel,
+  /// objects in different channels may run concurrently if there is more
+  /// than one worker thread. The queue of waiting objects may be bounded,
+  /// in which case dispatch() blocks until there is space in the queue.
+  /// The workers sleep until objects are dispatched.
+  ///
+  /// Exceptions thrown by an object are kept, and the first one is thrown
+  /// again by the next call to flush().
   class ThreadHandle
   {
   public:
@@ -47,7 +63,6 @@ namespace Opm
     public:
       virtual ~ObjectInterface() {}
       virtual void run() = 0;
-      virtual bool isEndMarker () const { return false; }
     };
 
     /// \brief ObjectWrapper class
@@ -64,140 +79,131 @@ namespace Opm
 
   protected:
 
-    /// \brief EndObject class
-    /// Empthy object marking thread termination.
-    class EndObject : public ObjectInterface
+    /// \brief An object waiting in the queue, and its channel.
+    struct QueueEntry
     {
-    public:
-      void run () { }
-      bool isEndMarker () const { return true; }
+      std::unique_ptr< ObjectInterface > obj;
+      int channel;
     };
 
-
-    /// \brief The ThreadHandleQueue class
-    /// Queue of objects to be handled by this thread.
-    class ThreadHandleQueue
+    std::vector< std::thread > threads_;
+    std::deque< QueueEntry > queue_;
+    const std::size_t maxQueueSize_;
+
+    std::mutex mutex_;
+    // signalled when an object is queued or a channel is released
+    std::condition_variable workAvailable_;
+    // signalled when an object is taken from the queue
+    std::condition_variable spaceAvailable_;
+    // signalled when the queue is empty and no object is running
+    std::condition_variable idle_;
+
+    // channels of the objects currently running
+    std::vector< int > busyChannels_;
+    bool stop_;
+    std::exception_ptr error_;
+
+    // first queued object whose channel is not busy
+    std::deque< QueueEntry >::iterator nextRunnable()
     {
-    public:
-      //! constructor creating object that is executed by thread
-      ThreadHandleQueue()
-        : objQueue_(), mutex_()
-      {
-      }
+      return std::find_if( queue_.begin(), queue_.end(), [this]( const QueueEntry& entry ) {
+          return std::find( busyChannels_.begin(), busyChannels_.end(), entry.channel ) == busyChannels_.end();
+        } );
+    }
 
-      ~ThreadHandleQueue()
+    //! do the work until the handle is stopped and the queue is empty
+    void workerLoop()
+    {
+      std::unique_lock< std::mutex > lock( mutex_ );
+      for( ;; )
       {
-        // wait until all objects have been written.
-        while( ! objQueue_.empty() )
-        {
-            wait();
+        auto next = queue_.end();
+        workAvailable_.wait( lock, [ this, &next ] () {
+            next = nextRunnable();
+            return next != queue_.end() || ( stop_ && queue_.empty() );
+          } );
+        if( next == queue_.end() ) {
+          return;
         }
-      }
 
-      //! insert object into threads queue
-      void push_back( std::unique_ptr< ObjectInterface >&& obj )
-      {
-        // lock mutex to make sure objPtr is not used
-        mutex_.lock();
-        objQueue_.emplace( std::move(obj) );
-        mutex_.unlock();
-      }
+        // take object from queue
+        QueueEntry entry( std::move( *next ) );
+        queue_.erase( next );
+        busyChannels_.push_back( entry.channel );
+        spaceAvailable_.notify_one();
+        lock.unlock();
 
-      //! do the work until the queue received an end object
-      void run()
-      {
-        // wait until objects have been pushed to the queue
-        while( objQueue_.empty() )
-        {
-          // sleep one second
-          wait();
+        // execute object action
+        try {
+          entry.obj->run();
         }
-
-        {
-            // lock mutex for access to objQueue_
-            mutex_.lock();
-
-            // get next object from queue
-            std::unique_ptr< ObjectInterface > obj( objQueue_.front().release() );
-            // remove object from queue
-            objQueue_.pop();
-
-            // unlock mutex for access to objQueue_
-            mutex_.unlock();
-
-            // if object is end marker terminate thread
-            if( obj->isEndMarker() ){
-                if( ! objQueue_.empty() ) {
-                    throw std::logic_error("ThreadHandleQueue: not all queued objects were executed");
-                }
-                return;
-            }
-
-            // execute object action
-            obj->run();
+        catch( ... ) {
+          lock.lock();
+          if( ! error_ ) {
+            error_ = std::current_exception();
+          }
+          lock.unlock();
         }
+        entry.obj.reset();
 
-        // keep thread running
-        run();
-      }
-
-    protected:
-      std::queue< std::unique_ptr< ObjectInterface > > objQueue_;
-      std::mutex  mutex_;
-
-      // no copying
-      ThreadHandleQueue( const ThreadHandleQueue& ) = delete;
-
-      // wait duration of 10 milli seconds
-      void wait() const
-      {
-          std::this_thread::sleep_for( std::chrono::milliseconds(10) );
+        lock.lock();
+        busyChannels_.erase( std::find( busyChannels_.begin(), busyChannels_.end(), entry.channel ) );
+        workAvailable_.notify_all();
+        if( queue_.empty() && busyChannels_.empty() ) {
+          idle_.notify_all();
+        }
       }
-    }; // end ThreadHandleQueue
-
-    ////////////////////////////////////////////////////
-    //  end ThreadHandleQueue
-    ////////////////////////////////////////////////////
+    }
 
-    // start the thread by calling method run
-    static void startThread( ThreadHandleQueue* obj )
+    // wait until all queued objects have been run
+    void waitIdle( std::unique_lock< std::mutex >& lock )
     {
-       obj->run();
+      idle_.wait( lock, [ this ] () { return queue_.empty() && busyChannels_.empty(); } );
     }
 
-    ThreadHandleQueue threadObjectQueue_;
-    std::unique_ptr< std::thread > thread_;
-
   private:
     // prohibit copying
     ThreadHandle( const ThreadHandle& ) = delete;
 
   public:
     //! constructor creating ThreadHandle
-    //! \param isIORank  if true thread is created
-    ThreadHandle( const bool createThread )
-      : threadObjectQueue_(),
-        thread_()
+    //! \param createThread  if true worker threads are created
+    //! \param numThreads    number of worker threads
+    //! \param maxQueueSize  maximal number of waiting objects, 0 for no limit
+    ThreadHandle( const bool createThread, const int numThreads = 1,
+                  const std::size_t maxQueueSize = 0 )
+      : threads_(),
+        queue_(),
+        maxQueueSize_( maxQueueSize ),
+        stop_( false ),
+        error_()
     {
         if( createThread )
         {
-           thread_.reset( new std::thread( startThread, &threadObjectQueue_ ) );
-           // detach thread into nirvana
-           thread_->detach();
+            const int n = std::max( numThreads, 1 );
+            for( int i = 0; i < n; ++i ) {
+                threads_.emplace_back( [ this ] () { workerLoop(); } );
+            }
         }
     } // end constructor
 
-    //! dispatch object to queue of separate thread
+    //! dispatch object to queue of worker threads
+    //! \param channel  objects in the same channel are run in dispatch order
     template <class Object>
-    void dispatch( Object&& obj )
+    void dispatch( Object&& obj, const int channel = 0 )
     {
-        if( thread_ )
+        if( ! threads_.empty() )
         {
             typedef ObjectWrapper< Object >  ObjectPointer;
-            ObjectInterface* objPtr = new ObjectPointer( std::move(obj) );
-
-            // add object to queue of objects
-            threadObjectQueue_.push_back( std::unique_ptr< ObjectInterface > (objPtr) );
+            std::unique_ptr< ObjectInterface > objPtr( new ObjectPointer( std::move(obj) ) );
+
+            std::unique_lock< std::mutex > lock( mutex_ );
+            // apply backpressure if the queue is full
+            spaceAvailable_.wait( lock, [ this ] () {
+                return maxQueueSize_ == 0 || queue_.size() < maxQueueSize_;
+              } );
+            queue_.push_back( QueueEntry{ std::move( objPtr ), channel } );
+            workAvailable_.notify_one();
         }
         else
         {
@@ -205,13 +211,49 @@ namespace Opm
         }
     }
 
-    //! destructor terminating the thread
+    //! wait until all dispatched objects have been run, and throw the
+    //! first exception thrown by any of them since the last flush
+    void flush()
+    {
+        std::unique_lock< std::mutex > lock( mutex_ );
+        waitIdle( lock );
+        if( error_ ) {
+            std::exception_ptr error;
+            std::swap( error, error_ );
+            std::rethrow_exception( error );
+        }
+    }
+
+    //! number of worker threads
+    int numThreads() const
+    {
+        return threads_.size();
+    }
+
+    //! destructor running the remaining objects and joining the threads
     ~ThreadHandle()
     {
-        if( thread_ )
+        if( ! threads_.empty() )
         {
-            // dispatch end object which will terminate the thread
-            threadObjectQueue_.push_back( std::unique_ptr< ObjectInterface > (new EndObject()) ) ;
+            {
+                std::unique_lock< std::mutex > lock( mutex_ );
+                stop_ = true;
+            }
+            workAvailable_.notify_all();
+            for( auto& thread : threads_ ) {
+                thread.join();
+            }
+            if( error_ ) {
+                try {
+                    std::rethrow_exception( error_ );
+                }
+                catch( const std::exception& e ) {
+                    std::cerr << "ThreadHandle: error in dispatched object: " << e.what() << std::endl;
+                }
+                catch( ... ) {
+                    std::cerr << "ThreadHandle: unknown error in dispatched object" << std::endl;
+                }
+            }
         }
     }
   };
@@ -0,0 +1,226 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_UPDATABLEPRECONDITIONER_HEADER_INCLUDED
+#define OPM_UPDATABLEPRECONDITIONER_HEADER_INCLUDED
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+
+#include <dune/common/version.hh>
+#include <dune/istl/ilu.hh>
+#include <dune/istl/operators.hh>
+#include <dune/istl/preconditioner.hh>
+#include <dune/istl/preconditioners.hh>
+#include <dune/istl/solvers.hh>
+#include <dune/istl/paamg/amg.hh>
+#if HAVE_SUITESPARSE_UMFPACK
+#include <dune/istl/umfpack.hh>
+#elif HAVE_SUPERLU
+#include <dune/istl/superlu.hh>
+#endif
+
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <cassert>
+#include <memory>
+
+namespace Opm
+{
+
+    /// A sequential ILU(0) preconditioner that can be refactorized when
+    /// the values of its matrix change. The factors are kept in a copy of
+    /// the matrix, and update() copies the current values into it and
+    /// repeats the numeric factorization, without allocating. The
+    /// sparsity pattern of the matrix must not change.
+    template <class M, class X, class Y>
+    class UpdatableSeqILU0 : public Dune::Preconditioner<X, Y>
+    {
+    public:
+        typedef M matrix_type;
+        typedef X domain_type;
+        typedef Y range_type;
+        typedef typename X::field_type field_type;
+
+#if ! DUNE_VERSION_NEWER(DUNE_ISTL, 2, 6)
+        enum { category = Dune::SolverCategory::sequential };
+#endif
+
+        /// \param[in] A  matrix to factorize, which must outlive the preconditioner
+        /// \param[in] w  relaxation factor
+        UpdatableSeqILU0(const M& A, const field_type w)
+            : A_(A),
+              ilu_(A),
+              w_(w)
+        {
+            Dune::bilu0_decomposition(ilu_);
+        }
+
+        /// Factorize the current values of the matrix.
+        void update()
+        {
+            assert(A_.N() == ilu_.N() && A_.nonzeroes() == ilu_.nonzeroes());
+            auto target = ilu_.begin();
+            for (auto row = A_.begin(); row != A_.end(); ++row, ++target) {
+                auto block = target->begin();
+                for (auto col = row->begin(); col != row->end(); ++col, ++block) {
+                    assert(block.index() == col.index());
+                    *block = *col;
+                }
+            }
+            Dune::bilu0_decomposition(ilu_);
+        }
+
+        void pre(X&, Y&)
+        {
+        }
+
+        void apply(X& v, const Y& d)
+        {
+            Dune::bilu_backsolve(ilu_, v, d);
+            v *= w_;
+        }
+
+        void post(X&)
+        {
+        }
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2, 6)
+        Dune::SolverCategory::Category category() const
+        {
+            return Dune::SolverCategory::sequential;
+        }
+#endif
+
+    private:
+        const M& A_;
+        M ilu_;
+        field_type w_;
+    };
+
+
+
+    /// A sequential AMG preconditioner that keeps its aggregates when the
+    /// values of the fine level matrix change. update() recomputes the
+    /// coarse level (Galerkin) matrices and then builds new smoothers and
+    /// a new coarse solver from them, so that every level of the cycle
+    /// refers to the current matrix. Only the aggregation is that of the
+    /// matrix the preconditioner was built with.
+    template <class Operator, class X, class Smoother>
+    class UpdatableAMG : public Dune::Preconditioner<X, X>
+    {
+    public:
+        typedef Dune::Amg::SequentialInformation ParallelInformation;
+        typedef Dune::Amg::AMG<Operator, X, Smoother, ParallelInformation> AMG;
+        typedef typename AMG::OperatorHierarchy OperatorHierarchy;
+        typedef typename AMG::SmootherArgs SmootherArgs;
+        typedef typename AMG::CoarseSolver CoarseSolver;
+        typedef typename Operator::matrix_type Matrix;
+        typedef X domain_type;
+        typedef X range_type;
+        typedef typename X::field_type field_type;
+
+#if ! DUNE_VERSION_NEWER(DUNE_ISTL, 2, 6)
+        enum { category = Dune::SolverCategory::sequential };
+#endif
+
+        /// Aggregate the matrix of op and set up the levels.
+        /// \param[in] op            fine level operator, which must outlive the preconditioner
+        /// \param[in] criterion     coarsening criterion and cycle parameters
+        /// \param[in] smootherArgs  arguments of the smoothers
+        template <class Criterion>
+        UpdatableAMG(const Operator& op, const Criterion& criterion,
+                     const SmootherArgs& smootherArgs)
+            : info_(),
+              hierarchy_(op, info_),
+              parameters_(criterion),
+              smootherArgs_(smootherArgs)
+        {
+            hierarchy_.template build< Dune::NegateSet< typename ParallelInformation::OwnerSet > >(criterion);
+            setupLevels();
+        }
+
+        /// Set up the levels for the current values of the fine level
+        /// matrix, with the aggregates found when it was built.
+        void update()
+        {
+            hierarchy_.recalculateGalerkin(Dune::NegateSet< typename ParallelInformation::OwnerSet >());
+            setupLevels();
+        }
+
+        void pre(X& x, X& b)
+        {
+            amg_->pre(x, b);
+        }
+
+        void apply(X& v, const X& d)
+        {
+            amg_->apply(v, d);
+        }
+
+        void post(X& x)
+        {
+            amg_->post(x);
+        }
+
+#if DUNE_VERSION_NEWER(DUNE_ISTL, 2, 6)
+        Dune::SolverCategory::Category category() const
+        {
+            return Dune::SolverCategory::sequential;
+        }
+#endif
+
+    private:
+        typedef Dune::MatrixAdapter<Matrix, X, X> CoarseOperator;
+        typedef Dune::SeqILU0<Matrix, X, X> CoarseSmoother;
+
+        // Build the smoothers of all levels and the coarse solver. The
+        // coarse solver is the one Dune::Amg::AMG chooses itself: a
+        // direct solver if one is available, otherwise BiCGStab with an
+        // ILU(0) preconditioner. The AMG takes ownership of it.
+        void setupLevels()
+        {
+            amg_.reset();
+            const Matrix& coarsest = hierarchy_.matrices().coarsest()->getmat();
+#if HAVE_SUITESPARSE_UMFPACK
+            CoarseSolver* coarseSolver = new Dune::UMFPack<Matrix>(coarsest, 0);
+#elif HAVE_SUPERLU
+            CoarseSolver* coarseSolver = new Dune::SuperLU<Matrix>(coarsest, false);
+#else
+            coarseOperator_.reset(new CoarseOperator(coarsest));
+            coarseSmoother_.reset(new CoarseSmoother(coarsest, 1.0));
+            CoarseSolver* coarseSolver = new Dune::BiCGSTABSolver<X>(*coarseOperator_, *coarseSmoother_,
+                                                                    1e-2, 1000, 0);
+#endif
+            amg_.reset(new AMG(hierarchy_, *coarseSolver, smootherArgs_, parameters_));
+        }
+
+        ParallelInformation info_;
+        OperatorHierarchy hierarchy_;
+        Dune::Amg::Parameters parameters_;
+        SmootherArgs smootherArgs_;
+        std::unique_ptr< CoarseOperator > coarseOperator_;
+        std::unique_ptr< CoarseSmoother > coarseSmoother_;
+        // Declared last, so that it is destroyed before the objects its
+        // coarse solver refers to.
+        std::unique_ptr< AMG > amg_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_UPDATABLEPRECONDITIONER_HEADER_INCLUDED
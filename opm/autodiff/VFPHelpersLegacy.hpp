@@ -26,6 +26,12 @@
 #include <opm/parser/eclipse/EclipseState/Schedule/VFPInjTable.hpp>
 #include <opm/autodiff/AutoDiffHelpers.hpp>
 
+#include <algorithm>
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
 /**
  * This file contains a set of helper functions used by VFPProd / VFPInj.
  */
@@ -179,48 +185,47 @@ ADB combineADBVars(const std::vector<const TABLE*>& well_tables,
     assert(liquid.size() == num_wells);
     assert(vapour.size() == num_wells);
 
-    //Caching variable for flo/wfr/gfr
-    std::map<TYPE, ADB> map;
-
-    //Indexing variable used when combining the different ADB types
-    std::map<TYPE, std::vector<int> > elems;
-
-    //Compute all of the different ADB types,
-    //and record which wells use which types
+    //The few different types in use, and the index of the type
+    //used by each well (-1 for wells not under THP control)
+    std::vector<TYPE> types;
+    std::vector<int> type_of_well(num_wells, -1);
+    bool all_wells_have_table = true;
     for (int i=0; i<num_wells; ++i) {
         const TABLE* table = well_tables[i];
 
-        //Only do something if this well is under THP control
         if (table != NULL) {
-            TYPE type = getType<TYPE>(table);
-
-            //"Caching" of flo_type etc: Only calculate used types
-            //Create type if it does not exist
-            if (map.find(type) == map.end()) {
-                map.insert(std::pair<TYPE, ADB>(
-                        type,
-                        detail::getValue<TYPE>(aqua, liquid, vapour, type)
-                        ));
+            const TYPE type = getType<TYPE>(table);
+            const auto pos = std::find(types.begin(), types.end(), type);
+            type_of_well[i] = pos - types.begin();
+            if (pos == types.end()) {
+                types.push_back(type);
             }
-
-            //Add the index for assembly later in gather_vars
-            elems[type].push_back(i);
+        }
+        else {
+            all_wells_have_table = false;
         }
     }
 
+    //Common case: all wells use the same type of variable
+    if (types.size() == 1 && all_wells_have_table) {
+        return detail::getValue<TYPE>(aqua, liquid, vapour, types.front());
+    }
+
     //Loop over all types of ADB variables, and combine them
     //so that each well gets the proper variable
     ADB retval = ADB::constant(ADB::V::Zero(num_wells));
-    for (const auto& entry : elems) {
-        const auto& key = entry.first;
-        const auto& value = entry.second;
-
+    std::vector<int> current;
+    for (int k=0; k<static_cast<int>(types.size()); ++k) {
         //Get the ADB for this type of variable
-        assert(map.find(key) != map.end());
-        const ADB& values = map.find(key)->second;
+        const ADB values = detail::getValue<TYPE>(aqua, liquid, vapour, types[k]);
 
         //Get indices to all elements that should use this ADB
-        const std::vector<int>& current = value;
+        current.clear();
+        for (int i=0; i<num_wells; ++i) {
+            if (type_of_well[i] == k) {
+                current.push_back(i);
+            }
+        }
 
         //Add these elements to retval
         retval = retval + superset(subset(values, current), current, values.size());
@@ -229,6 +234,146 @@ ADB combineADBVars(const std::vector<const TABLE*>& well_tables,
     return retval;
 }
 
+
+/**
+ * Same as findInterpData(value_in, values), but first tries the interval
+ * ending at values[hint] and its two neighbours, so that no search is
+ * needed when the value moved little since the hint was found. hint is
+ * ind_[1] of an earlier result on the same axis, or 0 for none. The result
+ * is identical to that of findInterpData(value_in, values).
+ */
+inline InterpData findInterpData(const double value_in, const std::vector<double>& values, const int hint) {
+    const int nvalues = values.size();
+    const double value = value_in < 0.0 ? 0.0 : value_in;
+
+    //findInterpData() uses the first interval that ends at or above the
+    //value, for values inside [values.front(), values.back())
+    if (hint > 0 && nvalues > 1 && value >= values.front() && value < values.back()) {
+        for (const int i : { hint, hint + 1, hint - 1 }) {
+            if (i >= 1 && i < nvalues && values[i] >= value && (i == 1 || values[i-1] < value)) {
+                InterpData retval;
+                retval.ind_[0] = i-1;
+                retval.ind_[1] = i;
+
+                const double start = values[i-1];
+                const double end   = values[i];
+                if (end > start) {
+                    retval.inv_dist_ = 1.0 / (end-start);
+                    retval.factor_ = (value-start) * retval.inv_dist_;
+                }
+                else {
+                    retval.inv_dist_ = 0.0;
+                    retval.factor_ = 0.0;
+                }
+                return retval;
+            }
+        }
+    }
+
+    return findInterpData(value_in, values);
+}
+
+
+/**
+ * The last evaluation of a VFP table for each well, with N interpolation
+ * arguments (flo, thp, ... in the order used by the caller).
+ *
+ * The interpolation is a function of the table and the arguments only, so
+ * an evaluation can be reused whenever a well evaluates the same table with
+ * the same arguments again. This is the case for wells whose rates and
+ * pressures did not change between the calls of the well solver, and for
+ * the repeated evaluations within one Newton iteration.
+ *
+ * When the arguments did change, the intervals the well found on each axis
+ * in its last evaluation of the table are tried first, as they usually
+ * still bracket the arguments between Newton iterations.
+ */
+template <int N>
+class VFPEvaluationCache
+{
+public:
+    typedef std::array<double, N> Arguments;
+
+    /// The stored evaluation of the well, or null if the well last
+    /// evaluated another table or other arguments.
+    const VFPEvaluation* find(const int well, const void* table, const Arguments& args) const
+    {
+        if (well < static_cast<int>(entries_.size())) {
+            const Entry& entry = entries_[well];
+            if (entry.table == table && entry.args == args) {
+                return &entry.result;
+            }
+        }
+        return nullptr;
+    }
+
+    /// The interpolation data of args[axis] on the given axis of the
+    /// table, starting from the interval found by the last evaluation of
+    /// the same table by the well.
+    InterpData findInterpData(const int well, const void* table, const Arguments& args,
+                              const int axis, const std::vector<double>& values)
+    {
+        Entry& entry = this->entry(well);
+        const int hint = entry.table == table ? entry.intervals[axis] : 0;
+        const InterpData data = detail::findInterpData(args[axis], values, hint);
+        entry.next_intervals[axis] = data.ind_[1];
+        return data;
+    }
+
+    /// Store the evaluation of the well, together with the intervals
+    /// found for it by findInterpData().
+    const VFPEvaluation& store(const int well, const void* table, const Arguments& args, const VFPEvaluation& result)
+    {
+        Entry& entry = this->entry(well);
+        entry.table = table;
+        entry.args = args;
+        entry.intervals = entry.next_intervals;
+        entry.result = result;
+        return entry.result;
+    }
+
+private:
+    struct Entry
+    {
+        const void* table = nullptr;
+        Arguments args;
+        std::array<int, N> intervals;
+        std::array<int, N> next_intervals;
+        VFPEvaluation result;
+    };
+
+    Entry& entry(const int well)
+    {
+        if (well >= static_cast<int>(entries_.size())) {
+            entries_.resize(well + 1);
+        }
+        return entries_[well];
+    }
+
+    std::vector<Entry> entries_;
+};
+
+
+/**
+ * The wells with a table, ordered by table, so that the wells sharing a
+ * table are evaluated one after the other.
+ */
+template <typename TABLE>
+std::vector<int> wellsByTable(const std::vector<const TABLE*>& well_tables) {
+    std::vector<int> order;
+    order.reserve(well_tables.size());
+    for (int i=0; i<static_cast<int>(well_tables.size()); ++i) {
+        if (well_tables[i] != nullptr) {
+            order.push_back(i);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&well_tables](const int a, const int b) {
+                         return std::less<const TABLE*>()(well_tables[a], well_tables[b]);
+                     });
+    return order;
+}
+
 } // namespace detail
 
 
@@ -83,23 +83,28 @@ VFPInjPropertiesLegacy::ADB VFPInjPropertiesLegacy::bhp(const std::vector<int>&
     //Get the right FLO variable for each well as a single ADB
     const ADB flo = detail::combineADBVars<VFPInjTable::FLO_TYPE>(well_tables, aqua, liquid, vapour);
 
-    //Compute the BHP for each well independently
-    for (int i=0; i<nw; ++i) {
+    //Compute the BHP for each well independently, table by table.
+    //Wells without a table keep the value -1e100 to signal that it has not
+    //been calculated properly, due to "missing" table
+    value.setConstant(-1e100);
+    for (const int i : detail::wellsByTable(well_tables)) {
         const VFPInjTable* table = well_tables[i];
-        if (table != nullptr) {
-            //First, find the values to interpolate between
-            auto flo_i = detail::findInterpData(flo.value()[i], table->getFloAxis());
-            auto thp_i = detail::findInterpData(thp_arg.value()[i], table->getTHPAxis());
 
-            detail::VFPEvaluation bhp_val = detail::interpolate(table->getTable(), flo_i, thp_i);
+        const detail::VFPEvaluationCache<2>::Arguments args = {{ flo.value()[i],
+                                                                 thp_arg.value()[i] }};
+        const detail::VFPEvaluation* cached = m_evaluations.find(i, table, args);
+        if (cached == nullptr) {
+            //First, find the values to interpolate between
+            auto flo_i = m_evaluations.findInterpData(i, table, args, 0, table->getFloAxis());
+            auto thp_i = m_evaluations.findInterpData(i, table, args, 1, table->getTHPAxis());
 
-            value[i] = bhp_val.value;
-            dthp[i] = bhp_val.dthp;
-            dflo[i] = bhp_val.dflo;
-        }
-        else {
-            value[i] = -1e100; //Signal that this value has not been calculated properly, due to "missing" table
+            cached = &m_evaluations.store(i, table, args, detail::interpolate(table->getTable(), flo_i, thp_i));
         }
+        const detail::VFPEvaluation& bhp_val = *cached;
+
+        value[i] = bhp_val.value;
+        dthp[i] = bhp_val.dthp;
+        dflo[i] = bhp_val.dflo;
     }
 
     //Create diagonal matrices from ADB::Vs
@@ -94,6 +94,12 @@ public:
             const ADB& liquid,
             const ADB& vapour,
             const ADB& thp) const;
+
+private:
+    // Last table evaluation of each well, and the intervals it found on
+    // each axis. The well solver evaluates the tables several times with
+    // unchanged or slightly changed arguments.
+    mutable detail::VFPEvaluationCache<2> m_evaluations;
 };
 
 
@@ -89,30 +89,39 @@ VFPProdPropertiesLegacy::ADB VFPProdPropertiesLegacy::bhp(const std::vector<int>
     const ADB wfr = detail::combineADBVars<VFPProdTable::WFR_TYPE>(well_tables, aqua, liquid, vapour);
     const ADB gfr = detail::combineADBVars<VFPProdTable::GFR_TYPE>(well_tables, aqua, liquid, vapour);
 
-    //Compute the BHP for each well independently
-    for (int i=0; i<nw; ++i) {
+    //Compute the BHP for each well independently, table by table.
+    //Wells without a table keep the value -1e100 to signal that it has not
+    //been calculated properly, due to "missing" table
+    value.setConstant(-1e100);
+    for (const int i : detail::wellsByTable(well_tables)) {
         const VFPProdTable* table = well_tables[i];
-        if (table != nullptr) {
+
+        //Value of FLO is negative in OPM for producers, but positive in VFP table
+        const detail::VFPEvaluationCache<5>::Arguments args = {{ -flo.value()[i],
+                                                                 thp_arg.value()[i],
+                                                                 wfr.value()[i],
+                                                                 gfr.value()[i],
+                                                                 alq.value()[i] }};
+        const detail::VFPEvaluation* cached = m_evaluations.find(i, table, args);
+        if (cached == nullptr) {
             //First, find the values to interpolate between
-            //Value of FLO is negative in OPM for producers, but positive in VFP table
-            auto flo_i = detail::findInterpData(-flo.value()[i], table->getFloAxis());
-            auto thp_i = detail::findInterpData( thp_arg.value()[i], table->getTHPAxis());
-            auto wfr_i = detail::findInterpData( wfr.value()[i], table->getWFRAxis());
-            auto gfr_i = detail::findInterpData( gfr.value()[i], table->getGFRAxis());
-            auto alq_i = detail::findInterpData( alq.value()[i], table->getALQAxis());
-
-            detail::VFPEvaluation bhp_val = detail::interpolate(table->getTable(), flo_i, thp_i, wfr_i, gfr_i, alq_i);
-
-            value[i] = bhp_val.value;
-            dthp[i] = bhp_val.dthp;
-            dwfr[i] = bhp_val.dwfr;
-            dgfr[i] = bhp_val.dgfr;
-            dalq[i] = bhp_val.dalq;
-            dflo[i] = bhp_val.dflo;
-        }
-        else {
-            value[i] = -1e100; //Signal that this value has not been calculated properly, due to "missing" table
+            auto flo_i = m_evaluations.findInterpData(i, table, args, 0, table->getFloAxis());
+            auto thp_i = m_evaluations.findInterpData(i, table, args, 1, table->getTHPAxis());
+            auto wfr_i = m_evaluations.findInterpData(i, table, args, 2, table->getWFRAxis());
+            auto gfr_i = m_evaluations.findInterpData(i, table, args, 3, table->getGFRAxis());
+            auto alq_i = m_evaluations.findInterpData(i, table, args, 4, table->getALQAxis());
+
+            cached = &m_evaluations.store(i, table, args,
+                                          detail::interpolate(table->getTable(), flo_i, thp_i, wfr_i, gfr_i, alq_i));
         }
+        const detail::VFPEvaluation& bhp_val = *cached;
+
+        value[i] = bhp_val.value;
+        dthp[i] = bhp_val.dthp;
+        dwfr[i] = bhp_val.dwfr;
+        dgfr[i] = bhp_val.dgfr;
+        dalq[i] = bhp_val.dalq;
+        dflo[i] = bhp_val.dflo;
     }
 
     //Create diagonal matrices from ADB::Vs
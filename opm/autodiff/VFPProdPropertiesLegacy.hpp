@@ -102,6 +102,12 @@ public:
             const ADB& vapour,
             const ADB& thp,
             const ADB& alq) const;
+
+private:
+    // Last table evaluation of each well, and the intervals it found on
+    // each axis. The well solver evaluates the tables several times with
+    // unchanged or slightly changed arguments.
+    mutable detail::VFPEvaluationCache<5> m_evaluations;
 };
 
 } //namespace
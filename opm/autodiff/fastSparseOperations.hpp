@@ -15,15 +15,69 @@
 #include <Eigen/Sparse>
 
 #include <algorithm>
+#include <atomic>
 #include <iterator>
 #include <functional>
 #include <limits>
+#include <type_traits>
 #include <vector>
 
 #include <Eigen/Core>
 
+#if HAVE_OPENMP
+#include <omp.h>
+#endif // HAVE_OPENMP
+
 namespace Opm {
 
+/// Run-time choice of where the AutoDiffBlock operations use OpenMP
+/// threads. By default the operations run in parallel over the jacobian
+/// blocks, of which there are only a handful. With row parallelism the
+/// kernels below instead partition the outer dimension (columns) of each
+/// matrix between the threads, which scales with the number of cells.
+class SparseKernelParallelism
+{
+public:
+    /// Whether the kernels run in parallel over rows (columns).
+    static bool rowParallel()
+    {
+        return rowParallelFlag().load(std::memory_order_relaxed);
+    }
+
+    /// Select row parallel kernels (true) or parallelism over the
+    /// jacobian blocks (false).
+    static void setRowParallel(const bool enable)
+    {
+        rowParallelFlag().store(enable);
+    }
+
+    /// Whether a kernel doing about the given amount of work should run
+    /// in parallel. Small matrices, and calls from within a parallel
+    /// region, are always handled serially.
+    static bool runParallel(const long work)
+    {
+#if HAVE_OPENMP
+        return rowParallel() && work >= minimumParallelWork
+            && !omp_in_parallel() && omp_get_max_threads() > 1;
+#else
+        static_cast<void>(work);
+        return false;
+#endif
+    }
+
+    /// Matrices with fewer non-zeros are handled serially.
+    static const long minimumParallelWork = 20000;
+
+private:
+    static std::atomic<bool>& rowParallelFlag()
+    {
+        static std::atomic<bool> flag(false);
+        return flag;
+    }
+};
+
+
+
 template < unsigned int depth >
 struct QuickSort
 {
@@ -56,17 +110,124 @@ struct QuickSort< 0 >
 };
 
 
+#if HAVE_OPENMP
+namespace detail {
+
+// Parallel version of fastSparseProduct: each thread computes a range of
+// the result columns into its own storage, which is then copied into
+// the result at offsets given by the column sizes.
+template<typename Lhs, typename Rhs, typename ResultType>
+void fastSparseProductParallel(const Lhs& lhs, const Rhs& rhs, ResultType& res)
+{
+  typedef typename Eigen::internal::remove_all<Lhs>::type::Scalar Scalar;
+  typedef typename Eigen::internal::remove_all<Lhs>::type::Index Index;
+  typedef typename std::remove_reference<decltype(*res.innerIndexPtr())>::type StorageIndex;
+
+  const Index rows = lhs.innerSize();
+  const Index cols = rhs.outerSize();
+  eigen_assert(lhs.outerSize() == rhs.innerSize());
+
+  const int max_threads = omp_get_max_threads();
+  std::vector< std::vector<StorageIndex> > inner(max_threads);
+  std::vector< std::vector<Scalar> > values(max_threads);
+  std::vector<Index> outer(cols + 1, 0);
+  const Index estimated_nnz_prod = lhs.nonZeros() + rhs.nonZeros();
+
+#pragma omp parallel num_threads(max_threads)
+  {
+    const int thread = omp_get_thread_num();
+    const int num_threads = omp_get_num_threads();
+    const Index begin = cols * thread / num_threads;
+    const Index end = cols * (thread + 1) / num_threads;
+
+    std::vector<char> mask(rows, false);
+    Eigen::Matrix<Scalar,Eigen::Dynamic,1> column_values(rows);
+    Eigen::Matrix<Index, Eigen::Dynamic,1> indices(rows);
+    std::vector<StorageIndex>& my_inner = inner[thread];
+    std::vector<Scalar>& my_values = values[thread];
+    my_inner.reserve(estimated_nnz_prod / num_threads + 1);
+    my_values.reserve(estimated_nnz_prod / num_threads + 1);
+
+    for (Index j=begin; j<end; ++j)
+    {
+      Index nnz = 0;
+      for (typename Rhs::InnerIterator rhsIt(rhs, j); rhsIt; ++rhsIt)
+      {
+        const Scalar y = rhsIt.value();
+        for (typename Lhs::InnerIterator lhsIt(lhs, rhsIt.index()); lhsIt; ++lhsIt)
+        {
+          const Scalar val = lhsIt.value() * y;
+          // skip exact zeros, like the serial version
+          if( !( std::abs( val ) > Scalar(0) ) )
+            continue;
+          const Index i = lhsIt.index();
+          if(!mask[i])
+          {
+            mask[i] = true;
+            column_values[i] = val;
+            indices[nnz] = i;
+            ++nnz;
+          }
+          else
+            column_values[i] += val;
+        }
+      }
+
+      if( nnz > 1 )
+      {
+        QuickSort< 1 >::sort( indices.data(), indices.data()+nnz );
+      }
+
+      for(Index k=0; k<nnz; ++k)
+      {
+        const Index i = indices[k];
+        my_inner.push_back(StorageIndex(i));
+        my_values.push_back(column_values[i]);
+        mask[i] = false;
+      }
+      outer[j + 1] = nnz;
+    }
+
+#pragma omp barrier
+#pragma omp single
+    {
+      for (Index j=0; j<cols; ++j) {
+        outer[j + 1] += outer[j];
+      }
+      res.resizeNonZeros(outer[cols]);
+      for (Index j=0; j<=cols; ++j) {
+        res.outerIndexPtr()[j] = StorageIndex(outer[j]);
+      }
+    }
+
+    std::copy(my_inner.begin(), my_inner.end(), res.innerIndexPtr() + outer[begin]);
+    std::copy(my_values.begin(), my_values.end(), res.valuePtr() + outer[begin]);
+  }
+}
+
+} // namespace detail
+#endif // HAVE_OPENMP
+
+
 template<typename Lhs, typename Rhs, typename ResultType>
 void fastSparseProduct(const Lhs& lhs, const Rhs& rhs, ResultType& res)
 {
-  // initialize result
-  res = ResultType(lhs.rows(), rhs.cols());
+  // initialize result, keeping any storage already allocated in res
+  res.resize(lhs.rows(), rhs.cols());
 
   // if one of the matrices does not contain non zero elements
   // the result will only contain an empty matrix
   if( lhs.nonZeros() == 0 || rhs.nonZeros() == 0 )
     return;
 
+#if HAVE_OPENMP
+  if( SparseKernelParallelism::runParallel( lhs.nonZeros() + rhs.nonZeros() ) )
+  {
+    detail::fastSparseProductParallel(lhs, rhs, res);
+    return;
+  }
+#endif
+
   typedef typename Eigen::internal::remove_all<Lhs>::type::Scalar Scalar;
   typedef typename Eigen::internal::remove_all<Lhs>::type::Index Index;
 
@@ -147,14 +308,18 @@ inline void fastDiagSparseProduct(const std::vector<double>& lhs,
                                   Eigen::SparseMatrix<double>& res)
 {
     res = rhs;
+    res.makeCompressed();
 
     // Multiply rows by diagonal lhs.
-    int n = res.cols();
-    for (int col = 0; col < n; ++col) {
-        typedef Eigen::SparseMatrix<double>::InnerIterator It;
-        for (It it(res, col); it; ++it) {
-            it.valueRef() *= lhs[it.row()];
-        }
+    const long nnz = res.nonZeros();
+    double* values = res.valuePtr();
+    const auto rows = res.innerIndexPtr();
+    const double* d = lhs.data();
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(static) if(SparseKernelParallelism::runParallel(nnz))
+#endif // HAVE_OPENMP
+    for (long k = 0; k < nnz; ++k) {
+        values[k] *= d[rows[k]];
     }
 }
 
@@ -166,13 +331,20 @@ inline void fastSparseDiagProduct(const Eigen::SparseMatrix<double>& lhs,
                                   Eigen::SparseMatrix<double>& res)
 {
     res = lhs;
+    res.makeCompressed();
 
     // Multiply columns by diagonal rhs.
-    int n = res.cols();
+    const int n = res.cols();
+    double* values = res.valuePtr();
+    const auto outer = res.outerIndexPtr();
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(static) if(SparseKernelParallelism::runParallel(res.nonZeros()))
+#endif // HAVE_OPENMP
     for (int col = 0; col < n; ++col) {
-        typedef Eigen::SparseMatrix<double>::InnerIterator It;
-        for (It it(res, col); it; ++it) {
-            it.valueRef() *= rhs[col];
+        const double d = rhs[col];
+        const long end = outer[col + 1];
+        for (long k = outer[col]; k < end; ++k) {
+            values[k] *= d;
         }
     }
 }
@@ -238,6 +410,9 @@ fastSparseAdd(Lhs& lhs, const Rhs& rhs)
         const Scalar* rhsV = rhs.valuePtr();
         Scalar* lhsV = lhs.valuePtr();
 
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(static) if(SparseKernelParallelism::runParallel(nnz))
+#endif // HAVE_OPENMP
         for(Index i=0; i<nnz; ++i )
         {
             lhsV[ i ] += rhsV[ i ];
@@ -267,6 +442,9 @@ fastSparseSubstract(Lhs& lhs, const Rhs& rhs)
         const Scalar* rhsV = rhs.valuePtr();
         Scalar* lhsV = lhs.valuePtr();
 
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(static) if(SparseKernelParallelism::runParallel(nnz))
+#endif // HAVE_OPENMP
         for(Index i=0; i<nnz; ++i )
         {
             lhsV[ i ] -= rhsV[ i ];
@@ -0,0 +1,72 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_SOLVEREORDERCOMPONENT_HEADER_INCLUDED
+#define OPM_SOLVEREORDERCOMPONENT_HEADER_INCLUDED
+
+#include <type_traits>
+#include <vector>
+
+namespace Opm
+{
+    /// Solve a strongly connected component of a reordered system.
+    ///
+    /// Components with at least min_coupled_size cells are first
+    /// solved for all cells at once. Smaller components, and those for
+    /// which the coupled solve fails, are solved by nonlinear
+    /// Gauss-Seidel, one cell at a time. The Gauss-Seidel sweep starts
+    /// from the values the cells had before the coupled solve.
+    ///
+    /// @param[in] comp_size         number of cells in the component
+    /// @param[in] cells             the cells of the component
+    /// @param[in] min_coupled_size  smallest component solved coupled
+    /// @param[in] save              save(cell) returns the values of a cell
+    /// @param[in] restore           restore(cell, values) resets a cell
+    /// @param[in] solve_coupled     solve_coupled(comp_size, cells) returns
+    ///                              true if the component converged
+    /// @param[in] solve_single      solve_single(cell) solves a single cell
+    /// @return true if the coupled solve was used and converged.
+    template <class Save, class Restore, class SolveCoupled, class SolveSingle>
+    bool solveReorderComponent(const int comp_size, const int* cells,
+                               const int min_coupled_size,
+                               Save&& save, Restore&& restore,
+                               SolveCoupled&& solve_coupled,
+                               SolveSingle&& solve_single)
+    {
+        if (comp_size >= min_coupled_size) {
+            std::vector<typename std::decay<decltype(save(cells[0]))>::type> saved;
+            saved.reserve(comp_size);
+            for (int ii = 0; ii < comp_size; ++ii) {
+                saved.push_back(save(cells[ii]));
+            }
+            if (solve_coupled(comp_size, cells)) {
+                return true;
+            }
+            for (int ii = 0; ii < comp_size; ++ii) {
+                restore(cells[ii], saved[ii]);
+            }
+        }
+        for (int ii = 0; ii < comp_size; ++ii) {
+            solve_single(cells[ii]);
+        }
+        return false;
+    }
+} // namespace Opm
+
+#endif // OPM_SOLVEREORDERCOMPONENT_HEADER_INCLUDED
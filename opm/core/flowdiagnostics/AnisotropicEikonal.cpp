@@ -22,8 +22,11 @@
 #include <opm/grid/GridUtilities.hpp>
 #include <opm/grid/UnstructuredGrid.h>
 #include <opm/common/utility/numeric/RootFinders.hpp>
+#include <opm/common/ErrorMacros.hpp>
 
-#if BOOST_HEAP_AVAILABLE
+#include <algorithm>
+#include <cassert>
+#include <cmath>
 
 namespace Opm
 {
@@ -107,21 +110,18 @@ namespace Opm
         const double inf = 1e100;
         solution.clear();
         solution.resize(num_cells, inf);
-        is_accepted_.clear();
-        is_accepted_.resize(num_cells, false);
-        accepted_front_.clear();
+        is_accepted_.assign(num_cells, false);
+        is_front_.assign(num_cells, false);
         considered_.clear();
-        considered_handles_.clear();
-        is_considered_.clear();
-        is_considered_.resize(num_cells, false);
+        considered_pos_.assign(num_cells, -1);
 
         // 2. Move the startcells to Accepted. U_i = q(x_i)
         const int num_startcells = startcells.size();
         for (int ii = 0; ii < num_startcells; ++ii) {
             is_accepted_[startcells[ii]] = true;
+            is_front_[startcells[ii]] = true;
             solution[startcells[ii]] = 0.0;
         }
-        accepted_front_.insert(startcells.begin(), startcells.end());
 
         // 3. Move cells adjacent to startcells to Considered, evaluate
         //    U_i = min_{(x_j,x_k) \in NF(x_i)} G_{j,k}
@@ -130,12 +130,15 @@ namespace Opm
             const int num_nb = cell_neighbours_[scell].size();
             for (int nb = 0; nb < num_nb; ++nb) {
                 const int nb_cell = cell_neighbours_[scell][nb];
-                if (!is_accepted_[nb_cell] && !is_considered_[nb_cell]) {
+                if (!is_accepted_[nb_cell] && considered_pos_[nb_cell] < 0) {
                     const double value = computeValue(nb_cell, metric, solution.data());
                     pushConsidered(std::make_pair(value, nb_cell));
                 }
             }
         }
+        for (int ii = 0; ii < num_startcells; ++ii) {
+            updateFront(startcells[ii]);
+        }
 
         while (!considered_.empty()) {
             // 4. Find the Considered cell with the smallest value: r.
@@ -147,37 +150,24 @@ namespace Opm
             is_accepted_[rcell] = true;
             solution[rcell] = r.first;
             popConsidered();
-            accepted_front_.insert(rcell);
-            for (auto it = accepted_front_.begin(); it != accepted_front_.end();) {
-                // Note that loop increment happens in the body of this loop.
-                const int cell = *it;
-                bool on_front = false;
-                for (auto it2 = cell_neighbours_[cell].begin(); it2 != cell_neighbours_[cell].end(); ++it2) {
-                    if (!is_accepted_[*it2]) {
-                        on_front = true;
-                        break;
-                    }
-                }
-                if (!on_front) {
-                    accepted_front_.erase(it++);
-                } else {
-                    ++it;
-                }
+            // Only r and its neighbours can change their front status.
+            is_front_[rcell] = true;
+            updateFront(rcell);
+            for (auto it = cell_neighbours_[rcell].begin(); it != cell_neighbours_[rcell].end(); ++it) {
+                updateFront(*it);
             }
 
             // 6. Recompute the value for all Considered cells within
             //    distance h * F_2/F1 from x_r. Use min of previous and new.
-            for (auto it = considered_.begin(); it != considered_.end(); ++it) {
-                const int ccell = it->second;
-                if (isClose(rcell, ccell)) {
+            //    The update uses r as a vertex, so only the neighbours of
+            //    r can get a new value.
+            for (auto it = cell_neighbours_[rcell].begin(); it != cell_neighbours_[rcell].end(); ++it) {
+                const int ccell = *it;
+                const int pos = considered_pos_[ccell];
+                if (pos >= 0 && isClose(rcell, ccell)) {
                     const double value = computeValueUpdate(ccell, metric, solution.data(), rcell);
-                    if (value < it->first) {
-                        // Update value for considered cell.
-                        // Note that as solution values decrease, their
-                        // goodness w.r.t. the heap comparator increase,
-                        // therefore we may safely call the increase()
-                        // modificator below.
-                        considered_.increase(considered_handles_[ccell], std::make_pair(value, ccell));
+                    if (value < considered_[pos].first) {
+                        decreaseConsidered(std::make_pair(value, ccell));
                     }
                 }
             }
@@ -185,7 +175,7 @@ namespace Opm
             // 7. Move cells adjacent to r from Far to Considered.
             for (auto it = cell_neighbours_[rcell].begin(); it != cell_neighbours_[rcell].end(); ++it) {
                 const int nb_cell = *it;
-                if (!is_accepted_[nb_cell] && !is_considered_[nb_cell]) {
+                if (!is_accepted_[nb_cell] && considered_pos_[nb_cell] < 0) {
                     assert(solution[nb_cell] == inf);
                     const double value = computeValue(nb_cell, metric, solution.data());
                     pushConsidered(std::make_pair(value, nb_cell));
@@ -201,6 +191,25 @@ namespace Opm
 
 
 
+    void AnisotropicEikonal2d::updateFront(const int cell)
+    {
+        if (!is_front_[cell]) {
+            return;
+        }
+        bool on_front = false;
+        for (auto it = cell_neighbours_[cell].begin(); it != cell_neighbours_[cell].end(); ++it) {
+            if (!is_accepted_[*it]) {
+                on_front = true;
+                break;
+            }
+        }
+        is_front_[cell] = on_front;
+    }
+
+
+
+
+
     bool AnisotropicEikonal2d::isClose(const int c1,
                                        const int c2) const
     {
@@ -224,7 +233,7 @@ namespace Opm
         double val = inf;
         for (int ii = 0; ii < num_nbs; ++ii) {
             const int n[2] = { nbs[ii], nbs[(ii+1) % num_nbs] };
-            if (accepted_front_.count(n[0]) && accepted_front_.count(n[1])) {
+            if (is_front_[n[0]] && is_front_[n[1]]) {
                 const double cand_val = computeFromTri(cell, n[0], n[1], metric, solution);
                 val = std::min(val, cand_val);
             }
@@ -233,7 +242,7 @@ namespace Opm
             // Failed to find two accepted front nodes adjacent to this,
             // so we go for a single-neighbour update.
             for (int ii = 0; ii < num_nbs; ++ii) {
-                if (accepted_front_.count(nbs[ii])) {
+                if (is_front_[nbs[ii]]) {
                     const double cand_val = computeFromLine(cell, nbs[ii], metric, solution);
                     val = std::min(val, cand_val);
                 }
@@ -261,7 +270,7 @@ namespace Opm
         for (int ii = 0; ii < num_nbs; ++ii) {
             const int n[2] = { nbs[ii], nbs[(ii+1) % num_nbs] };
             if ((n[0] == new_cell || n[1] == new_cell)
-                && accepted_front_.count(n[0]) && accepted_front_.count(n[1])) {
+                && is_front_[n[0]] && is_front_[n[1]]) {
                 const double cand_val = computeFromTri(cell, n[0], n[1], metric, solution);
                 val = std::min(val, cand_val);
             }
@@ -270,7 +279,7 @@ namespace Opm
             // Failed to find two accepted front nodes adjacent to this,
             // so we go for a single-neighbour update.
             for (int ii = 0; ii < num_nbs; ++ii) {
-                if (nbs[ii] == new_cell && accepted_front_.count(nbs[ii])) {
+                if (nbs[ii] == new_cell && is_front_[nbs[ii]]) {
                     const double cand_val = computeFromLine(cell, nbs[ii], metric, solution);
                     val = std::min(val, cand_val);
                 }
@@ -360,7 +369,7 @@ namespace Opm
 
     const AnisotropicEikonal2d::ValueAndCell& AnisotropicEikonal2d::topConsidered() const
     {
-        return considered_.top();
+        return considered_.front();
     }
 
 
@@ -369,9 +378,8 @@ namespace Opm
 
     void AnisotropicEikonal2d::pushConsidered(const ValueAndCell& vc)
     {
-        HeapHandle h = considered_.push(vc);
-        considered_handles_[vc.second] = h;
-        is_considered_[vc.second] = true;
+        considered_.push_back(vc);
+        moveUpConsidered(considered_.size() - 1);
     }
 
 
@@ -380,9 +388,79 @@ namespace Opm
 
     void AnisotropicEikonal2d::popConsidered()
     {
-        is_considered_[considered_.top().second] = false;
-        considered_handles_.erase(considered_.top().second);
-        considered_.pop();
+        considered_pos_[considered_.front().second] = -1;
+        if (considered_.size() > 1) {
+            considered_.front() = considered_.back();
+            considered_.pop_back();
+            moveDownConsidered(0);
+        } else {
+            considered_.pop_back();
+        }
+    }
+
+
+
+
+
+    void AnisotropicEikonal2d::decreaseConsidered(const ValueAndCell& vc)
+    {
+        const int pos = considered_pos_[vc.second];
+        assert(pos >= 0 && vc < considered_[pos]);
+        considered_[pos] = vc;
+        moveUpConsidered(pos);
+    }
+
+
+
+
+
+    void AnisotropicEikonal2d::moveUpConsidered(int pos)
+    {
+        // Ties in value are broken by the cell index, so the order in
+        // which cells are accepted does not depend on the heap layout.
+        const ValueAndCell vc = considered_[pos];
+        while (pos > 0) {
+            const int parent = (pos - 1) / heapArity;
+            if (!(vc < considered_[parent])) {
+                break;
+            }
+            considered_[pos] = considered_[parent];
+            considered_pos_[considered_[pos].second] = pos;
+            pos = parent;
+        }
+        considered_[pos] = vc;
+        considered_pos_[vc.second] = pos;
+    }
+
+
+
+
+
+    void AnisotropicEikonal2d::moveDownConsidered(int pos)
+    {
+        const int size = considered_.size();
+        const ValueAndCell vc = considered_[pos];
+        while (true) {
+            const int first_child = heapArity*pos + 1;
+            if (first_child >= size) {
+                break;
+            }
+            const int end_child = std::min(first_child + heapArity, size);
+            int min_child = first_child;
+            for (int child = first_child + 1; child < end_child; ++child) {
+                if (considered_[child] < considered_[min_child]) {
+                    min_child = child;
+                }
+            }
+            if (!(considered_[min_child] < vc)) {
+                break;
+            }
+            considered_[pos] = considered_[min_child];
+            considered_pos_[considered_[pos].second] = pos;
+            pos = min_child;
+        }
+        considered_[pos] = vc;
+        considered_pos_[vc.second] = pos;
     }
 
 
@@ -428,35 +506,3 @@ namespace Opm
 
 
 } // namespace Opm
-
-
-#else // BOOST_HEAP_AVAILABLE is false
-
-namespace {
-    const char* AnisotropicEikonal2derrmsg =
-        "\n********************************************************************************\n"
-        "This library has not been compiled with support for the AnisotropicEikonal2d\n"
-        "class, due to too old version of the boost libraries (Boost.Heap from boost\n"
-        "version 1.49 or newer is required.\n"
-        "To use this class you must recompile opm-core on a system with sufficiently new\n"
-        "version of the boost libraries."
-        "\n********************************************************************************\n";
-}
-
-namespace Opm
-{
-
-    AnisotropicEikonal2d::AnisotropicEikonal2d(const UnstructuredGrid&)
-    {
-        OPM_THROW(std::logic_error, AnisotropicEikonal2derrmsg);
-    }
-
-    void AnisotropicEikonal2d::solve(const double*,
-                                     const std::vector<int>&,
-                                     std::vector<double>&)
-    {
-        OPM_THROW(std::logic_error, AnisotropicEikonal2derrmsg);
-    }
-}
-
-#endif // BOOST_HEAP_AVAILABLE
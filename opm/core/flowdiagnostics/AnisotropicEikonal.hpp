@@ -21,21 +21,8 @@
 #define OPM_ANISOTROPICEIKONAL_HEADER_INCLUDED
 
 #include <opm/grid/utility/SparseTable.hpp>
+#include <utility>
 #include <vector>
-#include <set>
-#include <map>
-
-#include <opm/common/utility/platform_dependent/disable_warnings.h>
-
-#include <boost/version.hpp>
-
-#define BOOST_HEAP_AVAILABLE ((BOOST_VERSION / 100 % 1000) >= 49)
-
-#if BOOST_HEAP_AVAILABLE
-#include <boost/heap/fibonacci_heap.hpp>
-#endif
-
-#include <opm/common/utility/platform_dependent/reenable_warnings.h>
 
 
 struct UnstructuredGrid;
@@ -47,6 +34,11 @@ namespace Opm
     /// where M(x) is a symmetric positive definite matrix.
     /// The boundary conditions are assumed to be
     ///    \f[ u(x) = 0 \qquad x \in \partial\Omega \f].
+    ///
+    /// The considered cells are kept in an array-based d-ary heap with
+    /// the heap position of each cell stored, and the accepted front is
+    /// a flag per cell, so the work per accepted cell only depends on
+    /// the size of its neighbourhood.
     class AnisotropicEikonal2d
     {
     public:
@@ -62,29 +54,29 @@ namespace Opm
                    const std::vector<int>& startcells,
                    std::vector<double>& solution);
     private:
-#if BOOST_HEAP_AVAILABLE
         // Grid and topology.
         const UnstructuredGrid& grid_;
         SparseTable<int> cell_neighbours_;
 
-        // Keep track of accepted cells.
+        // Keep track of accepted cells, and of the accepted cells that
+        // have a neighbour that is not accepted (the accepted front).
         std::vector<char> is_accepted_;
-        std::set<int> accepted_front_;
+        std::vector<char> is_front_;
 
         // Quantities relating to anisotropy.
         std::vector<double> grid_radius_;
         std::vector<double> aniso_ratio_;
         const double safety_factor_;
 
-        // Keep track of considered cells.
+        // Keep track of considered cells, in a min-heap with heapArity
+        // children per node. The heap position of each cell is stored in
+        // considered_pos_, which is -1 for cells that are not considered.
         typedef std::pair<double, int> ValueAndCell;
-        typedef boost::heap::compare<std::greater<ValueAndCell>> Comparator;
-        typedef boost::heap::fibonacci_heap<ValueAndCell, Comparator> Heap;
-        Heap considered_;
-        typedef Heap::handle_type HeapHandle;
-        std::map<int, HeapHandle> considered_handles_;
-        std::vector<char> is_considered_;
+        static const int heapArity = 4;
+        std::vector<ValueAndCell> considered_;
+        std::vector<int> considered_pos_;
 
+        void updateFront(const int cell);
         bool isClose(const int c1, const int c2) const;
         double computeValue(const int cell, const double* metric, const double* solution) const;
         double computeValueUpdate(const int cell, const double* metric, const double* solution, const int new_cell) const;
@@ -94,10 +86,12 @@ namespace Opm
         const ValueAndCell& topConsidered() const;
         void pushConsidered(const ValueAndCell& vc);
         void popConsidered();
+        void decreaseConsidered(const ValueAndCell& vc);
+        void moveUpConsidered(int pos);
+        void moveDownConsidered(int pos);
 
         void computeGridRadius();
         void computeAnisoRatio(const double* metric);
-#endif // BOOST_HEAP_AVAILABLE
     };
 
 } // namespace Opm
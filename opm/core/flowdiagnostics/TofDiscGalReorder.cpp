@@ -31,12 +31,34 @@
 
 #include <algorithm>
 #include <cmath>
+#include <exception>
 #include <numeric>
 #include <iostream>
 
+#if HAVE_OPENMP
+#include <omp.h>
+#endif // HAVE_OPENMP
+
 namespace Opm
 {
 
+    namespace
+    {
+        // Smallest number of components of a level for which the
+        // components are solved in parallel.
+        const int minimumParallelComponents = 32;
+
+        int threadIndex()
+        {
+#if HAVE_OPENMP
+            return omp_get_thread_num();
+#else
+            return 0;
+#endif // HAVE_OPENMP
+        }
+    } // anonymous namespace
+
+
 
     /// Construct solver.
     TofDiscGalReorder::TofDiscGalReorder(const UnstructuredGrid& grid,
@@ -47,8 +69,7 @@ namespace Opm
           limiter_relative_flux_threshold_(1e-3),
           limiter_method_(MinUpwindAverage),
           limiter_usage_(DuringComputations),
-          coord_(grid.dimensions),
-          velocity_(grid.dimensions),
+          parallel_levels_(false),
           gauss_seidel_tol_(1e-3)
     {
         const int dg_degree = param.getDefault("dg_degree", 0);
@@ -62,6 +83,7 @@ namespace Opm
         tracers_ensure_unity_ = param.getDefault("tracers_ensure_unity", true);
 
         use_cvi_ = param.getDefault("use_cvi", use_cvi_);
+        parallel_levels_ = param.getDefault("parallel_levels", parallel_levels_);
         use_limiter_ = param.getDefault("use_limiter", use_limiter_);
         if (use_limiter_) {
             limiter_relative_flux_threshold_ = param.getDefault("limiter_relative_flux_threshold",
@@ -122,19 +144,10 @@ namespace Opm
         tof_coeff.resize(num_basis*grid_.number_of_cells);
         std::fill(tof_coeff.begin(), tof_coeff.end(), 0.0);
         tof_coeff_ = &tof_coeff[0];
-        rhs_.resize(num_basis);
-        jac_.resize(num_basis*num_basis);
-        orig_jac_.resize(num_basis*num_basis);
-        basis_.resize(num_basis);
-        basis_nb_.resize(num_basis);
-        grad_basis_.resize(num_basis*grid_.dimensions);
         velocity_interpolation_->setupFluxes(darcyflux);
         num_tracers_ = 0;
-        num_multicell_ = 0;
-        max_size_multicell_ = 0;
-        max_iter_multicell_ = 0;
-        num_singlesolves_ = 0;
-        reorderAndTransport(grid_, darcyflux);
+        setupLocalWork(1);
+        solveAllCells();
         switch (limiter_usage_) {
         case AsPostProcess:
             applyLimiterAsPostProcess();
@@ -148,13 +161,7 @@ namespace Opm
         default:
             OPM_THROW(std::runtime_error, "Unknown limiter usage choice: " << limiter_usage_);
         }
-        if (num_multicell_ > 0) {
-            std::cout << num_multicell_ << " multicell blocks with max size "
-                      << max_size_multicell_ << " cells in upto "
-                      << max_iter_multicell_ << " iterations." << std::endl;
-            std::cout << "Average solves per cell (for all cells) was "
-                      << double(num_singlesolves_)/double(grid_.number_of_cells) << std::endl;
-        }
+        reportStatistics();
     }
 
 
@@ -201,13 +208,8 @@ namespace Opm
         tof_coeff.resize(num_basis*grid_.number_of_cells);
         std::fill(tof_coeff.begin(), tof_coeff.end(), 0.0);
         tof_coeff_ = &tof_coeff[0];
-        rhs_.resize(num_basis*(num_tracers_ + 1));
-        jac_.resize(num_basis*num_basis);
-        orig_jac_.resize(num_basis*num_basis);
-        basis_.resize(num_basis);
-        basis_nb_.resize(num_basis);
-        grad_basis_.resize(num_basis*grid_.dimensions);
         velocity_interpolation_->setupFluxes(darcyflux);
+        setupLocalWork(num_tracers_ + 1);
 
         // Set up tracer
         tracer_coeff.resize(grid_.number_of_cells*num_tracers_*num_basis);
@@ -227,11 +229,7 @@ namespace Opm
         }
 
         tracer_coeff_ = &tracer_coeff[0];
-        num_multicell_ = 0;
-        max_size_multicell_ = 0;
-        max_iter_multicell_ = 0;
-        num_singlesolves_ = 0;
-        reorderAndTransport(grid_, darcyflux);
+        solveAllCells();
         switch (limiter_usage_) {
         case AsPostProcess:
             applyLimiterAsPostProcess();
@@ -245,12 +243,123 @@ namespace Opm
         default:
             OPM_THROW(std::runtime_error, "Unknown limiter usage choice: " << limiter_usage_);
         }
-        if (num_multicell_ > 0) {
-            std::cout << num_multicell_ << " multicell blocks with max size "
-                      << max_size_multicell_ << " cells in upto "
-                      << max_iter_multicell_ << " iterations." << std::endl;
+        reportStatistics();
+    }
+
+
+
+
+    void TofDiscGalReorder::setupLocalWork(const int num_rhs)
+    {
+        const int num_basis = basis_func_->numBasisFunc();
+        const int dim = grid_.dimensions;
+        int num_threads = 1;
+#if HAVE_OPENMP
+        if (parallel_levels_ && !use_cvi_) {
+            num_threads = omp_get_max_threads();
+        }
+#endif // HAVE_OPENMP
+        local_work_.resize(num_threads);
+        for (LocalWork& work : local_work_) {
+            work.rhs.resize(num_basis*num_rhs);
+            work.jac.resize(num_basis*num_basis);
+            work.orig_jac.resize(num_basis*num_basis);
+            work.coord.resize(dim);
+            work.basis.resize(num_basis);
+            work.basis_nb.resize(num_basis);
+            work.grad_basis.resize(num_basis*dim);
+            work.velocity.resize(dim);
+            work.num_singlesolves = 0;
+            work.num_multicell = 0;
+            work.max_size_multicell = 0;
+            work.max_iter_multicell = 0;
+        }
+    }
+
+
+
+
+    void TofDiscGalReorder::solveAllCells()
+    {
+        // The ECVI velocity interpolation keeps scratch space in the
+        // interpolator, so it cannot be used by several threads.
+        if (parallel_levels_ && !use_cvi_) {
+            solveByLevels();
+        } else {
+            reorderAndTransport(grid_, darcyflux_);
+        }
+    }
+
+
+
+
+    void TofDiscGalReorder::solveByLevels()
+    {
+        ReorderSolverInterface::reorder(grid_, darcyflux_);
+        ReorderSolverInterface::computeLevels();
+        const std::vector<int>& seq = ReorderSolverInterface::sequence();
+        const std::vector<int>& comps = ReorderSolverInterface::components();
+        const std::vector<int>& levels = ReorderSolverInterface::levels();
+        const std::vector<int>& level_comps = ReorderSolverInterface::levelComponents();
+        const int num_levels = levels.size() - 1;
+
+        // The components of a level only read the solution of earlier
+        // levels, and each writes to its own cells.
+        std::exception_ptr error;
+        for (int level = 0; level < num_levels && !error; ++level) {
+            const int begin = levels[level];
+            const int end = levels[level + 1];
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 16) if(end - begin >= minimumParallelComponents)
+#endif // HAVE_OPENMP
+            for (int i = begin; i < end; ++i) {
+                try {
+                    LocalWork& work = local_work_[threadIndex()];
+                    const int comp = level_comps[i];
+                    const int comp_size = comps[comp + 1] - comps[comp];
+                    if (comp_size == 1) {
+                        solveCell(seq[comps[comp]], work);
+                    } else {
+                        solveComponent(comp_size, &seq[comps[comp]], work);
+                    }
+                } catch (...) {
+#if HAVE_OPENMP
+#pragma omp critical(TofDiscGalReorderError)
+#endif // HAVE_OPENMP
+                    {
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+            }
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+
+
+
+    void TofDiscGalReorder::reportStatistics() const
+    {
+        int num_singlesolves = 0;
+        int num_multicell = 0;
+        int max_size_multicell = 0;
+        int max_iter_multicell = 0;
+        for (const LocalWork& work : local_work_) {
+            num_singlesolves += work.num_singlesolves;
+            num_multicell += work.num_multicell;
+            max_size_multicell = std::max(max_size_multicell, work.max_size_multicell);
+            max_iter_multicell = std::max(max_iter_multicell, work.max_iter_multicell);
+        }
+        if (num_multicell > 0) {
+            std::cout << num_multicell << " multicell blocks with max size "
+                      << max_size_multicell << " cells in upto "
+                      << max_iter_multicell << " iterations." << std::endl;
             std::cout << "Average solves per cell (for all cells) was "
-                      << double(num_singlesolves_)/double(grid_.number_of_cells) << std::endl;
+                      << double(num_singlesolves)/double(grid_.number_of_cells) << std::endl;
         }
     }
 
@@ -258,6 +367,14 @@ namespace Opm
 
 
     void TofDiscGalReorder::solveSingleCell(const int cell)
+    {
+        solveCell(cell, local_work_[0]);
+    }
+
+
+
+
+    void TofDiscGalReorder::solveCell(const int cell, LocalWork& work)
     {
         // Residual:
         // For each cell K, basis function b_j (spanning V_h),
@@ -272,37 +389,37 @@ namespace Opm
         // For tracers, the equation is the same, except for the last
         // term being zero (the one with \phi).
         //
-        // The rhs_ vector contains a (Fortran ordering) matrix of all
+        // The work.rhs vector contains a (Fortran ordering) matrix of all
         // right-hand-sides, first for tof and then (optionally) for
         // all tracers.
 
         const int num_basis = basis_func_->numBasisFunc();
-        ++num_singlesolves_;
+        ++work.num_singlesolves;
 
-        std::fill(rhs_.begin(), rhs_.end(), 0.0);
-        std::fill(jac_.begin(), jac_.end(), 0.0);
+        std::fill(work.rhs.begin(), work.rhs.end(), 0.0);
+        std::fill(work.jac.begin(), work.jac.end(), 0.0);
 
-        // Add cell contributions to res_ and jac_.
-        cellContribs(cell);
+        // Add cell contributions to res_ and work.jac.
+        cellContribs(cell, work);
 
-        // Add face contributions to res_ and jac_.
-        faceContribs(cell);
+        // Add face contributions to res_ and work.jac.
+        faceContribs(cell, work);
 
         // Solve linear equation.
-        solveLinearSystem(cell);
+        solveLinearSystem(cell, work);
 
-        // The solution ends up in rhs_, so we must copy it.
-        std::copy(rhs_.begin(), rhs_.begin() + num_basis, tof_coeff_ + num_basis*cell);
+        // The solution ends up in work.rhs, so we must copy it.
+        std::copy(work.rhs.begin(), work.rhs.begin() + num_basis, tof_coeff_ + num_basis*cell);
         if (num_tracers_ && tracerhead_by_cell_[cell] == NoTracerHead) {
-            std::copy(rhs_.begin() + num_basis, rhs_.end(), tracer_coeff_ + num_tracers_*num_basis*cell);
+            std::copy(work.rhs.begin() + num_basis, work.rhs.end(), tracer_coeff_ + num_tracers_*num_basis*cell);
         }
 
         // Apply limiter.
         if (basis_func_->degree() > 0 && use_limiter_ && limiter_usage_ == DuringComputations) {
-            applyLimiter(cell, tof_coeff_);
+            applyLimiter(cell, tof_coeff_, work);
             if (num_tracers_ && tracerhead_by_cell_[cell] == NoTracerHead) {
                 for (int tr = 0; tr < num_tracers_; ++tr) {
-                    applyTracerLimiter(cell, tracer_coeff_ + cell*num_tracers_*num_basis + tr*num_basis);
+                    applyTracerLimiter(cell, tracer_coeff_ + cell*num_tracers_*num_basis + tr*num_basis, work);
                 }
             }
         }
@@ -331,7 +448,7 @@ namespace Opm
 
 
 
-    void TofDiscGalReorder::cellContribs(const int cell)
+    void TofDiscGalReorder::cellContribs(const int cell, LocalWork& work)
     {
         const int num_basis = basis_func_->numBasisFunc();
         const int dim = grid_.dimensions;
@@ -342,18 +459,18 @@ namespace Opm
             CellQuadrature quad(grid_, cell, deg_needed);
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
                 // Integral of: b_i \phi
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
+                quad.quadPtCoord(quad_pt, &work.coord[0]);
+                basis_func_->eval(cell, &work.coord[0], &work.basis[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 for (int j = 0; j < num_basis; ++j) {
                     // Only adding to the tof rhs.
-                    rhs_[j] += w * basis_[j] * porevolume_[cell] / grid_.cell_volumes[cell];
+                    work.rhs[j] += w * work.basis[j] * porevolume_[cell] / grid_.cell_volumes[cell];
                 }
             }
         }
 
         // Compute cell jacobian contribution. We use Fortran ordering
-        // for jac_, i.e. rows cycling fastest.
+        // for work.jac, i.e. rows cycling fastest.
         {
             // Even with ECVI velocity interpolation, degree of precision 1
             // is sufficient for optimal convergence order for DG1 when we
@@ -368,15 +485,15 @@ namespace Opm
             CellQuadrature quad(grid_, cell, deg_needed);
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
                 // b_i (v \cdot \grad b_j)
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
-                basis_func_->evalGrad(cell, &coord_[0], &grad_basis_[0]);
-                velocity_interpolation_->interpolate(cell, &coord_[0], &velocity_[0]);
+                quad.quadPtCoord(quad_pt, &work.coord[0]);
+                basis_func_->eval(cell, &work.coord[0], &work.basis[0]);
+                basis_func_->evalGrad(cell, &work.coord[0], &work.grad_basis[0]);
+                velocity_interpolation_->interpolate(cell, &work.coord[0], &work.velocity[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 for (int j = 0; j < num_basis; ++j) {
                     for (int i = 0; i < num_basis; ++i) {
                         for (int dd = 0; dd < dim; ++dd) {
-                            jac_[j*num_basis + i] -= w * basis_[j] * grad_basis_[dim*i + dd] * velocity_[dd];
+                            work.jac[j*num_basis + i] -= w * work.basis[j] * work.grad_basis[dim*i + dd] * work.velocity[dd];
                         }
                     }
                 }
@@ -396,12 +513,12 @@ namespace Opm
             // \int_{K} b_i flux b_j dx
             CellQuadrature quad(grid_, cell, 2*basis_func_->degree());
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
+                quad.quadPtCoord(quad_pt, &work.coord[0]);
+                basis_func_->eval(cell, &work.coord[0], &work.basis[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 for (int j = 0; j < num_basis; ++j) {
                     for (int i = 0; i < num_basis; ++i) {
-                        jac_[j*num_basis + i] += w * basis_[i] * flux_density * basis_[j];
+                        work.jac[j*num_basis + i] += w * work.basis[i] * flux_density * work.basis[j];
                     }
                 }
             }
@@ -411,7 +528,7 @@ namespace Opm
 
 
 
-    void TofDiscGalReorder::faceContribs(const int cell)
+    void TofDiscGalReorder::faceContribs(const int cell, LocalWork& work)
     {
         const int num_basis = basis_func_->numBasisFunc();
 
@@ -448,23 +565,23 @@ namespace Opm
             const int deg_needed = 2*basis_func_->degree();
             FaceQuadrature quad(grid_, face, deg_needed);
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
-                basis_func_->eval(upstream_cell, &coord_[0], &basis_nb_[0]);
+                quad.quadPtCoord(quad_pt, &work.coord[0]);
+                basis_func_->eval(cell, &work.coord[0], &work.basis[0]);
+                basis_func_->eval(upstream_cell, &work.coord[0], &work.basis_nb[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 // Modify tof rhs
-                const double tof_upstream = std::inner_product(basis_nb_.begin(), basis_nb_.end(),
+                const double tof_upstream = std::inner_product(work.basis_nb.begin(), work.basis_nb.end(),
                                                                tof_coeff_ + num_basis*upstream_cell, 0.0);
                 for (int j = 0; j < num_basis; ++j) {
-                    rhs_[j] -= w * tof_upstream * normal_velocity * basis_[j];
+                    work.rhs[j] -= w * tof_upstream * normal_velocity * work.basis[j];
                 }
                 // Modify tracer rhs
                 if (num_tracers_ && tracerhead_by_cell_[cell] == NoTracerHead) {
                     for (int tr = 0; tr < num_tracers_; ++tr) {
                         const double* up_tr_co = tracer_coeff_ + num_tracers_*num_basis*upstream_cell + num_basis*tr;
-                        const double tracer_up = std::inner_product(basis_nb_.begin(), basis_nb_.end(), up_tr_co, 0.0);
+                        const double tracer_up = std::inner_product(work.basis_nb.begin(), work.basis_nb.end(), up_tr_co, 0.0);
                         for (int j = 0; j < num_basis; ++j) {
-                            rhs_[num_basis*(tr + 1) + j] -= w * tracer_up * normal_velocity * basis_[j];
+                            work.rhs[num_basis*(tr + 1) + j] -= w * tracer_up * normal_velocity * work.basis[j];
                         }
                     }
                 }
@@ -490,12 +607,12 @@ namespace Opm
             FaceQuadrature quad(grid_, face, 2*basis_func_->degree());
             for (int quad_pt = 0; quad_pt < quad.numQuadPts(); ++quad_pt) {
                 // u^ext flux B   (B = {b_j})
-                quad.quadPtCoord(quad_pt, &coord_[0]);
-                basis_func_->eval(cell, &coord_[0], &basis_[0]);
+                quad.quadPtCoord(quad_pt, &work.coord[0]);
+                basis_func_->eval(cell, &work.coord[0], &work.basis[0]);
                 const double w = quad.quadPtWeight(quad_pt);
                 for (int j = 0; j < num_basis; ++j) {
                     for (int i = 0; i < num_basis; ++i) {
-                        jac_[j*num_basis + i] += w * basis_[i] * normal_velocity * basis_[j];
+                        work.jac[j*num_basis + i] += w * work.basis[i] * normal_velocity * work.basis[j];
                     }
                 }
             }
@@ -504,11 +621,11 @@ namespace Opm
 
 
 
-    // This function assumes that jac_ and rhs_ contain the
-    // linear system to be solved. They are stored in orig_jac_
-    // and orig_rhs_, then the system is solved via LAPACK,
-    // overwriting the input data (jac_ and rhs_).
-    void TofDiscGalReorder::solveLinearSystem(const int cell)
+    // This function assumes that work.jac and work.rhs contain the
+    // linear system to be solved. They are stored in work.orig_jac
+    // and work.orig_rhs, then the system is solved via LAPACK,
+    // overwriting the input data (work.jac and work.rhs).
+    void TofDiscGalReorder::solveLinearSystem(const int cell, LocalWork& work)
     {
         MAT_SIZE_T n = basis_func_->numBasisFunc();
         int num_tracer_to_compute = num_tracers_;
@@ -522,22 +639,22 @@ namespace Opm
         std::vector<MAT_SIZE_T> piv(n);
         MAT_SIZE_T ldb = n;
         MAT_SIZE_T info = 0;
-        orig_jac_ = jac_;
-        orig_rhs_ = rhs_;
-        dgesv_(&n, &nrhs, &jac_[0], &lda, &piv[0], &rhs_[0], &ldb, &info);
+        work.orig_jac = work.jac;
+        work.orig_rhs = work.rhs;
+        dgesv_(&n, &nrhs, &work.jac[0], &lda, &piv[0], &work.rhs[0], &ldb, &info);
         if (info != 0) {
             // Print the local matrix and rhs.
             std::cerr << "Failed solving single-cell system Ax = b in cell " << cell
                       << " with A = \n";
             for (int row = 0; row < n; ++row) {
                 for (int col = 0; col < n; ++col) {
-                    std::cerr << "    " << orig_jac_[row + n*col];
+                    std::cerr << "    " << work.orig_jac[row + n*col];
                 }
                 std::cerr << '\n';
             }
             std::cerr << "and b = \n";
             for (int row = 0; row < n; ++row) {
-                std::cerr << "    " << orig_rhs_[row] << '\n';
+                std::cerr << "    " << work.orig_rhs[row] << '\n';
             }
             OPM_THROW(std::runtime_error, "Lapack error: " << info << " encountered in cell " << cell);
         }
@@ -548,8 +665,16 @@ namespace Opm
 
     void TofDiscGalReorder::solveMultiCell(const int num_cells, const int* cells)
     {
-        ++num_multicell_;
-        max_size_multicell_ = std::max(max_size_multicell_, num_cells);
+        solveComponent(num_cells, cells, local_work_[0]);
+    }
+
+
+
+
+    void TofDiscGalReorder::solveComponent(const int num_cells, const int* cells, LocalWork& work)
+    {
+        ++work.num_multicell;
+        work.max_size_multicell = std::max(work.max_size_multicell, num_cells);
         // std::cout << "Multiblock solve with " << num_cells << " cells." << std::endl;
 
         // Using a Gauss-Seidel approach.
@@ -562,26 +687,26 @@ namespace Opm
             for (int ci = 0; ci < num_cells; ++ci) {
                 const int cell = cells[ci];
                 const double tof_before = basis_func_->functionAverage(&tof_coeff_[nb*cell]);
-                solveSingleCell(cell);
+                solveCell(cell, work);
                 const double tof_after = basis_func_->functionAverage(&tof_coeff_[nb*cell]);
                 max_delta = std::max(max_delta, std::fabs(tof_after - tof_before));
             }
             // std::cout << "Max delta = " << max_delta << std::endl;
         }
-        max_iter_multicell_ = std::max(max_iter_multicell_, num_iter);
+        work.max_iter_multicell = std::max(work.max_iter_multicell, num_iter);
     }
 
 
 
 
-    void TofDiscGalReorder::applyLimiter(const int cell, double* tof)
+    void TofDiscGalReorder::applyLimiter(const int cell, double* tof, LocalWork& work)
     {
         switch (limiter_method_) {
         case MinUpwindFace:
-            applyMinUpwindLimiter(cell, true, tof);
+            applyMinUpwindLimiter(cell, true, tof, work);
             break;
         case MinUpwindAverage:
-            applyMinUpwindLimiter(cell, false, tof);
+            applyMinUpwindLimiter(cell, false, tof, work);
             break;
         default:
             OPM_THROW(std::runtime_error, "Limiter type not implemented: " << limiter_method_);
@@ -591,7 +716,7 @@ namespace Opm
 
 
 
-    void TofDiscGalReorder::applyMinUpwindLimiter(const int cell, const bool face_min, double* tof)
+    void TofDiscGalReorder::applyMinUpwindLimiter(const int cell, const bool face_min, double* tof, LocalWork& work)
     {
         if (basis_func_->degree() != 1) {
             OPM_THROW(std::runtime_error, "This limiter only makes sense for our DG1 implementation.");
@@ -633,13 +758,13 @@ namespace Opm
 
             // Find minimum tof in this cell and upstream.
             // The meaning of minimum upstream tof depends on method.
-            min_here_tof = std::min(min_here_tof, minCornerVal(cell, face));
+            min_here_tof = std::min(min_here_tof, minCornerVal(cell, face, work));
             if (upstream) {
                 ++num_upstream_faces;
                 double upstream_tof = 0.0;
                 if (interior) {
                     if (face_min) {
-                        upstream_tof = minCornerVal(upstream_cell, face);
+                        upstream_tof = minCornerVal(upstream_cell, face, work);
                     } else {
                         upstream_tof = basis_func_->functionAverage(tof_coeff_ + num_basis*upstream_cell);
                     }
@@ -690,7 +815,7 @@ namespace Opm
         assert(nc == grid_.number_of_cells);
         for (int i = 0; i < nc; ++i) {
             const int cell = seq[i];
-            applyLimiter(cell, tof_coeff_);
+            applyLimiter(cell, tof_coeff_, local_work_[0]);
         }
     }
 
@@ -706,7 +831,7 @@ namespace Opm
         const int num_basis = basis_func_->numBasisFunc();
         std::vector<double> tof_coeffs_new(tof_coeff_, tof_coeff_ + num_basis*grid_.number_of_cells);
         for (int c = 0; c < grid_.number_of_cells; ++c) {
-            applyLimiter(c, &tof_coeffs_new[0]);
+            applyLimiter(c, &tof_coeffs_new[0], local_work_[0]);
         }
         std::copy(tof_coeffs_new.begin(), tof_coeffs_new.end(), tof_coeff_);
     }
@@ -742,7 +867,7 @@ namespace Opm
 
 
 
-    double TofDiscGalReorder::minCornerVal(const int cell, const int face) const
+    double TofDiscGalReorder::minCornerVal(const int cell, const int face, LocalWork& work) const
     {
         // Evaluate the solution in all corners.
         const int dim = grid_.dimensions;
@@ -750,8 +875,8 @@ namespace Opm
         double min_cornerval = 1e100;
         for (int fnode = grid_.face_nodepos[face]; fnode < grid_.face_nodepos[face+1]; ++fnode) {
             const double* nc = grid_.node_coordinates + dim*grid_.face_nodes[fnode];
-            basis_func_->eval(cell, nc, &basis_[0]);
-            const double tof_corner = std::inner_product(basis_.begin(), basis_.end(),
+            basis_func_->eval(cell, nc, &work.basis[0]);
+            const double tof_corner = std::inner_product(work.basis.begin(), work.basis.end(),
                                                          tof_coeff_ + num_basis*cell, 0.0);
             min_cornerval = std::min(min_cornerval, tof_corner);
         }
@@ -760,7 +885,7 @@ namespace Opm
 
 
 
-    void TofDiscGalReorder::applyTracerLimiter(const int cell, double* local_coeff)
+    void TofDiscGalReorder::applyTracerLimiter(const int cell, double* local_coeff, LocalWork& work)
     {
         // Evaluate the solution in all corners of all faces. Extract max and min.
         const int dim = grid_.dimensions;
@@ -771,8 +896,8 @@ namespace Opm
             const int face = grid_.cell_faces[hface];
             for (int fnode = grid_.face_nodepos[face]; fnode < grid_.face_nodepos[face+1]; ++fnode) {
                 const double* nc = grid_.node_coordinates + dim*grid_.face_nodes[fnode];
-                basis_func_->eval(cell, nc, &basis_[0]);
-                const double tracer_corner = std::inner_product(basis_.begin(), basis_.end(),
+                basis_func_->eval(cell, nc, &work.basis[0]);
+                const double tracer_corner = std::inner_product(work.basis.begin(), work.basis.end(),
                                                                 local_coeff, 0.0);
                 min_cornerval = std::min(min_cornerval, tracer_corner);
                 max_cornerval = std::max(min_cornerval, tracer_corner);
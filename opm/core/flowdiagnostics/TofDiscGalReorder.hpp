@@ -71,6 +71,10 @@ namespace Opm
         ///                                             computing (unlimited) solution.
         ///             - AsSimultaneousPostProcess  -- Apply to each cell independently, using un-
         ///                                             limited solution in neighbouring cells.
+        ///   - \c parallel_levels (false)                 -- Solve the cells level by level, where the cells
+        ///                                                   of a level do not depend on each other and are
+        ///                                                   solved concurrently. The result is the same as
+        ///                                                   when solving in sequence. Ignored with use_cvi.
         TofDiscGalReorder(const UnstructuredGrid& grid,
                           const ParameterGroup& param);
 
@@ -118,12 +122,37 @@ namespace Opm
                             std::vector<double>& tracer_coeff);
 
     private:
+        // Scratch space and statistics for single-cell solves. There is
+        // one per thread when solving by levels.
+        struct LocalWork
+        {
+            std::vector<double> rhs;        // single-cell right-hand-sides
+            std::vector<double> jac;        // single-cell jacobian
+            std::vector<double> orig_rhs;   // single-cell right-hand-sides (copy)
+            std::vector<double> orig_jac;   // single-cell jacobian (copy)
+            std::vector<double> coord;
+            std::vector<double> basis;
+            std::vector<double> basis_nb;
+            std::vector<double> grad_basis;
+            std::vector<double> velocity;
+            int num_singlesolves;
+            int num_multicell;
+            int max_size_multicell;
+            int max_iter_multicell;
+        };
+
         virtual void solveSingleCell(const int cell);
         virtual void solveMultiCell(const int num_cells, const int* cells);
 
-        void cellContribs(const int cell);
-        void faceContribs(const int cell);
-        void solveLinearSystem(const int cell);
+        void setupLocalWork(const int num_rhs);
+        void solveAllCells();
+        void solveByLevels();
+        void reportStatistics() const;
+        void solveCell(const int cell, LocalWork& work);
+        void solveComponent(const int num_cells, const int* cells, LocalWork& work);
+        void cellContribs(const int cell, LocalWork& work);
+        void faceContribs(const int cell, LocalWork& work);
+        void solveLinearSystem(const int cell, LocalWork& work);
 
     private:
         // Disable copying and assignment.
@@ -151,38 +180,27 @@ namespace Opm
         enum { NoTracerHead = -1 };
         std::vector<int> tracerhead_by_cell_;
         bool tracers_ensure_unity_;
-        // Used by solveSingleCell().
-        std::vector<double> rhs_;   // single-cell right-hand-sides
-        std::vector<double> jac_;   // single-cell jacobian
-        std::vector<double> orig_rhs_;   // single-cell right-hand-sides (copy)
-        std::vector<double> orig_jac_;   // single-cell jacobian (copy)
-        std::vector<double> coord_;
-        mutable std::vector<double> basis_;
-        mutable std::vector<double> basis_nb_;
-        std::vector<double> grad_basis_;
-        std::vector<double> velocity_;
-        int num_singlesolves_;
+        bool parallel_levels_;
+        // Used by solveSingleCell(), solveMultiCell() and the limiters.
+        std::vector<LocalWork> local_work_;
         // Used by solveMultiCell():
         double gauss_seidel_tol_;
-        int num_multicell_;
-        int max_size_multicell_;
-        int max_iter_multicell_;
 
         // Private methods
 
         // Apply some limiter, writing to array tof
         // (will read data from tof_coeff_, it is ok to call
         //  with tof_coeff as tof argument.
-        void applyLimiter(const int cell, double* tof);
-        void applyMinUpwindLimiter(const int cell, const bool face_min, double* tof);
+        void applyLimiter(const int cell, double* tof, LocalWork& work);
+        void applyMinUpwindLimiter(const int cell, const bool face_min, double* tof, LocalWork& work);
         void applyLimiterAsPostProcess();
         void applyLimiterAsSimultaneousPostProcess();
         double totalFlux(const int cell) const;
-        double minCornerVal(const int cell, const int face) const;
+        double minCornerVal(const int cell, const int face, LocalWork& work) const;
 
         // Apply a simple (restrict to [0,1]) limiter.
         // Intended for tracers.
-        void applyTracerLimiter(const int cell, double* local_coeff);
+        void applyTracerLimiter(const int cell, double* local_coeff, LocalWork& work);
     };
 
 } // namespace Opm
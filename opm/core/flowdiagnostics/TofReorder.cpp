@@ -42,6 +42,8 @@ namespace Opm
           porevolume_(0),
           source_(0),
           tof_(0),
+          tracer_(0),
+          num_tracers_(0),
           gauss_seidel_tol_(1e-3),
           use_multidim_upwind_(use_multidim_upwind)
     {
@@ -145,7 +147,7 @@ namespace Opm
             const unsigned int tracerheadsSize = tracerheads[tr].size();
             for (unsigned int i = 0; i < tracerheadsSize; ++i) {
                 const int cell = tracerheads[tr][i];
-                tracer[num_cells * tr + cell] = 1.0;
+                tracer[num_tracers * cell + tr] = 1.0;
                 tracerhead_by_cell_[cell] = tr;
             }
         }
@@ -153,18 +155,31 @@ namespace Opm
         // Execute solve for tracers.
         std::vector<double> fake_pv(num_cells, 0.0);
         porevolume_ = fake_pv.data();
-        for (int tr = 0; tr < num_tracers; ++tr) {
-            tof_ = tracer.data() + tr * num_cells;
-            compute_tracer_ = true;
-            executeSolve();
-        }
-
-        // Write output tracer data (transposing the computed data).
-        std::vector<double> computed = tracer;
-        for (int cell = 0; cell < num_cells; ++cell) {
+        compute_tracer_ = true;
+        if (use_multidim_upwind_) {
+            // The multidimensional upwind face values are stored for a
+            // single field, so the tracers are solved one at a time.
+            std::vector<double> single_tracer(num_cells);
             for (int tr = 0; tr < num_tracers; ++tr) {
-                tracer[num_tracers * cell + tr] = computed[num_cells * tr + cell];
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    single_tracer[cell] = tracer[num_tracers * cell + tr];
+                }
+                tof_ = single_tracer.data();
+                executeSolve();
+                for (int cell = 0; cell < num_cells; ++cell) {
+                    tracer[num_tracers * cell + tr] = single_tracer[cell];
+                }
             }
+        } else if (num_tracers > 0) {
+            // All tracers are solved in one pass over the cells, using
+            // the output layout with the tracers of a cell stored
+            // contiguously.
+            tracer_ = tracer.data();
+            num_tracers_ = num_tracers;
+            tracer_upwind_.resize(num_tracers);
+            tracer_before_.resize(num_tracers);
+            tracer_delta_.resize(num_tracers);
+            executeSolve();
         }
     }
 
@@ -192,16 +207,16 @@ namespace Opm
             solveSingleCellMultidimUpwind(cell);
             return;
         }
+        if (compute_tracer_) {
+            solveSingleCellTracers(cell);
+            return;
+        }
         // Compute flux terms.
         // Sources have zero tof, and therefore do not contribute
         // to upwind_term. Sinks on the other hand, must be added
         // to the downwind_flux (note sign change resulting from
         // different sign conventions: pos. source is injection,
         // pos. flux is outflow).
-        if (compute_tracer_ && tracerhead_by_cell_[cell] != NoTracerHead) {
-            // This is a tracer head cell, already has solution.
-            return;
-        }
         double upwind_term = 0.0;
         double downwind_flux = std::max(-source_[cell], 0.0);
         for (int i = grid_.cell_facepos[cell]; i < grid_.cell_facepos[cell+1]; ++i) {
@@ -236,6 +251,53 @@ namespace Opm
 
 
 
+    void TofReorder::solveSingleCellTracers(const int cell)
+    {
+        if (tracerhead_by_cell_[cell] != NoTracerHead) {
+            // This is a tracer head cell, already has solution.
+            return;
+        }
+        // As in solveSingleCell(), but the flux terms are computed once
+        // and applied to all tracers.
+        const int num_tracers = num_tracers_;
+        double* upwind_term = tracer_upwind_.data();
+        std::fill(upwind_term, upwind_term + num_tracers, 0.0);
+        double downwind_flux = std::max(-source_[cell], 0.0);
+        for (int i = grid_.cell_facepos[cell]; i < grid_.cell_facepos[cell+1]; ++i) {
+            int f = grid_.cell_faces[i];
+            double flux;
+            int other;
+            // Compute cell flux
+            if (cell == grid_.face_cells[2*f]) {
+                flux  = darcyflux_[f];
+                other = grid_.face_cells[2*f+1];
+            } else {
+                flux  =-darcyflux_[f];
+                other = grid_.face_cells[2*f];
+            }
+            // Add flux to upwind_term or downwind_flux
+            if (flux < 0.0) {
+                if (other != -1) {
+                    const double* other_tracer = tracer_ + num_tracers*other;
+                    for (int tr = 0; tr < num_tracers; ++tr) {
+                        upwind_term[tr] += flux*other_tracer[tr];
+                    }
+                }
+            } else {
+                downwind_flux += flux;
+            }
+        }
+
+        // Compute tracers.
+        double* cell_tracer = tracer_ + num_tracers*cell;
+        for (int tr = 0; tr < num_tracers; ++tr) {
+            cell_tracer[tr] = (porevolume_[cell] - upwind_term[tr])/downwind_flux;
+        }
+    }
+
+
+
+
     void TofReorder::solveSingleCellMultidimUpwind(const int cell)
     {
         // Compute flux terms.
@@ -304,6 +366,10 @@ namespace Opm
 
     void TofReorder::solveMultiCell(const int num_cells, const int* cells)
     {
+        if (compute_tracer_ && !use_multidim_upwind_) {
+            solveMultiCellTracers(num_cells, cells);
+            return;
+        }
         ++num_multicell_;
         max_size_multicell_ = std::max(max_size_multicell_, num_cells);
         // std::cout << "Multiblock solve with " << num_cells << " cells." << std::endl;
@@ -328,6 +394,48 @@ namespace Opm
 
 
 
+    void TofReorder::solveMultiCellTracers(const int num_cells, const int* cells)
+    {
+        ++num_multicell_;
+        max_size_multicell_ = std::max(max_size_multicell_, num_cells);
+
+        // Using a Gauss-Seidel approach as in solveMultiCell(), with a
+        // convergence check for each tracer. A converged tracer keeps its
+        // values, so that the result is the same as when solving for one
+        // tracer at a time.
+        const int num_tracers = num_tracers_;
+        tracer_active_.assign(num_tracers, 1);
+        int num_active = num_tracers;
+        int num_iter = 0;
+        while (num_active > 0) {
+            ++num_iter;
+            std::fill(tracer_delta_.begin(), tracer_delta_.end(), 0.0);
+            for (int ci = 0; ci < num_cells; ++ci) {
+                const int cell = cells[ci];
+                double* cell_tracer = tracer_ + num_tracers*cell;
+                std::copy(cell_tracer, cell_tracer + num_tracers, tracer_before_.begin());
+                solveSingleCellTracers(cell);
+                for (int tr = 0; tr < num_tracers; ++tr) {
+                    if (tracer_active_[tr]) {
+                        tracer_delta_[tr] = std::max(tracer_delta_[tr], std::fabs(cell_tracer[tr] - tracer_before_[tr]));
+                    } else {
+                        cell_tracer[tr] = tracer_before_[tr];
+                    }
+                }
+            }
+            for (int tr = 0; tr < num_tracers; ++tr) {
+                if (tracer_active_[tr] && !(tracer_delta_[tr] > gauss_seidel_tol_)) {
+                    tracer_active_[tr] = 0;
+                    --num_active;
+                }
+            }
+        }
+        max_iter_multicell_ = std::max(max_iter_multicell_, num_iter);
+    }
+
+
+
+
     // Assumes that face_part_tof_[node_pos] is known for all inflow
     // faces to 'upwind_cell' sharing vertices with 'face'. The index
     // 'node_pos' is the same as the one used for the grid face-node
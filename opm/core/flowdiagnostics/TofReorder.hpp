@@ -83,11 +83,13 @@ namespace Opm
         void executeSolve();
         virtual void solveSingleCell(const int cell);
         void solveSingleCellMultidimUpwind(const int cell);
+        void solveSingleCellTracers(const int cell);
         void assembleSingleCell(const int cell,
                                 std::vector<int>& local_column,
                                 std::vector<double>& local_coefficient,
                                 double& rhs);
         virtual void solveMultiCell(const int num_cells, const int* cells);
+        void solveMultiCellTracers(const int num_cells, const int* cells);
 
         void multidimUpwindTerms(const int face, const int upwind_cell,
                                  double& face_term, double& cell_term_factor) const;
@@ -103,6 +105,14 @@ namespace Opm
         bool compute_tracer_;
         enum { NoTracerHead = -1 };
         std::vector<int> tracerhead_by_cell_;
+        // For solving all tracers in one pass, with num_tracers_ values
+        // per cell in tracer_:
+        double* tracer_;
+        int num_tracers_;
+        std::vector<double> tracer_upwind_;
+        std::vector<double> tracer_before_;
+        std::vector<double> tracer_delta_;
+        std::vector<char> tracer_active_;
         // For solveMultiCell():
         double gauss_seidel_tol_;
         int num_multicell_;
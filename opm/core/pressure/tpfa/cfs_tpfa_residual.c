@@ -5,6 +5,9 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if HAVE_OPENMP
+#include <omp.h>
+#endif /* HAVE_OPENMP */
 
 #include <opm/core/wells.h>
 #include <opm/core/well_controls.h>
@@ -23,6 +26,10 @@
 
 #define MAX(a,b) (((a) > (b)) ? (a) : (b))
 
+/* Minimum number of faces or cells for which the assembly loops are
+ * run in parallel. */
+#define CFS_TPFA_RES_MIN_PARALLEL 1000
+
 
 
 struct densrat_util {
@@ -49,12 +56,17 @@ struct cfs_tpfa_res_impl {
     double              *compflux_p;       /* A_{wi} q_{wi} */
     double              *compflux_deriv_p; /* A_{wi} \partial_{p} q_{wi} */
 
+    /* np * (1 + 2) entries per thread */
     double              *flux_work;
 
     /* Scratch array for face pressure calculation */
     double              *scratch_f;
 
-    struct densrat_util *ratio;
+    /* Number of threads for which scratch space is allocated */
+    int                   nthreads;
+
+    /* One per thread */
+    struct densrat_util **ratio;
 
     /* Linear storage */
     double *ddata;
@@ -120,15 +132,37 @@ static void
 impl_deallocate(struct cfs_tpfa_res_impl *pimpl)
 /* ---------------------------------------------------------------------- */
 {
+    int t;
+
     if (pimpl != NULL) {
-        free              (pimpl->ddata);
-        deallocate_densrat(pimpl->ratio);
+        free(pimpl->ddata);
+
+        if (pimpl->ratio != NULL) {
+            for (t = 0; t < pimpl->nthreads; t++) {
+                deallocate_densrat(pimpl->ratio[t]);
+            }
+        }
+
+        free(pimpl->ratio);
     }
 
     free(pimpl);
 }
 
 
+/* ---------------------------------------------------------------------- */
+static int
+thread_index(void)
+/* ---------------------------------------------------------------------- */
+{
+#if HAVE_OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif /* HAVE_OPENMP */
+}
+
+
 /* ---------------------------------------------------------------------- */
 static struct cfs_tpfa_res_impl *
 impl_allocate(struct UnstructuredGrid   *G       ,
@@ -137,11 +171,17 @@ impl_allocate(struct UnstructuredGrid   *G       ,
               int                        np      )
 /* ---------------------------------------------------------------------- */
 {
+    int                   t, nthreads;
     size_t                nnu, nwperf;
     struct cfs_tpfa_res_impl *new;
 
     size_t ddata_sz;
 
+    nthreads = 1;
+#if HAVE_OPENMP
+    nthreads = omp_get_max_threads();
+#endif /* HAVE_OPENMP */
+
     nnu    = G->number_of_cells;
     nwperf = 0;
 
@@ -161,17 +201,27 @@ impl_allocate(struct UnstructuredGrid   *G       ,
     ddata_sz += np *      nwperf ;             /* compflux_p */
     ddata_sz += np * (2 * nwperf);             /* compflux_deriv_p */
 
-    ddata_sz += np * (1 + 2)                 ; /* flux_work */
+    ddata_sz += np * (1 + 2) * nthreads      ; /* flux_work */
 
     ddata_sz += 1  *      G->number_of_faces ; /* scratch_f */
 
     new = malloc(1 * sizeof *new);
 
     if (new != NULL) {
-        new->ddata = malloc(ddata_sz * sizeof *new->ddata);
-        new->ratio = allocate_densrat(max_conn, np);
+        new->nthreads = nthreads;
+        new->ddata    = malloc(ddata_sz * sizeof *new->ddata);
+        new->ratio    = calloc(nthreads, sizeof *new->ratio);
 
-        if (new->ddata == NULL || new->ratio == NULL) {
+        if (new->ratio != NULL) {
+            for (t = 0; t < nthreads; t++) {
+                new->ratio[t] = allocate_densrat(max_conn, np);
+
+                if (new->ratio[t] == NULL) { break; }
+            }
+        }
+
+        if (new->ddata == NULL || new->ratio == NULL ||
+            new->ratio[nthreads - 1] == NULL) {
             impl_deallocate(new);
             new = NULL;
         }
@@ -381,37 +431,47 @@ compute_compflux_and_deriv(struct UnstructuredGrid  *G     ,
                            const double             *Af    ,
                            struct cfs_tpfa_res_impl *pimpl )
 {
-    int     c1, c2, f, np2;
-    double  dp;
-    double *cflux, *dcflux;
+    int nf, np2;
 
-    np2    = np * np;
+    nf  = G->number_of_faces;
+    np2 = np * np;
 
-    cflux  = pimpl->compflux_f;
-    dcflux = pimpl->compflux_deriv_f;
+#if HAVE_OPENMP
+#pragma omp parallel num_threads(pimpl->nthreads) if (nf >= CFS_TPFA_RES_MIN_PARALLEL)
+#endif /* HAVE_OPENMP */
+    {
+        int     c1, c2, f;
+        double  dp;
+        double *work;
 
-    for (f = 0; f < G->number_of_faces;
-         f++, pmobf += np, gcapf += np, Af += np2,
-             cflux += np, dcflux += 2 * np) {
+        work = pimpl->flux_work + (thread_index() * (1 + 2) * np);
 
-        c1 = G->face_cells[2*f + 0];
-        c2 = G->face_cells[2*f + 1];
+#if HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif /* HAVE_OPENMP */
+        for (f = 0; f < nf; f++) {
+            c1 = G->face_cells[2*f + 0];
+            c2 = G->face_cells[2*f + 1];
 
-        if ((c1 >= 0) && (c2 >= 0)) {
-            dp = cpress[c1] - cpress[c2];
+            if ((c1 >= 0) && (c2 >= 0)) {
+                dp = cpress[c1] - cpress[c2];
 
-            compute_darcyflux_and_deriv(np, trans[f], dp, pmobf, gcapf,
-                                        pimpl->flux_work,
-                                        pimpl->flux_work + np);
+                compute_darcyflux_and_deriv(np, trans[f], dp,
+                                            pmobf + (f * np),
+                                            gcapf + (f * np),
+                                            work, work + np);
 
-            /* Component flux = Af * v*/
-            matvec(np, np, Af, pimpl->flux_work     , cflux );
+                /* Component flux = Af * v*/
+                matvec(np, np, Af + (f * np2), work,
+                       pimpl->compflux_f + (f * np));
 
-            /* Derivative = Af * (dv/dp) */
-            matmat(np, 2 , Af, pimpl->flux_work + np, dcflux);
-        }
+                /* Derivative = Af * (dv/dp) */
+                matmat(np, 2 , Af + (f * np2), work + np,
+                       pimpl->compflux_deriv_f + (f * 2 * np));
+            }
 
-        /* Boundary connections excluded */
+            /* Boundary connections excluded */
+        }
     }
 }
 
@@ -499,19 +559,20 @@ init_cell_contrib(struct UnstructuredGrid  *G    ,
                   double                    pvol ,
                   double                    dt   ,
                   const double             *z    ,
-                  struct cfs_tpfa_res_impl *pimpl)
+                  struct cfs_tpfa_res_impl *pimpl,
+                  struct densrat_util      *ratio)
 {
     int     c1, c2, f, i, conn, nconn;
     double *cflx, *dcflx;
 
     nconn = count_internal_conn(G, c);
 
-    memcpy(pimpl->ratio->linsolve_buffer, z, np * sizeof *z);
+    memcpy(ratio->linsolve_buffer, z, np * sizeof *z);
 
-    pimpl->ratio->coeff[0] = -pvol;
+    ratio->coeff[0] = -pvol;
     conn = 1;
 
-    cflx  = pimpl->ratio->linsolve_buffer + (1 * np);
+    cflx  = ratio->linsolve_buffer + (1 * np);
     dcflx = cflx + (nconn * np);
 
     for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++) {
@@ -529,18 +590,18 @@ init_cell_contrib(struct UnstructuredGrid  *G    ,
             cflx  += 1 * np;
             dcflx += 2 * np;
 
-            pimpl->ratio->coeff[ conn++ ] = dt * (2*(c1 == c) - 1.0);
+            ratio->coeff[ conn++ ] = dt * (2*(c1 == c) - 1.0);
         }
     }
 
     assert (conn == nconn + 1);
-    assert (cflx == pimpl->ratio->linsolve_buffer + (nconn + 1)*np);
+    assert (cflx == ratio->linsolve_buffer + (nconn + 1)*np);
 
     return nconn;
 }
 
 
-static void
+static int
 compute_cell_contrib(struct UnstructuredGrid  *G    ,
                      int                       c    ,
                      int                       np   ,
@@ -549,49 +610,50 @@ compute_cell_contrib(struct UnstructuredGrid  *G    ,
                      const double             *z    ,
                      const double             *Ac   ,
                      const double             *dAc  ,
-                     struct cfs_tpfa_res_impl *pimpl)
+                     struct cfs_tpfa_res_impl *pimpl,
+                     struct densrat_util      *ratio)
 {
-    int        c1, c2, f, i, off, nconn, p;
+    int        c1, c2, f, i, off, nconn, p, is_incomp;
     MAT_SIZE_T nrhs;
     double     s, dF1, dF2, *dv, *dv1, *dv2;
 
-    nconn = init_cell_contrib(G, c, np, pvol, dt, z, pimpl);
+    nconn = init_cell_contrib(G, c, np, pvol, dt, z, pimpl, ratio);
     nrhs  = 1 + (1 + 2)*nconn;  /* [z, Af*v, Af*dv] */
 
-    factorise_fluid_matrix(np, Ac, pimpl->ratio);
-    solve_linear_systems  (np, nrhs, pimpl->ratio,
-                           pimpl->ratio->linsolve_buffer);
+    factorise_fluid_matrix(np, Ac, ratio);
+    solve_linear_systems  (np, nrhs, ratio,
+                           ratio->linsolve_buffer);
 
     /* Sum residual contributions over the connections (+ accumulation):
      *   t1 <- (Ac \ [z, Af*v]) * [-pvol; repmat(dt, [nconn, 1])] */
-    matvec(np, nconn + 1, pimpl->ratio->linsolve_buffer,
-           pimpl->ratio->coeff, pimpl->ratio->t1);
+    matvec(np, nconn + 1, ratio->linsolve_buffer,
+           ratio->coeff, ratio->t1);
 
     /* Compute residual in cell 'c' */
-    pimpl->ratio->residual = pvol;
+    ratio->residual = pvol;
     for (p = 0; p < np; p++) {
-        pimpl->ratio->residual += pimpl->ratio->t1[ p ];
+        ratio->residual += ratio->t1[ p ];
     }
 
     /* Jacobian row */
 
     vector_zero(1 + (G->cell_facepos[c + 1] - G->cell_facepos[c]),
-                pimpl->ratio->mat_row);
+                ratio->mat_row);
 
     /* t2 <- A \ ((dA/dp) * t1) */
-    matvec(np, np, dAc, pimpl->ratio->t1, pimpl->ratio->t2);
-    solve_linear_systems(np, 1, pimpl->ratio, pimpl->ratio->t2);
+    matvec(np, np, dAc, ratio->t1, ratio->t2);
+    solve_linear_systems(np, 1, ratio, ratio->t2);
 
     dF2 = 0.0;
     for (p = 0; p < np; p++) {
-        dF2 += pimpl->ratio->t2[ p ];
+        dF2 += ratio->t2[ p ];
     }
 
-    pimpl->is_incomp           = pimpl->is_incomp && (! (fabs(dF2) > 0));
-    pimpl->ratio->mat_row[ 0 ] = - dF2;
+    is_incomp           = ! (fabs(dF2) > 0);
+    ratio->mat_row[ 0 ] = - dF2;
 
     /* Accumulate inter-cell Jacobian contributions */
-    dv  = pimpl->ratio->linsolve_buffer + (1 + nconn)*np;
+    dv  = ratio->linsolve_buffer + (1 + nconn)*np;
     off = 1;
     for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++, off++) {
 
@@ -609,12 +671,14 @@ compute_cell_contrib(struct UnstructuredGrid  *G    ,
                 dF2 += dv2[ p ];
             }
 
-            pimpl->ratio->mat_row[  0  ] += s * dt * dF1;
-            pimpl->ratio->mat_row[ off ] += s * dt * dF2;
+            ratio->mat_row[  0  ] += s * dt * dF1;
+            ratio->mat_row[ off ] += s * dt * dF2;
 
             dv += 2 * np;       /* '2' == number of one-sided derivatives. */
         }
     }
+
+    return is_incomp;
 }
 
 
@@ -636,16 +700,17 @@ assemble_sources(double                    dt ,
 
 /* ---------------------------------------------------------------------- */
 static int
-assemble_cell_contrib(struct UnstructuredGrid  *G,
-                      int                       c,
-                      struct cfs_tpfa_res_data *h)
+assemble_cell_contrib(struct UnstructuredGrid  *G    ,
+                      int                       c    ,
+                      struct densrat_util      *ratio,
+                      struct cfs_tpfa_res_data *h    )
 /* ---------------------------------------------------------------------- */
 {
     int c1, c2, i, f, j1, j2, off;
 
     j1 = csrmatrix_elm_index(c, c, h->J);
 
-    h->J->sa[j1] += h->pimpl->ratio->mat_row[ 0 ];
+    h->J->sa[j1] += ratio->mat_row[ 0 ];
 
     off = 1;
     for (i = G->cell_facepos[c]; i < G->cell_facepos[c + 1]; i++, off++) {
@@ -659,11 +724,11 @@ assemble_cell_contrib(struct UnstructuredGrid  *G,
         if (c2 >= 0) {
             j2 = csrmatrix_elm_index(c, c2, h->J);
 
-            h->J->sa[j2] += h->pimpl->ratio->mat_row[ off ];
+            h->J->sa[j2] += ratio->mat_row[ off ];
         }
     }
 
-    h->F[ c ] = h->pimpl->ratio->residual;
+    h->F[ c ] = ratio->residual;
 
     return 0;
 }
@@ -676,27 +741,27 @@ init_completion_contrib(int                       i    ,
                         const double             *dAc  ,
                         struct cfs_tpfa_res_impl *pimpl)
 {
-    memcpy(pimpl->ratio->linsolve_buffer,
+    memcpy(pimpl->ratio[0]->linsolve_buffer,
            pimpl->compflux_p + (i * np),
-           np * sizeof *pimpl->ratio->linsolve_buffer);
+           np * sizeof *pimpl->ratio[0]->linsolve_buffer);
 
-    memcpy(pimpl->ratio->linsolve_buffer + (1 * np),
+    memcpy(pimpl->ratio[0]->linsolve_buffer + (1 * np),
            pimpl->compflux_deriv_p + (i * 2 * np),
-           2 * np * sizeof *pimpl->ratio->linsolve_buffer);
+           2 * np * sizeof *pimpl->ratio[0]->linsolve_buffer);
 
     /* buffer <- Ac \ [A_{wi}q_{wi}, A_{wi} dq_{wi}] */
-    factorise_fluid_matrix(np, Ac, pimpl->ratio);
-    solve_linear_systems  (np, 1 + 2, pimpl->ratio,
-                           pimpl->ratio->linsolve_buffer);
+    factorise_fluid_matrix(np, Ac, pimpl->ratio[0]);
+    solve_linear_systems  (np, 1 + 2, pimpl->ratio[0],
+                           pimpl->ratio[0]->linsolve_buffer);
 
     /* t1 <- Ac \ (A_{wi} q_{wi}) */
-    memcpy(pimpl->ratio->t1,
-           pimpl->ratio->linsolve_buffer,
-           np * sizeof *pimpl->ratio->t1);
+    memcpy(pimpl->ratio[0]->t1,
+           pimpl->ratio[0]->linsolve_buffer,
+           np * sizeof *pimpl->ratio[0]->t1);
 
     /* t2 <- Ac \ ((dA/dp) * t1) (== -d(Ac^{-1})/dp (A_{wi} q_{wi})) */
-    matvec(np, np, dAc, pimpl->ratio->t1, pimpl->ratio->t2);
-    solve_linear_systems(np, 1, pimpl->ratio, pimpl->ratio->t2);
+    matvec(np, np, dAc, pimpl->ratio[0]->t1, pimpl->ratio[0]->t2);
+    solve_linear_systems(np, 1, pimpl->ratio[0], pimpl->ratio[0]->t2);
 }
 
 
@@ -711,8 +776,8 @@ assemble_completion_to_cell(int c, int wdof, int np, double dt,
     /* Accumulate residual contributions and (dA^{-1}/dp) terms as
      * sums of phase contributions. */
     for (p = 0, s1 = 0.0, s2 = 0.0; p < np; p++) {
-        s1 += h->pimpl->ratio->t1[ p ];
-        s2 += h->pimpl->ratio->t2[ p ];
+        s1 += h->pimpl->ratio[0]->t1[ p ];
+        s2 += h->pimpl->ratio[0]->t2[ p ];
     }
 
     /* Assemble residual contributions from well completion.
@@ -734,7 +799,7 @@ assemble_completion_to_cell(int c, int wdof, int np, double dt,
 
     /* Linear terms arising from simple differentiation of reservoir
      * volume flux on completion. */
-    d1 = h->pimpl->ratio->linsolve_buffer + (1 * np);
+    d1 = h->pimpl->ratio[0]->linsolve_buffer + (1 * np);
     d2 = d1                               + (1 * np);
     for (p = 0, s1 = 0.0, s2 = 0.0; p < np; p++) {
         s1 += d1[ p ];
@@ -1208,7 +1273,7 @@ cfs_tpfa_res_construct(struct UnstructuredGrid   *G      ,
             h->pimpl->compflux_deriv_p               + (nphases * 2 * nwperf);
 
         h->pimpl->scratch_f        =
-            h->pimpl->flux_work                      + (nphases * (1 + 2));
+            h->pimpl->flux_work                      + (nphases * (1 + 2) * h->pimpl->nthreads);
     }
 
     return h;
@@ -1230,30 +1295,53 @@ cfs_tpfa_res_assemble(struct UnstructuredGrid     *G        ,
                       struct cfs_tpfa_res_data    *h        )
 /* ---------------------------------------------------------------------- */
 {
-    int res_is_neumann, well_is_neumann, c, np2, singular;
+    int res_is_neumann, well_is_neumann, is_incomp, nc, np, np2, singular;
 
     csrmatrix_zero(         h->J);
     vector_zero   (h->J->m, h->F);
 
-    h->pimpl->is_incomp = 1;
-
     compute_compflux_and_deriv(G, cq->nphases, cpress, trans,
                                cq->phasemobf, gravcap_f, cq->Af, h->pimpl);
 
     res_is_neumann  = 1;
     well_is_neumann = 1;
 
-    np2 = cq->nphases * cq->nphases;
-    for (c = 0; c < G->number_of_cells;
-         c++, zc += cq->nphases) {
-
-        compute_cell_contrib(G, c, cq->nphases, porevol[c], dt, zc,
-                             cq->Ac + (c * np2), cq->dAc + (c * np2),
-                             h->pimpl);
+    nc  = G->number_of_cells;
+    np  = cq->nphases;
+    np2 = np * np;
 
-        assemble_cell_contrib(G, c, h);
+    is_incomp = 1;
+
+    /* Cell 'c' only contributes to row 'c' of the Jacobian and the
+     * residual, so the threads own disjoint sets of rows. */
+#if HAVE_OPENMP
+#pragma omp parallel num_threads(h->pimpl->nthreads) if (nc >= CFS_TPFA_RES_MIN_PARALLEL)
+#endif /* HAVE_OPENMP */
+    {
+        int                  c;
+        struct densrat_util *ratio;
+
+        ratio = h->pimpl->ratio[ thread_index() ];
+
+#if HAVE_OPENMP
+#pragma omp for schedule(static) reduction(&&:is_incomp)
+#endif /* HAVE_OPENMP */
+        for (c = 0; c < nc; c++) {
+            is_incomp = compute_cell_contrib(G, c, np, porevol[c], dt,
+                                             zc + (c * np),
+                                             cq->Ac + (c * np2),
+                                             cq->dAc + (c * np2),
+                                             h->pimpl, ratio) && is_incomp;
+
+            assemble_cell_contrib(G, c, ratio, h);
+        }
     }
 
+    h->pimpl->is_incomp = is_incomp;
+
+    /* Well contributions are assembled serially, as several completions
+     * may contribute to the same row. */
+
     if ((forces           != NULL) &&
         (forces->wells    != NULL) &&
         (forces->wells->W != NULL)) {
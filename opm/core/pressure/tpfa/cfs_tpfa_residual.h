@@ -119,6 +119,10 @@ struct cfs_tpfa_res_data {
  * linear equations using, e.g., function cfs_tpfa_res_assemble().  @c NULL in
  * case of allocation failure.  Must be destroyed using function
  * cfs_tpfa_res_destroy().
+ *
+ * When built with OpenMP, work arrays are allocated for
+ * <CODE>omp_get_max_threads()</CODE> threads, and the face and cell loops of
+ * the assembly use at most that many threads.
  */
 struct cfs_tpfa_res_data *
 cfs_tpfa_res_construct(struct UnstructuredGrid   *G      ,
@@ -36,6 +36,12 @@ namespace Opm
 
     typedef SaturationPropsFromDeck::MaterialLawManager::MaterialLaw MaterialLaw;
 
+    namespace
+    {
+        // Smaller evaluations are not worth starting threads for.
+        const int minimumParallelPoints = 1000;
+    }
+
     // ----------- Methods of SaturationPropsFromDeck ---------
 
 
@@ -77,41 +83,84 @@ namespace Opm
                                           double* kr,
                                           double* dkrds) const
     {
-        assert(cells != 0);
-
         const int np = numPhases();
-        if (dkrds) {
-            ExplicitArraysSatDerivativesFluidState fluidState(phaseUsage_);
-            fluidState.setSaturationArray(s);
+        relpermImpl(n, s, cells, kr, dkrds, OutputLayout{ np, 1, np*np, 1 });
+    }
 
-            typedef ExplicitArraysSatDerivativesFluidState::Evaluation Evaluation;
-            Evaluation relativePerms[BlackoilPhases::MaxNumPhases];
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
-                MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
 
-                // copy the values calculated using opm-material to the target arrays
-                for (int krPhaseIdx = 0; krPhaseIdx < np; ++krPhaseIdx) {
-                    kr[np*i + krPhaseIdx] = relativePerms[krPhaseIdx].value();
 
-                    for (int satPhaseIdx = 0; satPhaseIdx < np; ++satPhaseIdx)
-                        dkrds[np*np*i + satPhaseIdx*np + krPhaseIdx] = relativePerms[krPhaseIdx].derivative(satPhaseIdx);
-                }
-            }
-        } else {
-            ExplicitArraysFluidState fluidState(phaseUsage_);
-            fluidState.setSaturationArray(s);
 
-            double relativePerms[BlackoilPhases::MaxNumPhases] = { 0 };
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
-                MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
+    /// Relative permeability, with the output stored phase by phase.
+    void SaturationPropsFromDeck::relpermByPhase(const int n,
+                                                 const double* s,
+                                                 const int* cells,
+                                                 double* kr,
+                                                 double* dkrds) const
+    {
+        relpermImpl(n, s, cells, kr, dkrds, OutputLayout{ 1, n, 1, n });
+    }
+
 
-                // copy the values calculated using opm-material to the target arrays
-                for (int krPhaseIdx = 0; krPhaseIdx < np; ++krPhaseIdx) {
-                    kr[np*i + krPhaseIdx] = relativePerms[krPhaseIdx];
+
+
+    // The data points are split in contiguous ranges over the threads,
+    // each with its own fluid state. The material law parameters are only
+    // read, so the evaluation is thread safe.
+    void SaturationPropsFromDeck::relpermImpl(const int n,
+                                              const double* s,
+                                              const int* cells,
+                                              double* kr,
+                                              double* dkrds,
+                                              const OutputLayout& layout) const
+    {
+        assert(cells != 0);
+
+        const int np = numPhases();
+#if HAVE_OPENMP
+#pragma omp parallel if(n >= minimumParallelPoints)
+#endif // HAVE_OPENMP
+        {
+            if (dkrds) {
+                ExplicitArraysSatDerivativesFluidState fluidState(phaseUsage_);
+                fluidState.setSaturationArray(s);
+
+                typedef ExplicitArraysSatDerivativesFluidState::Evaluation Evaluation;
+                Evaluation relativePerms[BlackoilPhases::MaxNumPhases];
+#if HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif // HAVE_OPENMP
+                for (int i = 0; i < n; ++i) {
+                    fluidState.setIndex(i);
+                    const auto& params = materialLawManager_->materialLawParams(cells[i]);
+                    MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
+
+                    // copy the values calculated using opm-material to the target arrays
+                    for (int krPhaseIdx = 0; krPhaseIdx < np; ++krPhaseIdx) {
+                        kr[layout.point_stride*i + layout.entry_stride*krPhaseIdx] = relativePerms[krPhaseIdx].value();
+
+                        for (int satPhaseIdx = 0; satPhaseIdx < np; ++satPhaseIdx) {
+                            dkrds[layout.deriv_point_stride*i + layout.deriv_entry_stride*(satPhaseIdx*np + krPhaseIdx)]
+                                = relativePerms[krPhaseIdx].derivative(satPhaseIdx);
+                        }
+                    }
+                }
+            } else {
+                ExplicitArraysFluidState fluidState(phaseUsage_);
+                fluidState.setSaturationArray(s);
+
+                double relativePerms[BlackoilPhases::MaxNumPhases] = { 0 };
+#if HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif // HAVE_OPENMP
+                for (int i = 0; i < n; ++i) {
+                    fluidState.setIndex(i);
+                    const auto& params = materialLawManager_->materialLawParams(cells[i]);
+                    MaterialLaw::relativePermeabilities(relativePerms, params, fluidState);
+
+                    // copy the values calculated using opm-material to the target arrays
+                    for (int krPhaseIdx = 0; krPhaseIdx < np; ++krPhaseIdx) {
+                        kr[layout.point_stride*i + layout.entry_stride*krPhaseIdx] = relativePerms[krPhaseIdx];
+                    }
                 }
             }
         }
@@ -135,69 +184,114 @@ namespace Opm
                                            const int* cells,
                                            double* pc,
                                            double* dpcds) const
+    {
+        const int np = numPhases();
+        capPressImpl(n, s, cells, pc, dpcds, OutputLayout{ np, 1, np*np, 1 });
+    }
+
+
+
+
+    /// Capillary pressure, with the output stored phase by phase.
+    void SaturationPropsFromDeck::capPressByPhase(const int n,
+                                                  const double* s,
+                                                  const int* cells,
+                                                  double* pc,
+                                                  double* dpcds) const
+    {
+        capPressImpl(n, s, cells, pc, dpcds, OutputLayout{ 1, n, 1, n });
+    }
+
+
+
+
+    void SaturationPropsFromDeck::capPressImpl(const int n,
+                                               const double* s,
+                                               const int* cells,
+                                               double* pc,
+                                               double* dpcds,
+                                               const OutputLayout& layout) const
     {
         assert(cells != 0);
         assert(phaseUsage_.phase_used[BlackoilPhases::Liquid]);
 
         const int np = numPhases();
 
-        if (dpcds) {
-            ExplicitArraysSatDerivativesFluidState fluidState(phaseUsage_);
-            typedef ExplicitArraysSatDerivativesFluidState::Evaluation Evaluation;
-            fluidState.setSaturationArray(s);
+        // The active phases, their positions and the signs used below.
+        int numActive = 0;
+        int canonicalIdx[BlackoilPhases::MaxNumPhases];
+        int phasePos[BlackoilPhases::MaxNumPhases];
+        double sign[BlackoilPhases::MaxNumPhases];
+        for (int canonicalPhaseIdx = 0; canonicalPhaseIdx < BlackoilPhases::MaxNumPhases; ++canonicalPhaseIdx) {
+            // skip unused phases
+            if ( ! phaseUsage_.phase_used[canonicalPhaseIdx]) {
+                continue;
+            }
+            canonicalIdx[numActive] = canonicalPhaseIdx;
+            phasePos[numActive] = phaseUsage_.phase_pos[canonicalPhaseIdx];
+            sign[numActive] = (canonicalPhaseIdx == BlackoilPhases::Aqua)? -1.0 : 1.0;
+            ++numActive;
+        }
 
-            Evaluation capillaryPressures[BlackoilPhases::MaxNumPhases];
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
-                MaterialLaw::capillaryPressures(capillaryPressures, params, fluidState);
-
-                // copy the values calculated using opm-material to the target arrays
-                for (int canonicalPhaseIdx = 0; canonicalPhaseIdx < BlackoilPhases::MaxNumPhases; ++canonicalPhaseIdx) {
-                    // skip unused phases
-                    if ( ! phaseUsage_.phase_used[canonicalPhaseIdx]) {
-                        continue;
-                    }
-                    const int pcPhaseIdx = phaseUsage_.phase_pos[canonicalPhaseIdx];
-
-                    const double sign = (canonicalPhaseIdx == BlackoilPhases::Aqua)? -1.0 : 1.0;
-                    // in opm-material the wetting phase is the reference phase
-                    // for two-phase problems i.e water for oil-water system,
-                    // but for flow it is always oil. Add oil (liquid) capillary pressure value
-                    // to shift the reference phase to oil
-                    pc[np*i + pcPhaseIdx] = capillaryPressures[BlackoilPhases::Liquid].value() + sign * capillaryPressures[canonicalPhaseIdx].value();
-                    for (int canonicalSatPhaseIdx = 0; canonicalSatPhaseIdx < BlackoilPhases::MaxNumPhases; ++canonicalSatPhaseIdx) {
-                        if ( ! phaseUsage_.phase_used[canonicalSatPhaseIdx])
-                            continue;
-
-                        const int satPhaseIdx = phaseUsage_.phase_pos[canonicalSatPhaseIdx];
-                        dpcds[np*np*i + satPhaseIdx*np + pcPhaseIdx] = capillaryPressures[BlackoilPhases::Liquid].derivative(canonicalSatPhaseIdx) + sign * capillaryPressures[canonicalPhaseIdx].derivative(canonicalSatPhaseIdx);
+#if HAVE_OPENMP
+#pragma omp parallel if(n >= minimumParallelPoints)
+#endif // HAVE_OPENMP
+        {
+            if (dpcds) {
+                ExplicitArraysSatDerivativesFluidState fluidState(phaseUsage_);
+                typedef ExplicitArraysSatDerivativesFluidState::Evaluation Evaluation;
+                fluidState.setSaturationArray(s);
+
+                Evaluation capillaryPressures[BlackoilPhases::MaxNumPhases];
+#if HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif // HAVE_OPENMP
+                for (int i = 0; i < n; ++i) {
+                    fluidState.setIndex(i);
+                    const auto& params = materialLawManager_->materialLawParams(cells[i]);
+                    MaterialLaw::capillaryPressures(capillaryPressures, params, fluidState);
+
+                    // copy the values calculated using opm-material to the target arrays
+                    for (int a = 0; a < numActive; ++a) {
+                        const int pcPhaseIdx = phasePos[a];
+                        const Evaluation& pcPhase = capillaryPressures[canonicalIdx[a]];
+                        // in opm-material the wetting phase is the reference phase
+                        // for two-phase problems i.e water for oil-water system,
+                        // but for flow it is always oil. Add oil (liquid) capillary pressure value
+                        // to shift the reference phase to oil
+                        pc[layout.point_stride*i + layout.entry_stride*pcPhaseIdx]
+                            = capillaryPressures[BlackoilPhases::Liquid].value() + sign[a] * pcPhase.value();
+                        for (int b = 0; b < numActive; ++b) {
+                            const int canonicalSatPhaseIdx = canonicalIdx[b];
+                            const int satPhaseIdx = phasePos[b];
+                            dpcds[layout.deriv_point_stride*i + layout.deriv_entry_stride*(satPhaseIdx*np + pcPhaseIdx)]
+                                = capillaryPressures[BlackoilPhases::Liquid].derivative(canonicalSatPhaseIdx)
+                                + sign[a] * pcPhase.derivative(canonicalSatPhaseIdx);
+                        }
                     }
                 }
-            }
-        } else {
-            ExplicitArraysFluidState fluidState(phaseUsage_);
-            fluidState.setSaturationArray(s);
-
-            double capillaryPressures[BlackoilPhases::MaxNumPhases] = { 0 };
-            for (int i = 0; i < n; ++i) {
-                fluidState.setIndex(i);
-                const auto& params = materialLawManager_->materialLawParams(cells[i]);
-                MaterialLaw::capillaryPressures(capillaryPressures, params, fluidState);
-
-                // copy the values calculated using opm-material to the target arrays
-                for (int canonicalPhaseIdx = 0; canonicalPhaseIdx < BlackoilPhases::MaxNumPhases; ++canonicalPhaseIdx) {
-                    // skip unused phases
-                    if ( ! phaseUsage_.phase_used[canonicalPhaseIdx])
-                        continue;
-
-                    const int pcPhaseIdx = phaseUsage_.phase_pos[canonicalPhaseIdx];
-                    double sign = (canonicalPhaseIdx == BlackoilPhases::Aqua)? -1.0 : 1.0;
-                    // in opm-material the wetting phase is the reference phase
-                    // for two-phase problems i.e water for oil-water system,
-                    // but for flow it is always oil. Add oil (liquid) capillary pressure value
-                    // to shift the reference phase to oil
-                    pc[np*i + pcPhaseIdx] = capillaryPressures[BlackoilPhases::Liquid] + sign * capillaryPressures[canonicalPhaseIdx];
+            } else {
+                ExplicitArraysFluidState fluidState(phaseUsage_);
+                fluidState.setSaturationArray(s);
+
+                double capillaryPressures[BlackoilPhases::MaxNumPhases] = { 0 };
+#if HAVE_OPENMP
+#pragma omp for schedule(static)
+#endif // HAVE_OPENMP
+                for (int i = 0; i < n; ++i) {
+                    fluidState.setIndex(i);
+                    const auto& params = materialLawManager_->materialLawParams(cells[i]);
+                    MaterialLaw::capillaryPressures(capillaryPressures, params, fluidState);
+
+                    // copy the values calculated using opm-material to the target arrays
+                    for (int a = 0; a < numActive; ++a) {
+                        // in opm-material the wetting phase is the reference phase
+                        // for two-phase problems i.e water for oil-water system,
+                        // but for flow it is always oil. Add oil (liquid) capillary pressure value
+                        // to shift the reference phase to oil
+                        pc[layout.point_stride*i + layout.entry_stride*phasePos[a]]
+                            = capillaryPressures[BlackoilPhases::Liquid] + sign[a] * capillaryPressures[canonicalIdx[a]];
+                    }
                 }
             }
         }
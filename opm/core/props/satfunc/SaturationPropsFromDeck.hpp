@@ -105,6 +105,27 @@ namespace Opm
                       double* pc,
                       double* dpcds) const;
 
+        /// Relative permeability, with the output stored phase by phase.
+        /// Same as relperm(), except that kr[n*p + i] is the relperm of
+        /// phase p for data point i, and dkrds[n*(np*j + p) + i] is its
+        /// derivative with respect to the saturation of phase j. Each
+        /// output quantity is then contiguous over the data points.
+        void relpermByPhase(const int n,
+                            const double* s,
+                            const int* cells,
+                            double* kr,
+                            double* dkrds) const;
+
+        /// Capillary pressure, with the output stored phase by phase.
+        /// Same as capPress(), except that pc[n*p + i] is the capillary
+        /// pressure of phase p for data point i, and dpcds[n*(np*j + p) + i]
+        /// is its derivative with respect to the saturation of phase j.
+        void capPressByPhase(const int n,
+                             const double* s,
+                             const int* cells,
+                             double* pc,
+                             double* dpcds) const;
+
         /// Obtain the range of allowable saturation values.
         /// \param[in]  n      Number of data points.
         /// \param[out] smin   Array of nP minimum s values, array must be valid before calling.
@@ -170,6 +191,30 @@ namespace Opm
 
 
     private:
+        // Position of the output for data point i and phase (or
+        // derivative entry) p: i*point_stride + p*entry_stride.
+        struct OutputLayout
+        {
+            int point_stride;
+            int entry_stride;
+            int deriv_point_stride;
+            int deriv_entry_stride;
+        };
+
+        void relpermImpl(const int n,
+                         const double* s,
+                         const int* cells,
+                         double* kr,
+                         double* dkrds,
+                         const OutputLayout& layout) const;
+
+        void capPressImpl(const int n,
+                          const double* s,
+                          const int* cells,
+                          double* pc,
+                          double* dpcds,
+                          const OutputLayout& layout) const;
+
         std::shared_ptr<MaterialLawManager> materialLawManager_;
         PhaseUsage phaseUsage_;
     };
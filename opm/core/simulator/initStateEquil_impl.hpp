@@ -30,12 +30,17 @@
 
 #include <cassert>
 #include <cmath>
+#include <exception>
 #include <functional>
 #include <vector>
 
 namespace Opm
 {
     namespace Details {
+        /// Smallest number of cells of a region for which the cells are
+        /// processed in parallel.
+        const int minimumParallelCells = 1000;
+
         template <class RHS>
         class RK4IVP {
         public:
@@ -250,15 +255,30 @@ namespace Opm
 
                 enum { up = 0, down = 1 };
 
-                std::vector<double>::size_type c = 0;
-                for (typename CellRange::const_iterator
-                         ci = cells.begin(), ce = cells.end();
-                     ci != ce; ++ci, ++c)
-                {
-                    assert (c < p.size());
-
-                    const double z = UgGridHelpers::cellCenterDepth(G, *ci);
-                    p[c] = (z < split) ? f[up](z) : f[down](z);
+                const std::vector<int> cell_list(cells.begin(), cells.end());
+                const int num_cells = cell_list.size();
+                assert (std::vector<double>::size_type(num_cells) <= p.size());
+                std::exception_ptr error;
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(static) if(num_cells >= minimumParallelCells)
+#endif // HAVE_OPENMP
+                for (int c = 0; c < num_cells; ++c) {
+                    try {
+                        const double z = UgGridHelpers::cellCenterDepth(G, cell_list[c]);
+                        p[c] = (z < split) ? f[up](z) : f[down](z);
+                    } catch (...) {
+#if HAVE_OPENMP
+#pragma omp critical(EquilPhasePressureError)
+#endif // HAVE_OPENMP
+                        {
+                            if (!error) {
+                                error = std::current_exception();
+                            }
+                        }
+                    }
+                }
+                if (error) {
+                    std::rethrow_exception(error);
                 }
             }
 
@@ -617,7 +637,6 @@ namespace Opm
                     /*storeViscosity=*/false,
                     /*storeEnthalpy=*/false> SatOnlyFluidState;
 
-            SatOnlyFluidState fluidState;
             typedef typename MaterialLawManager::MaterialLaw MaterialLaw;
 
             const bool water = FluidSystem::phaseIsActive(FluidSystem::waterPhaseIdx);
@@ -625,124 +644,150 @@ namespace Opm
             const int oilpos = FluidSystem::oilPhaseIdx;
             const int waterpos = FluidSystem::waterPhaseIdx;
             const int gaspos = FluidSystem::gasPhaseIdx;
-            std::vector<double>::size_type local_index = 0;
-            for (typename CellRange::const_iterator ci = cells.begin(); ci != cells.end(); ++ci, ++local_index) {
-                const int cell = *ci;
-                const auto& scaledDrainageInfo =
-                    materialLawManager.oilWaterScaledEpsInfoDrainage(cell);
-                const auto& matParams = materialLawManager.materialLawParams(cell);
-
-                // Find saturations from pressure differences by
-                // inverting capillary pressure functions.
-                double sw = 0.0;
-                if (water) {
-                    if (isConstPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,FluidSystem::waterPhaseIdx, cell)){
-                        const double cellDepth  =  UgGridHelpers::cellCenterDepth(G,
-                                                                            cell);
-                        sw = satFromDepth<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,cellDepth,reg.zwoc(),waterpos,cell,false);
-                        phase_saturations[waterpos][local_index] = sw;
-                    }
-                    else{
-                        const double pcov = phase_pressures[oilpos][local_index] - phase_pressures[waterpos][local_index];
-                        if (swat_init.empty()) { // Invert Pc to find sw
-                            sw = satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, waterpos, cell, pcov);
-                            phase_saturations[waterpos][local_index] = sw;
-                        } else { // Scale Pc to reflect imposed sw
-                            sw = swat_init[cell];
-                            sw = materialLawManager.applySwatinit(cell, pcov, sw);
+            // The cells are independent, except for the scaling of the
+            // capillary pressure to SWATINIT, which updates the material
+            // law parameters and is done serially.
+            const std::vector<int> cell_list(cells.begin(), cells.end());
+            const int num_cells = cell_list.size();
+            std::exception_ptr error;
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(dynamic, 64) if(num_cells >= Details::minimumParallelCells && swat_init.empty())
+#endif // HAVE_OPENMP
+            for (int local_index = 0; local_index < num_cells; ++local_index) {
+                try {
+                    const int cell = cell_list[local_index];
+                    SatOnlyFluidState fluidState;
+                    fluidState.setSaturation(FluidSystem::waterPhaseIdx, 0.0);
+                    fluidState.setSaturation(FluidSystem::oilPhaseIdx, 0.0);
+                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, 0.0);
+                    const auto& scaledDrainageInfo =
+                        materialLawManager.oilWaterScaledEpsInfoDrainage(cell);
+                    const auto& matParams = materialLawManager.materialLawParams(cell);
+
+                    // Find saturations from pressure differences by
+                    // inverting capillary pressure functions.
+                    double sw = 0.0;
+                    if (water) {
+                        if (isConstPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,FluidSystem::waterPhaseIdx, cell)){
+                            const double cellDepth  =  UgGridHelpers::cellCenterDepth(G,
+                                                                                cell);
+                            sw = satFromDepth<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,cellDepth,reg.zwoc(),waterpos,cell,false);
                             phase_saturations[waterpos][local_index] = sw;
                         }
+                        else{
+                            const double pcov = phase_pressures[oilpos][local_index] - phase_pressures[waterpos][local_index];
+                            if (swat_init.empty()) { // Invert Pc to find sw
+                                sw = satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, waterpos, cell, pcov);
+                                phase_saturations[waterpos][local_index] = sw;
+                            } else { // Scale Pc to reflect imposed sw
+                                sw = swat_init[cell];
+                                sw = materialLawManager.applySwatinit(cell, pcov, sw);
+                                phase_saturations[waterpos][local_index] = sw;
+                            }
+                        }
                     }
-                }
-                double sg = 0.0;
-                if (gas) {
-                    if (isConstPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,FluidSystem::gasPhaseIdx,cell)){
-                        const double cellDepth  = UgGridHelpers::cellCenterDepth(G,
-                                                                                        cell);
-                        sg = satFromDepth<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,cellDepth,reg.zgoc(),gaspos,cell,true);
-                        phase_saturations[gaspos][local_index] = sg;
+                    double sg = 0.0;
+                    if (gas) {
+                        if (isConstPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,FluidSystem::gasPhaseIdx,cell)){
+                            const double cellDepth  = UgGridHelpers::cellCenterDepth(G,
+                                                                                            cell);
+                            sg = satFromDepth<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager,cellDepth,reg.zgoc(),gaspos,cell,true);
+                            phase_saturations[gaspos][local_index] = sg;
+                        }
+                        else{
+                            // Note that pcog is defined to be (pg - po), not (po - pg).
+                            const double pcog = phase_pressures[gaspos][local_index] - phase_pressures[oilpos][local_index];
+                            const double increasing = true; // pcog(sg) expected to be increasing function
+                            sg = satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, gaspos, cell, pcog, increasing);
+                            phase_saturations[gaspos][local_index] = sg;
+                        }
                     }
-                    else{
-                        // Note that pcog is defined to be (pg - po), not (po - pg).
-                        const double pcog = phase_pressures[gaspos][local_index] - phase_pressures[oilpos][local_index];
-                        const double increasing = true; // pcog(sg) expected to be increasing function
-                        sg = satFromPc<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, gaspos, cell, pcog, increasing);
+                    if (gas && water && (sg + sw > 1.0)) {
+                        // Overlapping gas-oil and oil-water transition
+                        // zones can lead to unphysical saturations when
+                        // treated as above. Must recalculate using gas-water
+                        // capillary pressure.
+                        const double pcgw = phase_pressures[gaspos][local_index] - phase_pressures[waterpos][local_index];
+                        if (! swat_init.empty()) { 
+                            // Re-scale Pc to reflect imposed sw for vanishing oil phase.
+                            // This seems consistent with ecl, and fails to honour 
+                            // swat_init in case of non-trivial gas-oil cap pressure.
+                            sw = materialLawManager.applySwatinit(cell, pcgw, sw);
+                        }
+                        sw = satFromSumOfPcs<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, waterpos, gaspos, cell, pcgw);
+                        sg = 1.0 - sw;
+                        phase_saturations[waterpos][local_index] = sw;
                         phase_saturations[gaspos][local_index] = sg;
+                        if ( water ) {
+                            fluidState.setSaturation(FluidSystem::waterPhaseIdx, sw);
+                        }
+                        else {
+                            fluidState.setSaturation(FluidSystem::waterPhaseIdx, 0.0);
+                        }
+                        fluidState.setSaturation(FluidSystem::oilPhaseIdx, 1.0 - sw - sg);
+                        fluidState.setSaturation(FluidSystem::gasPhaseIdx, sg);
+
+                        double pC[/*numPhases=*/3] = { 0.0, 0.0, 0.0 };
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
+                        phase_pressures[oilpos][local_index] = phase_pressures[gaspos][local_index] - pcGas;
                     }
-                }
-                if (gas && water && (sg + sw > 1.0)) {
-                    // Overlapping gas-oil and oil-water transition
-                    // zones can lead to unphysical saturations when
-                    // treated as above. Must recalculate using gas-water
-                    // capillary pressure.
-                    const double pcgw = phase_pressures[gaspos][local_index] - phase_pressures[waterpos][local_index];
-                    if (! swat_init.empty()) { 
-                        // Re-scale Pc to reflect imposed sw for vanishing oil phase.
-                        // This seems consistent with ecl, and fails to honour 
-                        // swat_init in case of non-trivial gas-oil cap pressure.
-                        sw = materialLawManager.applySwatinit(cell, pcgw, sw);
+                    phase_saturations[oilpos][local_index] = 1.0 - sw - sg;
+                
+                    // Adjust phase pressures for max and min saturation ...
+                    double threshold_sat = 1.0e-6;
+
+                    double so = 1.0;
+                    double pC[FluidSystem::numPhases] = { 0.0, 0.0, 0.0 };
+                    if (water) {
+                        double swu = scaledDrainageInfo.Swu;
+                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, swu);
+                        so -= swu;
                     }
-                    sw = satFromSumOfPcs<FluidSystem, MaterialLaw, MaterialLawManager>(materialLawManager, waterpos, gaspos, cell, pcgw);
-                    sg = 1.0 - sw;
-                    phase_saturations[waterpos][local_index] = sw;
-                    phase_saturations[gaspos][local_index] = sg;
-                    if ( water ) {
-                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, sw);
+                    if (gas) {
+                        double sgu = scaledDrainageInfo.Sgu;
+                        fluidState.setSaturation(FluidSystem::gasPhaseIdx, sgu);
+                        so-= sgu;
                     }
-                    else {
-                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, 0.0);
+                    fluidState.setSaturation(FluidSystem::oilPhaseIdx, so);
+
+                    if (water && sw > scaledDrainageInfo.Swu-threshold_sat ) {
+                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, scaledDrainageInfo.Swu);
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcWat = pC[FluidSystem::oilPhaseIdx] - pC[FluidSystem::waterPhaseIdx];
+                        phase_pressures[oilpos][local_index] = phase_pressures[waterpos][local_index] + pcWat;
+                    } else if (gas && sg > scaledDrainageInfo.Sgu-threshold_sat) {
+                        fluidState.setSaturation(FluidSystem::gasPhaseIdx, scaledDrainageInfo.Sgu);
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
+                        phase_pressures[oilpos][local_index] = phase_pressures[gaspos][local_index] - pcGas;
+                    }
+                    if (gas && sg < scaledDrainageInfo.Sgl+threshold_sat) {
+                        fluidState.setSaturation(FluidSystem::gasPhaseIdx, scaledDrainageInfo.Sgl);
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
+                        phase_pressures[gaspos][local_index] = phase_pressures[oilpos][local_index] + pcGas;
+                    }
+                    if (water && sw < scaledDrainageInfo.Swl+threshold_sat) {
+                        fluidState.setSaturation(FluidSystem::waterPhaseIdx, scaledDrainageInfo.Swl);
+                        MaterialLaw::capillaryPressures(pC, matParams, fluidState);
+                        double pcWat = pC[FluidSystem::oilPhaseIdx] - pC[FluidSystem::waterPhaseIdx];
+                        phase_pressures[waterpos][local_index] = phase_pressures[oilpos][local_index] - pcWat;
+                    }
+                } catch (...) {
+#if HAVE_OPENMP
+#pragma omp critical(EquilPhaseSaturationsError)
+#endif // HAVE_OPENMP
+                    {
+                        if (!error) {
+                            error = std::current_exception();
+                        }
                     }
-                    fluidState.setSaturation(FluidSystem::oilPhaseIdx, 1.0 - sw - sg);
-                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, sg);
-
-                    double pC[/*numPhases=*/3] = { 0.0, 0.0, 0.0 };
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
-                    phase_pressures[oilpos][local_index] = phase_pressures[gaspos][local_index] - pcGas;
-                }
-                phase_saturations[oilpos][local_index] = 1.0 - sw - sg;
-                
-                // Adjust phase pressures for max and min saturation ...
-                double threshold_sat = 1.0e-6;
-
-                double so = 1.0;
-                double pC[FluidSystem::numPhases] = { 0.0, 0.0, 0.0 };
-                if (water) {
-                    double swu = scaledDrainageInfo.Swu;
-                    fluidState.setSaturation(FluidSystem::waterPhaseIdx, swu);
-                    so -= swu;
-                }
-                if (gas) {
-                    double sgu = scaledDrainageInfo.Sgu;
-                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, sgu);
-                    so-= sgu;
-                }
-                fluidState.setSaturation(FluidSystem::oilPhaseIdx, so);
-
-                if (water && sw > scaledDrainageInfo.Swu-threshold_sat ) {
-                    fluidState.setSaturation(FluidSystem::waterPhaseIdx, scaledDrainageInfo.Swu);
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcWat = pC[FluidSystem::oilPhaseIdx] - pC[FluidSystem::waterPhaseIdx];
-                    phase_pressures[oilpos][local_index] = phase_pressures[waterpos][local_index] + pcWat;
-                } else if (gas && sg > scaledDrainageInfo.Sgu-threshold_sat) {
-                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, scaledDrainageInfo.Sgu);
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
-                    phase_pressures[oilpos][local_index] = phase_pressures[gaspos][local_index] - pcGas;
-                }
-                if (gas && sg < scaledDrainageInfo.Sgl+threshold_sat) {
-                    fluidState.setSaturation(FluidSystem::gasPhaseIdx, scaledDrainageInfo.Sgl);
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcGas = pC[FluidSystem::oilPhaseIdx] + pC[FluidSystem::gasPhaseIdx];
-                    phase_pressures[gaspos][local_index] = phase_pressures[oilpos][local_index] + pcGas;
-                }
-                if (water && sw < scaledDrainageInfo.Swl+threshold_sat) {
-                    fluidState.setSaturation(FluidSystem::waterPhaseIdx, scaledDrainageInfo.Swl);
-                    MaterialLaw::capillaryPressures(pC, matParams, fluidState);
-                    double pcWat = pC[FluidSystem::oilPhaseIdx] - pC[FluidSystem::waterPhaseIdx];
-                    phase_pressures[waterpos][local_index] = phase_pressures[oilpos][local_index] - pcWat;
                 }
             }
+            if (error) {
+                std::rethrow_exception(error);
+            }
             return phase_saturations;
         }
 
@@ -774,11 +819,30 @@ namespace Opm
                                       const std::vector<double> gas_saturation)
         {
             assert(UgGridHelpers::dimensions(grid) == 3);
-            std::vector<double> rs(cells.size());
-            int count = 0;
-            for (auto it = cells.begin(); it != cells.end(); ++it, ++count) {
-                const double depth = UgGridHelpers::cellCenterDepth(grid, *it);
-                rs[count] = rs_func(depth, oil_pressure[count], temperature[count], gas_saturation[count]);
+            const std::vector<int> cell_list(cells.begin(), cells.end());
+            const int num_cells = cell_list.size();
+            std::vector<double> rs(num_cells);
+            std::exception_ptr error;
+#if HAVE_OPENMP
+#pragma omp parallel for schedule(static) if(num_cells >= Details::minimumParallelCells)
+#endif // HAVE_OPENMP
+            for (int count = 0; count < num_cells; ++count) {
+                try {
+                    const double depth = UgGridHelpers::cellCenterDepth(grid, cell_list[count]);
+                    rs[count] = rs_func(depth, oil_pressure[count], temperature[count], gas_saturation[count]);
+                } catch (...) {
+#if HAVE_OPENMP
+#pragma omp critical(EquilRsError)
+#endif // HAVE_OPENMP
+                    {
+                        if (!error) {
+                            error = std::current_exception();
+                        }
+                    }
+                }
+            }
+            if (error) {
+                std::rethrow_exception(error);
             }
             return rs;
         }
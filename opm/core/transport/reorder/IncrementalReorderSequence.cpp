@@ -0,0 +1,348 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "config.h"
+#include <opm/core/transport/reorder/IncrementalReorderSequence.hpp>
+#include <opm/core/transport/reorder/tarjan.h>
+#include <opm/grid/UnstructuredGrid.h>
+
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+namespace Opm
+{
+
+    IncrementalReorderSequence::IncrementalReorderSequence(const double max_repair_fraction)
+        : max_repair_fraction_(max_repair_fraction),
+          num_cells_(0),
+          num_connections_(0),
+          connection_cells_(nullptr),
+          cell_connection_pos_(nullptr),
+          cell_connections_(nullptr),
+          num_sorted_cells_(0)
+    {
+    }
+
+
+
+    void IncrementalReorderSequence::compute(const UnstructuredGrid& grid, const double* flux)
+    {
+        compute(grid.number_of_cells, grid.number_of_faces,
+                grid.face_cells, grid.cell_facepos, grid.cell_faces, flux);
+    }
+
+
+
+    void IncrementalReorderSequence::compute(const int num_cells,
+                                             const int num_connections,
+                                             const int* connection_cells,
+                                             const int* cell_connection_pos,
+                                             const int* cell_connections,
+                                             const double* flux)
+    {
+        const bool same_graph = connection_cells == connection_cells_
+            && cell_connection_pos == cell_connection_pos_
+            && cell_connections == cell_connections_
+            && num_cells == num_cells_
+            && num_connections == num_connections_
+            && !components_.empty();
+        num_cells_ = num_cells;
+        num_connections_ = num_connections;
+        connection_cells_ = connection_cells;
+        cell_connection_pos_ = cell_connection_pos;
+        cell_connections_ = cell_connections;
+        if (!same_graph || !repair(flux)) {
+            computeFull(flux);
+        }
+    }
+
+
+
+    const std::vector<int>& IncrementalReorderSequence::sequence() const
+    {
+        return sequence_;
+    }
+
+
+
+    const std::vector<int>& IncrementalReorderSequence::components() const
+    {
+        return components_;
+    }
+
+
+
+    int IncrementalReorderSequence::numComponents() const
+    {
+        return components_.empty() ? 0 : int(components_.size()) - 1;
+    }
+
+
+
+    int IncrementalReorderSequence::numSortedCells() const
+    {
+        return num_sorted_cells_;
+    }
+
+
+
+    void IncrementalReorderSequence::reset()
+    {
+        connection_cells_ = nullptr;
+        cell_connection_pos_ = nullptr;
+        cell_connections_ = nullptr;
+        direction_.clear();
+        sequence_.clear();
+        components_.clear();
+        component_of_cell_.clear();
+        num_sorted_cells_ = 0;
+    }
+
+
+
+    void IncrementalReorderSequence::computeLevels(const LevelDependency dependency,
+                                                   std::vector<int>& levels,
+                                                   std::vector<int>& level_components)
+    {
+        // The components that a component depends on come before it in
+        // the sequence, so their levels are known.
+        const int ncomp = numComponents();
+        level_of_component_.assign(ncomp, 0);
+        int nlevels = ncomp > 0 ? 1 : 0;
+        for (int k = 0; k < ncomp; ++k) {
+            int level = 0;
+            for (int p = components_[k]; p < components_[k + 1]; ++p) {
+                const int cell = sequence_[p];
+                for (int j = cell_connection_pos_[cell]; j < cell_connection_pos_[cell + 1]; ++j) {
+                    const int conn = cell_connections_[j];
+                    const int c0 = connection_cells_[2*conn];
+                    const int c1 = connection_cells_[2*conn + 1];
+                    if (c0 < 0 || c1 < 0) {
+                        continue;
+                    }
+                    const int other = (cell == c0) ? c1 : c0;
+                    const int other_comp = component_of_cell_[other];
+                    if (other_comp >= k) {
+                        continue;
+                    }
+                    const bool upwind = direction_[conn] == ((cell == c0) ? -1 : 1);
+                    if (dependency == AllNeighbours || upwind) {
+                        level = std::max(level, level_of_component_[other_comp] + 1);
+                    }
+                }
+            }
+            level_of_component_[k] = level;
+            nlevels = std::max(nlevels, level + 1);
+        }
+
+        // Sort the components by level, keeping the sequence order within
+        // each level.
+        levels.assign(nlevels + 1, 0);
+        for (int k = 0; k < ncomp; ++k) {
+            ++levels[level_of_component_[k] + 1];
+        }
+        for (int level = 0; level < nlevels; ++level) {
+            levels[level + 1] += levels[level];
+        }
+        level_components.resize(ncomp);
+        level_pos_.assign(levels.begin(), levels.end() - 1);
+        for (int k = 0; k < ncomp; ++k) {
+            level_components[level_pos_[level_of_component_[k]]++] = k;
+        }
+    }
+
+
+
+    signed char IncrementalReorderSequence::upwindDirection(const double* flux, const int conn) const
+    {
+        if (connection_cells_[2*conn] < 0 || connection_cells_[2*conn + 1] < 0) {
+            return 0;
+        }
+        return flux[conn] > 0.0 ? 1 : (flux[conn] < 0.0 ? -1 : 0);
+    }
+
+
+
+    void IncrementalReorderSequence::computeFull(const double* flux)
+    {
+        // Sort all cells as if they were a single component.
+        const int nc = num_cells_;
+        sequence_.resize(nc);
+        for (int cell = 0; cell < nc; ++cell) {
+            sequence_[cell] = cell;
+        }
+        components_.assign(1, 0);
+        components_.push_back(nc);
+        local_index_.assign(nc, -1);
+        new_components_.assign(1, 0);
+        if (nc > 0) {
+            sortInterval(flux, 0, 0);
+        }
+        components_.swap(new_components_);
+
+        direction_.resize(num_connections_);
+        for (int conn = 0; conn < num_connections_; ++conn) {
+            direction_[conn] = upwindDirection(flux, conn);
+        }
+        component_of_cell_.resize(nc);
+        updateComponentOfCell(0);
+        num_sorted_cells_ = nc;
+    }
+
+
+
+    bool IncrementalReorderSequence::repair(const double* flux)
+    {
+        const int ncomp = numComponents();
+
+        // Components k, ..., interval_end_[k] must be sorted again if
+        // interval_end_[k] >= k.
+        interval_end_.assign(ncomp, -1);
+        auto mark = [this](const int first, const int last) {
+            interval_end_[first] = std::max(interval_end_[first], last);
+        };
+        for (int conn = 0; conn < num_connections_; ++conn) {
+            const signed char dir = upwindDirection(flux, conn);
+            if (dir == direction_[conn]) {
+                continue;
+            }
+            const int k0 = component_of_cell_[connection_cells_[2*conn]];
+            const int k1 = component_of_cell_[connection_cells_[2*conn + 1]];
+            if (direction_[conn] != 0 && k0 == k1) {
+                // Lost an internal edge, the component may split.
+                mark(k0, k0);
+            }
+            if (dir > 0 && k0 > k1) {
+                mark(k1, k0);
+            } else if (dir < 0 && k1 > k0) {
+                mark(k0, k1);
+            }
+            direction_[conn] = dir;
+        }
+
+        // Merge overlapping intervals.
+        intervals_.clear();
+        int num_cells = 0;
+        for (int k = 0; k < ncomp; ) {
+            if (interval_end_[k] < 0) {
+                ++k;
+                continue;
+            }
+            const int first = k;
+            int last = interval_end_[k];
+            for (; k <= last; ++k) {
+                last = std::max(last, interval_end_[k]);
+            }
+            intervals_.emplace_back(first, last);
+            num_cells += components_[last + 1] - components_[first];
+        }
+        if (num_cells > max_repair_fraction_ * num_cells_) {
+            return false;
+        }
+
+        num_sorted_cells_ = num_cells;
+        if (intervals_.empty()) {
+            return true;
+        }
+
+        // Sort the intervals again, other components are kept as they are.
+        new_components_.assign(1, 0);
+        int k = 0;
+        for (const auto& interval : intervals_) {
+            for (; k < interval.first; ++k) {
+                new_components_.push_back(components_[k + 1]);
+            }
+            sortInterval(flux, interval.first, interval.second);
+            k = interval.second + 1;
+        }
+        for (; k < ncomp; ++k) {
+            new_components_.push_back(components_[k + 1]);
+        }
+        components_.swap(new_components_);
+        updateComponentOfCell(intervals_.front().first);
+        return true;
+    }
+
+
+
+    void IncrementalReorderSequence::sortInterval(const double* flux, const int first_comp, const int last_comp)
+    {
+        const int begin = components_[first_comp];
+        const int end = components_[last_comp + 1];
+        const int m = end - begin;
+        for (int i = 0; i < m; ++i) {
+            local_index_[sequence_[begin + i]] = i;
+        }
+
+        // Upwind graph of the cells of the interval, as in compute_sequence().
+        // Edges to cells outside the interval all agree with the order of
+        // the intervals, so they do not affect the components.
+        ia_.resize(m + 1);
+        ja_.clear();
+        ia_[0] = 0;
+        for (int i = 0; i < m; ++i) {
+            const int cell = sequence_[begin + i];
+            for (int j = cell_connection_pos_[cell]; j < cell_connection_pos_[cell + 1]; ++j) {
+                const int conn = cell_connections_[j];
+                const int c0 = connection_cells_[2*conn];
+                const int c1 = connection_cells_[2*conn + 1];
+                if (c0 < 0 || c1 < 0) {
+                    continue;
+                }
+                const int other = (cell == c0) ? c1 : c0;
+                const double theflux = (cell == c0) ? flux[conn] : -flux[conn];
+                if (theflux < 0.0 && local_index_[other] >= 0) {
+                    ja_.push_back(local_index_[other]);
+                }
+            }
+            ia_[i + 1] = ja_.size();
+        }
+
+        vert_.resize(m);
+        comp_.resize(m + 1);
+        work_.resize(3 * m);
+        int ncomp = 0;
+        tarjan(m, ia_.data(), ja_.data(), vert_.data(), comp_.data(), &ncomp, work_.data());
+        assert(0 < ncomp && ncomp <= m);
+
+        // The scratch array is free again, use it for the old cell order.
+        std::copy(sequence_.begin() + begin, sequence_.begin() + end, work_.begin());
+        for (int i = 0; i < m; ++i) {
+            sequence_[begin + i] = work_[vert_[i]];
+            local_index_[work_[i]] = -1;
+        }
+        for (int c = 1; c <= ncomp; ++c) {
+            new_components_.push_back(begin + comp_[c]);
+        }
+    }
+
+
+
+    void IncrementalReorderSequence::updateComponentOfCell(const int first_comp)
+    {
+        const int ncomp = numComponents();
+        for (int k = first_comp; k < ncomp; ++k) {
+            for (int p = components_[k]; p < components_[k + 1]; ++p) {
+                component_of_cell_[sequence_[p]] = k;
+            }
+        }
+    }
+
+} // namespace Opm
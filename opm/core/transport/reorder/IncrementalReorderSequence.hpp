@@ -0,0 +1,174 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OPM_INCREMENTALREORDERSEQUENCE_HEADER_INCLUDED
+#define OPM_INCREMENTALREORDERSEQUENCE_HEADER_INCLUDED
+
+#include <utility>
+#include <vector>
+
+struct UnstructuredGrid;
+
+namespace Opm
+{
+
+    /// Causal cell sequence and strongly connected components of the
+    /// upwind graph of a flux field, as computed by compute_sequence(),
+    /// but updated incrementally when the flux field changes.
+    ///
+    /// The first call to compute() for a grid does a full topological
+    /// sort. Later calls only look at the connections where the flux
+    /// changed direction. Where such a connection gives an edge against
+    /// the current order, the components between its end points are
+    /// sorted again, and a component that lost an internal edge is
+    /// checked for splitting. All other components keep their relative
+    /// order. If the repaired part of the sequence becomes too large, a
+    /// full sort is done instead.
+    ///
+    /// The sequence may differ from the one computed from scratch, but
+    /// is always a topological order of the components, and the
+    /// components are exactly the strongly connected components.
+    ///
+    /// Besides an UnstructuredGrid, any connection graph given in
+    /// compressed form can be used, such as the faces and
+    /// non-neighbouring connections of a corner-point grid. The scratch
+    /// space is kept between calls, so that repeated calls for the same
+    /// graph do not allocate.
+    class IncrementalReorderSequence
+    {
+    public:
+        /// Neighbours that a component depends on in computeLevels().
+        enum LevelDependency {
+            /// Neighbours upwind of the component.
+            UpwindNeighbours,
+            /// Neighbours through any connection, upwind or not.
+            AllNeighbours
+        };
+
+        /// Construct with a limit on the fraction of cells that may be
+        /// sorted again before a full sort is done instead.
+        explicit IncrementalReorderSequence(const double max_repair_fraction = 0.25);
+
+        /// Compute the sequence for the given flux field, with one value
+        /// per face of the grid, positive from face_cells[2*f] to
+        /// face_cells[2*f + 1].
+        void compute(const UnstructuredGrid& grid, const double* flux);
+
+        /// Compute the sequence for the given flux field on a general
+        /// connection graph. The arrays must stay valid and unchanged
+        /// between calls, unless reset() is called.
+        /// \param[in] num_cells           Number of cells.
+        /// \param[in] num_connections     Number of connections.
+        /// \param[in] connection_cells    The two cells of each connection, -1
+        ///                                for a boundary connection. Array of
+        ///                                size 2*num_connections.
+        /// \param[in] cell_connection_pos Start of the connections of each cell
+        ///                                in cell_connections. Array of size
+        ///                                num_cells + 1.
+        /// \param[in] cell_connections    Connections of each cell.
+        /// \param[in] flux                One value per connection, positive
+        ///                                from connection_cells[2*c] to
+        ///                                connection_cells[2*c + 1].
+        void compute(const int num_cells,
+                     const int num_connections,
+                     const int* connection_cells,
+                     const int* cell_connection_pos,
+                     const int* cell_connections,
+                     const double* flux);
+
+        /// Cells in causal order.
+        const std::vector<int>& sequence() const;
+
+        /// Start of each component in sequence(), with one extra element
+        /// for the end of the last component.
+        const std::vector<int>& components() const;
+
+        /// Number of strongly connected components.
+        int numComponents() const;
+
+        /// Number of cells sorted by the last call to compute(). This
+        /// is the number of cells of the grid for a full sort.
+        int numSortedCells() const;
+
+        /// Forget the current sequence, the next compute() does a full sort.
+        void reset();
+
+        /// Group the components of the current sequence in levels. A
+        /// component is placed in the level after the last level holding
+        /// a component that it depends on and that comes before it in
+        /// the sequence, using the flux of the last call to compute().
+        ///
+        /// With UpwindNeighbours, the components of a level can be solved
+        /// in any order, or concurrently, by a solver that only reads
+        /// upwind values. With AllNeighbours, no two neighbouring
+        /// components are in the same level, which is needed by a solver
+        /// that also reads downwind values and should see the same values
+        /// as in a serial sweep.
+        /// \param[in]  dependency       Neighbours that a component depends on.
+        /// \param[out] levels           Start of each level in level_components,
+        ///                              with one extra element for the end of
+        ///                              the last level.
+        /// \param[out] level_components Components sorted by level, in sequence
+        ///                              order within each level.
+        void computeLevels(const LevelDependency dependency,
+                           std::vector<int>& levels,
+                           std::vector<int>& level_components);
+
+    private:
+        signed char upwindDirection(const double* flux, const int conn) const;
+        void computeFull(const double* flux);
+        bool repair(const double* flux);
+        void sortInterval(const double* flux, const int first_comp, const int last_comp);
+        void updateComponentOfCell(const int first_comp);
+
+        double max_repair_fraction_;
+
+        // The connection graph.
+        int num_cells_;
+        int num_connections_;
+        const int* connection_cells_;
+        const int* cell_connection_pos_;
+        const int* cell_connections_;
+
+        // Direction of the upwind edge of each connection: 1 from
+        // connection_cells[2*c] to connection_cells[2*c + 1], -1 the
+        // other way, 0 for no edge.
+        std::vector<signed char> direction_;
+        std::vector<int> sequence_;
+        std::vector<int> components_;
+        std::vector<int> component_of_cell_;
+        int num_sorted_cells_;
+
+        // Scratch space.
+        std::vector<int> interval_end_;
+        std::vector<std::pair<int, int>> intervals_;
+        std::vector<int> new_components_;
+        std::vector<int> local_index_;
+        std::vector<int> ia_;
+        std::vector<int> ja_;
+        std::vector<int> vert_;
+        std::vector<int> comp_;
+        std::vector<int> work_;
+        std::vector<int> level_of_component_;
+        std::vector<int> level_pos_;
+    };
+
+} // namespace Opm
+
+#endif // OPM_INCREMENTALREORDERSEQUENCE_HEADER_INCLUDED
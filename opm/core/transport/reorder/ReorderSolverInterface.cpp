@@ -19,10 +19,10 @@
 
 #include "config.h"
 #include <opm/core/transport/reorder/ReorderSolverInterface.hpp>
-#include <opm/core/transport/reorder/reordersequence.h>
 #include <opm/grid/UnstructuredGrid.h>
 #include <opm/grid/utility/StopWatch.hpp>
 
+#include <algorithm>
 #include <vector>
 #include <cassert>
 #include <iostream>
@@ -31,17 +31,10 @@
 void Opm::ReorderSolverInterface::reorderAndTransport(const UnstructuredGrid& grid, const double* darcyflux)
 {
     // Compute reordered sequence of single-cell problems
-    sequence_.resize(grid.number_of_cells);
-    components_.resize(grid.number_of_cells + 1);
-    int ncomponents;
-    time::StopWatch clock;
-    clock.start();
-    compute_sequence(&grid, darcyflux, &sequence_[0], &components_[0], &ncomponents);
-    clock.stop();
-    std::cout << "Topological sort took: " << clock.secsSinceStart() << " seconds." << std::endl;
-
-    // Make vector's size match actual used data.
-    components_.resize(ncomponents + 1);
+    reorder(grid, darcyflux);
+    const int ncomponents = reorder_.numComponents();
+    const std::vector<int>& seq = reorder_.sequence();
+    const std::vector<int>& comps = reorder_.components();
 
     // Invoke appropriate solve method for each interdependent component.
     for (int comp = 0; comp < ncomponents; ++comp) {
@@ -55,23 +48,52 @@ void Opm::ReorderSolverInterface::reorderAndTransport(const UnstructuredGrid& gr
         }
 #endif
 #endif
-	const int comp_size = components_[comp + 1] - components_[comp];
+	const int comp_size = comps[comp + 1] - comps[comp];
 	if (comp_size == 1) {
-	    solveSingleCell(sequence_[components_[comp]]);
+	    solveSingleCell(seq[comps[comp]]);
 	} else {
-	    solveMultiCell(comp_size, &sequence_[components_[comp]]);
+	    solveMultiCell(comp_size, &seq[comps[comp]]);
 	}
     }
 }
 
 
+void Opm::ReorderSolverInterface::reorder(const UnstructuredGrid& grid, const double* darcyflux)
+{
+    time::StopWatch clock;
+    clock.start();
+    reorder_.compute(grid, darcyflux);
+    clock.stop();
+    std::cout << "Topological sort took: " << clock.secsSinceStart() << " seconds." << std::endl;
+}
+
+
+void Opm::ReorderSolverInterface::computeLevels()
+{
+    reorder_.computeLevels(IncrementalReorderSequence::UpwindNeighbours,
+                           levels_, level_components_);
+}
+
+
+const std::vector<int>& Opm::ReorderSolverInterface::levels() const
+{
+    return levels_;
+}
+
+
+const std::vector<int>& Opm::ReorderSolverInterface::levelComponents() const
+{
+    return level_components_;
+}
+
+
 const std::vector<int>& Opm::ReorderSolverInterface::sequence() const
 {
-    return sequence_;
+    return reorder_.sequence();
 }
 
 
 const std::vector<int>& Opm::ReorderSolverInterface::components() const
 {
-    return components_;
+    return reorder_.components();
 }
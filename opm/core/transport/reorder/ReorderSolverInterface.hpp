@@ -20,6 +20,8 @@
 #ifndef OPM_REORDERSOLVERINTERFACE_HEADER_INCLUDED
 #define OPM_REORDERSOLVERINTERFACE_HEADER_INCLUDED
 
+#include <opm/core/transport/reorder/IncrementalReorderSequence.hpp>
+
 #include <vector>
 
 struct UnstructuredGrid;
@@ -35,6 +37,11 @@ namespace Opm
     /// class.) The reorderAndTransport() method is provided as an aid
     /// to implementing solve() in subclasses, together with the
     /// sequence() and components() methods for accessing the ordering.
+    /// The ordering is updated incrementally from one call of
+    /// reorderAndTransport() to the next, see IncrementalReorderSequence.
+    /// Subclasses that solve independent components concurrently may
+    /// instead call reorder() and computeLevels(), and traverse the
+    /// components level by level.
     class ReorderSolverInterface
     {
     public:
@@ -44,11 +51,22 @@ namespace Opm
 	virtual void solveMultiCell(const int num_cells, const int* cells) = 0;
     protected:
 	void reorderAndTransport(const UnstructuredGrid& grid, const double* darcyflux);
+        void reorder(const UnstructuredGrid& grid, const double* darcyflux);
         const std::vector<int>& sequence() const;
         const std::vector<int>& components() const;
+
+        /// Group the components of the ordering computed by the last
+        /// reorder() in levels. A component only has upstream neighbours
+        /// in earlier levels, so the components of a level can be solved
+        /// in any order, or concurrently. The components of level l are
+        /// levelComponents()[levels()[l]], ..., levelComponents()[levels()[l+1] - 1].
+        void computeLevels();
+        const std::vector<int>& levels() const;
+        const std::vector<int>& levelComponents() const;
     private:
-        std::vector<int> sequence_;
-        std::vector<int> components_;
+        IncrementalReorderSequence reorder_;
+        std::vector<int> levels_;
+        std::vector<int> level_components_;
     };
 
 
@@ -47,11 +47,13 @@ namespace Opm
                                                                    const Opm::IncompPropertiesInterface& props,
                                                                    const double* gravity,
                                                                    const double tol,
-                                                                   const int maxit)
+                                                                   const int maxit,
+                                                                   const bool batch_levels)
         : grid_(grid),
           props_(props),
           tol_(tol),
           maxit_(maxit),
+          batch_levels_(batch_levels),
           darcyflux_(0),
           source_(0),
           dt_(0.0),
@@ -116,11 +118,44 @@ namespace Opm
                                &ia_downw_[0], &ja_downw_[0]);
 #endif
         std::fill(reorder_iterations_.begin(),reorder_iterations_.end(),0);
-        reorderAndTransport(grid_, darcyflux_);
+        if (batch_levels_) {
+            solveByLevels();
+        } else {
+            reorderAndTransport(grid_, darcyflux_);
+        }
         toBothSat(saturation_, state.saturation());
     }
 
 
+    void TransportSolverTwophaseReorder::solveByLevels()
+    {
+        ReorderSolverInterface::reorder(grid_, darcyflux_);
+        ReorderSolverInterface::computeLevels();
+        const std::vector<int>& seq = ReorderSolverInterface::sequence();
+        const std::vector<int>& comps = ReorderSolverInterface::components();
+        const std::vector<int>& levels = ReorderSolverInterface::levels();
+        const std::vector<int>& level_comps = ReorderSolverInterface::levelComponents();
+        const int num_levels = levels.size() - 1;
+
+        // The components of a level only depend on earlier levels, so
+        // the single cells of a level are collected and solved together.
+        std::vector<int>& single_cells = batch_.level_cells;
+        for (int level = 0; level < num_levels; ++level) {
+            single_cells.clear();
+            for (int i = levels[level]; i < levels[level + 1]; ++i) {
+                const int comp = level_comps[i];
+                const int comp_size = comps[comp + 1] - comps[comp];
+                if (comp_size == 1) {
+                    single_cells.push_back(seq[comps[comp]]);
+                } else {
+                    solveMultiCell(comp_size, &seq[comps[comp]]);
+                }
+            }
+            solveSingleCells(single_cells.size(), single_cells.data());
+        }
+    }
+
+
     const std::vector<int>& TransportSolverTwophaseReorder::getReorderIterations() const
     {
         return reorder_iterations_;
@@ -201,6 +236,162 @@ namespace Opm
         fractionalflow_[cell] = fracFlow(saturation_[cell], cell);
     }
 
+    // Solve a number of single-cell problems that do not depend on each
+    // other. Each cell is solved by regula falsi with the Illinois
+    // modification on a bracket taken from [0, 1] and the initial guess.
+    // The iterations of all cells are done in lockstep, so that the
+    // relative permeabilities of the cells that have not converged are
+    // evaluated by a single call per iteration. Cells that are not
+    // bracketed, or do not converge in maxit_ iterations, are left to
+    // solveSingleCell(), which starts over from the initial guess. The
+    // iterations spent in lockstep are counted for those cells as well.
+    void TransportSolverTwophaseReorder::solveSingleCells(const int num_cells, const int* cells)
+    {
+        if (num_cells == 0) {
+            return;
+        }
+        CellBatch& b = batch_;
+        b.s0.resize(num_cells);
+        b.influx.resize(num_cells);
+        b.outflux.resize(num_cells);
+        b.dtpv.resize(num_cells);
+        b.s.resize(num_cells);
+        b.s_lo.resize(num_cells);
+        b.s_hi.resize(num_cells);
+        b.r_lo.resize(num_cells);
+        b.r_hi.resize(num_cells);
+        b.fw.resize(num_cells);
+        b.r.resize(num_cells);
+        b.side.resize(num_cells);
+        b.active.resize(num_cells);
+        for (int i = 0; i < num_cells; ++i) {
+            const Residual res(*this, cells[i]);
+            b.s0[i] = res.s0;
+            b.influx[i] = res.influx;
+            b.outflux[i] = res.outflux;
+            b.dtpv[i] = res.dtpv;
+            b.s[i] = saturation_[cells[i]];
+            b.active[i] = i;
+        }
+
+        // Compute fractional flow and residual at b.s for the active cells.
+        auto evaluate = [&]() {
+            const int n = b.active.size();
+            b.eval_cells.resize(n);
+            b.eval_sat.resize(2*n);
+            b.eval_kr.resize(2*n);
+            for (int k = 0; k < n; ++k) {
+                const int i = b.active[k];
+                b.eval_cells[k] = cells[i];
+                b.eval_sat[2*k] = b.s[i];
+                b.eval_sat[2*k + 1] = 1.0 - b.s[i];
+            }
+            props_.relperm(n, b.eval_sat.data(), b.eval_cells.data(), b.eval_kr.data(), 0);
+            for (int k = 0; k < n; ++k) {
+                const int i = b.active[k];
+                const double mob0 = b.eval_kr[2*k]/visc_[0];
+                const double mob1 = b.eval_kr[2*k + 1]/visc_[1];
+                b.fw[i] = mob0/(mob0 + mob1);
+                b.r[i] = b.s[i] - b.s0[i] + b.dtpv[i]*(b.outflux[i]*b.fw[i] + b.influx[i]);
+            }
+        };
+        auto accept = [&](const int i, const int iters) {
+            const int cell = cells[i];
+            saturation_[cell] = b.s[i];
+            fractionalflow_[cell] = b.fw[i];
+            reorder_iterations_[cell] += iters;
+        };
+
+        // Residual at the initial guess, which replaces one end of [0, 1].
+        evaluate();
+        int num_active = 0;
+        for (int i : b.active) {
+            if (std::fabs(b.r[i]) < tol_) {
+                accept(i, 0);
+                continue;
+            }
+            if (b.r[i] < 0.0) {
+                b.s_lo[i] = b.s[i];
+                b.r_lo[i] = b.r[i];
+                b.s_hi[i] = 1.0;
+                b.side[i] = 1;
+            } else {
+                b.s_hi[i] = b.s[i];
+                b.r_hi[i] = b.r[i];
+                b.s_lo[i] = 0.0;
+                b.side[i] = -1;
+            }
+            b.s[i] = b.side[i] > 0 ? b.s_hi[i] : b.s_lo[i];
+            b.active[num_active++] = i;
+        }
+        b.active.resize(num_active);
+
+        // Residual at the other end.
+        evaluate();
+        b.fallback.clear();
+        num_active = 0;
+        for (int i : b.active) {
+            if (std::fabs(b.r[i]) < tol_) {
+                accept(i, 0);
+                continue;
+            }
+            if (b.side[i] > 0) {
+                b.r_hi[i] = b.r[i];
+            } else {
+                b.r_lo[i] = b.r[i];
+            }
+            if (!(b.r_lo[i] < 0.0 && b.r_hi[i] > 0.0)) {
+                b.fallback.push_back(i);
+                continue;
+            }
+            b.side[i] = 0;
+            b.active[num_active++] = i;
+        }
+        b.active.resize(num_active);
+
+        // Iterate in lockstep.
+        int iter = 0;
+        while (!b.active.empty() && iter < maxit_) {
+            ++iter;
+            for (int i : b.active) {
+                b.s[i] = b.s_lo[i] - b.r_lo[i]*(b.s_hi[i] - b.s_lo[i])/(b.r_hi[i] - b.r_lo[i]);
+            }
+            evaluate();
+            num_active = 0;
+            for (int i : b.active) {
+                if (std::fabs(b.r[i]) < tol_) {
+                    accept(i, iter);
+                    continue;
+                }
+                if (b.r[i] < 0.0) {
+                    b.s_lo[i] = b.s[i];
+                    b.r_lo[i] = b.r[i];
+                    if (b.side[i] < 0) {
+                        b.r_hi[i] *= 0.5;
+                    }
+                    b.side[i] = -1;
+                } else {
+                    b.s_hi[i] = b.s[i];
+                    b.r_hi[i] = b.r[i];
+                    if (b.side[i] > 0) {
+                        b.r_lo[i] *= 0.5;
+                    }
+                    b.side[i] = 1;
+                }
+                b.active[num_active++] = i;
+            }
+            b.active.resize(num_active);
+        }
+
+        for (const int i : b.fallback) {
+            solveSingleCell(cells[i]);
+        }
+        for (const int i : b.active) {
+            reorder_iterations_[cells[i]] += iter;
+            solveSingleCell(cells[i]);
+        }
+    }
+
     // namespace {
     //  class TofComputer
     //  {
@@ -42,11 +42,21 @@ namespace Opm
         /// \param[in] gravity   Gravity vector (null for no gravity).
         /// \param[in] tol       Tolerance used in the solver.
         /// \param[in] maxit     Maximum number of non-linear iterations used.
+        /// \param[in] batch_levels  If true, the cells are solved level by level,
+        ///                          where the cells of a level do not depend on
+        ///                          each other. The single-cell problems of a level
+        ///                          are iterated together, with one property
+        ///                          evaluation per iteration for all of them. The
+        ///                          iteration differs from the cell by cell solve,
+        ///                          so the results are not bit-identical: both
+        ///                          satisfy the same tolerance, but may differ
+        ///                          slightly.
         TransportSolverTwophaseReorder(const UnstructuredGrid& grid,
                                        const Opm::IncompPropertiesInterface& props,
                                        const double* gravity,
                                        const double tol,
-                                       const int maxit);
+                                       const int maxit,
+                                       const bool batch_levels = false);
 
         // Virtual destructor.
         virtual ~TransportSolverTwophaseReorder();
@@ -85,6 +95,8 @@ namespace Opm
         void initColumns();
         virtual void solveSingleCell(const int cell);
         virtual void solveMultiCell(const int num_cells, const int* cells);
+        void solveByLevels();
+        void solveSingleCells(const int num_cells, const int* cells);
 
         void solveSingleCellGravity(const std::vector<int>& cells,
                                     const int pos,
@@ -98,6 +110,7 @@ namespace Opm
         std::vector<double> smax_;
         double tol_;
         int maxit_;
+        bool batch_levels_;
 
         const double* darcyflux_;   // one flux per grid face
         const double* porevolume_;  // one volume per cell
@@ -112,6 +125,29 @@ namespace Opm
         std::vector<double> mob_;
         std::vector<double> s0_;
         std::vector<std::vector<int> > columns_;
+        // For solveByLevels() and solveSingleCells().
+        struct CellBatch
+        {
+            std::vector<int> level_cells;
+            std::vector<double> s0;
+            std::vector<double> influx;
+            std::vector<double> outflux;
+            std::vector<double> dtpv;
+            std::vector<double> s;
+            std::vector<double> s_lo;
+            std::vector<double> s_hi;
+            std::vector<double> r_lo;
+            std::vector<double> r_hi;
+            std::vector<double> fw;
+            std::vector<double> r;
+            std::vector<int> side;
+            std::vector<int> active;
+            std::vector<int> fallback;
+            std::vector<int> eval_cells;
+            std::vector<double> eval_sat;
+            std::vector<double> eval_kr;
+        };
+        CellBatch batch_;
 
         // Storing the upwind and downwind graphs for experiments.
         std::vector<int> ia_upw_;
@@ -34,8 +34,6 @@
 
 using namespace Opm;
 
-#if BOOST_HEAP_AVAILABLE
-
 BOOST_AUTO_TEST_CASE(cartesian_2d_a)
 {
     const GridManager gm(2, 2);
@@ -87,11 +85,34 @@ BOOST_AUTO_TEST_CASE(cartesian_2d_b)
     }
 }
 
-#else // BOOST_HEAP_AVAILABLE is false
 
-BOOST_AUTO_TEST_CASE(dummy)
+
+BOOST_AUTO_TEST_CASE(cartesian_2d_symmetric)
 {
-    BOOST_CHECK(true);
-}
+    // Two start cells placed symmetrically in a grid with an isotropic
+    // metric, many cells are considered at the same time.
+    const int nx = 15;
+    const int ny = 11;
+    const GridManager gm(nx, ny);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    AnisotropicEikonal2d ae(grid);
 
-#endif // BOOST_HEAP_AVAILABLE
+    std::vector<double> metric(grid.number_of_cells*4, 0.0);
+    for (int cell = 0; cell < grid.number_of_cells; ++cell) {
+        metric[4*cell] = metric[4*cell + 3] = 1.0;
+    }
+    const std::vector<int> start = { 5*nx + 3, 5*nx + 11 };
+    std::vector<double> sol;
+    ae.solve(metric.data(), start, sol);
+    BOOST_REQUIRE_EQUAL(sol.size(), grid.number_of_cells);
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            const int cell = i + nx*j;
+            const double dist = std::min(std::hypot(i - 3, j - 5), std::hypot(i - 11, j - 5));
+            BOOST_CHECK(sol[cell] >= dist - 1e-12);
+            BOOST_CHECK_CLOSE(sol[cell], sol[(nx - 1 - i) + nx*j], 1e-10);
+            BOOST_CHECK_CLOSE(sol[cell], sol[i + nx*(ny - 1 - j)], 1e-10);
+        }
+    }
+    BOOST_CHECK_EQUAL(sol[5*nx + 4], 1.0);
+}
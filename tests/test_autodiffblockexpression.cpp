@@ -0,0 +1,187 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE AutoDiffBlockExpressionTest
+
+#include <opm/autodiff/AutoDiffBlockExpression.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <Eigen/Eigen>
+#include <Eigen/Sparse>
+
+using namespace Opm;
+
+namespace {
+    typedef AutoDiffBlock<double> ADB;
+
+    void checkClose(const ADB& lhs, const ADB& rhs, double tolerance)
+    {
+        BOOST_CHECK(lhs.value().isApprox(rhs.value(), tolerance));
+        BOOST_REQUIRE_EQUAL(lhs.numBlocks(), rhs.numBlocks());
+        for (int block = 0; block < lhs.numBlocks(); ++block) {
+            Eigen::SparseMatrix<double> lhs_s, rhs_s;
+            lhs.derivative()[block].toSparse(lhs_s);
+            rhs.derivative()[block].toSparse(rhs_s);
+            const Eigen::MatrixXd diff = Eigen::MatrixXd(lhs_s) - Eigen::MatrixXd(rhs_s);
+            BOOST_CHECK_SMALL(diff.cwiseAbs().maxCoeff(), tolerance);
+        }
+    }
+
+    // Three variables, and a sparse (non-square) operator that turns
+    // them into face quantities with a non-trivial sparsity pattern.
+    struct Setup
+    {
+        Setup()
+        {
+            std::vector<ADB::V> vals(3, ADB::V(4));
+            vals[0] << 1.0, 2.0, 3.0, 4.0;
+            vals[1] << 0.5, 0.25, 0.125, 0.0625;
+            vals[2] << 10.0, 20.0, 30.0, 40.0;
+            vars = ADB::variables(vals);
+
+            Eigen::SparseMatrix<double> grad(3, 4);
+            grad.insert(0, 0) = -1.0;
+            grad.insert(0, 1) =  1.0;
+            grad.insert(1, 1) = -1.0;
+            grad.insert(1, 2) =  1.0;
+            grad.insert(2, 2) = -1.0;
+            grad.insert(2, 3) =  1.0;
+            grad.makeCompressed();
+            div = Eigen::SparseMatrix<double>(grad.transpose());
+
+            c = ADB::V(4);
+            c << 2.0, -1.0, 0.5, 3.0;
+            dp = grad * vars[0];
+        }
+
+        std::vector<ADB> vars;
+        Eigen::SparseMatrix<double> div;
+        ADB::V c;
+        ADB dp = ADB::null();
+    };
+}
+
+
+
+BOOST_AUTO_TEST_CASE(DiagonalScaledSum)
+{
+    typedef AutoDiffMatrix M;
+
+    const std::vector<double> s1 = { 1.0, 2.0, 3.0 };
+    const std::vector<double> s2 = { -1.0, 0.5, 4.0 };
+    ADB::V d(3);
+    d << 0.2, 1.2, 13.4;
+    const M z(3, 3);
+    const M i = M::createIdentity(3);
+    const M dm(d.matrix().asDiagonal());
+
+    Eigen::SparseMatrix<double> s(3, 3);
+    s.insert(0, 1) = 2.0;
+    s.insert(2, 0) = -1.0;
+    s.insert(1, 1) = 5.0;
+    s.makeCompressed();
+    const M sm(s);
+
+    // Only zero terms.
+    {
+        const M r = M::diagonalScaledSum({ &z, &z }, { s1.data(), s2.data() });
+        BOOST_CHECK_EQUAL(r.nonZeros(), 0);
+        BOOST_CHECK_EQUAL(r.rows(), 3);
+    }
+
+    // Identity and diagonal terms give a diagonal result.
+    {
+        const M r = M::diagonalScaledSum({ &i, &dm, &z }, { s1.data(), s2.data(), s1.data() });
+        BOOST_CHECK_EQUAL(r.nonZeros(), 3);
+        for (int row = 0; row < 3; ++row) {
+            BOOST_CHECK_CLOSE(r.coeff(row, row), s1[row] + s2[row]*d[row], 1e-12);
+        }
+    }
+
+    // Mixed terms give a sparse result with the union of the patterns.
+    {
+        const M r = M::diagonalScaledSum({ &sm, &dm, &sm }, { s1.data(), s2.data(), s2.data() });
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 3; ++col) {
+                const double expected = (s1[row] + s2[row])*s.coeff(row, col)
+                    + ((row == col) ? s2[row]*d[row] : 0.0);
+                BOOST_CHECK_CLOSE(r.coeff(row, col) + 1.0, expected + 1.0, 1e-12);
+            }
+        }
+        BOOST_CHECK_EQUAL(r.nonZeros(), 5);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ElementwiseOperators)
+{
+    const Setup s;
+    const ADB& a = s.vars[0];
+    const ADB& b = s.vars[1];
+    const ADB& x = s.vars[2];
+
+    checkClose(fusedEval(lazy(a) + b), a + b, 1e-14);
+    checkClose(fusedEval(lazy(a) - b), a - b, 1e-14);
+    checkClose(fusedEval(lazy(a) * b), a * b, 1e-14);
+    checkClose(fusedEval(lazy(a) / b), a / b, 1e-14);
+    checkClose(fusedEval(-lazy(a)), a * (-1.0), 1e-14);
+    checkClose(fusedEval(2.0 * lazy(a) / 4.0), a * 0.5, 1e-14);
+    checkClose(fusedEval(s.c * lazy(x)), s.c * x, 1e-14);
+    checkClose(fusedEval(lazy(x) / s.c), x / s.c, 1e-14);
+    checkClose(fusedEval(s.c - lazy(x)), s.c - x, 1e-14);
+
+    // Repeated leaves are merged.
+    checkClose(fusedEval(lazy(a) * a - a), a * a - a, 1e-14);
+    checkClose(fusedEval(lazy(a) - a), a - a, 1e-14);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(CompoundExpressions)
+{
+    const Setup s;
+    const ADB& a = s.vars[0];
+    const ADB& b = s.vars[1];
+    const ADB& x = s.vars[2];
+
+    // Mass-balance like expression, including a sparse leaf.
+    const ADB flux = s.div * s.dp;
+    const ADB eager = s.c * (a * b - x) + flux;
+    const ADB fused = fusedEval(s.c * (lazy(a) * b - x) + flux);
+    checkClose(fused, eager, 1e-13);
+
+    // Nested quotients and products of several leaves.
+    const ADB eager2 = (a * b) / (x + a) - b / a * x;
+    const ADB fused2 = fusedEval((lazy(a) * b) / (lazy(x) + a) - lazy(b) / a * x);
+    checkClose(fused2, eager2, 1e-13);
+
+    // A constant ADB (no jacobians) as leaf.
+    const ADB k = ADB::constant(s.c);
+    const ADB fused3 = fusedEval(lazy(k) * a + k);
+    checkClose(fused3, s.c * a + s.c, 1e-14);
+
+    // Constant expressions evaluate to constants.
+    const ADB fused4 = fusedEval(lazy(k) * s.c);
+    BOOST_CHECK_EQUAL(fused4.numBlocks(), 0);
+    BOOST_CHECK(fused4.value().isApprox(s.c * s.c));
+}
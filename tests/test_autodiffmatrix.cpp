@@ -425,3 +425,51 @@ BOOST_AUTO_TEST_CASE(nonZeros)
     BOOST_CHECK_EQUAL(s.nonZeros(), 4);
 }
 
+
+
+
+BOOST_AUTO_TEST_CASE(RowParallelKernels)
+{
+    // Large enough for the kernels to run in parallel, if OpenMP is
+    // available.
+    const int n = 4000;
+    std::vector<Eigen::Triplet<double>> triplets;
+    for (int col = 0; col < n; ++col) {
+        for (int k = 0; k < 8; ++k) {
+            const int row = (col * 7 + k * 509) % n;
+            triplets.emplace_back(row, col, 1.0 + 0.001 * (row + k) - 0.002 * col);
+        }
+    }
+    Sp a(n, n);
+    a.setFromTriplets(triplets.begin(), triplets.end());
+    const Sp b = Sp(a.transpose()) * 0.5;
+    std::vector<double> d(n);
+    for (int i = 0; i < n; ++i) {
+        d[i] = 1.0 + 0.25 * (i % 5);
+    }
+
+    SparseKernelParallelism::setRowParallel(false);
+    Sp prod_serial, dprod_serial, prodd_serial;
+    fastSparseProduct(a, b, prod_serial);
+    fastDiagSparseProduct(d, a, dprod_serial);
+    fastSparseDiagProduct(a, d, prodd_serial);
+    Sp sum_serial = a;
+    fastSparseAdd(sum_serial, a);
+
+    SparseKernelParallelism::setRowParallel(true);
+    Sp prod, dprod, prodd;
+    fastSparseProduct(a, b, prod);
+    fastDiagSparseProduct(d, a, dprod);
+    fastSparseDiagProduct(a, d, prodd);
+    Sp sum = a;
+    fastSparseAdd(sum, a);
+    SparseKernelParallelism::setRowParallel(false);
+
+    // Each column is computed in the same order, so the results are
+    // identical.
+    BOOST_CHECK(prod == prod_serial);
+    BOOST_CHECK(dprod == dprod_serial);
+    BOOST_CHECK(prodd == prodd_serial);
+    BOOST_CHECK(sum == sum_serial);
+    BOOST_CHECK(Eigen::MatrixXd(prod).isApprox(Eigen::MatrixXd(a * b)));
+}
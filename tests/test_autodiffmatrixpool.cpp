@@ -0,0 +1,197 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE AutoDiffMatrixPoolTest
+
+#include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/AutoDiffMatrixPool.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <Eigen/Eigen>
+#include <Eigen/Sparse>
+
+#include <future>
+#include <thread>
+
+using namespace Opm;
+
+namespace {
+    typedef AutoDiffBlock<double> ADB;
+
+    // Something like one Newton iteration: a handful of elementwise
+    // operations and a sparse operator applied to variables.
+    ADB iteration(const double shift)
+    {
+        std::vector<ADB::V> vals(2, ADB::V(4));
+        vals[0] << 1.0, 2.0, 3.0, 4.0;
+        vals[1] << 0.5, 0.25, 0.125, 0.0625;
+        vals[0] += shift;
+        const std::vector<ADB> vars = ADB::variables(vals);
+
+        Eigen::SparseMatrix<double> grad(3, 4);
+        grad.insert(0, 0) = -1.0;
+        grad.insert(0, 1) =  1.0;
+        grad.insert(1, 1) = -1.0;
+        grad.insert(1, 2) =  1.0;
+        grad.insert(2, 2) = -1.0;
+        grad.insert(2, 3) =  1.0;
+        grad.makeCompressed();
+        const Eigen::SparseMatrix<double> div = grad.transpose();
+
+        const ADB flux = grad * (vars[0] * vars[1]);
+        return vars[0] * vars[1] / vars[0] + div * flux * 2.0;
+    }
+
+    Eigen::MatrixXd dense(const ADB::M& m)
+    {
+        Eigen::SparseMatrix<double> s;
+        m.toSparse(s);
+        return Eigen::MatrixXd(s);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(RecycleStorage)
+{
+    AutoDiffMatrixPool::setEnabled(false);
+    const ADB reference = iteration(1.0);
+
+    AutoDiffMatrixPool::setEnabled(true);
+    AutoDiffMatrixPool* pool = AutoDiffMatrixPool::local();
+    BOOST_REQUIRE(pool != nullptr);
+
+    AutoDiffMatrixPool::newAssembly();
+    const ADB first = iteration(0.0);
+    const std::size_t hits_first = pool->hits();
+
+    AutoDiffMatrixPool::newAssembly();
+    const ADB second = iteration(1.0);
+    BOOST_CHECK(pool->hits() > hits_first);
+
+    // Results are not affected by the recycled storage.
+    BOOST_CHECK(second.value().isApprox(reference.value()));
+    BOOST_REQUIRE_EQUAL(second.numBlocks(), reference.numBlocks());
+    for (int block = 0; block < reference.numBlocks(); ++block) {
+        BOOST_CHECK(dense(second.derivative()[block]).isApprox(dense(reference.derivative()[block])));
+    }
+
+    AutoDiffMatrixPool::setEnabled(false);
+    pool->clear();
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ReleaseIdleStorage)
+{
+    AutoDiffMatrixPool::setEnabled(true);
+    AutoDiffMatrixPool* pool = AutoDiffMatrixPool::local();
+    pool->clear();
+
+    {
+        ADB::V d = ADB::V::Constant(7, 2.0);
+        ADB::M m(d.matrix().asDiagonal());
+        ADB::M copy = m;
+    }
+
+    // Storage recycled in the current assembly is available...
+    std::vector<double> storage;
+    const std::size_t hits = pool->hits();
+    pool->acquire(7, storage);
+    BOOST_CHECK_EQUAL(pool->hits(), hits + 1);
+    BOOST_CHECK(storage.capacity() >= 7);
+    pool->recycle(storage);
+
+    // ... but is released after an assembly in which it was not used.
+    AutoDiffMatrixPool::newAssembly();
+    AutoDiffMatrixPool::newAssembly();
+    std::vector<double> other;
+    pool->acquire(7, other);
+    BOOST_CHECK_EQUAL(other.capacity(), 0u);
+
+    AutoDiffMatrixPool::setEnabled(false);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ReleaseIdleStorageOfOtherThreads)
+{
+    AutoDiffMatrixPool::setEnabled(true);
+
+    // A thread that recycles some storage and then stays idle.
+    std::promise<AutoDiffMatrixPool*> filled;
+    std::promise<void> done;
+    std::thread worker([&filled, &done]() {
+        {
+            const ADB first = iteration(0.0);
+        }
+        AutoDiffMatrixPool* pool = AutoDiffMatrixPool::local();
+        filled.set_value(pool);
+        done.get_future().wait();
+    });
+    AutoDiffMatrixPool* worker_pool = filled.get_future().get();
+    BOOST_CHECK(worker_pool != AutoDiffMatrixPool::local());
+    BOOST_CHECK(worker_pool->size() > 0);
+
+    // Storage is kept until an assembly has passed without using it.
+    AutoDiffMatrixPool::newAssembly();
+    AutoDiffMatrixPool::releaseIdle();
+    BOOST_CHECK(worker_pool->size() > 0);
+    AutoDiffMatrixPool::newAssembly();
+    AutoDiffMatrixPool::releaseIdle();
+    BOOST_CHECK_EQUAL(worker_pool->size(), 0u);
+
+    done.set_value();
+    worker.join();
+    AutoDiffMatrixPool::setEnabled(false);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(PreferStorageThatFits)
+{
+    AutoDiffMatrixPool::setEnabled(true);
+    AutoDiffMatrixPool* pool = AutoDiffMatrixPool::local();
+    pool->clear();
+
+    const Eigen::MatrixXd ones = Eigen::MatrixXd::Ones(5, 5);
+    AutoDiffMatrixPool::SparseRep small = ones.sparseView();
+    small = Eigen::MatrixXd::Identity(5, 5).sparseView();
+    AutoDiffMatrixPool::SparseRep large = ones.sparseView();
+    const auto small_size = small.data().allocatedSize();
+    const auto large_size = large.data().allocatedSize();
+    BOOST_REQUIRE(small_size < 20 && large_size >= 20);
+    pool->recycle(large);
+    pool->recycle(small);
+    BOOST_CHECK_EQUAL(pool->size(), 2u);
+
+    // The most recently recycled storage is too small for 20 nonzeros.
+    AutoDiffMatrixPool::SparseRep s;
+    pool->acquire(5, 5, s, 20);
+    BOOST_CHECK_EQUAL(s.data().allocatedSize(), large_size);
+    AutoDiffMatrixPool::SparseRep t;
+    pool->acquire(5, 5, t);
+    BOOST_CHECK_EQUAL(t.data().allocatedSize(), small_size);
+    BOOST_CHECK_EQUAL(pool->size(), 0u);
+
+    AutoDiffMatrixPool::setEnabled(false);
+}
@@ -0,0 +1,139 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE CompressibleTpfaResidualTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/pressure/tpfa/cfs_tpfa_residual.h>
+#include <opm/core/pressure/tpfa/compr_quant_general.h>
+#include <opm/core/linalg/sparse_sys.h>
+#include <opm/grid/GridManager.hpp>
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif // HAVE_OPENMP
+
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Assembled system of a 60 x 40 grid (4900 faces, 2400 cells, above
+    // the limit for parallel assembly) with random fluid data.
+    struct AssembledSystem
+    {
+        std::vector<int> ia, ja;
+        std::vector<double> sa, F;
+        int is_incomp;
+    };
+
+    AssembledSystem assemble(const int num_threads)
+    {
+#if HAVE_OPENMP
+        const int old_num_threads = omp_get_max_threads();
+        omp_set_num_threads(num_threads);
+#else
+        static_cast<void>(num_threads);
+#endif // HAVE_OPENMP
+
+        Opm::GridManager gm(60, 40);
+        UnstructuredGrid* G = const_cast<UnstructuredGrid*>(gm.c_grid());
+        const int np = 3;
+        const int nc = G->number_of_cells;
+        const int nf = G->number_of_faces;
+
+        std::mt19937 gen(3);
+        std::uniform_real_distribution<double> u(0.1, 1.0);
+        std::vector<double> Ac(nc*np*np), dAc(nc*np*np), Af(nf*np*np);
+        std::vector<double> mob(nf*np), z(nc*np), trans(nf), gravcap(nf*np);
+        std::vector<double> p(nc), pv(nc);
+        for (int c = 0; c < nc; ++c) {
+            for (int k = 0; k < np*np; ++k) {
+                Ac[c*np*np + k] = (k % (np + 1) == 0) ? 2.0 + u(gen) : 0.1*u(gen);
+                dAc[c*np*np + k] = 0.01*u(gen);
+            }
+            p[c] = u(gen);
+            pv[c] = u(gen);
+        }
+        for (int f = 0; f < nf; ++f) {
+            for (int k = 0; k < np*np; ++k) {
+                Af[f*np*np + k] = (k % (np + 1) == 0) ? 2.0 + u(gen) : 0.1*u(gen);
+            }
+            trans[f] = u(gen);
+        }
+        for (double& m : mob) {
+            m = u(gen);
+        }
+        for (double& zi : z) {
+            zi = u(gen);
+        }
+        for (double& g : gravcap) {
+            g = 0.1*(u(gen) - 0.5);
+        }
+
+        compr_quantities_gen cq;
+        cq.nphases = np;
+        cq.Ac = Ac.data();
+        cq.dAc = dAc.data();
+        cq.Af = Af.data();
+        cq.phasemobf = mob.data();
+        cq.voldiscr = nullptr;
+
+        cfs_tpfa_res_data* h = cfs_tpfa_res_construct(G, nullptr, np);
+        BOOST_REQUIRE(h != nullptr);
+
+        AssembledSystem sys;
+        sys.is_incomp = cfs_tpfa_res_assemble(G, 0.5, nullptr, z.data(), &cq, trans.data(),
+                                              gravcap.data(), p.data(), nullptr, pv.data(), h);
+        const CSRMatrix& J = *h->J;
+        sys.ia.assign(J.ia, J.ia + J.m + 1);
+        sys.ja.assign(J.ja, J.ja + J.nnz);
+        sys.sa.assign(J.sa, J.sa + J.nnz);
+        sys.F.assign(h->F, h->F + nc);
+        cfs_tpfa_res_destroy(h);
+
+#if HAVE_OPENMP
+        omp_set_num_threads(old_num_threads);
+#endif // HAVE_OPENMP
+        return sys;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SameSystemForAnyNumberOfThreads)
+{
+    const AssembledSystem serial = assemble(1);
+    const AssembledSystem threaded = assemble(4);
+
+    BOOST_CHECK_EQUAL(serial.is_incomp, threaded.is_incomp);
+    BOOST_CHECK_EQUAL_COLLECTIONS(serial.ia.begin(), serial.ia.end(),
+                                  threaded.ia.begin(), threaded.ia.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(serial.ja.begin(), serial.ja.end(),
+                                  threaded.ja.begin(), threaded.ja.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(serial.sa.begin(), serial.sa.end(),
+                                  threaded.sa.begin(), threaded.sa.end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(serial.F.begin(), serial.F.end(),
+                                  threaded.F.begin(), threaded.F.end());
+}
@@ -0,0 +1,243 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE IncrementalReorderSequenceTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/transport/reorder/IncrementalReorderSequence.hpp>
+#include <opm/core/transport/reorder/reordersequence.h>
+#include <opm/grid/GridManager.hpp>
+#include <opm/grid/UnstructuredGrid.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace Opm;
+
+namespace {
+    // Check that every upwind edge goes from a component to itself or
+    // to a later one, and return the number of components.
+    int checkCausal(const UnstructuredGrid& grid, const double* flux,
+                    const std::vector<int>& sequence, const std::vector<int>& components)
+    {
+        const int nc = grid.number_of_cells;
+        BOOST_REQUIRE_EQUAL(sequence.size(), nc);
+        BOOST_REQUIRE_EQUAL(components.front(), 0);
+        BOOST_REQUIRE_EQUAL(components.back(), nc);
+        std::vector<int> comp(nc, -1);
+        for (std::size_t k = 0; k + 1 < components.size(); ++k) {
+            for (int p = components[k]; p < components[k + 1]; ++p) {
+                BOOST_REQUIRE_EQUAL(comp[sequence[p]], -1);
+                comp[sequence[p]] = k;
+            }
+        }
+        for (int f = 0; f < grid.number_of_faces; ++f) {
+            const int c0 = grid.face_cells[2*f];
+            const int c1 = grid.face_cells[2*f + 1];
+            if (c0 < 0 || c1 < 0) {
+                continue;
+            }
+            if (flux[f] > 0.0) {
+                BOOST_CHECK(comp[c0] <= comp[c1]);
+            } else if (flux[f] < 0.0) {
+                BOOST_CHECK(comp[c1] <= comp[c0]);
+            }
+        }
+        return components.size() - 1;
+    }
+
+    int numComponentsFromScratch(const UnstructuredGrid& grid, const double* flux)
+    {
+        const int nc = grid.number_of_cells;
+        std::vector<int> sequence(nc);
+        std::vector<int> components(nc + 1);
+        int ncomp = 0;
+        compute_sequence(&grid, flux, sequence.data(), components.data(), &ncomp);
+        return ncomp;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ReuseUnchangedOrder)
+{
+    const GridManager gm(4, 3);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    const std::vector<double> flux(grid.number_of_faces, 1.0);
+
+    IncrementalReorderSequence reorder;
+    reorder.compute(grid, flux.data());
+    BOOST_CHECK_EQUAL(reorder.numSortedCells(), grid.number_of_cells);
+    BOOST_CHECK_EQUAL(reorder.numComponents(), grid.number_of_cells);
+    const std::vector<int> first = reorder.sequence();
+
+    // Same directions, different magnitudes.
+    std::vector<double> flux2(flux);
+    flux2[3] = 5.0;
+    reorder.compute(grid, flux2.data());
+    BOOST_CHECK_EQUAL(reorder.numSortedCells(), 0);
+    BOOST_CHECK(reorder.sequence() == first);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(RepairMatchesFullSort)
+{
+    const GridManager gm(6, 5);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    const int nf = grid.number_of_faces;
+
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> face(0, nf - 1);
+    std::uniform_real_distribution<double> value(-1.0, 2.0);
+    std::vector<double> flux(nf);
+    for (double& q : flux) {
+        q = value(gen);
+    }
+
+    // Allow repairing the whole grid, so that no full sort is done.
+    IncrementalReorderSequence reorder(1.0);
+    reorder.compute(grid, flux.data());
+    bool repaired = false;
+    for (int step = 0; step < 50; ++step) {
+        for (int flip = 0; flip < 1 + step % 3; ++flip) {
+            const int f = face(gen);
+            flux[f] = (step % 7 == 0) ? 0.0 : -flux[f];
+        }
+        reorder.compute(grid, flux.data());
+        repaired = repaired || (reorder.numSortedCells() > 0 && reorder.numSortedCells() < grid.number_of_cells);
+        const int ncomp = checkCausal(grid, flux.data(), reorder.sequence(), reorder.components());
+        BOOST_CHECK_EQUAL(ncomp, reorder.numComponents());
+        BOOST_CHECK_EQUAL(ncomp, numComponentsFromScratch(grid, flux.data()));
+    }
+    BOOST_CHECK(repaired);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(FallBackToFullSort)
+{
+    const GridManager gm(4, 4);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    std::vector<double> flux(grid.number_of_faces, 1.0);
+
+    IncrementalReorderSequence reorder(0.1);
+    reorder.compute(grid, flux.data());
+
+    // Reversing all flux gives an edge against the order from the first
+    // to the last component.
+    std::transform(flux.begin(), flux.end(), flux.begin(), [](const double q) { return -q; });
+    reorder.compute(grid, flux.data());
+    BOOST_CHECK_EQUAL(reorder.numSortedCells(), grid.number_of_cells);
+    checkCausal(grid, flux.data(), reorder.sequence(), reorder.components());
+}
+
+
+
+BOOST_AUTO_TEST_CASE(GeneralConnectionGraph)
+{
+    // Four cells in a row, and a non-neighbouring connection between
+    // the first and last cell.
+    const std::vector<int> connection_cells = { 0, 1,  1, 2,  2, 3,  3, 0 };
+    const std::vector<int> cell_connection_pos = { 0, 2, 4, 6, 8 };
+    const std::vector<int> cell_connections = { 0, 3,  0, 1,  1, 2,  2, 3 };
+    std::vector<double> flux = { 1.0, 1.0, 1.0, -1.0 };
+
+    IncrementalReorderSequence reorder(1.0);
+    reorder.compute(4, 4, connection_cells.data(), cell_connection_pos.data(),
+                    cell_connections.data(), flux.data());
+    BOOST_CHECK_EQUAL(reorder.numComponents(), 4);
+    BOOST_CHECK_EQUAL(reorder.sequence().front(), 0);
+    BOOST_CHECK_EQUAL(reorder.sequence().back(), 3);
+
+    // Flow from the last to the first cell closes a loop.
+    flux[3] = 1.0;
+    reorder.compute(4, 4, connection_cells.data(), cell_connection_pos.data(),
+                    cell_connections.data(), flux.data());
+    BOOST_CHECK_EQUAL(reorder.numSortedCells(), 4);
+    BOOST_CHECK_EQUAL(reorder.numComponents(), 1);
+
+    // Breaking a connection of the loop splits it again.
+    flux[1] = 0.0;
+    reorder.compute(4, 4, connection_cells.data(), cell_connection_pos.data(),
+                    cell_connections.data(), flux.data());
+    BOOST_CHECK_EQUAL(reorder.numComponents(), 4);
+    const std::vector<int> expected = { 2, 3, 0, 1 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(reorder.sequence().begin(), reorder.sequence().end(),
+                                  expected.begin(), expected.end());
+}
+
+
+
+BOOST_AUTO_TEST_CASE(LevelDependencies)
+{
+    // Five cells in a row. Flow goes from cell 0 to 1, from 2 to 1 and
+    // from 3 to 4, with no flow between cells 2 and 3.
+    const std::vector<int> connection_cells = { 0, 1,  1, 2,  2, 3,  3, 4 };
+    const std::vector<int> cell_connection_pos = { 0, 1, 3, 5, 7, 8 };
+    const std::vector<int> cell_connections = { 0,  0, 1,  1, 2,  2, 3,  3 };
+    const std::vector<double> flux = { 1.0, -1.0, 0.0, 1.0 };
+
+    IncrementalReorderSequence reorder;
+    reorder.compute(5, 4, connection_cells.data(), cell_connection_pos.data(),
+                    cell_connections.data(), flux.data());
+    BOOST_REQUIRE_EQUAL(reorder.numComponents(), 5);
+    const std::vector<int>& seq = reorder.sequence();
+
+    for (const auto dependency : { IncrementalReorderSequence::UpwindNeighbours,
+                                   IncrementalReorderSequence::AllNeighbours }) {
+        std::vector<int> levels;
+        std::vector<int> level_comps;
+        reorder.computeLevels(dependency, levels, level_comps);
+        BOOST_REQUIRE_EQUAL(levels.front(), 0);
+        BOOST_REQUIRE_EQUAL(levels.back(), 5);
+        BOOST_REQUIRE_EQUAL(level_comps.size(), 5);
+        std::vector<int> level_of_cell(5, -1);
+        for (std::size_t l = 0; l + 1 < levels.size(); ++l) {
+            BOOST_CHECK_LT(levels[l], levels[l + 1]);
+            for (int i = levels[l]; i < levels[l + 1]; ++i) {
+                // Single cell components, so component k is cell seq[k].
+                const int cell = seq[level_comps[i]];
+                BOOST_REQUIRE_EQUAL(level_of_cell[cell], -1);
+                level_of_cell[cell] = l;
+            }
+            BOOST_CHECK(std::is_sorted(level_comps.begin() + levels[l],
+                                       level_comps.begin() + levels[l + 1]));
+        }
+        // Upwind neighbours are always in earlier levels.
+        BOOST_CHECK_LT(level_of_cell[0], level_of_cell[1]);
+        BOOST_CHECK_LT(level_of_cell[2], level_of_cell[1]);
+        BOOST_CHECK_LT(level_of_cell[3], level_of_cell[4]);
+        if (dependency == IncrementalReorderSequence::UpwindNeighbours) {
+            BOOST_CHECK_EQUAL(levels.size(), 3);
+        } else {
+            // No two neighbours share a level, also without flow
+            // between them.
+            for (int cell = 0; cell < 4; ++cell) {
+                BOOST_CHECK_NE(level_of_cell[cell], level_of_cell[cell + 1]);
+            }
+        }
+    }
+}
@@ -0,0 +1,344 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE NewtonIterationBlackoilInterleavedTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <Eigen/Dense>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/autodiff/NewtonIterationBlackoilInterleaved.hpp>
+#include <opm/autodiff/NewtonIterationUtilities.hpp>
+#include <opm/autodiff/LinearisedBlackoilResidual.hpp>
+#include <opm/common/utility/parameters/ParameterGroup.hpp>
+#include <opm/common/Exceptions.hpp>
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Opm;
+
+namespace {
+    typedef LinearisedBlackoilResidual::ADB ADB;
+    typedef ADB::V V;
+    typedef ADB::M M;
+    typedef Eigen::SparseMatrix<double> Sp;
+    typedef NewtonIterationBlackoilInterface::SolutionVector SolutionVector;
+
+    const int nc = 6;
+    const int np = 3;
+    const int nw = 1;
+
+    Sp sparse(const int rows, const int cols,
+              const std::vector< Eigen::Triplet<double> >& t)
+    {
+        Sp s(rows, cols);
+        s.setFromTriplets(t.begin(), t.end());
+        return s;
+    }
+
+    // A three-phase system on a row of cells with one well, perforated
+    // in cells 1 and 4. The well couples these cells, so the well
+    // elimination adds entries outside the cell jacobians. With
+    // extra_connection, cells 0 and nc - 1 are also connected, as by a
+    // non-neighbouring connection.
+    LinearisedBlackoilResidual makeResidual(const unsigned seed, const bool extra_connection)
+    {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> rand(-1.0, 1.0);
+        std::vector< std::pair<int, int> > connections;
+        for (int c = 0; c + 1 < nc; ++c) {
+            connections.emplace_back(c, c + 1);
+        }
+        if (extra_connection) {
+            connections.emplace_back(0, nc - 1);
+        }
+        const std::vector<int> perf_cells = { 1, 4 };
+
+        LinearisedBlackoilResidual residual;
+        for (int p1 = 0; p1 < np; ++p1) {
+            std::vector<M> jacs;
+            for (int p2 = 0; p2 < np; ++p2) {
+                std::vector< Eigen::Triplet<double> > t;
+                for (int c = 0; c < nc; ++c) {
+                    t.emplace_back(c, c, (p1 == p2 ? 10.0 : 0.0) + rand(gen));
+                }
+                for (const auto& conn : connections) {
+                    t.emplace_back(conn.first, conn.second, rand(gen));
+                    t.emplace_back(conn.second, conn.first, rand(gen));
+                }
+                jacs.emplace_back(sparse(nc, nc, t));
+            }
+            std::vector< Eigen::Triplet<double> > q;
+            for (const int c : perf_cells) {
+                q.emplace_back(c, p1, -0.5 + 0.1*rand(gen));
+            }
+            jacs.emplace_back(sparse(nc, np*nw, q));
+            jacs.emplace_back(nc, nw);
+            V val(nc);
+            for (int c = 0; c < nc; ++c) {
+                val[c] = rand(gen);
+            }
+            residual.material_balance_eq.push_back(ADB::function(std::move(val), std::move(jacs)));
+        }
+
+        // Well rates, depending on the pressure of the perforated cells
+        // and on the bottom hole pressure.
+        {
+            std::vector<M> jacs;
+            std::vector< Eigen::Triplet<double> > dp;
+            for (int p = 0; p < np; ++p) {
+                for (const int c : perf_cells) {
+                    dp.emplace_back(p, c, rand(gen));
+                }
+            }
+            jacs.emplace_back(sparse(np*nw, nc, dp));
+            jacs.emplace_back(np*nw, nc);
+            jacs.emplace_back(np*nw, nc);
+            jacs.push_back(M::createIdentity(np*nw));
+            std::vector< Eigen::Triplet<double> > dbhp;
+            for (int p = 0; p < np; ++p) {
+                dbhp.emplace_back(p, 0, 0.2*rand(gen));
+            }
+            jacs.emplace_back(sparse(np*nw, nw, dbhp));
+            V val(np*nw);
+            for (int p = 0; p < np; ++p) {
+                val[p] = rand(gen);
+            }
+            residual.well_flux_eq = ADB::function(std::move(val), std::move(jacs));
+        }
+
+        // Well control.
+        {
+            std::vector<M> jacs;
+            for (int p = 0; p < np; ++p) {
+                jacs.emplace_back(nw, nc);
+            }
+            std::vector< Eigen::Triplet<double> > dq;
+            for (int p = 0; p < np; ++p) {
+                dq.emplace_back(0, p, 0.1);
+            }
+            jacs.emplace_back(sparse(nw, np*nw, dq));
+            jacs.push_back(M::createIdentity(nw));
+            V val(nw);
+            val[0] = rand(gen);
+            residual.well_eq = ADB::function(std::move(val), std::move(jacs));
+        }
+
+        residual.matbalscale = { 1.0, 2.0, 0.5 };
+        residual.singlePrecision = false;
+        return residual;
+    }
+
+    // The interleaved matrix and right hand side of the scaled,
+    // well-eliminated system, with entry (np*i + p1, np*j + p2) from
+    // the derivative of equation p1 in cell i with respect to variable
+    // p2 in cell j, as formed by formInterleavedSystem() before the
+    // in-place assembly.
+    void formInterleavedSystem(const std::vector<ADB>& eqs,
+                               Eigen::MatrixXd& A, Eigen::VectorXd& b)
+    {
+        A = Eigen::MatrixXd::Zero(np*nc, np*nc);
+        b.resize(np*nc);
+        for (int p1 = 0; p1 < np; ++p1) {
+            for (int i = 0; i < nc; ++i) {
+                b[np*i + p1] = eqs[p1].value()[i];
+            }
+            for (int p2 = 0; p2 < np; ++p2) {
+                const Sp s = eqs[p1].derivative()[p2].getSparse();
+                for (int col = 0; col < s.outerSize(); ++col) {
+                    for (Sp::InnerIterator it(s, col); it; ++it) {
+                        A(np*it.row() + p1, np*col + p2) = it.value();
+                    }
+                }
+            }
+        }
+    }
+
+    // The well-eliminated, scaled and interleaved system, and the
+    // eliminated equations needed to recover the well unknowns.
+    void reducedSystem(const LinearisedBlackoilResidual& residual,
+                       Eigen::MatrixXd& A, Eigen::VectorXd& b,
+                       std::vector<ADB>& elim_eqs)
+    {
+        std::vector<ADB> eqs = residual.material_balance_eq;
+        eqs.push_back(residual.well_flux_eq);
+        eqs.push_back(residual.well_eq);
+        elim_eqs.clear();
+        elim_eqs.push_back(eqs[np]);
+        eqs = eliminateVariable(eqs, np);
+        elim_eqs.push_back(eqs[np]);
+        eqs = eliminateVariable(eqs, np);
+        BOOST_REQUIRE_EQUAL(eqs.size(), np);
+        for (int p = 0; p < np; ++p) {
+            eqs[p] = eqs[p] * residual.matbalscale[p];
+        }
+        formInterleavedSystem(eqs, A, b);
+    }
+
+    // The increment from eliminateVariable(), the interleaved system
+    // and recoverVariable(), with a direct solve of the interleaved
+    // system.
+    SolutionVector referenceIncrement(const LinearisedBlackoilResidual& residual)
+    {
+        Eigen::MatrixXd A;
+        Eigen::VectorXd b;
+        std::vector<ADB> elim_eqs;
+        reducedSystem(residual, A, b, elim_eqs);
+        const Eigen::VectorXd x = A.partialPivLu().solve(b);
+        V dx(np*nc);
+        for (int i = 0; i < nc; ++i) {
+            for (int p = 0; p < np; ++p) {
+                dx[p*nc + i] = x[np*i + p];
+            }
+        }
+        dx = recoverVariable(elim_eqs[1], dx, np);
+        dx = recoverVariable(elim_eqs[0], dx, np);
+        return dx;
+    }
+
+    // Norm of the residual of the reduced system for the cell part of
+    // dx, relative to the norm of its right hand side.
+    double relativeResidual(const LinearisedBlackoilResidual& residual, const SolutionVector& dx)
+    {
+        Eigen::MatrixXd A;
+        Eigen::VectorXd b;
+        std::vector<ADB> elim_eqs;
+        reducedSystem(residual, A, b, elim_eqs);
+        Eigen::VectorXd x(np*nc);
+        for (int i = 0; i < nc; ++i) {
+            for (int p = 0; p < np; ++p) {
+                x[np*i + p] = dx[p*nc + i];
+            }
+        }
+        return (b - A*x).norm() / b.norm();
+    }
+
+    // Maximum difference of the increments, relative to the largest
+    // value of the reference.
+    double relativeDifference(const SolutionVector& dx, const SolutionVector& ref)
+    {
+        BOOST_REQUIRE_EQUAL(dx.size(), ref.size());
+        return (dx - ref).abs().maxCoeff() / ref.abs().maxCoeff();
+    }
+
+    ParameterGroup solverParameters(const std::string& reduction = "1e-12")
+    {
+        ParameterGroup param;
+        param.insertParameter(std::string("use_cpr"), std::string("false"));
+        param.insertParameter(std::string("linear_solver_reduction"), reduction);
+        param.insertParameter(std::string("linear_solver_maxiter"), std::string("200"));
+        return param;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(InPlaceAssemblyMatchesElimination)
+{
+    const NewtonIterationBlackoilInterleaved solver(solverParameters());
+
+    const LinearisedBlackoilResidual first = makeResidual(1, false);
+    const SolutionVector dx1 = solver.computeNewtonIncrement(first);
+    BOOST_CHECK_EQUAL(dx1.size(), np*nc + np*nw + nw);
+    BOOST_CHECK_SMALL(relativeDifference(dx1, referenceIncrement(first)), 1e-8);
+
+    // Same structure, new values: written into the kept structure.
+    const LinearisedBlackoilResidual second = makeResidual(2, false);
+    const SolutionVector dx2 = solver.computeNewtonIncrement(second);
+    BOOST_CHECK_SMALL(relativeDifference(dx2, referenceIncrement(second)), 1e-8);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(NewEntryRebuildsStructure)
+{
+    const NewtonIterationBlackoilInterleaved solver(solverParameters());
+
+    const LinearisedBlackoilResidual first = makeResidual(3, false);
+    const SolutionVector dx1 = solver.computeNewtonIncrement(first);
+    BOOST_CHECK_SMALL(relativeDifference(dx1, referenceIncrement(first)), 1e-8);
+
+    // The connection between the first and last cell is not in the
+    // structure of the first system, which must be rebuilt.
+    const LinearisedBlackoilResidual second = makeResidual(4, true);
+    const SolutionVector dx2 = solver.computeNewtonIncrement(second);
+    BOOST_CHECK_SMALL(relativeDifference(dx2, referenceIncrement(second)), 1e-8);
+
+    // Going back to the smaller structure keeps the larger one, with
+    // zeros for the entries that are no longer there.
+    const LinearisedBlackoilResidual third = makeResidual(5, false);
+    const SolutionVector dx3 = solver.computeNewtonIncrement(third);
+    BOOST_CHECK_SMALL(relativeDifference(dx3, referenceIncrement(third)), 1e-8);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(MixedPrecisionRefinementMatchesDouble)
+{
+    const NewtonIterationBlackoilInterleaved double_solver(solverParameters("1e-10"));
+    ParameterGroup param = solverParameters("1e-10");
+    param.insertParameter(std::string("linear_solver_mixed_precision"), std::string("true"));
+    const NewtonIterationBlackoilInterleaved mixed_solver(param);
+
+    const LinearisedBlackoilResidual residual = makeResidual(6, false);
+    const SolutionVector dx_double = double_solver.computeNewtonIncrement(residual);
+    const SolutionVector dx_mixed = mixed_solver.computeNewtonIncrement(residual);
+
+    // A single precision solve cannot reduce the residual by 1e-10,
+    // refinement is needed to get there.
+    BOOST_CHECK_LE(relativeResidual(residual, dx_mixed), 1e-10);
+    BOOST_CHECK_SMALL(relativeDifference(dx_mixed, dx_double), 1e-7);
+    BOOST_CHECK_SMALL(relativeDifference(dx_mixed, referenceIncrement(residual)), 1e-7);
+
+    // Systems marked as single precision take the same path.
+    LinearisedBlackoilResidual single = residual;
+    single.singlePrecision = true;
+    const SolutionVector dx_single = double_solver.computeNewtonIncrement(single);
+    BOOST_CHECK_LE(relativeResidual(single, dx_single), 1e-10);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(MixedPrecisionRefinementFailure)
+{
+    // One single precision solve cannot reach a reduction of 1e-12.
+    ParameterGroup param = solverParameters("1e-12");
+    param.insertParameter(std::string("linear_solver_mixed_precision"), std::string("true"));
+    param.insertParameter(std::string("linear_solver_max_refinement_steps"), std::string("1"));
+    const LinearisedBlackoilResidual residual = makeResidual(7, false);
+    {
+        const NewtonIterationBlackoilInterleaved solver(param);
+        BOOST_CHECK_THROW(solver.computeNewtonIncrement(residual), LinearSolverProblem);
+    }
+
+    // Unless convergence failures are ignored, in which case the
+    // unrefined solution is returned.
+    param.insertParameter(std::string("linear_solver_ignoreconvergencefailure"), std::string("true"));
+    const NewtonIterationBlackoilInterleaved solver(param);
+    SolutionVector dx;
+    BOOST_CHECK_NO_THROW(dx = solver.computeNewtonIncrement(residual));
+    BOOST_CHECK_GT(relativeResidual(residual, dx), 1e-12);
+    BOOST_CHECK_SMALL(relativeDifference(dx, referenceIncrement(residual)), 1e-3);
+}
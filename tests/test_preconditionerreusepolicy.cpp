@@ -0,0 +1,102 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE PreconditionerReusePolicyTest
+
+#include <opm/autodiff/PreconditionerReusePolicy.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace Opm;
+
+BOOST_AUTO_TEST_CASE(DisabledByDefault)
+{
+    PreconditionerReusePolicy policy;
+    const int a = 0;
+    policy.rebuilt(&a, 17);
+    policy.solved(10);
+    BOOST_CHECK(!policy.reuse(&a, 17));
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ReuseForSameMatrix)
+{
+    PreconditionerReuseParameters param;
+    param.reuse_preconditioner_ = true;
+    param.max_preconditioner_age_ = 3;
+    PreconditionerReusePolicy policy(param);
+    const int a = 0, b = 0;
+
+    // Nothing to reuse before the first preconditioner is built.
+    BOOST_CHECK(!policy.reuse(&a, 17));
+
+    policy.rebuilt(&a, 17);
+    policy.solved(10);
+    BOOST_CHECK(policy.reuse(&a, 17));
+
+    // Not for another matrix, or another sparsity pattern.
+    BOOST_CHECK(!policy.reuse(&b, 17));
+    BOOST_CHECK(!policy.reuse(&a, 18));
+
+    // Not after the maximum number of solves.
+    policy.solved(10);
+    BOOST_CHECK(policy.reuse(&a, 17));
+    policy.solved(10);
+    BOOST_CHECK(!policy.reuse(&a, 17));
+
+    policy.rebuilt(&a, 17);
+    policy.solved(10);
+    BOOST_CHECK(policy.reuse(&a, 17));
+    policy.invalidate();
+    BOOST_CHECK(!policy.reuse(&a, 17));
+
+    param.reuse_preconditioner_ = false;
+    PreconditionerReusePolicy disabled(param);
+    disabled.rebuilt(&a, 17);
+    disabled.solved(10);
+    BOOST_CHECK(!disabled.reuse(&a, 17));
+}
+
+
+
+BOOST_AUTO_TEST_CASE(RebuildOnIterationGrowth)
+{
+    PreconditionerReuseParameters param;
+    param.reuse_preconditioner_ = true;
+    param.max_preconditioner_age_ = 100;
+    param.max_iteration_growth_ = 1.5;
+    PreconditionerReusePolicy policy(param);
+    const int a = 0;
+
+    policy.rebuilt(&a, 1);
+    policy.solved(10);
+    policy.solved(15);
+    BOOST_CHECK(policy.reuse(&a, 1));
+    policy.solved(16);
+    BOOST_CHECK(!policy.reuse(&a, 1));
+
+    // The reference is the first solve after a rebuild.
+    policy.rebuilt(&a, 1);
+    policy.solved(20);
+    BOOST_CHECK(policy.reuse(&a, 1));
+    BOOST_CHECK_EQUAL(policy.age(), 1);
+}
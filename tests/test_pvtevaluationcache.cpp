@@ -0,0 +1,127 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE PvtEvaluationCacheTest
+
+#include <opm/autodiff/PvtEvaluationCache.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+using namespace Opm;
+
+namespace {
+    // Two quantities, b = p + r and mu = p * T, unless saturated.
+    struct Evaluate
+    {
+        const std::vector<double>& p;
+        const std::vector<double>& T;
+        const std::vector<double>& r;
+        const std::vector<char>& saturated;
+        int& calls;
+
+        void operator()(PvtEvaluationCache::Result& result) const
+        {
+            ++calls;
+            for (int i = 0; i < result.size(); ++i) {
+                const double rr = saturated[i] ? 0.0 : r[i];
+                result.value(0)[i] = p[i] + rr;
+                result.dp(0)[i] = 1.0;
+                result.dr(0)[i] = saturated[i] ? 0.0 : 1.0;
+                result.value(1)[i] = p[i] * T[i];
+                result.dp(1)[i] = T[i];
+            }
+        }
+    };
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ReuseIdenticalInputs)
+{
+    const std::vector<int> cells = { 0, 1, 2 };
+    std::vector<double> p = { 1.0, 2.0, 3.0 };
+    std::vector<double> T = { 10.0, 10.0, 20.0 };
+    std::vector<double> r = { 0.5, 0.5, 0.5 };
+    std::vector<char> saturated = { 0, 1, 0 };
+    int calls = 0;
+    const Evaluate evaluate{ p, T, r, saturated, calls };
+
+    PvtEvaluationCache cache(2);
+    const PvtEvaluationCache::Result& first
+        = cache.evaluate(cells, p.data(), T.data(), r.data(), saturated, evaluate);
+    BOOST_CHECK_EQUAL(first.size(), 3);
+    BOOST_CHECK_EQUAL(first.value(0)[1], 2.0);
+    BOOST_CHECK_EQUAL(first.value(1)[2], 60.0);
+
+    const PvtEvaluationCache::Result& second
+        = cache.evaluate(cells, p.data(), T.data(), r.data(), saturated, evaluate);
+    BOOST_CHECK_EQUAL(&first, &second);
+    BOOST_CHECK_EQUAL(calls, 1);
+    BOOST_CHECK_EQUAL(cache.hits(), 1u);
+    BOOST_CHECK_EQUAL(cache.misses(), 1u);
+
+    // Any change of the inputs gives a new evaluation.
+    p[0] = 1.5;
+    BOOST_CHECK_EQUAL(cache.evaluate(cells, p.data(), T.data(), r.data(), saturated, evaluate).value(0)[0], 2.0);
+    saturated[0] = 1;
+    BOOST_CHECK_EQUAL(cache.evaluate(cells, p.data(), T.data(), r.data(), saturated, evaluate).value(0)[0], 1.5);
+    T[2] = 30.0;
+    BOOST_CHECK_EQUAL(cache.evaluate(cells, p.data(), T.data(), r.data(), saturated, evaluate).value(1)[2], 90.0);
+    BOOST_CHECK_EQUAL(calls, 4);
+    cache.evaluate(cells, p.data(), T.data(), nullptr, saturated, evaluate);
+    BOOST_CHECK_EQUAL(calls, 5);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(KeepSeveralEvaluations)
+{
+    const std::vector<int> all_cells = { 0, 1, 2, 3 };
+    const std::vector<int> well_cells = { 3 };
+    const std::vector<int> other_cells = { 1 };
+    const std::vector<double> p = { 1.0, 2.0, 3.0, 4.0 };
+    const std::vector<double> T = { 1.0, 1.0, 1.0, 1.0 };
+    const std::vector<double> r = { 0.0, 0.0, 0.0, 0.0 };
+    const std::vector<char> saturated = { 0, 0, 0, 0 };
+    int calls = 0;
+    const Evaluate evaluate{ p, T, r, saturated, calls };
+    const std::vector<char> none;
+
+    PvtEvaluationCache cache(2);
+    cache.evaluate(all_cells, p.data(), T.data(), nullptr, none, evaluate);
+    cache.evaluate(well_cells, p.data(), T.data(), nullptr, none, evaluate);
+    cache.evaluate(all_cells, p.data(), T.data(), nullptr, none, evaluate);
+    cache.evaluate(well_cells, p.data(), T.data(), nullptr, none, evaluate);
+    BOOST_CHECK_EQUAL(calls, 2);
+
+    // The least recently used evaluation is replaced.
+    cache.evaluate(other_cells, p.data(), T.data(), nullptr, none, evaluate);
+    cache.evaluate(well_cells, p.data(), T.data(), nullptr, none, evaluate);
+    BOOST_CHECK_EQUAL(calls, 3);
+    cache.evaluate(all_cells, p.data(), T.data(), nullptr, none, evaluate);
+    BOOST_CHECK_EQUAL(calls, 4);
+
+    cache.clear();
+    cache.evaluate(well_cells, p.data(), T.data(), nullptr, none, evaluate);
+    BOOST_CHECK_EQUAL(calls, 5);
+}
@@ -0,0 +1,414 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE ReorderingTransportModelTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/autodiff/BlackoilReorderingTransportModel.hpp>
+#include <opm/autodiff/BlackoilPropsAdFromDeck.hpp>
+#include <opm/autodiff/GeoProps.hpp>
+#include <opm/autodiff/NewtonIterationBlackoilSimple.hpp>
+#include <opm/autodiff/StandardWells.hpp>
+#include <opm/autodiff/WellStateFullyImplicitBlackoil.hpp>
+#include <opm/core/simulator/BlackoilState.hpp>
+#include <opm/core/utility/initHydroCarbonState.hpp>
+#include <opm/common/utility/parameters/ParameterGroup.hpp>
+#include <opm/grid/GridManager.hpp>
+#include <opm/grid/UnstructuredGrid.h>
+#include <opm/simulators/timestepping/SimulatorTimer.hpp>
+
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/Parser/ErrorGuard.hpp>
+#include <opm/parser/eclipse/Parser/ParseContext.hpp>
+#include <opm/parser/eclipse/Parser/Parser.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+#include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
+#include <opm/parser/eclipse/EclipseState/SummaryConfig/SummaryConfig.hpp>
+#include <opm/parser/eclipse/Units/Units.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if HAVE_OPENMP
+#include <omp.h>
+#endif // HAVE_OPENMP
+
+using namespace Opm;
+
+namespace {
+    const int nx = 40;
+    const int ny = 40;
+
+    // Live oil on a single layer of 40 x 40 cells, without wells.
+    const std::string deckString =
+        "RUNSPEC\n"
+        "TABDIMS\n"
+        "/\n"
+        "OIL\n"
+        "GAS\n"
+        "WATER\n"
+        "DISGAS\n"
+        "METRIC\n"
+        "START\n"
+        "1 'JAN' 2000 /\n"
+        "DIMENS\n"
+        "40 40 1 /\n"
+        "GRID\n"
+        "DX\n"
+        "1600*10.0 /\n"
+        "DY\n"
+        "1600*10.0 /\n"
+        "DZ\n"
+        "1600*1.0 /\n"
+        "TOPS\n"
+        "1600*1000.0 /\n"
+        "PORO\n"
+        "1600*0.3 /\n"
+        "PERMX\n"
+        "1600*100 /\n"
+        "PERMY\n"
+        "1600*100 /\n"
+        "PERMZ\n"
+        "1600*10 /\n"
+        "PROPS\n"
+        "DENSITY\n"
+        "800 1000 1 /\n"
+        "PVTW\n"
+        "100 1.0 4e-5 0.5 0 /\n"
+        "PVDG\n"
+        "50 0.02 0.015\n"
+        "200 0.005 0.02 /\n"
+        "PVTO\n"
+        "20 50 1.1 1.0\n"
+        "   150 1.08 1.1 /\n"
+        "40 100 1.2 0.9\n"
+        "   200 1.18 1.0 /\n"
+        "/\n"
+        "SWOF\n"
+        "0.1 0.0 1.0 0.0\n"
+        "0.5 0.2 0.3 0.0\n"
+        "1.0 1.0 0.0 0.0 /\n"
+        "SGOF\n"
+        "0.0 0.0 1.0 0.0\n"
+        "0.5 0.3 0.2 0.0\n"
+        "0.9 1.0 0.0 0.0 /\n"
+        "SCHEDULE\n"
+        "TSTEP\n"
+        "1.0 /\n";
+
+    typedef BlackoilReorderingTransportModel<UnstructuredGrid, StandardWells> Model;
+
+    // Runs the transport sweeps of a nonlinear iteration, without the
+    // assembly by the fully implicit transport model that follows them.
+    class ReorderingProbe : public Model
+    {
+    public:
+        using Model::Model;
+
+        BlackoilState sweep(const SimulatorTimerInterface& timer,
+                            const BlackoilState& reservoir_state,
+                            const WellStateFullyImplicitBlackoil& well_state)
+        {
+            prepareStep(timer, reservoir_state, well_state);
+            extractFluxes(reservoir_state, well_state);
+            extractState(reservoir_state, well_state);
+            computeOrdering();
+            for (int ii = 0; ii < 5; ++ii) {
+                solveComponents();
+            }
+            return state_.reservoir_state;
+        }
+
+        // Solve each component once, in sequence order. The multi-cell
+        // components are solved either by the coupled Newton method, or
+        // by Gauss-Seidel sweeps until every cell of the component has
+        // converged.
+        BlackoilState solveInOrder(const SimulatorTimerInterface& timer,
+                                   const BlackoilState& reservoir_state,
+                                   const WellStateFullyImplicitBlackoil& well_state,
+                                   const bool coupled)
+        {
+            prepareStep(timer, reservoir_state, well_state);
+            extractFluxes(reservoir_state, well_state);
+            extractState(reservoir_state, well_state);
+            computeOrdering();
+            MaxChange change;
+            const int num_components = components_.size() - 1;
+            for (int comp = 0; comp < num_components; ++comp) {
+                const int comp_size = components_[comp + 1] - components_[comp];
+                const int* cells = &sequence_[components_[comp]];
+                if (comp_size == 1) {
+                    solveSingleCell(cells[0], change);
+                } else if (coupled) {
+                    BOOST_REQUIRE(solveCoupled(comp_size, cells, change));
+                } else {
+                    BOOST_REQUIRE(gaussSeidel(comp_size, cells, change));
+                }
+            }
+            return state_.reservoir_state;
+        }
+
+        int largestWavefront() const
+        {
+            int largest = 0;
+            for (std::size_t w = 0; w + 1 < wavefronts_.size(); ++w) {
+                largest = std::max(largest, wavefronts_[w + 1] - wavefronts_[w]);
+            }
+            return largest;
+        }
+
+        int largestComponent() const
+        {
+            int largest = 0;
+            for (std::size_t comp = 0; comp + 1 < components_.size(); ++comp) {
+                largest = std::max(largest, components_[comp + 1] - components_[comp]);
+            }
+            return largest;
+        }
+
+        // The cells of the multi-cell components.
+        std::vector<int> multiCellComponentCells() const
+        {
+            std::vector<int> cells;
+            for (std::size_t comp = 0; comp + 1 < components_.size(); ++comp) {
+                if (components_[comp + 1] - components_[comp] > 1) {
+                    cells.insert(cells.end(),
+                                 sequence_.begin() + components_[comp],
+                                 sequence_.begin() + components_[comp + 1]);
+                }
+            }
+            return cells;
+        }
+
+    private:
+        bool gaussSeidel(const int comp_size, const int* cells, MaxChange& change)
+        {
+            const int max_sweeps = 1000;
+            for (int sweep = 0; sweep < max_sweeps; ++sweep) {
+                for (int ii = 0; ii < comp_size; ++ii) {
+                    solveSingleCell(cells[ii], change);
+                }
+                bool converged = true;
+                for (int ii = 0; ii < comp_size; ++ii) {
+                    Vec2 res;
+                    Mat22 jac;
+                    assembleSingleCell(cells[ii], res, jac);
+                    converged = converged && getConvergence(cells[ii], res);
+                }
+                if (converged) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    // Add the flux v from cell a to its neighbour b.
+    void addFlux(const UnstructuredGrid& grid, const HelperOps& ops,
+                 const int a, const int b, const double v, std::vector<double>& flux)
+    {
+        for (int ii = 0; ii < ops.internal_faces.size(); ++ii) {
+            const int f = ops.internal_faces[ii];
+            const int c0 = grid.face_cells[2*f];
+            const int c1 = grid.face_cells[2*f + 1];
+            if (c0 == a && c1 == b) {
+                flux[ii] += v;
+            } else if (c0 == b && c1 == a) {
+                flux[ii] -= v;
+            }
+        }
+    }
+
+    const double gravity[] = { 0.0, 0.0, 9.80665 };
+
+    // The model on the grid of deckString, and a state with gas in the
+    // left half of the grid and undersaturated oil in the right half.
+    // The flow is diagonal through the grid, moving about a fifth of a
+    // pore volume per day, so that the anti-diagonals are the
+    // wavefronts. Recirculation in some 2 x 2 blocks near the last row
+    // gives multi-cell components, and only shifts the last few cells
+    // of the anti-diagonals they are on. One of the blocks straddles
+    // the gas-oil boundary.
+    struct ModelFixture
+    {
+        ModelFixture()
+            : deck(parser.parseString(deckString, parse_context, errors)),
+              ecl_state(std::make_shared<EclipseState>(deck, parse_context, errors)),
+              schedule(std::make_shared<Schedule>(deck,
+                                                  ecl_state->getInputGrid(),
+                                                  ecl_state->get3DProperties(),
+                                                  ecl_state->runspec(),
+                                                  parse_context,
+                                                  errors)),
+              summary_config(std::make_shared<SummaryConfig>(deck,
+                                                             *schedule,
+                                                             ecl_state->getTableManager(),
+                                                             parse_context,
+                                                             errors)),
+              gm(ecl_state->getInputGrid()),
+              grid(*gm.c_grid()),
+              props(deck, *ecl_state, grid),
+              geo(grid, props, *ecl_state, false, gravity),
+              linsolver(param),
+              std_wells(nullptr, nullptr, 0),
+              model(model_param, grid, props, geo, nullptr, std_wells, linsolver,
+                    ecl_state, schedule, summary_config,
+                    /* has_disgas */ true, /* has_vapoil */ false,
+                    /* terminal_output */ false),
+              state(grid.number_of_cells, grid.number_of_faces, 3)
+        {
+            BOOST_REQUIRE_EQUAL(grid.number_of_cells, nx*ny);
+            timer.init(schedule->getTimeMap(), 0);
+
+            const int nc = grid.number_of_cells;
+            const PhaseUsage pu = props.phaseUsage();
+            for (int cell = 0; cell < nc; ++cell) {
+                const bool left = (cell % nx) < nx/2;
+                state.pressure()[cell] = 100.0*unit::barsa;
+                state.saturation()[3*cell + pu.phase_pos[BlackoilPhases::Aqua]] = 0.2;
+                state.saturation()[3*cell + pu.phase_pos[BlackoilPhases::Liquid]] = left ? 0.5 : 0.8;
+                state.saturation()[3*cell + pu.phase_pos[BlackoilPhases::Vapour]] = left ? 0.3 : 0.0;
+                state.gasoilratio()[cell] = left ? 40.0 : 30.0;
+                state.rv()[cell] = 0.0;
+            }
+            initHydroCarbonState(state, pu, nc, true, false);
+
+            const HelperOps ops(grid);
+            const double q = 0.2 * 30.0 / unit::day;
+            std::vector<double> flux(ops.internal_faces.size(), q);
+            const int j = ny - 3;
+            for (int i = 1; i < nx - 2; i += 6) {
+                const int c = i + nx*j;
+                addFlux(grid, ops, c, c + 1, 3.0*q, flux);
+                addFlux(grid, ops, c + 1, c + 1 + nx, 3.0*q, flux);
+                addFlux(grid, ops, c + 1 + nx, c + nx, 3.0*q, flux);
+                addFlux(grid, ops, c + nx, c, 3.0*q, flux);
+            }
+            state.faceflux() = flux;
+
+            WellStateFullyImplicitBlackoil prev_well_state;
+            well_state.initLegacy(nullptr, state, prev_well_state, pu);
+        }
+
+        ParameterGroup param;
+        Parser parser;
+        ParseContext parse_context;
+        ErrorGuard errors;
+        Deck deck;
+        std::shared_ptr<EclipseState> ecl_state;
+        std::shared_ptr<Schedule> schedule;
+        std::shared_ptr<SummaryConfig> summary_config;
+        GridManager gm;
+        const UnstructuredGrid& grid;
+        BlackoilPropsAdFromDeck props;
+        DerivedGeology geo;
+        NewtonIterationBlackoilSimple linsolver;
+        StandardWells std_wells;
+        BlackoilModelParameters model_param;
+        ReorderingProbe model;
+        SimulatorTimer timer;
+        BlackoilState state;
+        WellStateFullyImplicitBlackoil well_state;
+    };
+}
+
+
+
+BOOST_FIXTURE_TEST_CASE(WavefrontsMatchSerialSolve, ModelFixture)
+{
+#if HAVE_OPENMP
+    const int max_threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+#endif // HAVE_OPENMP
+    const BlackoilState serial = model.sweep(timer, state, well_state);
+#if HAVE_OPENMP
+    omp_set_num_threads(std::max(max_threads, 4));
+#endif // HAVE_OPENMP
+    const BlackoilState parallel = model.sweep(timer, state, well_state);
+#if HAVE_OPENMP
+    omp_set_num_threads(max_threads);
+#endif // HAVE_OPENMP
+
+    // Some wavefronts are large enough to be solved in parallel, and
+    // the recirculation gives multi-cell components.
+    BOOST_CHECK_GE(model.largestWavefront(), detail::minimumParallelComponents);
+    BOOST_CHECK_EQUAL(model.largestComponent(), 4);
+
+    // The transport changed the state, in both halves of the grid.
+    const int nc = grid.number_of_cells;
+    bool changed_sat = false;
+    bool changed_rs = false;
+    for (int cell = 0; cell < nc; ++cell) {
+        changed_sat = changed_sat || serial.saturation()[3*cell] != state.saturation()[3*cell];
+        changed_rs = changed_rs || serial.gasoilratio()[cell] != state.gasoilratio()[cell];
+    }
+    BOOST_CHECK(changed_sat);
+    BOOST_CHECK(changed_rs);
+
+    // Every component sees the same neighbour values as in the serial
+    // solve, so the results are identical.
+    for (int ii = 0; ii < 3*nc; ++ii) {
+        BOOST_CHECK_EQUAL(serial.saturation()[ii], parallel.saturation()[ii]);
+    }
+    for (int cell = 0; cell < nc; ++cell) {
+        BOOST_CHECK_EQUAL(serial.gasoilratio()[cell], parallel.gasoilratio()[cell]);
+        BOOST_CHECK_EQUAL(serial.rv()[cell], parallel.rv()[cell]);
+        BOOST_CHECK(serial.hydroCarbonState()[cell] == parallel.hydroCarbonState()[cell]);
+    }
+}
+
+
+
+BOOST_FIXTURE_TEST_CASE(CoupledSolveMatchesGaussSeidel, ModelFixture)
+{
+    const BlackoilState coupled = model.solveInOrder(timer, state, well_state, true);
+    const BlackoilState gauss_seidel = model.solveInOrder(timer, state, well_state, false);
+
+    // The recirculating components are large enough for the coupled
+    // solve, and their cells are changed by the transport.
+    BOOST_CHECK_EQUAL(model.largestComponent(), 4);
+    const std::vector<int> cells = model.multiCellComponentCells();
+    BOOST_REQUIRE(!cells.empty());
+    bool changed = false;
+    for (const int cell : cells) {
+        changed = changed || coupled.saturation()[3*cell] != state.saturation()[3*cell];
+    }
+    BOOST_CHECK(changed);
+
+    // Both converge the component residuals to the same tolerance, and
+    // every other cell sees the same upstream values, so the states
+    // agree to about that tolerance.
+    const int nc = grid.number_of_cells;
+    const double tol = 1e-5;
+    for (int ii = 0; ii < 3*nc; ++ii) {
+        BOOST_CHECK_SMALL(coupled.saturation()[ii] - gauss_seidel.saturation()[ii], tol);
+    }
+    for (int cell = 0; cell < nc; ++cell) {
+        BOOST_CHECK_SMALL(coupled.gasoilratio()[cell] - gauss_seidel.gasoilratio()[cell],
+                          tol * state.gasoilratio()[cell]);
+        BOOST_CHECK(coupled.hydroCarbonState()[cell] == gauss_seidel.hydroCarbonState()[cell]);
+    }
+}
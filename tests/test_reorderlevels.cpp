@@ -0,0 +1,241 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE ReorderLevelsTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/transport/reorder/ReorderSolverInterface.hpp>
+#include <opm/core/flowdiagnostics/TofDiscGalReorder.hpp>
+#include <opm/common/utility/parameters/ParameterGroup.hpp>
+#include <opm/grid/GridManager.hpp>
+#include <opm/grid/UnstructuredGrid.h>
+#include <opm/grid/utility/SparseTable.hpp>
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace Opm;
+
+namespace {
+    // Gives access to the ordering and levels of ReorderSolverInterface.
+    class LevelsProbe : public ReorderSolverInterface
+    {
+    public:
+        void compute(const UnstructuredGrid& grid, const double* darcyflux)
+        {
+            reorder(grid, darcyflux);
+            computeLevels();
+        }
+        using ReorderSolverInterface::sequence;
+        using ReorderSolverInterface::components;
+        using ReorderSolverInterface::levels;
+        using ReorderSolverInterface::levelComponents;
+    private:
+        void solveSingleCell(const int) override {}
+        void solveMultiCell(const int, const int*) override {}
+    };
+
+    // Unit flux along each of the given (upstream, downstream) cell
+    // pairs, and no flux through other faces.
+    std::vector<double> fluxAlong(const UnstructuredGrid& grid,
+                                  const std::set<std::pair<int, int>>& edges)
+    {
+        std::vector<double> flux(grid.number_of_faces, 0.0);
+        for (int f = 0; f < grid.number_of_faces; ++f) {
+            const int c0 = grid.face_cells[2*f];
+            const int c1 = grid.face_cells[2*f + 1];
+            if (edges.count(std::make_pair(c0, c1))) {
+                flux[f] = 1.0;
+            } else if (edges.count(std::make_pair(c1, c0))) {
+                flux[f] = -1.0;
+            }
+        }
+        return flux;
+    }
+
+    // Check that every component is in exactly one level, and that
+    // every upstream neighbour of a component is in an earlier level.
+    // Returns the level of each cell.
+    std::vector<int> checkLevels(const UnstructuredGrid& grid, const double* flux,
+                                 const LevelsProbe& probe)
+    {
+        const std::vector<int>& seq = probe.sequence();
+        const std::vector<int>& comps = probe.components();
+        const std::vector<int>& levels = probe.levels();
+        const std::vector<int>& level_comps = probe.levelComponents();
+        const int ncomp = comps.size() - 1;
+        BOOST_REQUIRE_EQUAL(levels.front(), 0);
+        BOOST_REQUIRE_EQUAL(levels.back(), ncomp);
+        BOOST_REQUIRE_EQUAL(int(level_comps.size()), ncomp);
+
+        std::vector<int> level_of_comp(ncomp, -1);
+        for (std::size_t l = 0; l + 1 < levels.size(); ++l) {
+            BOOST_CHECK_LT(levels[l], levels[l + 1]);
+            for (int i = levels[l]; i < levels[l + 1]; ++i) {
+                BOOST_REQUIRE_EQUAL(level_of_comp[level_comps[i]], -1);
+                level_of_comp[level_comps[i]] = l;
+            }
+        }
+        std::vector<int> level_of_cell(grid.number_of_cells, -1);
+        for (int comp = 0; comp < ncomp; ++comp) {
+            for (int i = comps[comp]; i < comps[comp + 1]; ++i) {
+                level_of_cell[seq[i]] = level_of_comp[comp];
+            }
+        }
+
+        std::vector<int> comp_of_cell(grid.number_of_cells);
+        for (int comp = 0; comp < ncomp; ++comp) {
+            for (int i = comps[comp]; i < comps[comp + 1]; ++i) {
+                comp_of_cell[seq[i]] = comp;
+            }
+        }
+        for (int f = 0; f < grid.number_of_faces; ++f) {
+            const int c0 = grid.face_cells[2*f];
+            const int c1 = grid.face_cells[2*f + 1];
+            if (c0 < 0 || c1 < 0 || flux[f] == 0.0 || comp_of_cell[c0] == comp_of_cell[c1]) {
+                continue;
+            }
+            const int up = flux[f] > 0.0 ? c0 : c1;
+            const int down = flux[f] > 0.0 ? c1 : c0;
+            BOOST_CHECK_LT(level_of_cell[up], level_of_cell[down]);
+        }
+        return level_of_cell;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(DiagonalWavefronts)
+{
+    // Flow in the positive x and y directions of a 3 x 3 grid. The level
+    // of cell (i, j) is i + j.
+    const int nx = 3, ny = 3;
+    GridManager gm(nx, ny);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    std::set<std::pair<int, int>> edges;
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            if (i + 1 < nx) {
+                edges.emplace(i + nx*j, i + 1 + nx*j);
+            }
+            if (j + 1 < ny) {
+                edges.emplace(i + nx*j, i + nx*(j + 1));
+            }
+        }
+    }
+    const std::vector<double> flux = fluxAlong(grid, edges);
+
+    LevelsProbe probe;
+    probe.compute(grid, flux.data());
+    const std::vector<int> level_of_cell = checkLevels(grid, flux.data(), probe);
+
+    const std::vector<int> expected_levels = { 0, 1, 3, 6, 8, 9 };
+    const std::vector<int>& levels = probe.levels();
+    BOOST_CHECK_EQUAL_COLLECTIONS(levels.begin(), levels.end(),
+                                  expected_levels.begin(), expected_levels.end());
+    for (int j = 0; j < ny; ++j) {
+        for (int i = 0; i < nx; ++i) {
+            BOOST_CHECK_EQUAL(level_of_cell[i + nx*j], i + j);
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(CycleIsOneComponent)
+{
+    // A 3 x 2 grid with cells
+    //     3 4 5
+    //     0 1 2
+    // where 0 -> 1 -> 4 -> 3 -> 0 is a cycle, which feeds 2 and 5,
+    // and 2 feeds 5.
+    GridManager gm(3, 2);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    const std::set<std::pair<int, int>> edges = {
+        { 0, 1 }, { 1, 4 }, { 4, 3 }, { 3, 0 }, { 1, 2 }, { 4, 5 }, { 2, 5 }
+    };
+    const std::vector<double> flux = fluxAlong(grid, edges);
+
+    LevelsProbe probe;
+    probe.compute(grid, flux.data());
+    const std::vector<int> level_of_cell = checkLevels(grid, flux.data(), probe);
+
+    BOOST_CHECK_EQUAL(probe.levels().size(), 4u);
+    const std::vector<int> expected = { 0, 0, 1, 0, 0, 2 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(level_of_cell.begin(), level_of_cell.end(),
+                                  expected.begin(), expected.end());
+}
+
+
+
+BOOST_AUTO_TEST_CASE(TofIndependentOfParallelLevels)
+{
+    // Random fluxes with some reversed faces, giving cycles. The grid
+    // is large enough for some levels to be solved by several threads.
+    const int nx = 80, ny = 60;
+    GridManager gm(nx, ny);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> u(0.2, 1.0);
+    std::vector<double> flux(grid.number_of_faces);
+    for (int f = 0; f < grid.number_of_faces; ++f) {
+        flux[f] = u(gen) * (f % 7 == 0 ? -1.0 : 1.0);
+    }
+    LevelsProbe probe;
+    probe.compute(grid, flux.data());
+    checkLevels(grid, flux.data(), probe);
+    int max_level_size = 0;
+    for (std::size_t l = 0; l + 1 < probe.levels().size(); ++l) {
+        max_level_size = std::max(max_level_size, probe.levels()[l + 1] - probe.levels()[l]);
+    }
+    BOOST_CHECK_GE(max_level_size, 32);
+
+    std::vector<double> pv(grid.number_of_cells, 0.3);
+    std::vector<double> src(grid.number_of_cells, -1e-2);
+    src[0] = 1.0;
+    src[grid.number_of_cells - 1] = -1.0;
+    SparseTable<int> heads;
+    const int h0[] = { 0 };
+    const int h1[] = { 5 };
+    heads.appendRow(h0, h0 + 1);
+    heads.appendRow(h1, h1 + 1);
+
+    std::vector<double> tof[2], tracer[2];
+    for (int parallel = 0; parallel < 2; ++parallel) {
+        ParameterGroup param;
+        param.insertParameter("dg_degree", "1");
+        param.insertParameter("use_limiter", "true");
+        param.insertParameter("parallel_levels", parallel ? "true" : "false");
+        TofDiscGalReorder solver(grid, param);
+        solver.solveTofTracer(flux.data(), pv.data(), src.data(), heads,
+                              tof[parallel], tracer[parallel]);
+    }
+    BOOST_CHECK_EQUAL_COLLECTIONS(tof[0].begin(), tof[0].end(),
+                                  tof[1].begin(), tof[1].end());
+    BOOST_CHECK_EQUAL_COLLECTIONS(tracer[0].begin(), tracer[0].end(),
+                                  tracer[1].begin(), tracer[1].end());
+}
@@ -21,6 +21,10 @@
 #include <opm/core/props/BlackoilPropertiesBasic.hpp>
 #include <opm/core/props/BlackoilPropertiesFromDeck.hpp>
 #include <opm/core/props/BlackoilPhases.hpp>
+#include <opm/core/props/satfunc/SaturationPropsFromDeck.hpp>
+#include <opm/grid/utility/compressedToCartesian.hpp>
+
+#include <opm/material/fluidmatrixinteractions/EclMaterialLawManager.hpp>
 
 #include <opm/parser/eclipse/Parser/Parser.hpp>
 #include <opm/parser/eclipse/Parser/ParseContext.hpp>
@@ -667,4 +671,67 @@ BOOST_AUTO_TEST_CASE (GwsegEPS_D)
 */
 }
 
+BOOST_AUTO_TEST_CASE (ByPhaseLayout)
+{
+    // The phase by phase output must hold the same values and
+    // derivatives as the interleaved output. Enough points are used
+    // for the evaluation to be split over threads.
+
+    Opm::GridManager gm(1, 1, 10, 1.0, 1.0, 5.0);
+    const UnstructuredGrid& grid = *(gm.c_grid());
+    Opm::ParseContext parseContext;
+    Opm::Parser parser;
+    Opm::ErrorGuard errors;
+    Opm::Deck deck = parser.parseFile("satfuncStandard.DATA", parseContext, errors);
+    Opm::EclipseState eclipseState(deck , parseContext, errors);
+
+    typedef Opm::SaturationPropsFromDeck::MaterialLawManager MaterialLawManager;
+    auto materialLawManager = std::make_shared<MaterialLawManager>();
+    materialLawManager->initFromDeck(deck, eclipseState,
+                                     Opm::compressedToCartesian(grid.number_of_cells, grid.global_cell));
+    Opm::SaturationPropsFromDeck satprops;
+    satprops.init(deck, materialLawManager);
+
+    const int np = 3;
+    BOOST_REQUIRE(np == satprops.numPhases());
+
+    const int n = 1210;
+    std::vector<double> s(n*np);
+    std::vector<int> cells(n);
+    for (int i = 0; i < n; ++i) {
+        cells[i] = i % grid.number_of_cells;
+        const double sw = 0.01*(i % 110);
+        const double sg = (1.0 - sw)*0.1*(i / 110);
+        s[i*np + 0] = sw;
+        s[i*np + 1] = 1.0 - sw - sg;
+        s[i*np + 2] = sg;
+    }
+
+    std::vector<double> kr(n*np), dkrds(n*np*np);
+    std::vector<double> krp(n*np), dkrdsp(n*np*np);
+    satprops.relperm(n, s.data(), cells.data(), kr.data(), dkrds.data());
+    satprops.relpermByPhase(n, s.data(), cells.data(), krp.data(), dkrdsp.data());
+
+    std::vector<double> pc(n*np), dpcds(n*np*np);
+    std::vector<double> pcp(n*np), dpcdsp(n*np*np);
+    satprops.capPress(n, s.data(), cells.data(), pc.data(), dpcds.data());
+    satprops.capPressByPhase(n, s.data(), cells.data(), pcp.data(), dpcdsp.data());
+
+    for (int i = 0; i < n; ++i) {
+        for (int p = 0; p < np; ++p) {
+            BOOST_CHECK_EQUAL(krp[n*p + i], kr[i*np + p]);
+            BOOST_CHECK_EQUAL(pcp[n*p + i], pc[i*np + p]);
+            for (int j = 0; j < np; ++j) {
+                BOOST_CHECK_EQUAL(dkrdsp[n*(np*j + p) + i], dkrds[i*np*np + np*j + p]);
+                BOOST_CHECK_EQUAL(dpcdsp[n*(np*j + p) + i], dpcds[i*np*np + np*j + p]);
+            }
+        }
+    }
+
+    // Without derivatives.
+    std::vector<double> krv(n*np);
+    satprops.relpermByPhase(n, s.data(), cells.data(), krv.data(), nullptr);
+    BOOST_CHECK_EQUAL_COLLECTIONS(krv.begin(), krv.end(), krp.begin(), krp.end());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,113 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE SolveReorderComponentTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/autodiff/solveReorderComponent.hpp>
+
+#include <vector>
+
+namespace
+{
+    // A component of three cells in a field of eight. The coupled
+    // solver moves all cells to a given value, and converges if asked
+    // to. The single cell solver records the value it starts from, and
+    // sets the cell to the sum of its own and the previous cell's value.
+    struct Component
+    {
+        const int min_coupled_size = 3;
+        std::vector<int> cells = { 5, 2, 6 };
+        std::vector<double> values = { 0.0, 0.0, 20.0, 0.0, 0.0, 10.0, 30.0, 0.0 };
+        std::vector<double> single_start;
+        int coupled_calls = 0;
+        int restored = 0;
+
+        bool solve(const bool coupled_converges)
+        {
+            const int n = cells.size();
+            return Opm::solveReorderComponent(
+                n, cells.data(), min_coupled_size,
+                [this](const int cell) { return values[cell]; },
+                [this](const int cell, const double v) { values[cell] = v; ++restored; },
+                [this, coupled_converges](const int comp_size, const int* comp_cells) {
+                    ++coupled_calls;
+                    for (int ii = 0; ii < comp_size; ++ii) {
+                        values[comp_cells[ii]] = -1.0;
+                    }
+                    return coupled_converges;
+                },
+                [this](const int cell) {
+                    single_start.push_back(values[cell]);
+                    values[cell] += values[cell - 1];
+                });
+        }
+    };
+}
+
+
+
+BOOST_AUTO_TEST_CASE(CoupledSolveConverges)
+{
+    Component c;
+    BOOST_CHECK(c.solve(true));
+    BOOST_CHECK_EQUAL(c.coupled_calls, 1);
+    BOOST_CHECK_EQUAL(c.restored, 0);
+    BOOST_CHECK(c.single_start.empty());
+    for (const int cell : c.cells) {
+        BOOST_CHECK_EQUAL(c.values[cell], -1.0);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(FallbackStartsFromSavedState)
+{
+    Component c;
+    BOOST_CHECK(!c.solve(false));
+    BOOST_CHECK_EQUAL(c.coupled_calls, 1);
+    BOOST_CHECK_EQUAL(c.restored, 3);
+
+    // Gauss-Seidel in component order, from the values before the
+    // coupled solve, not from the failed coupled iterate.
+    const std::vector<double> expected_start = { 10.0, 20.0, 30.0 };
+    BOOST_CHECK_EQUAL_COLLECTIONS(c.single_start.begin(), c.single_start.end(),
+                                  expected_start.begin(), expected_start.end());
+    BOOST_CHECK_EQUAL(c.values[5], 10.0);
+    BOOST_CHECK_EQUAL(c.values[2], 20.0);
+    BOOST_CHECK_EQUAL(c.values[6], 40.0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SmallComponentsAreNotCoupled)
+{
+    Component c;
+    c.cells = { 5, 6 };
+    BOOST_CHECK(!c.solve(true));
+    BOOST_CHECK_EQUAL(c.coupled_calls, 0);
+    BOOST_CHECK_EQUAL(c.restored, 0);
+    BOOST_CHECK_EQUAL(c.single_start.size(), 2u);
+    BOOST_CHECK_EQUAL(c.values[6], 40.0);
+}
@@ -0,0 +1,137 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE SparseProductCacheTest
+
+#include <opm/autodiff/AutoDiffBlock.hpp>
+#include <opm/autodiff/SparseProductCache.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <Eigen/Eigen>
+#include <Eigen/Sparse>
+
+using namespace Opm;
+
+namespace {
+    typedef Eigen::SparseMatrix<double> Sp;
+    typedef AutoDiffBlock<double> ADB;
+
+    // Gradient operator of a 1D grid with n cells.
+    Sp gradient(const int n)
+    {
+        std::vector<Eigen::Triplet<double>> t;
+        for (int f = 0; f < n - 1; ++f) {
+            t.emplace_back(f, f, 1.0);
+            t.emplace_back(f, f + 1, -1.0);
+        }
+        Sp grad(n - 1, n);
+        grad.setFromTriplets(t.begin(), t.end());
+        return grad;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(SameResultAsFastSparseProduct)
+{
+    const int n = 20;
+    const Sp grad = gradient(n);
+    const Sp div = grad.transpose();
+
+    SparseProductCache cache;
+    for (int iteration = 0; iteration < 3; ++iteration) {
+        // Same pattern, different values in every iteration.
+        Sp flux = grad;
+        for (int k = 0; k < flux.nonZeros(); ++k) {
+            flux.valuePtr()[k] *= 1.0 + 0.1 * k + iteration;
+        }
+        Sp cached, reference;
+        cache.multiply(div, flux, cached);
+        fastSparseProduct(div, flux, reference);
+        BOOST_CHECK(Eigen::MatrixXd(cached).isApprox(Eigen::MatrixXd(reference)));
+        BOOST_CHECK_EQUAL(cached.nonZeros(), reference.nonZeros());
+    }
+    BOOST_CHECK_EQUAL(cache.misses(), 1u);
+    BOOST_CHECK_EQUAL(cache.hits(), 2u);
+
+    // A new pattern is computed for a different rhs pattern.
+    const Sp id = Sp(Eigen::MatrixXd::Identity(n - 1, n - 1).sparseView());
+    Sp cached;
+    cache.multiply(div, id, cached);
+    BOOST_CHECK(Eigen::MatrixXd(cached).isApprox(Eigen::MatrixXd(div)));
+    BOOST_CHECK_EQUAL(cache.misses(), 2u);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(DifferentLhsPattern)
+{
+    // Two lhs with the same number of entries in each column, in
+    // different rows, so that only the inner indices differ.
+    const int n = 4;
+    std::vector<Eigen::Triplet<double>> t1, t2;
+    for (int j = 0; j < n; ++j) {
+        t1.emplace_back(j, j, 1.0 + j);
+        t2.emplace_back((j + 1) % n, j, 1.0 + j);
+    }
+    Sp lhs1(n, n), lhs2(n, n);
+    lhs1.setFromTriplets(t1.begin(), t1.end());
+    lhs2.setFromTriplets(t2.begin(), t2.end());
+    const Sp rhs = Sp(Eigen::MatrixXd::Identity(n, n).sparseView());
+
+    SparseProductCache cache;
+    Sp cached;
+    cache.multiply(lhs1, rhs, cached);
+    BOOST_CHECK(Eigen::MatrixXd(cached).isApprox(Eigen::MatrixXd(lhs1)));
+    cache.multiply(lhs2, rhs, cached);
+    BOOST_CHECK(Eigen::MatrixXd(cached).isApprox(Eigen::MatrixXd(lhs2)));
+    BOOST_CHECK_EQUAL(cache.misses(), 2u);
+    BOOST_CHECK_EQUAL(cache.hits(), 0u);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(AutoDiffBlockProduct)
+{
+    const int n = 10;
+    const Sp grad = gradient(n);
+    const Sp div = grad.transpose();
+
+    std::vector<ADB::V> vals(2, ADB::V::LinSpaced(n, 1.0, 2.0));
+    const std::vector<ADB> vars = ADB::variables(vals);
+    const ADB flux = grad * (vars[0] * vars[1]);
+
+    SparseProductCache cache;
+    const ADB reference = div * flux;
+    for (int iteration = 0; iteration < 2; ++iteration) {
+        const ADB result = cachedProduct(div, cache, flux);
+        BOOST_CHECK(result.value().isApprox(reference.value()));
+        BOOST_REQUIRE_EQUAL(result.numBlocks(), reference.numBlocks());
+        for (int block = 0; block < reference.numBlocks(); ++block) {
+            Sp r, e;
+            result.derivative()[block].toSparse(r);
+            reference.derivative()[block].toSparse(e);
+            BOOST_CHECK(Eigen::MatrixXd(r).isApprox(Eigen::MatrixXd(e)));
+        }
+    }
+    BOOST_CHECK(cache.hits() > 0);
+}
@@ -0,0 +1,124 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE ThreadHandleTest
+
+#include <opm/autodiff/ThreadHandle.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+using namespace Opm;
+
+namespace {
+    // Appends its number to a shared list.
+    struct Append
+    {
+        std::vector<int>* list;
+        std::mutex* mutex;
+        int value;
+
+        void run()
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            std::lock_guard<std::mutex> lock(*mutex);
+            list->push_back(value);
+        }
+    };
+
+    struct Throw
+    {
+        void run()
+        {
+            throw std::runtime_error("write failed");
+        }
+    };
+
+    struct Count
+    {
+        std::atomic<int>* counter;
+
+        void run()
+        {
+            ++(*counter);
+        }
+    };
+}
+
+
+
+BOOST_AUTO_TEST_CASE(OrderWithinChannel)
+{
+    std::vector<int> list0, list1;
+    std::mutex mutex;
+    {
+        ThreadHandle handle(true, 3, 2);
+        BOOST_CHECK_EQUAL(handle.numThreads(), 3);
+        for (int i = 0; i < 50; ++i) {
+            handle.dispatch(Append{ &list0, &mutex, i }, 0);
+            handle.dispatch(Append{ &list1, &mutex, i }, 1);
+        }
+        handle.flush();
+        BOOST_CHECK_EQUAL(list0.size(), 50u);
+        BOOST_CHECK_EQUAL(list1.size(), 50u);
+    }
+    for (int i = 0; i < 50; ++i) {
+        BOOST_CHECK_EQUAL(list0[i], i);
+        BOOST_CHECK_EQUAL(list1[i], i);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(DestructorRunsRemainingObjects)
+{
+    std::atomic<int> counter(0);
+    {
+        ThreadHandle handle(true);
+        for (int i = 0; i < 100; ++i) {
+            handle.dispatch(Count{ &counter });
+        }
+    }
+    BOOST_CHECK_EQUAL(counter.load(), 100);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(FlushThrowsErrors)
+{
+    std::atomic<int> counter(0);
+    ThreadHandle handle(true, 2);
+    handle.dispatch(Throw());
+    handle.dispatch(Count{ &counter });
+    BOOST_CHECK_THROW(handle.flush(), std::runtime_error);
+    BOOST_CHECK_EQUAL(counter.load(), 1);
+
+    // The error is only reported once.
+    handle.flush();
+
+    ThreadHandle noThread(false);
+    BOOST_CHECK_THROW(noThread.dispatch(Count{ &counter }), std::logic_error);
+    noThread.flush();
+}
@@ -0,0 +1,150 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE TofReorderTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/flowdiagnostics/TofReorder.hpp>
+#include <opm/grid/GridManager.hpp>
+#include <opm/grid/UnstructuredGrid.h>
+#include <opm/grid/utility/SparseTable.hpp>
+
+#include <tuple>
+#include <vector>
+
+using namespace Opm;
+
+namespace {
+    // Sum of the flux v from cell a to its neighbour b, for each
+    // (a, b, v), with positive flux from face_cells[2*f] to
+    // face_cells[2*f + 1].
+    std::vector<double> fluxAlong(const UnstructuredGrid& grid,
+                                  const std::vector< std::tuple<int, int, double> >& paths)
+    {
+        std::vector<double> flux(grid.number_of_faces, 0.0);
+        for (int f = 0; f < grid.number_of_faces; ++f) {
+            const int c0 = grid.face_cells[2*f];
+            const int c1 = grid.face_cells[2*f + 1];
+            for (const auto& p : paths) {
+                if (std::get<0>(p) == c0 && std::get<1>(p) == c1) {
+                    flux[f] += std::get<2>(p);
+                } else if (std::get<0>(p) == c1 && std::get<1>(p) == c0) {
+                    flux[f] -= std::get<2>(p);
+                }
+            }
+        }
+        return flux;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(BatchedTracersMatchSingleTracers)
+{
+    // A 5 x 2 grid with cells
+    //     5 6 7 8 9
+    //     0 1 2 3 4
+    // and injectors in 0, 5 and 8, and a producer in 4. The flows are
+    //     0 -> 1 -> 2 -> 3 -> 4 with rate 1,
+    //     5 -> 6 -> 7 -> 8 -> 9 -> 4 with rate qb,
+    //     8 -> 9 -> 4 with rate 0.5,
+    // and a recirculation 1 -> 2 -> 7 -> 6 -> 1 with rate 3, so that
+    // cells 1, 2, 7 and 6 are one component.
+    GridManager gm(5, 2);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    const double qb = 0.01;
+    const std::vector< std::tuple<int, int, double> > paths = {
+        std::make_tuple(0, 1, 1.0), std::make_tuple(1, 2, 1.0),
+        std::make_tuple(2, 3, 1.0), std::make_tuple(3, 4, 1.0),
+        std::make_tuple(5, 6, qb), std::make_tuple(6, 7, qb),
+        std::make_tuple(7, 8, qb), std::make_tuple(8, 9, qb), std::make_tuple(9, 4, qb),
+        std::make_tuple(8, 9, 0.5), std::make_tuple(9, 4, 0.5),
+        std::make_tuple(1, 2, 3.0), std::make_tuple(2, 7, 3.0),
+        std::make_tuple(7, 6, 3.0), std::make_tuple(6, 1, 3.0)
+    };
+    const std::vector<double> flux = fluxAlong(grid, paths);
+    const int nc = grid.number_of_cells;
+    std::vector<double> pv(nc, 1.0);
+    std::vector<double> src(nc, 0.0);
+    src[0] = 1.0;
+    src[5] = qb;
+    src[8] = 0.5;
+    src[4] = -1.5 - qb;
+
+    // One tracer for each injector. In the recirculating component,
+    // the tracer of 8 is zero and converges in the first Gauss-Seidel
+    // iteration, and the tracer of 5 is about qb times the tracer of
+    // 0, so it converges several iterations before it. The tracers
+    // that have converged must keep their values while the others
+    // are iterated.
+    const int heads[] = { 0, 5, 8 };
+    const int num_tracers = 3;
+    SparseTable<int> tracerheads;
+    for (int tr = 0; tr < num_tracers; ++tr) {
+        tracerheads.appendRow(heads + tr, heads + tr + 1);
+    }
+
+    TofReorder solver(grid);
+    std::vector<double> tof;
+    std::vector<double> tracer;
+    solver.solveTofTracer(flux.data(), pv.data(), src.data(), tracerheads, tof, tracer);
+    BOOST_REQUIRE_EQUAL(int(tof.size()), nc);
+    BOOST_REQUIRE_EQUAL(int(tracer.size()), nc*num_tracers);
+
+    // The time of flight is the same as without tracers.
+    std::vector<double> tof_only;
+    solver.solveTof(flux.data(), pv.data(), src.data(), tof_only);
+    BOOST_CHECK_EQUAL_COLLECTIONS(tof.begin(), tof.end(), tof_only.begin(), tof_only.end());
+
+    // Each tracer is the same as when solved on its own.
+    for (int tr = 0; tr < num_tracers; ++tr) {
+        SparseTable<int> single_head;
+        single_head.appendRow(heads + tr, heads + tr + 1);
+        std::vector<double> single_tof;
+        std::vector<double> single_tracer;
+        solver.solveTofTracer(flux.data(), pv.data(), src.data(), single_head,
+                              single_tof, single_tracer);
+        BOOST_CHECK_EQUAL_COLLECTIONS(single_tof.begin(), single_tof.end(), tof.begin(), tof.end());
+        BOOST_REQUIRE_EQUAL(int(single_tracer.size()), nc);
+        for (int cell = 0; cell < nc; ++cell) {
+            BOOST_CHECK_EQUAL(tracer[num_tracers*cell + tr], single_tracer[cell]);
+        }
+    }
+
+    // All fluid comes from the injectors, so the tracers sum to one,
+    // up to the Gauss-Seidel tolerance in the recirculating cells.
+    const int loop[] = { 1, 2, 6, 7 };
+    for (int cell = 0; cell < nc; ++cell) {
+        double sum = 0.0;
+        for (int tr = 0; tr < num_tracers; ++tr) {
+            sum += tracer[num_tracers*cell + tr];
+        }
+        BOOST_CHECK_CLOSE(sum, 1.0, 1.0);
+    }
+    for (const int cell : loop) {
+        BOOST_CHECK_GT(tracer[num_tracers*cell + 0], 0.5);
+        BOOST_CHECK_GT(tracer[num_tracers*cell + 1], 0.0);
+        BOOST_CHECK_EQUAL(tracer[num_tracers*cell + 2], 0.0);
+    }
+}
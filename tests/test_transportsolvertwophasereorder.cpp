@@ -0,0 +1,155 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE TransportSolverTwophaseReorderTest
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <opm/core/transport/reorder/TransportSolverTwophaseReorder.hpp>
+#include <opm/core/props/IncompPropertiesInterface.hpp>
+#include <opm/core/simulator/TwophaseState.hpp>
+#include <opm/grid/GridManager.hpp>
+#include <opm/grid/UnstructuredGrid.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Opm;
+
+namespace {
+    // Two phases of equal viscosity, with relative permeabilities
+    // s^p and (1 - s)^p. The fractional flow is linear for p = 1.
+    class PowerLawProps : public IncompPropertiesInterface
+    {
+    public:
+        explicit PowerLawProps(const std::vector<double>& exponent)
+            : exponent_(exponent),
+              porosity_(exponent.size(), 0.2)
+        {
+        }
+        int numDimensions() const override { return 2; }
+        int numCells() const override { return exponent_.size(); }
+        const double* porosity() const override { return porosity_.data(); }
+        const double* permeability() const override { return nullptr; }
+        int numPhases() const override { return 2; }
+        const double* viscosity() const override { return viscosity_; }
+        const double* density() const override { return nullptr; }
+        const double* surfaceDensity() const override { return nullptr; }
+        void relperm(const int n, const double* s, const int* cells,
+                     double* kr, double* dkrds) const override
+        {
+            for (int i = 0; i < n; ++i) {
+                const double p = exponent_[cells[i]];
+                kr[2*i] = std::pow(s[2*i], p);
+                kr[2*i + 1] = std::pow(1.0 - s[2*i], p);
+            }
+            static_cast<void>(dkrds);
+        }
+        void capPress(const int n, const double*, const int*,
+                      double* pc, double*) const override
+        {
+            std::fill(pc, pc + 2*n, 0.0);
+        }
+        void satRange(const int n, const int*, double* smin, double* smax) const override
+        {
+            std::fill(smin, smin + 2*n, 0.0);
+            std::fill(smax, smax + 2*n, 1.0);
+        }
+    private:
+        std::vector<double> exponent_;
+        std::vector<double> porosity_;
+        double viscosity_[2] = { 1.0, 1.0 };
+    };
+
+    // Flux from cell c to cell c + 1 of a single row of cells.
+    std::vector<double> rowFlux(const UnstructuredGrid& grid, const std::vector<double>& flux)
+    {
+        std::vector<double> face_flux(grid.number_of_faces, 0.0);
+        for (int f = 0; f < grid.number_of_faces; ++f) {
+            const int c0 = grid.face_cells[2*f];
+            const int c1 = grid.face_cells[2*f + 1];
+            if (c0 >= 0 && c1 == c0 + 1) {
+                face_flux[f] = flux[c0];
+            } else if (c1 >= 0 && c0 == c1 + 1) {
+                face_flux[f] = -flux[c1];
+            }
+        }
+        return face_flux;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(BatchLevelsMatchCellByCell)
+{
+    // A row of five cells, where water is injected in cell 0 and flows
+    // through cells 1 and 2 to a producer in cell 3:
+    //   cell 0  linear, converges in one iteration,
+    //   cell 1  steep fractional flow, does not converge in maxit iterations,
+    //   cell 2  gets more water than it passes on, so it is not bracketed,
+    //   cell 3  linear, converges in one iteration,
+    //   cell 4  no flow, converges at the initial guess.
+    GridManager gm(5, 1);
+    const UnstructuredGrid& grid = *gm.c_grid();
+    const std::vector<double> exponent = { 1.0, 4.0, 1.0, 1.0, 1.0 };
+    const PowerLawProps props(exponent);
+    const std::vector<double> flux = rowFlux(grid, { 1.0, 1.0, 0.01, 0.0 });
+    const std::vector<double> pv = { 1.0, 1.0, 0.01, 1.0, 1.0 };
+    const std::vector<double> src = { 1.0, 0.0, 0.0, -0.01, 0.0 };
+    const double tol = 1e-10;
+    const int maxit = 3;
+
+    std::vector<double> sat[2];
+    std::vector<int> iters[2];
+    for (int batch = 0; batch < 2; ++batch) {
+        TwophaseState state(grid.number_of_cells, grid.number_of_faces);
+        state.faceflux() = flux;
+        std::vector<double>& s = state.saturation();
+        for (int c = 0; c < grid.number_of_cells; ++c) {
+            s[2*c] = c == 4 ? 0.3 : 0.0;
+            s[2*c + 1] = 1.0 - s[2*c];
+        }
+        TransportSolverTwophaseReorder solver(grid, props, nullptr, tol, maxit, batch == 1);
+        solver.solve(pv.data(), src.data(), 1.0, state);
+        sat[batch] = state.saturation();
+        iters[batch] = solver.getReorderIterations();
+    }
+
+    // Not bit-identical, but within the tolerance.
+    for (int c = 0; c < grid.number_of_cells; ++c) {
+        BOOST_CHECK_SMALL(sat[1][2*c] - sat[0][2*c], 10.0*tol);
+        BOOST_CHECK_SMALL(sat[1][2*c] + sat[1][2*c + 1] - 1.0, 1e-14);
+    }
+    BOOST_CHECK_CLOSE(sat[1][0], 0.5, 1e-6);
+    BOOST_CHECK_EQUAL(sat[1][8], 0.3);
+
+    // The iterations done in lockstep. How the cell by cell solve
+    // counts its iterations is up to the root finder, so only the
+    // lockstep part of the count of cells that fall back to it is
+    // checked.
+    BOOST_CHECK_EQUAL(iters[1][0], 1);
+    BOOST_CHECK_GE(iters[1][1], maxit);
+    BOOST_CHECK_EQUAL(iters[1][3], 1);
+    BOOST_CHECK_EQUAL(iters[1][4], 0);
+}
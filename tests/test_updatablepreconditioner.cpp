@@ -0,0 +1,202 @@
+/*
+  Copyright 2019 SINTEF Digital, Mathematics and Cybernetics.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <config.h>
+
+#define BOOST_TEST_MODULE UpdatablePreconditionerTest
+
+#include <opm/autodiff/UpdatablePreconditioner.hpp>
+
+#include <opm/common/utility/platform_dependent/disable_warnings.h>
+#include <boost/test/unit_test.hpp>
+#include <dune/common/fmatrix.hh>
+#include <dune/common/fvector.hh>
+#include <dune/istl/bcrsmatrix.hh>
+#include <dune/istl/bvector.hh>
+#include <opm/common/utility/platform_dependent/reenable_warnings.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace Opm;
+
+namespace {
+    typedef Dune::BCRSMatrix< Dune::FieldMatrix<double, 1, 1> > Matrix;
+    typedef Dune::BlockVector< Dune::FieldVector<double, 1> > Vector;
+
+    // Tridiagonal pattern of a row of n cells.
+    Matrix rowPattern(const int n)
+    {
+        Matrix A(n, n, 3*n - 2, Matrix::row_wise);
+        for (auto row = A.createbegin(); row != A.createend(); ++row) {
+            const int i = row.index();
+            if (i > 0) {
+                row.insert(i - 1);
+            }
+            row.insert(i);
+            if (i < n - 1) {
+                row.insert(i + 1);
+            }
+        }
+        return A;
+    }
+
+    // Diffusion between neighbouring cells, with transmissibility
+    // trans[i] between cells i and i + 1, and accumulation acc in each
+    // cell.
+    void setDiffusion(Matrix& A, const std::vector<double>& trans, const double acc)
+    {
+        const int n = A.N();
+        A = 0.0;
+        for (int i = 0; i < n; ++i) {
+            A[i][i] = acc;
+            if (i > 0) {
+                A[i][i] += trans[i - 1];
+                A[i][i - 1] = -trans[i - 1];
+            }
+            if (i < n - 1) {
+                A[i][i] += trans[i];
+                A[i][i + 1] = -trans[i];
+            }
+        }
+    }
+
+    std::vector<double> transmissibilities(const int n, const double frequency)
+    {
+        std::vector<double> trans(n - 1);
+        for (int i = 0; i < n - 1; ++i) {
+            trans[i] = 1.0 + 0.9*std::sin(frequency*i);
+        }
+        return trans;
+    }
+
+    double maxNorm(const Vector& v)
+    {
+        double norm = 0.0;
+        for (const auto& vi : v) {
+            norm = std::max(norm, std::fabs(vi[0]));
+        }
+        return norm;
+    }
+
+    Vector rightHandSide(const int n)
+    {
+        Vector d(n);
+        for (int i = 0; i < n; ++i) {
+            d[i] = std::cos(0.1*i);
+        }
+        return d;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(ILU0UpdateMatchesNewFactorization)
+{
+    const int n = 50;
+    Matrix A = rowPattern(n);
+    setDiffusion(A, transmissibilities(n, 0.3), 0.1);
+    UpdatableSeqILU0<Matrix, Vector, Vector> ilu(A, 0.9);
+    const Vector d = rightHandSide(n);
+    Vector v_old(n);
+    ilu.apply(v_old, d);
+
+    // New values with the same pattern.
+    setDiffusion(A, transmissibilities(n, 0.7), 0.5);
+    ilu.update();
+    UpdatableSeqILU0<Matrix, Vector, Vector> fresh(A, 0.9);
+    Vector v(n), v_fresh(n);
+    ilu.apply(v, d);
+    fresh.apply(v_fresh, d);
+
+    const double scale = maxNorm(v_fresh);
+    BOOST_REQUIRE_GT(scale, 0.0);
+    double change = 0.0;
+    for (int i = 0; i < n; ++i) {
+        BOOST_CHECK_SMALL(v[i][0] - v_fresh[i][0], 1e-12*scale);
+        change = std::max(change, std::fabs(v[i][0] - v_old[i][0]));
+    }
+    // The factorization of the old values would not do.
+    BOOST_CHECK_GT(change, 1e-3*scale);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(AMGUpdateMatchesNewSetup)
+{
+    typedef Dune::MatrixAdapter<Matrix, Vector, Vector> Operator;
+    typedef Dune::SeqILU0<Matrix, Vector, Vector> Smoother;
+    typedef UpdatableAMG<Operator, Vector, Smoother> AMG;
+    typedef Dune::Amg::SymmetricCriterion<Matrix, Dune::Amg::FirstDiagonal> CritBase;
+    typedef Dune::Amg::CoarsenCriterion<CritBase> Criterion;
+
+    const int n = 2000;
+    Criterion criterion(15, 100);
+    criterion.setDebugLevel(0);
+    criterion.setDefaultValuesIsotropic(1);
+    criterion.setNoPostSmoothSteps(1);
+    criterion.setNoPreSmoothSteps(1);
+    AMG::SmootherArgs smootherArgs;
+    smootherArgs.iterations = 1;
+    smootherArgs.relaxationFactor = 1.0;
+
+    Matrix A = rowPattern(n);
+    const std::vector<double> trans = transmissibilities(n, 0.3);
+    setDiffusion(A, trans, 0.01);
+    const Operator op(A);
+    AMG amg(op, criterion, smootherArgs);
+    const Vector d = rightHandSide(n);
+    Vector x(n), b(d);
+    x = 0.0;
+    Vector v_old(n);
+    v_old = 0.0;
+    amg.pre(x, b);
+    amg.apply(v_old, d);
+    amg.post(x);
+
+    // Scaling the matrix does not change the aggregates, so the updated
+    // preconditioner must be the same as a new one, and every level must
+    // be scaled: the smoothers and the coarse solver as well as the
+    // coarse level matrices.
+    std::vector<double> scaled(trans);
+    for (double& t : scaled) {
+        t *= 2.0;
+    }
+    setDiffusion(A, scaled, 0.02);
+    amg.update();
+    AMG fresh(op, criterion, smootherArgs);
+
+    Vector v(n), v_fresh(n);
+    v = 0.0;
+    v_fresh = 0.0;
+    amg.pre(x, b);
+    amg.apply(v, d);
+    amg.post(x);
+    fresh.pre(x, b);
+    fresh.apply(v_fresh, d);
+    fresh.post(x);
+
+    const double scale = maxNorm(v_fresh);
+    BOOST_REQUIRE_GT(scale, 0.0);
+    for (int i = 0; i < n; ++i) {
+        BOOST_CHECK_SMALL(v[i][0] - v_fresh[i][0], 1e-10*scale);
+        BOOST_CHECK_SMALL(v[i][0] - 0.5*v_old[i][0], 1e-8*scale);
+    }
+}
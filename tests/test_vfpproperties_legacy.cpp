@@ -602,4 +602,76 @@ BOOST_AUTO_TEST_CASE(InterpolateADBAndQs)
 }
 
 
+
+/**
+ * Tests that repeated evaluations, where only some wells change, give the
+ * same values as evaluations from scratch
+ */
+BOOST_AUTO_TEST_CASE(RepeatedEvaluations)
+{
+    fillDataPlane();
+    initProperties();
+
+    const int nwells = 4;
+    ADB::V aqua_v(nwells), liquid_v(nwells), vapour_v(nwells), thp_v(nwells);
+    for (int i=0; i<nwells; ++i) {
+        aqua_v[i] = -0.1*(i+1);
+        liquid_v[i] = -0.2*(i+1);
+        vapour_v[i] = -0.05*(i+1);
+        thp_v[i] = 0.25*i;
+    }
+    const ADB aqua = ADB::constant(aqua_v);
+    const ADB liquid = ADB::constant(liquid_v);
+    const ADB vapour = ADB::constant(vapour_v);
+    const ADB alq = ADB::constant(ADB::V::Zero(nwells));
+    const std::vector<int> ids = { 1, -1, 1, 1 };
+
+    const ADB::V first = properties->bhp(ids, aqua, liquid, vapour, ADB::constant(thp_v), alq).value();
+    BOOST_CHECK_EQUAL(first[1], -1e100);
+
+    //Change the THP of one well only
+    thp_v[2] = 0.9;
+    const ADB thp = ADB::constant(thp_v);
+    const ADB::V second = properties->bhp(ids, aqua, liquid, vapour, thp, alq).value();
+
+    Opm::VFPProdPropertiesLegacy fresh(table.get());
+    const ADB::V reference = fresh.bhp(ids, aqua, liquid, vapour, thp, alq).value();
+    for (int i=0; i<nwells; ++i) {
+        BOOST_CHECK_EQUAL(second[i], reference[i]);
+    }
+    BOOST_CHECK_EQUAL(second[0], first[0]);
+    BOOST_CHECK(second[2] != first[2]);
+}
+
+
 BOOST_AUTO_TEST_SUITE_END() // Trivial tests
+
+
+
+/**
+ * Tests that the search for interpolation data from an earlier interval
+ * gives the same result as a search of the whole axis, for any hint
+ */
+BOOST_AUTO_TEST_CASE(FindInterpDataFromHint)
+{
+    const std::vector<double> values = { 0.5, 1.0, 2.0, 2.0, 3.5, 10.0 };
+    const int nvalues = values.size();
+
+    for (double value = -1.0; value < 12.0; value += 0.125) {
+        const Opm::detail::InterpData reference = Opm::detail::findInterpData(value, values);
+        for (int hint = 0; hint < nvalues; ++hint) {
+            const Opm::detail::InterpData data = Opm::detail::findInterpData(value, values, hint);
+            BOOST_CHECK_EQUAL(data.ind_[0], reference.ind_[0]);
+            BOOST_CHECK_EQUAL(data.ind_[1], reference.ind_[1]);
+            BOOST_CHECK_EQUAL(data.inv_dist_, reference.inv_dist_);
+            BOOST_CHECK_EQUAL(data.factor_, reference.factor_);
+        }
+    }
+
+    //A single value
+    const std::vector<double> single = { 1.0 };
+    const Opm::detail::InterpData data = Opm::detail::findInterpData(2.0, single, 1);
+    BOOST_CHECK_EQUAL(data.ind_[0], 0);
+    BOOST_CHECK_EQUAL(data.ind_[1], 0);
+    BOOST_CHECK_EQUAL(data.factor_, 0.0);
+}